@@ -8,11 +8,14 @@ ECCN 5D002 TSU - Technology / Software Unrestricted
 Source: http://is.gd/o9RSPq
 **************************************************************/
 #include <stdint.h>
+#include <string.h>
 #include "opendefs.h"
 #include "openaes.h"
 
 //=========================== variables =======================================
 
+openaes_vars_t openaes_vars;
+
 // foreward sbox
 const unsigned char sbox[256] = {
     //0     1    2      3     4    5     6     7      8    9     A      B    C     D     E     F
@@ -39,6 +42,7 @@ const unsigned char Rcon[11] = {
 //=========================== prototypes ======================================
 
 void expandKey(unsigned char *expandedKey,unsigned char *key);
+openaes_keycache_entry_t* openaes_findKey(uint8_t* key);
 unsigned char galois_mul2(unsigned char value);
 void aes_encr(unsigned char *state, unsigned char *expandedKey);
 
@@ -61,6 +65,66 @@ owerror_t openaes_enc(uint8_t buffer[16], uint8_t key[16])
     return E_SUCCESS;
 }
 
+/**
+\brief Get the expanded form of a key, for use with openaes_encExpanded.
+
+The last OPENAES_KEYCACHE_SIZE keys are kept expanded, so that a key which is
+used over and over (a link-layer key, an OSCOAP context key) is only expanded
+once.
+
+\note This is called both from task context (OSCOAP) and from the MAC
+   interrupt (link-layer security). The cache is only read or written with
+   interrupts disabled; a missing key is expanded into the caller's buffer
+   with interrupts enabled, and only the copy into the cache is done in the
+   critical section.
+
+\param[in] key Buffer containing the secret key (16 octets).
+\param[out] expandedKey Buffer receiving the expanded key (176 octets).
+*/
+void openaes_loadKey(uint8_t* key, uint8_t* expandedKey)
+{
+    openaes_keycache_entry_t* entry;
+    INTERRUPT_DECLARATION();
+
+    DISABLE_INTERRUPTS();
+    entry = openaes_findKey(key);
+    if (entry != NULL) {
+        memcpy(expandedKey, entry->expandedKey, OPENAES_EXPANDEDKEY_LEN);
+        ENABLE_INTERRUPTS();
+        return;
+    }
+    ENABLE_INTERRUPTS();
+
+    expandKey(expandedKey, key);
+
+    DISABLE_INTERRUPTS();
+    // an interrupt may have cached the same key in the meantime
+    if (openaes_findKey(key) == NULL) {
+        entry = &openaes_vars.keyCache[openaes_vars.nextKey];
+        memcpy(entry->key, key, OPENAES_KEY_LEN);
+        memcpy(entry->expandedKey, expandedKey, OPENAES_EXPANDEDKEY_LEN);
+        if (openaes_vars.numKeys < OPENAES_KEYCACHE_SIZE) {
+            openaes_vars.numKeys++;
+        }
+        openaes_vars.nextKey = (openaes_vars.nextKey + 1) % OPENAES_KEYCACHE_SIZE;
+    }
+    ENABLE_INTERRUPTS();
+}
+
+/**
+\brief AES encryption of a single 16-octet block with an already expanded key.
+\param[in,out] buffer Single block plaintext. Will be overwritten by ciphertext.
+\param[in] expandedKey Buffer containing the expanded key (176 octets), see openaes_loadKey.
+
+\returns E_SUCCESS when the encryption was successful.
+*/
+owerror_t openaes_encExpanded(uint8_t* buffer, uint8_t* expandedKey)
+{
+    aes_encr(buffer, expandedKey);
+
+    return E_SUCCESS;
+}
+
 //=========================== private =========================================
 
 // expand the key
@@ -93,6 +157,19 @@ void expandKey(unsigned char *expandedKey,
 
 }
 
+// cache entry holding key, NULL if none; call with interrupts disabled
+openaes_keycache_entry_t* openaes_findKey(uint8_t* key)
+{
+    uint8_t i;
+
+    for (i = 0; i < openaes_vars.numKeys; i++) {
+        if (memcmp(openaes_vars.keyCache[i].key, key, OPENAES_KEY_LEN) == 0) {
+            return &openaes_vars.keyCache[i];
+        }
+    }
+    return NULL;
+}
+
 // multiply by 2 in the galois field
 unsigned char galois_mul2(unsigned char value)
 {
@@ -10,8 +10,35 @@ Source: http://is.gd/o9RSPq
 #ifndef __OPENAES_H__
 #define __OPENAES_H__
 
+//=========================== define ==========================================
+
+#define OPENAES_KEY_LEN           16
+#define OPENAES_EXPANDEDKEY_LEN   176
+
+/// number of expanded keys kept, the oldest one is replaced by a new key
+#ifndef OPENAES_KEYCACHE_SIZE
+#define OPENAES_KEYCACHE_SIZE     4
+#endif
+
+//=========================== typedef =========================================
+
+typedef struct {
+   uint8_t key[OPENAES_KEY_LEN];
+   uint8_t expandedKey[OPENAES_EXPANDEDKEY_LEN];
+} openaes_keycache_entry_t;
+
+//=========================== module variables ================================
+
+typedef struct {
+   openaes_keycache_entry_t keyCache[OPENAES_KEYCACHE_SIZE];
+   uint8_t                  numKeys;       // entries in use
+   uint8_t                  nextKey;       // entry the next new key goes to
+} openaes_vars_t;
+
 //=========================== prototypes ======================================
 
 owerror_t openaes_enc(uint8_t* buffer, uint8_t* key);
+void      openaes_loadKey(uint8_t* key, uint8_t* expandedKey);
+owerror_t openaes_encExpanded(uint8_t* buffer, uint8_t* expandedKey);
 
 #endif /* __OPENAES_H__ */
@@ -80,6 +80,11 @@
 //===== sctimer scheduling
 #define TIMERTHRESHOLD                     10  
 
+//===== uart
+
+// uart_writeBufferByLen() sends a whole block, with a single TX interrupt
+#define UART_DMA_ENABLED
+
 //=========================== typedef  ========================================
 
 //=========================== variables =======================================
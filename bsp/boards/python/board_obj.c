@@ -54,6 +54,12 @@ void board_sleep(OpenMote* self) {
    printf("C@0x%x: board_sleep()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_board_sleep(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_sleep],NULL);
    if (result == NULL) {
@@ -68,19 +74,23 @@ void board_sleep(OpenMote* self) {
 }
 
 void board_reset(OpenMote* self) {
-   PyObject*   result;
+   PyObject*          result;
+   PyGILState_STATE   gilState;
    
 #ifdef TRACE_ON
    printf("C@0x%x: board_reset()... \n",self);
 #endif
    
-   // forward to Python
+   // forward to Python, taking the GIL a natively emulated mote runs without
+   gilState   = PyGILState_Ensure();
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_reset],NULL);
    if (result == NULL) {
       printf("[CRITICAL] board_reset() returned NULL\r\n");
+      PyGILState_Release(gilState);
       return;
    }
    Py_DECREF(result);
+   PyGILState_Release(gilState);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -1,5 +1,10 @@
 /**
-\brief Wrapper of software implementation of CCM.
+\brief Wrapper of software implementation of CCM, with an AES-NI backend.
+
+On x86-64 hosts whose CPU has the AES instructions, AES and CCM* are computed
+with them. The backend is selected at runtime, the first time the engine is
+used, and only if it passes a known-answer test. Otherwise, the software
+implementation of bsp/boards/common is used. Both give the same results.
 
 \author Malisa Vucinic <malishav@gmail.com>, March 2015.
 */
@@ -10,6 +15,54 @@
 #include "openccms_obj.h"
 #include "openaes_obj.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CRYPTOENGINE_AESNI
+#include <wmmintrin.h>
+#endif
+
+//=========================== defines =========================================
+
+typedef enum {
+   CRYPTOENGINE_BACKEND_NONE      = 0,   // not selected yet
+   CRYPTOENGINE_BACKEND_SOFTWARE,        // openccms and openaes
+   CRYPTOENGINE_BACKEND_AESNI,           // AES instructions of the host
+} cryptoengine_backend_t;
+
+#ifdef CRYPTOENGINE_AESNI
+
+#define AESNI_ATTR                   __attribute__((target("aes,sse2")))
+#define AESNI_NUMROUNDS              10
+#define AESNI_MAX_LEN                127     // same bound as openccms
+#define AESNI_NONCE_LEN              13
+
+// one step of the AES-128 key schedule, rcon must be a constant
+#define AESNI_EXPAND(rk,i,rcon)      rk[i] = aesni_expandStep(rk[i-1],_mm_aeskeygenassist_si128(rk[i-1],rcon))
+
+#endif
+
+//=========================== variables =======================================
+
+// a property of the host, shared by all the motes
+static cryptoengine_backend_t cryptoengine_backend = CRYPTOENGINE_BACKEND_NONE;
+
+//=========================== prototypes ======================================
+
+static cryptoengine_backend_t cryptoengine_getBackend(void);
+#ifdef CRYPTOENGINE_AESNI
+static bool      aesni_isSupported(void);
+static __m128i   aesni_expandStep(__m128i key, __m128i assist);
+static void      aesni_loadKey(const uint8_t* key, __m128i rk[AESNI_NUMROUNDS+1]);
+static __m128i   aesni_encBlock(__m128i block, const __m128i rk[AESNI_NUMROUNDS+1]);
+static void      aesni_ecb_enc(uint8_t* buffer, const uint8_t* key);
+static bool      aesni_selfTest(void);
+static __m128i   aesni_cbcMac(const uint8_t* a, uint8_t len_a, const uint8_t* m, uint8_t len_m, const uint8_t* nonce, uint8_t len_mac, const __m128i rk[AESNI_NUMROUNDS+1]);
+static __m128i   aesni_ctr(uint8_t* m, uint8_t len_m, const uint8_t* nonce, const __m128i rk[AESNI_NUMROUNDS+1]);
+static owerror_t aesni_ccms_enc(uint8_t* a, uint8_t len_a, uint8_t* m, uint8_t* len_m, uint8_t* nonce, uint8_t* key, uint8_t len_mac);
+static owerror_t aesni_ccms_dec(uint8_t* a, uint8_t len_a, uint8_t* m, uint8_t* len_m, uint8_t* nonce, uint8_t* key, uint8_t len_mac);
+#endif
+
+//=========================== public ==========================================
+
 owerror_t cryptoengine_aes_ccms_enc(OpenMote *self,
          uint8_t* a,
          uint8_t len_a,
@@ -19,7 +72,15 @@ owerror_t cryptoengine_aes_ccms_enc(OpenMote *self,
          uint8_t l,
          uint8_t key[16],
          uint8_t len_mac) {
-   
+
+#ifdef CRYPTOENGINE_AESNI
+   if (cryptoengine_getBackend()==CRYPTOENGINE_BACKEND_AESNI) {
+      if (l != 2) {
+         return E_FAIL;
+      }
+      return aesni_ccms_enc(a, len_a, m, len_m, nonce, key, len_mac);
+   }
+#endif
    return openccms_enc(self, a,len_a, m, len_m, nonce, l, key, len_mac);
 
 }
@@ -33,14 +94,290 @@ owerror_t cryptoengine_aes_ccms_dec(OpenMote* self,
          uint8_t l,
          uint8_t key[16],
          uint8_t len_mac) {
+#ifdef CRYPTOENGINE_AESNI
+    if (cryptoengine_getBackend()==CRYPTOENGINE_BACKEND_AESNI) {
+       if (l != 2) {
+          return E_FAIL;
+       }
+       return aesni_ccms_dec(a, len_a, m, len_m, nonce, key, len_mac);
+    }
+#endif
     return openccms_dec(self, a, len_a, m, len_m, nonce, l, key, len_mac);
 }
 
 owerror_t cryptoengine_aes_ecb_enc(OpenMote* self, uint8_t* buffer, uint8_t* key) {
+#ifdef CRYPTOENGINE_AESNI
+    if (cryptoengine_getBackend()==CRYPTOENGINE_BACKEND_AESNI) {
+       aesni_ecb_enc(buffer, key);
+       return E_SUCCESS;
+    }
+#endif
     return openaes_enc(self, buffer, key);
 }
 
 owerror_t cryptoengine_init(OpenMote *self) {
+    cryptoengine_getBackend();
     return E_SUCCESS;
 }
 
+//=========================== private =========================================
+
+/**
+\brief Select the backend, the first time it is called.
+
+Not every board calls cryptoengine_init(), hence the lazy selection.
+*/
+static cryptoengine_backend_t cryptoengine_getBackend(void) {
+   if (cryptoengine_backend==CRYPTOENGINE_BACKEND_NONE) {
+      cryptoengine_backend = CRYPTOENGINE_BACKEND_SOFTWARE;
+#ifdef CRYPTOENGINE_AESNI
+      if (aesni_isSupported()==TRUE && aesni_selfTest()==TRUE) {
+         cryptoengine_backend = CRYPTOENGINE_BACKEND_AESNI;
+      }
+#endif
+   }
+   return cryptoengine_backend;
+}
+
+#ifdef CRYPTOENGINE_AESNI
+
+static bool aesni_isSupported(void) {
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("aes") ? TRUE : FALSE;
+}
+
+AESNI_ATTR
+static __m128i aesni_expandStep(__m128i key, __m128i assist) {
+   assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3,3,3,3));
+   key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+   key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+   key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+   return _mm_xor_si128(key, assist);
+}
+
+/**
+\brief Expand an AES-128 key into its round keys.
+*/
+AESNI_ATTR
+static void aesni_loadKey(const uint8_t* key, __m128i rk[AESNI_NUMROUNDS+1]) {
+   rk[0] = _mm_loadu_si128((const __m128i*)key);
+   AESNI_EXPAND(rk, 1,0x01);
+   AESNI_EXPAND(rk, 2,0x02);
+   AESNI_EXPAND(rk, 3,0x04);
+   AESNI_EXPAND(rk, 4,0x08);
+   AESNI_EXPAND(rk, 5,0x10);
+   AESNI_EXPAND(rk, 6,0x20);
+   AESNI_EXPAND(rk, 7,0x40);
+   AESNI_EXPAND(rk, 8,0x80);
+   AESNI_EXPAND(rk, 9,0x1b);
+   AESNI_EXPAND(rk,10,0x36);
+}
+
+AESNI_ATTR
+static __m128i aesni_encBlock(__m128i block, const __m128i rk[AESNI_NUMROUNDS+1]) {
+   uint8_t i;
+
+   block = _mm_xor_si128(block, rk[0]);
+   for (i = 1; i < AESNI_NUMROUNDS; i++) {
+      block = _mm_aesenc_si128(block, rk[i]);
+   }
+   return _mm_aesenclast_si128(block, rk[AESNI_NUMROUNDS]);
+}
+
+AESNI_ATTR
+static void aesni_ecb_enc(uint8_t* buffer, const uint8_t* key) {
+   __m128i rk[AESNI_NUMROUNDS+1];
+
+   aesni_loadKey(key, rk);
+   _mm_storeu_si128((__m128i*)buffer, aesni_encBlock(_mm_loadu_si128((const __m128i*)buffer), rk));
+}
+
+/**
+\brief Check the AES instructions against the example vector of FIPS-197.
+*/
+static bool aesni_selfTest(void) {
+   const uint8_t key[16] = {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+   };
+   const uint8_t expected[16] = {
+      0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+   };
+   uint8_t buffer[16] = {
+      0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+   };
+
+   aesni_ecb_enc(buffer, key);
+   return memcmp(buffer, expected, 16) == 0 ? TRUE : FALSE;
+}
+
+/**
+\brief CBC-MAC of CCM*, with the same block formatting as openccms.
+
+\returns The last block of the CBC-MAC, whose first len_mac octets are the tag.
+*/
+AESNI_ATTR
+static __m128i aesni_cbcMac(const uint8_t* a,
+         uint8_t len_a,
+         const uint8_t* m,
+         uint8_t len_m,
+         const uint8_t* nonce,
+         uint8_t len_mac,
+         const __m128i rk[AESNI_NUMROUNDS+1]) {
+
+   uint8_t  block[16];
+   uint8_t  len;
+   uint8_t  i;
+   __m128i  x;
+
+   // B0: flags (1B) | nonce (13B) | len(m) (2B)
+   block[0]  = 0x01;                                  // field L, l = 2
+   block[0] |= len_mac == 0 ? 0 : (0x07 & (len_mac - 2)) << 2; // field M
+   block[0] |= len_a != 0 ? 0x40 : 0;                 // field Adata
+   memcpy(&block[1], nonce, AESNI_NONCE_LEN);
+   block[14] = 0;
+   block[15] = len_m;
+   x = aesni_encBlock(_mm_loadu_si128((const __m128i*)block), rk);
+
+   // len(a) (2B) | a, zero padded
+   if (len_a > 0) {
+      block[0] = 0;
+      block[1] = len_a;
+      len      = 2;
+      i        = 0;
+      while (i < len_a) {
+         block[len++] = a[i++];
+         if (len == 16 || i == len_a) {
+            memset(&block[len], 0, 16 - len);
+            x   = aesni_encBlock(_mm_xor_si128(x, _mm_loadu_si128((const __m128i*)block)), rk);
+            len = 0;
+         }
+      }
+   }
+
+   // m, zero padded
+   for (i = 0; i < len_m; i += 16) {
+      if (len_m - i >= 16) {
+         x = aesni_encBlock(_mm_xor_si128(x, _mm_loadu_si128((const __m128i*)&m[i])), rk);
+      } else {
+         memcpy(block, &m[i], len_m - i);
+         memset(&block[len_m - i], 0, 16 - (len_m - i));
+         x = aesni_encBlock(_mm_xor_si128(x, _mm_loadu_si128((const __m128i*)block)), rk);
+      }
+   }
+
+   return x;
+}
+
+/**
+\brief CTR encryption of CCM*, in place.
+
+\returns The key stream block of counter 0, which encrypts the tag.
+*/
+AESNI_ATTR
+static __m128i aesni_ctr(uint8_t* m,
+         uint8_t len_m,
+         const uint8_t* nonce,
+         const __m128i rk[AESNI_NUMROUNDS+1]) {
+
+   uint8_t  ctr[16];
+   uint8_t  block[16];
+   uint8_t  n;
+   uint8_t  i;
+   uint8_t  k;
+   __m128i  s;
+
+   // A_i: flags (1B) | nonce (13B) | i (2B)
+   ctr[0]  = 0x01;                                    // field L, l = 2
+   memcpy(&ctr[1], nonce, AESNI_NONCE_LEN);
+   ctr[14] = 0;
+
+   // at most 8 blocks, the counter fits in its last octet
+   n = 1;
+   for (i = 0; i < len_m; i += 16) {
+      ctr[15] = n++;
+      s = aesni_encBlock(_mm_loadu_si128((const __m128i*)ctr), rk);
+      if (len_m - i >= 16) {
+         _mm_storeu_si128((__m128i*)&m[i], _mm_xor_si128(s, _mm_loadu_si128((const __m128i*)&m[i])));
+      } else {
+         _mm_storeu_si128((__m128i*)block, s);
+         for (k = 0; k < len_m - i; k++) {
+            m[i + k] ^= block[k];
+         }
+      }
+   }
+
+   ctr[15] = 0;
+   return aesni_encBlock(_mm_loadu_si128((const __m128i*)ctr), rk);
+}
+
+/**
+\brief CCM* forward transformation with the AES instructions, see openccms_enc().
+*/
+AESNI_ATTR
+static owerror_t aesni_ccms_enc(uint8_t* a,
+         uint8_t len_a,
+         uint8_t* m,
+         uint8_t* len_m,
+         uint8_t* nonce,
+         uint8_t* key,
+         uint8_t len_mac) {
+
+   __m128i  rk[AESNI_NUMROUNDS+1];
+   __m128i  mac;
+   uint8_t  tag[16];
+
+   if (!((len_mac == 0) || (len_mac == 4) || (len_mac == 8) || (len_mac == 16))) {
+      return E_FAIL;
+   }
+   if ((len_a > AESNI_MAX_LEN) || (*len_m > AESNI_MAX_LEN) || ((len_a + *len_m) > AESNI_MAX_LEN)) {
+      return E_FAIL;
+   }
+
+   aesni_loadKey(key, rk);
+
+   mac = aesni_cbcMac(a, len_a, m, *len_m, nonce, len_mac, rk);
+   mac = _mm_xor_si128(mac, aesni_ctr(m, *len_m, nonce, rk));
+   _mm_storeu_si128((__m128i*)tag, mac);
+
+   memcpy(&m[*len_m], tag, len_mac);
+   *len_m += len_mac;
+
+   return E_SUCCESS;
+}
+
+/**
+\brief CCM* inverse transformation with the AES instructions, see openccms_dec().
+*/
+AESNI_ATTR
+static owerror_t aesni_ccms_dec(uint8_t* a,
+         uint8_t len_a,
+         uint8_t* m,
+         uint8_t* len_m,
+         uint8_t* nonce,
+         uint8_t* key,
+         uint8_t len_mac) {
+
+   __m128i  rk[AESNI_NUMROUNDS+1];
+   __m128i  mac;
+   uint8_t  tag[16];
+
+   if (!((len_mac == 0) || (len_mac == 4) || (len_mac == 8) || (len_mac == 16))) {
+      return E_FAIL;
+   }
+
+   *len_m -= len_mac;
+
+   if ((len_a > AESNI_MAX_LEN) || (*len_m > AESNI_MAX_LEN) || ((len_a + *len_m) > AESNI_MAX_LEN)) {
+      return E_FAIL;
+   }
+
+   aesni_loadKey(key, rk);
+
+   mac = aesni_ctr(m, *len_m, nonce, rk);
+   mac = _mm_xor_si128(mac, aesni_cbcMac(a, len_a, m, *len_m, nonce, len_mac, rk));
+   _mm_storeu_si128((__m128i*)tag, mac);
+
+   return memcmp(tag, &m[*len_m], len_mac) == 0 ? E_SUCCESS : E_FAIL;
+}
+
+#endif /* CRYPTOENGINE_AESNI */
@@ -21,6 +21,11 @@ void debugpins_init(OpenMote* self) {
    printf("C@0x%x: debugpins_init()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_init],NULL);
    if (result == NULL) {
@@ -41,6 +46,11 @@ void debugpins_frame_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_toggle()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_toggle],NULL);
    if (result == NULL) {
@@ -60,6 +70,11 @@ void debugpins_frame_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_clr],NULL);
    if (result == NULL) {
@@ -79,6 +94,11 @@ void debugpins_frame_set(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_set],NULL);
    if (result == NULL) {
@@ -99,6 +119,11 @@ void debugpins_slot_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_toggle()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_toggle],NULL);
    if (result == NULL) {
@@ -118,6 +143,11 @@ void debugpins_slot_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_clr],NULL);
    if (result == NULL) {
@@ -137,6 +167,11 @@ void debugpins_slot_set(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_set],NULL);
    if (result == NULL) {
@@ -157,6 +192,11 @@ void debugpins_fsm_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_toggle()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_toggle],NULL);
    if (result == NULL) {
@@ -176,6 +216,11 @@ void debugpins_fsm_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_clr],NULL);
    if (result == NULL) {
@@ -195,6 +240,11 @@ void debugpins_fsm_set(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_set],NULL);
    if (result == NULL) {
@@ -215,6 +265,11 @@ void debugpins_task_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_task_toggle(... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_toggle],NULL);
    if (result == NULL) {
@@ -234,6 +289,11 @@ void debugpins_task_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_task_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_clr],NULL);
    if (result == NULL) {
@@ -253,6 +313,11 @@ void debugpins_task_set(OpenMote* self) {
    printf("C@0x%x: debugpins_task_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_set],NULL);
    if (result == NULL) {
@@ -273,6 +338,11 @@ void debugpins_isr_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_toggle()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_toggle],NULL);
    if (result == NULL) {
@@ -292,6 +362,11 @@ void debugpins_isr_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_clr],NULL);
    if (result == NULL) {
@@ -311,6 +386,11 @@ void debugpins_isr_set(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_set],NULL);
    if (result == NULL) {
@@ -331,6 +411,11 @@ void debugpins_radio_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_toggle()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_toggle],NULL);
    if (result == NULL) {
@@ -350,6 +435,11 @@ void debugpins_radio_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_clr],NULL);
    if (result == NULL) {
@@ -369,6 +459,11 @@ void debugpins_radio_set(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_set],NULL);
    if (result == NULL) {
@@ -389,6 +484,11 @@ void debugpins_ka_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_ka_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_ka_clr],NULL);
    if (result == NULL) {
@@ -408,6 +508,11 @@ void debugpins_ka_set(OpenMote* self) {
    printf("C@0x%x: debugpins_ka_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_ka_set],NULL);
    if (result == NULL) {
@@ -428,6 +533,11 @@ void debugpins_syncPacket_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_syncPacket_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncPacket_clr],NULL);
    if (result == NULL) {
@@ -447,6 +557,11 @@ void debugpins_syncPacket_set(OpenMote* self) {
    printf("C@0x%x: debugpins_syncPacket_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncPacket_set],NULL);
    if (result == NULL) {
@@ -467,6 +582,11 @@ void debugpins_syncAck_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_syncAck_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncAck_clr],NULL);
    if (result == NULL) {
@@ -486,6 +606,11 @@ void debugpins_syncAck_set(OpenMote* self) {
    printf("C@0x%x: debugpins_syncAck_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncAck_set],NULL);
    if (result == NULL) {
@@ -506,6 +631,11 @@ void debugpins_debug_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_debug_clr()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_debug_clr],NULL);
    if (result == NULL) {
@@ -525,6 +655,11 @@ void debugpins_debug_set(OpenMote* self) {
    printf("C@0x%x: debugpins_debug_set()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_debug_set],NULL);
    if (result == NULL) {
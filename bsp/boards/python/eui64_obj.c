@@ -15,28 +15,35 @@
 //=========================== public ==========================================
 
 void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
-   PyObject*  result;
-   PyObject*  item;
-   uint8_t    i;
+   PyObject*          result;
+   PyObject*          item;
+   uint8_t            i;
+   PyGILState_STATE   gilState;
    
 #ifdef TRACE_ON
    printf("C@0x%x: eui64_get()... \n",self);
 #endif
    
-   // forward to Python
+   // forward to Python, taking the GIL a natively emulated mote runs without
+   gilState   = PyGILState_Ensure();
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_eui64_get],NULL);
    if (result == NULL) {
       printf("[CRITICAL] eui64_get() returned NULL\r\n");
+      PyGILState_Release(gilState);
       return;
    }
    
    // verify
    if (!PySequence_Check(result)) {
       printf("[CRITICAL] eui64_get() did not return a list\r\n");
+      Py_DECREF(result);
+      PyGILState_Release(gilState);
       return;
    }
    if (PyList_Size(result)!=8) {
       printf("[CRITICAL] eui64_get() did not return a list of exactly 8 elements\r\n");
+      Py_DECREF(result);
+      PyGILState_Release(gilState);
       return;
    }
 
@@ -57,6 +64,7 @@ void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
    
    // dispose of returned value
    Py_DECREF(result);
+   PyGILState_Release(gilState);
 }
 
 //=========================== private =========================================
\ No newline at end of file
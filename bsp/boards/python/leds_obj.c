@@ -22,6 +22,12 @@ void leds_init(OpenMote* self) {
    printf("C@0x%x: leds_init()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,0);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_init],NULL);
    if (result == NULL) {
@@ -42,6 +48,12 @@ void leds_error_on(OpenMote* self) {
    printf("C@0x%x: leds_error_on()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)|SIMENGINE_LED_ERROR);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_on],NULL);
    if (result == NULL) {
@@ -61,6 +73,12 @@ void leds_error_off(OpenMote* self) {
    printf("C@0x%x: leds_error_off()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)&~SIMENGINE_LED_ERROR);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_off],NULL);
    if (result == NULL) {
@@ -80,6 +98,12 @@ void leds_error_toggle(OpenMote* self) {
    printf("C@0x%x: leds_error_toggle()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)^SIMENGINE_LED_ERROR);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_toggle],NULL);
    if (result == NULL) {
@@ -100,6 +124,11 @@ uint8_t leds_error_isOn(OpenMote* self) {
    printf("C@0x%x: leds_error_isOn()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return (simengine_leds_get(self)&SIMENGINE_LED_ERROR)!=0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_isOn],NULL);
    if (result == NULL) {
@@ -122,6 +151,11 @@ void leds_error_blink(OpenMote* self) {
    printf("C@0x%x: leds_error_blink()... \n",self);
 #endif
    
+   // nothing to show when emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_blink],NULL);
    if (result == NULL) {
@@ -142,6 +176,12 @@ void leds_radio_on(OpenMote* self) {
    printf("C@0x%x: leds_radio_on()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)|SIMENGINE_LED_RADIO);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_on],NULL);
    if (result == NULL) {
@@ -161,6 +201,12 @@ void leds_radio_off(OpenMote* self) {
    printf("C@0x%x: leds_radio_off()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)&~SIMENGINE_LED_RADIO);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_off],NULL);
    if (result == NULL) {
@@ -180,6 +226,12 @@ void leds_radio_toggle(OpenMote* self) {
    printf("C@0x%x: leds_radio_toggle()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)^SIMENGINE_LED_RADIO);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_toggle],NULL);
    if (result == NULL) {
@@ -200,6 +252,11 @@ uint8_t leds_radio_isOn(OpenMote* self) {
    printf("C@0x%x: leds_radio_isOn()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return (simengine_leds_get(self)&SIMENGINE_LED_RADIO)!=0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_isOn],NULL);
    if (result == NULL) {
@@ -224,6 +281,12 @@ void leds_sync_on(OpenMote* self) {
    printf("C@0x%x: leds_sync_on()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)|SIMENGINE_LED_SYNC);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_on],NULL);
    if (result == NULL) {
@@ -243,6 +306,12 @@ void leds_sync_off(OpenMote* self) {
    printf("C@0x%x: leds_sync_off()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)&~SIMENGINE_LED_SYNC);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_off],NULL);
    if (result == NULL) {
@@ -262,6 +331,12 @@ void leds_sync_toggle(OpenMote* self) {
    printf("C@0x%x: leds_sync_toggle()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)^SIMENGINE_LED_SYNC);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_toggle],NULL);
    if (result == NULL) {
@@ -282,6 +357,11 @@ uint8_t leds_sync_isOn(OpenMote* self) {
    printf("C@0x%x: leds_sync_isOn()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return (simengine_leds_get(self)&SIMENGINE_LED_SYNC)!=0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_isOn],NULL);
    if (result == NULL) {
@@ -306,6 +386,12 @@ void leds_debug_on(OpenMote* self) {
    printf("C@0x%x: leds_debug_on()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)|SIMENGINE_LED_DEBUG);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_on],NULL);
    if (result == NULL) {
@@ -325,6 +411,12 @@ void leds_debug_off(OpenMote* self) {
    printf("C@0x%x: leds_debug_off()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)&~SIMENGINE_LED_DEBUG);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_off],NULL);
    if (result == NULL) {
@@ -344,6 +436,12 @@ void leds_debug_toggle(OpenMote* self) {
    printf("C@0x%x: leds_debug_toggle()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)^SIMENGINE_LED_DEBUG);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_toggle],NULL);
     if (result == NULL) {
@@ -364,6 +462,11 @@ uint8_t leds_debug_isOn(OpenMote* self) {
    printf("C@0x%x: leds_debug_isOn()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return (simengine_leds_get(self)&SIMENGINE_LED_DEBUG)!=0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_isOn],NULL);
    if (result == NULL) {
@@ -387,6 +490,12 @@ void leds_all_on(OpenMote* self) {
    printf("C@0x%x: leds_all_on()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,SIMENGINE_LED_ALL);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_on],NULL);
    if (result == NULL) {
@@ -406,6 +515,12 @@ void leds_all_off(OpenMote* self) {
    printf("C@0x%x: leds_all_off()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,0);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_off],NULL);
    if (result == NULL) {
@@ -425,6 +540,12 @@ void leds_all_toggle(OpenMote* self) {
    printf("C@0x%x: leds_all_toggle()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,simengine_leds_get(self)^SIMENGINE_LED_ALL);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_toggle],NULL);
    if (result == NULL) {
@@ -445,6 +566,12 @@ void leds_circular_shift(OpenMote* self) {
    printf("C@0x%x: leds_circular_shift()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,((simengine_leds_get(self)<<1)|(simengine_leds_get(self)>>3))&SIMENGINE_LED_ALL);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_circular_shift],NULL);
    if (result == NULL) {
@@ -465,6 +592,12 @@ void leds_increment(OpenMote* self) {
    printf("C@0x%x: leds_increment()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_leds_set(self,(simengine_leds_get(self)+1)&SIMENGINE_LED_ALL);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_increment],NULL);
    if (result == NULL) {
@@ -293,6 +293,57 @@ static PyObject* OpenMote_supply_off(OpenMote* self) {
    Py_RETURN_NONE;
 }
 
+//===== native event engine
+
+static PyObject* OpenMote_simengine_attach(OpenMote* self) {
+   int moteId;
+   
+   // no arguments
+   
+   moteId = simengine_attach(self);
+   if (moteId<0) {
+      PyErr_SetString(PyExc_RuntimeError, "can not attach mote to simengine");
+      return NULL;
+   }
+   
+   return PyInt_FromLong(moteId);
+}
+
+static PyObject* OpenMote_uart_read(OpenMote* self) {
+   uint8_t  buffer[SIMENGINE_UART_BUFLEN];
+   uint16_t len;
+   
+   // no arguments
+   
+   if (self->simengine==NULL) {
+      PyErr_SetString(PyExc_RuntimeError, "mote not attached to simengine");
+      return NULL;
+   }
+   
+   len = simengine_uart_drain(self,buffer,sizeof(buffer));
+   
+   return PyString_FromStringAndSize((char*)buffer,len);
+}
+
+static PyObject* OpenMote_uart_inject(OpenMote* self, PyObject* args) {
+   const char* buffer;
+   int         len;
+   
+   // parse the arguments
+   if (!PyArg_ParseTuple(args, "s#", &buffer, &len)) {
+      return NULL;
+   }
+   if (self->simengine==NULL) {
+      PyErr_SetString(PyExc_RuntimeError, "mote not attached to simengine");
+      return NULL;
+   }
+   if (len>0xffff) {
+      len = 0xffff;
+   }
+   
+   return PyInt_FromLong(simengine_uart_inject(self,(uint8_t*)buffer,(uint16_t)len));
+}
+
 //===== admin
 
 /*
@@ -311,6 +362,10 @@ static PyMethodDef OpenMote_methods[] = {
    {  "uart_isr_rx",              (PyCFunction)OpenMote_uart_isr_rx,                METH_NOARGS,   ""},
    {  "supply_on",                (PyCFunction)OpenMote_supply_on,                  METH_NOARGS,   ""},
    {  "supply_off",               (PyCFunction)OpenMote_supply_off,                 METH_NOARGS,   ""},
+   //=== native event engine
+   {  "simengine_attach",         (PyCFunction)OpenMote_simengine_attach,           METH_NOARGS,   ""},
+   {  "uart_read",                (PyCFunction)OpenMote_uart_read,                  METH_NOARGS,   ""},
+   {  "uart_inject",              (PyCFunction)OpenMote_uart_inject,                METH_VARARGS,  ""},
    {NULL} // sentinel
 };
 
@@ -375,9 +430,102 @@ static PyTypeObject openwsn_OpenMoteType = {
 
 //===== methods
 
+static PyObject* openwsn_simengine_seed(PyObject* self, PyObject* args) {
+   unsigned int seed;
+   
+   // parse the arguments
+   if (!PyArg_ParseTuple(args, "I", &seed)) {
+      return NULL;
+   }
+   
+   simengine_seed(seed);
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* openwsn_simengine_setLink(PyObject* self, PyObject* args) {
+   int    src;
+   int    dst;
+   double pdr;
+   int    rssi;
+   
+   // parse the arguments
+   if (!PyArg_ParseTuple(args, "iidi", &src, &dst, &pdr, &rssi)) {
+      return NULL;
+   }
+   if (src<0 || dst<0 || pdr<0 || pdr>1 || rssi<-128 || rssi>127) {
+      PyErr_SetString(PyExc_ValueError, "wrong link");
+      return NULL;
+   }
+   
+   if (simengine_setLink(src,dst,(uint32_t)(pdr*SIMENGINE_PDR_ONE),(int8_t)rssi)!=0) {
+      PyErr_SetString(PyExc_ValueError, "unknown mote");
+      return NULL;
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* openwsn_simengine_run(PyObject* self, PyObject* args) {
+   double   duration;
+   int      numThreads;
+   uint32_t numEvents;
+   
+   // parse the arguments
+   numThreads = 1;
+   if (!PyArg_ParseTuple(args, "d|i", &duration, &numThreads)) {
+      return NULL;
+   }
+   if (duration<0) {
+      PyErr_SetString(PyExc_ValueError, "duration must be positive");
+      return NULL;
+   }
+   if (numThreads<1 || numThreads>SIMENGINE_MAXTHREADS) {
+      PyErr_SetString(PyExc_ValueError, "number of threads out of range");
+      return NULL;
+   }
+   
+   numEvents = simengine_run((uint64_t)(duration*SIMENGINE_TICKS_PER_S),(uint8_t)numThreads);
+   
+   return PyLong_FromUnsignedLong(numEvents);
+}
+
+static PyObject* openwsn_simengine_getTime(PyObject* self) {
+   
+   // no arguments
+   
+   return PyFloat_FromDouble((double)simengine_getTime()/SIMENGINE_TICKS_PER_S);
+}
+
+static PyObject* openwsn_simengine_getStats(PyObject* self) {
+   simengine_stats_t stats;
+   
+   // no arguments
+   
+   simengine_getStats(&stats);
+   
+   return Py_BuildValue(
+      "{s:k,s:k,s:k,s:k,s:k,s:k,s:k}",
+      "numEvents",        (unsigned long)stats.numEvents,
+      "numWindows",       (unsigned long)stats.numWindows,
+      "numFramesTx",      (unsigned long)stats.numFramesTx,
+      "numFramesRx",      (unsigned long)stats.numFramesRx,
+      "numFramesLost",    (unsigned long)stats.numFramesLost,
+      "numCollisions",    (unsigned long)stats.numCollisions,
+      "numUartOverflows", (unsigned long)stats.numUartOverflows
+   );
+}
+
 //===== admin
 
 static PyMethodDef openwsn_methods[] = {
+   // name                        function                                          flags          doc
+   //=== native event engine
+   {  "simengine_seed",           (PyCFunction)openwsn_simengine_seed,              METH_VARARGS,  ""},
+   {  "simengine_setLink",        (PyCFunction)openwsn_simengine_setLink,           METH_VARARGS,  ""},
+   {  "simengine_run",            (PyCFunction)openwsn_simengine_run,               METH_VARARGS,  ""},
+   {  "simengine_getTime",        (PyCFunction)openwsn_simengine_getTime,           METH_NOARGS,   ""},
+   {  "simengine_getStats",       (PyCFunction)openwsn_simengine_getStats,          METH_NOARGS,   ""},
    {NULL, NULL, 0, NULL} // sentinel
 };
 
@@ -12,6 +12,7 @@
 #include "structmember.h"
 // OpenWSN
 #include "openserial_obj.h"
+#include "opentelemetry_obj.h"
 #include "opentimers_obj.h"
 #include "scheduler_obj.h"
 #include "IEEE802154E_obj.h"
@@ -45,7 +46,12 @@
 #include "rrt_obj.h"
 #include "uecho_obj.h"
 #include "uinject_obj.h"
+#include "uexpiration_obj.h"
 #include "userialbridge_obj.h"
+// bsp
+#include "openaes_obj.h"
+// native event engine
+#include "simengine.h"
 
 //=========================== prototypes ======================================
 
@@ -197,12 +203,17 @@ struct OpenMote {
    uart_icb_t           uart_icb;
    sctimer_icb_t        sctimer_icb;
    radio_icb_t          radio_icb;
+   //===== native event engine, NULL when the BSP is emulated in Python
+   simengine_mote_t*    simengine;
+   //===== bsp
+   openaes_vars_t       openaes_vars;
    //===== openstack
    // l4
    icmpv6echo_vars_t    icmpv6echo_vars;
    icmpv6rpl_vars_t     icmpv6rpl_vars;
    openudp_vars_t       openudp_vars;
    // l3
+   iphc_vars_t          iphc_vars;
 #ifndef DO_NOT_USE_FRAGMENTATION
    fragmentqueue_vars_t fragmentqueue_vars;
 #endif
@@ -228,6 +239,7 @@ struct OpenMote {
    opentimers_vars_t    opentimers_vars;
    random_vars_t        random_vars;
    openserial_vars_t    openserial_vars;
+   opentelemetry_vars_t opentelemetry_vars;
    // kernel
    scheduler_vars_t     scheduler_vars;
    scheduler_dbg_t      scheduler_dbg;
@@ -246,6 +258,7 @@ struct OpenMote {
    cjoin_vars_t         cjoin_vars;
    uecho_vars_t         uecho_vars;
    uinject_vars_t       uinject_vars;
+   uexpiration_vars_t   uexpiration_vars;
    userialbridge_vars_t userialbridge_vars;
 };
 
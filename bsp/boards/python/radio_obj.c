@@ -50,6 +50,12 @@ void radio_init(OpenMote* self) {
    printf("C@0x%x: radio_init()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_reset(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_init],NULL);
    if (result == NULL) {
@@ -72,6 +78,12 @@ void radio_reset(OpenMote* self) {
    printf("C@0x%x: radio_reset()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_reset(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_reset],NULL);
    if (result == NULL) {
@@ -95,6 +107,12 @@ void radio_setFrequency(OpenMote* self, uint8_t frequency) {
    printf("C@0x%x: radio_setFrequency(frequency=%d)... \n",self,frequency);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_setFrequency(self,frequency);
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",frequency);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_setFrequency],arglist);
@@ -117,6 +135,11 @@ void radio_rfOn(OpenMote* self) {
    printf("C@0x%x: radio_rfOn()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOn],NULL);
    if (result == NULL) {
@@ -137,6 +160,12 @@ void radio_rfOff(OpenMote* self) {
    printf("C@0x%x: radio_rfOff()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_rfOff(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOff],NULL);
    if (result == NULL) {
@@ -164,6 +193,12 @@ void radio_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len) {
    printf("C@0x%x: radio_loadPacket(len=%d)... \n",self,len);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_loadPacket(self,packet,len);
+      return;
+   }
+   
    // forward to Python
    pkt        = PyList_New(len);
    for (i=0;i<len;i++) {
@@ -192,6 +227,12 @@ void radio_txEnable(OpenMote* self) {
    printf("C@0x%x: radio_txEnable()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_txEnable(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txEnable],NULL);
    if (result == NULL) {
@@ -212,6 +253,12 @@ void radio_txNow(OpenMote* self) {
    printf("C@0x%x: radio_txNow()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_txNow(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txNow],NULL);
    if (result == NULL) {
@@ -234,6 +281,12 @@ void radio_rxEnable(OpenMote* self) {
    printf("C@0x%x: radio_rxEnable()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_rxEnable(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxEnable],NULL);
    if (result == NULL) {
@@ -254,6 +307,12 @@ void radio_rxNow(OpenMote* self) {
    printf("C@0x%x: radio_rxNow()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_rxEnable(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxNow],NULL);
    if (result == NULL) {
@@ -284,6 +343,12 @@ void radio_getReceivedFrame(OpenMote* self,
    printf("C@0x%x: radio_getReceivedFrame()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_radio_getReceivedFrame(self,pBufRead,pLenRead,maxBufLen,pRssi,pLqi,pCrc);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getReceivedFrame],NULL);
    if (result == NULL) {
@@ -36,6 +36,11 @@ void sctimer_init(OpenMote* self) {
    printf("C@0x%x: sctimer_init()... \n",self,self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_init],NULL);
    if (result == NULL) {
@@ -59,6 +64,11 @@ PORT_RADIOTIMER_WIDTH sctimer_readCounter(OpenMote* self) {
    printf("C@0x%x: sctimer_readCounter()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return simengine_sctimer_readCounter(self);
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_readCounter],NULL);
    if (result == NULL) {
@@ -85,6 +95,12 @@ void sctimer_setCompare(OpenMote* self, PORT_RADIOTIMER_WIDTH value) {
    printf("C@0x%x: sctimer_setCompare(value=%d)... \n",self,value);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_sctimer_setCompare(self,value);
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",value);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_setCompare],arglist);
@@ -107,6 +123,12 @@ void sctimer_enable(OpenMote* self) {
    printf("C@0x%x: sctimer_enable()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_sctimer_enable(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_enable],NULL);
    if (result == NULL) {
@@ -127,6 +149,12 @@ void sctimer_disable(OpenMote* self) {
    printf("C@0x%x: sctimer_disable()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_sctimer_disable(self);
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_sctimer_disable],NULL);
    if (result == NULL) {
@@ -0,0 +1,1066 @@
+/**
+\brief Native event engine for the Python board.
+
+Each mote runs its firmware in its own thread, as it does when its BSP is
+emulated in Python. The engine hands the CPU to a mote when it has an
+interrupt for it: it delivers the interrupt, wakes the mote up, and waits for
+it to go back to sleep in board_sleep(). A mote drops the GIL the first time
+it sleeps, its firmware only runs C from then on.
+
+The motes are spread over partitions, one per worker thread, each with its own
+event queue and clock. Partitions only interact through the radio, and a frame
+is committed PORT_delayTx ticks before it is on the air: all partitions can
+therefore run the events up to PORT_delayTx past the earliest pending one
+before they have to exchange the frames they sent. The sequence number of an
+event comes from the mote which scheduled it, so that a run does not depend on
+the number of threads it is spread over.
+*/
+
+#include <Python.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "simengine.h"
+#include "openwsnmodule_obj.h"
+#include "radio_obj.h"
+
+//=========================== defines =========================================
+
+#define SIMENGINE_EVENTS_INIT     256
+#define SIMENGINE_SEQ_SHIFT       16     // the low bits of a sequence number hold the mote's id
+#define SIMENGINE_SEED_DEFAULT    0x2545f491
+
+typedef struct {
+   uint32_t             refs;               // receivers which have not processed the frame yet
+   uint8_t              len;
+   uint8_t              buf[SIMENGINE_RADIO_BUFLEN];
+} simengine_frame_t;
+
+typedef struct {
+   uint64_t             time;               // when the event happens, in ticks
+   uint64_t             seq;                // events at the same time are dispatched in order
+   simengine_frame_t*   frame;              // RX_START only, the frame reaching the antenna
+   uint32_t             gen;                // generation of the mote's timer or radio it was scheduled in
+   uint32_t             pdr;                // RX_START only, PDR of the link
+   uint16_t             moteId;             // mote the event is for
+   uint8_t              type;               // one of simengine_event_type_t
+   uint8_t              frequency;          // RX_START only, frequency the frame is sent on
+   int8_t               rssi;               // RX_START only, RSSI of the link
+} simengine_event_t;
+
+typedef struct {
+   simengine_event_t*   events;
+   uint32_t             numEvents;
+   uint32_t             maxEvents;
+} simengine_queue_t;
+
+typedef struct {
+   simengine_queue_t    events;             // min-heap on (time,seq)
+   simengine_queue_t    outbox;             // frames for the motes of other partitions, until the end of the window
+   uint64_t             now;                // current time of the partition, in ticks
+   simengine_stats_t    stats;
+   pthread_t            thread;
+   bool                 hasThread;          // a worker thread runs the partition, rather than the caller of simengine_run
+   sem_t                start;              // posted by the caller of simengine_run to start a window
+} simengine_partition_t;
+
+typedef struct {
+   uint16_t             dst;                // receiving mote
+   uint32_t             pdr;                // packet delivery ratio, SIMENGINE_PDR_ONE being 100%
+   int8_t               rssi;               // RSSI at the receiver, in dBm
+} simengine_link_t;
+
+struct simengine_mote_t {
+   OpenMote*              mote;
+   uint16_t               id;
+   simengine_partition_t* partition;        // partition the mote runs in
+   uint64_t               seq;              // sequence number of the next event the mote schedules
+   uint32_t               random;           // xorshift32 state
+   // CPU hand-over
+   sem_t                  awake;            // posted by the engine to run the mote
+   sem_t                  asleep;           // posted by the mote when it goes to sleep
+   bool                   running;          // the mote is running, the engine waits for it before delivering an interrupt
+   PyThreadState*         threadState;      // the mote's thread, once it has dropped the GIL
+   // leds
+   uint8_t                leds;
+   // sctimer
+   uint32_t               timerGen;         // bumped to invalidate the pending compare event
+   // radio
+   radio_state_t          radioState;
+   uint8_t                frequency;
+   uint32_t               radioGen;         // bumped to invalidate the pending radio events
+   uint8_t                txBuf[SIMENGINE_RADIO_BUFLEN];
+   uint8_t                txLen;
+   uint64_t               txEnd;            // end of the frame being transmitted
+   uint8_t                rxBuf[SIMENGINE_RADIO_BUFLEN];
+   uint8_t                rxLen;
+   int8_t                 rxRssi;
+   bool                   rxCrc;
+   uint64_t               rxEnd;            // end of the frame being received
+   simengine_link_t*      links;            // outgoing links, grown on demand
+   uint16_t               numLinks;
+   uint16_t               maxLinks;
+   // uart
+   uint8_t                uartTxBuf[SIMENGINE_UART_BUFLEN];
+   uint16_t               uartTxR;
+   uint16_t               uartTxW;
+   uint8_t                uartRxBuf[SIMENGINE_UART_BUFLEN];
+   uint16_t               uartRxR;
+   uint16_t               uartRxW;
+   uint16_t               uartRxScheduled;  // injected bytes already handed to the mote as interrupts
+};
+
+typedef struct {
+   simengine_mote_t*     motes[SIMENGINE_MAXMOTES];
+   uint16_t              numMotes;
+   uint64_t              now;               // time at the end of the last run, in ticks
+   uint32_t              seed;
+   simengine_partition_t partitions[SIMENGINE_MAXTHREADS];
+   uint8_t               numPartitions;     // 0 when the motes have to be spread again
+   uint64_t              windowEnd;         // the partitions run their events up to here before exchanging frames
+   bool                  stopping;          // the worker threads exit at the start of the next window
+   sem_t                 done;              // posted by a worker thread at the end of a window
+   simengine_stats_t     stats;             // what is not accounted for by a partition
+} simengine_vars_t;
+
+//=========================== variables =======================================
+
+// shared by all the motes of this process
+simengine_vars_t simengine_vars = {
+   .seed = SIMENGINE_SEED_DEFAULT,
+};
+
+//=========================== prototypes ======================================
+
+// partitions
+void     simengine_partition(uint8_t numPartitions);
+void     simengine_runParallel(uint64_t end);
+void*    simengine_worker(void* arg);
+void     simengine_runWindow(simengine_partition_t* p, uint64_t windowEnd);
+void     simengine_exchange(void);
+bool     simengine_nextTime(uint64_t* time);
+uint32_t simengine_countEvents(void);
+// events
+void     simengine_schedule(simengine_mote_t* m, uint64_t time, uint8_t type, uint32_t gen);
+void     simengine_sendFrame(simengine_mote_t* m, simengine_link_t* link, uint64_t time, simengine_frame_t* frame);
+bool     simengine_grow(simengine_queue_t* q);
+void     simengine_push(simengine_queue_t* q, simengine_event_t* event);
+bool     simengine_pop(simengine_queue_t* q, simengine_event_t* event);
+bool     simengine_isBefore(simengine_event_t* a, simengine_event_t* b);
+bool     simengine_isStale(simengine_mote_t* m, simengine_event_t* event);
+bool     simengine_dispatch(simengine_mote_t* m, simengine_event_t* event);
+bool     simengine_receive(simengine_mote_t* m, simengine_event_t* event);
+void     simengine_waitAsleep(simengine_mote_t* m);
+uint64_t simengine_frameDuration(uint8_t len);
+uint32_t simengine_moteSeed(uint16_t id);
+uint32_t simengine_rand(simengine_mote_t* m);
+
+//=========================== admin ===========================================
+
+/**
+\brief Attach a mote to the engine.
+
+Must be called before the mote is switched on. From then on, its radio,
+sctimer, UART, leds and debugpins are emulated natively.
+
+\returns the id of the mote in the engine, -1 if it can not be attached.
+*/
+int simengine_attach(OpenMote* self) {
+   simengine_mote_t* m;
+
+   if (self->simengine!=NULL) {
+      return self->simengine->id;
+   }
+   if (simengine_vars.numMotes>=SIMENGINE_MAXMOTES) {
+      return -1;
+   }
+   m = calloc(1,sizeof(simengine_mote_t));
+   if (m==NULL) {
+      return -1;
+   }
+   if (sem_init(&m->awake,0,0)!=0 || sem_init(&m->asleep,0,0)!=0) {
+      free(m);
+      return -1;
+   }
+   m->mote        = self;
+   m->id          = simengine_vars.numMotes;
+   m->random      = simengine_moteSeed(m->id);
+   m->radioState  = RADIOSTATE_STOPPED;
+   // the mote boots as soon as it is switched on, until its first sleep
+   m->running     = TRUE;
+
+   // the mote boots in the first partition, the next run spreads the motes again
+   m->partition   = &simengine_vars.partitions[0];
+   simengine_vars.numPartitions = 0;
+
+   simengine_vars.motes[simengine_vars.numMotes++] = m;
+   self->simengine = m;
+   return m->id;
+}
+
+void simengine_seed(uint32_t seed) {
+   uint16_t i;
+
+   simengine_vars.seed = seed;
+   for (i=0;i<simengine_vars.numMotes;i++) {
+      simengine_vars.motes[i]->random = simengine_moteSeed(i);
+   }
+}
+
+/**
+\brief Set the link from mote src to mote dst.
+
+\param[in] pdr  packet delivery ratio, SIMENGINE_PDR_ONE being 100%. 0 removes
+   the link.
+\param[in] rssi RSSI dst receives src's frames with.
+
+\returns 0 on success, -1 if a mote does not exist or memory is exhausted.
+*/
+int simengine_setLink(uint16_t src, uint16_t dst, uint32_t pdr, int8_t rssi) {
+   simengine_mote_t* m;
+   simengine_link_t* links;
+   uint16_t          i;
+
+   if (src>=simengine_vars.numMotes || dst>=simengine_vars.numMotes) {
+      return -1;
+   }
+   m = simengine_vars.motes[src];
+
+   for (i=0;i<m->numLinks;i++) {
+      if (m->links[i].dst==dst) {
+         break;
+      }
+   }
+   if (pdr==0) {
+      if (i<m->numLinks) {
+         m->links[i] = m->links[--m->numLinks];
+      }
+      return 0;
+   }
+   if (i==m->numLinks) {
+      if (m->numLinks==m->maxLinks) {
+         links = realloc(m->links,(m->maxLinks+8)*sizeof(simengine_link_t));
+         if (links==NULL) {
+            return -1;
+         }
+         m->links     = links;
+         m->maxLinks += 8;
+      }
+      m->numLinks++;
+   }
+   m->links[i].dst  = dst;
+   m->links[i].pdr  = pdr>SIMENGINE_PDR_ONE ? SIMENGINE_PDR_ONE : pdr;
+   m->links[i].rssi = rssi;
+   return 0;
+}
+
+/**
+\brief Run the simulation for the given number of ticks.
+
+Must be called from a Python thread, with the GIL held, while the attached
+motes are switched on in threads of their own. The GIL is released during the
+run, but none of the other functions of the engine may be called before it
+returns.
+
+\param[in] numThreads number of threads to spread the motes over. 1 runs them
+   all in the calling thread.
+
+\returns the number of events dispatched.
+*/
+uint32_t simengine_run(uint64_t duration, uint8_t numThreads) {
+   uint64_t end;
+   uint32_t numEvents;
+   uint16_t i;
+   uint8_t  p;
+
+   if (numThreads>SIMENGINE_MAXTHREADS) {
+      numThreads = SIMENGINE_MAXTHREADS;
+   }
+   if (numThreads>simengine_vars.numMotes) {
+      numThreads = simengine_vars.numMotes;
+   }
+   if (numThreads==0) {
+      numThreads = 1;
+   }
+
+   end       = simengine_vars.now+duration;
+   numEvents = simengine_countEvents();
+
+   Py_BEGIN_ALLOW_THREADS
+
+   // let the motes which are still booting reach their first sleep, so they
+   // have scheduled their first events
+   for (i=0;i<simengine_vars.numMotes;i++) {
+      simengine_waitAsleep(simengine_vars.motes[i]);
+   }
+
+   if (numThreads!=simengine_vars.numPartitions) {
+      simengine_partition(numThreads);
+   }
+   if (numThreads==1) {
+      simengine_runWindow(&simengine_vars.partitions[0],end+1);
+   } else {
+      simengine_runParallel(end);
+   }
+
+   Py_END_ALLOW_THREADS
+
+   for (p=0;p<SIMENGINE_MAXTHREADS;p++) {
+      simengine_vars.partitions[p].now = end;
+   }
+   simengine_vars.now = end;
+
+   return simengine_countEvents()-numEvents;
+}
+
+uint64_t simengine_getTime(void) {
+   return simengine_vars.now;
+}
+
+void simengine_getStats(simengine_stats_t* stats) {
+   simengine_stats_t* s;
+   uint8_t            p;
+
+   memcpy(stats,&simengine_vars.stats,sizeof(simengine_stats_t));
+   for (p=0;p<SIMENGINE_MAXTHREADS;p++) {
+      s = &simengine_vars.partitions[p].stats;
+      stats->numEvents         += s->numEvents;
+      stats->numFramesTx       += s->numFramesTx;
+      stats->numFramesRx       += s->numFramesRx;
+      stats->numFramesLost     += s->numFramesLost;
+      stats->numCollisions     += s->numCollisions;
+      stats->numUartOverflows  += s->numUartOverflows;
+   }
+}
+
+//=========================== board ===========================================
+
+void simengine_board_sleep(OpenMote* self) {
+   simengine_mote_t* m;
+
+   m = self->simengine;
+
+   // the firmware only runs C from now on, the GIL is left to Python
+   if (m->threadState==NULL) {
+      m->threadState = PyEval_SaveThread();
+   }
+
+   // hand the CPU back to the engine, until it has an interrupt for this mote
+   sem_post(&m->asleep);
+   sem_wait(&m->awake);
+}
+
+//=========================== leds ============================================
+
+uint8_t simengine_leds_get(OpenMote* self) {
+   return self->simengine->leds;
+}
+
+void simengine_leds_set(OpenMote* self, uint8_t leds) {
+   self->simengine->leds = leds;
+}
+
+//=========================== sctimer =========================================
+
+PORT_TIMER_WIDTH simengine_sctimer_readCounter(OpenMote* self) {
+   return (PORT_TIMER_WIDTH)self->simengine->partition->now;
+}
+
+void simengine_sctimer_setCompare(OpenMote* self, PORT_TIMER_WIDTH value) {
+   simengine_mote_t* m;
+   uint64_t          now;
+   int32_t           delay;
+
+   m   = self->simengine;
+   now = m->partition->now;
+
+   // a compare value in the past fires right away, as on the real boards
+   delay = (int32_t)(value-(PORT_TIMER_WIDTH)now);
+   if (delay<0) {
+      delay = 0;
+   }
+   m->timerGen++;
+   simengine_schedule(m,now+delay,SIMENGINE_EVT_SCTIMER,m->timerGen);
+}
+
+void simengine_sctimer_enable(OpenMote* self) {
+   // the compare interrupt is armed by simengine_sctimer_setCompare
+}
+
+void simengine_sctimer_disable(OpenMote* self) {
+   self->simengine->timerGen++;
+}
+
+//=========================== radio ===========================================
+
+void simengine_radio_reset(OpenMote* self) {
+   simengine_mote_t* m;
+
+   m = self->simengine;
+   m->radioGen++;
+   m->radioState  = RADIOSTATE_RFOFF;
+}
+
+void simengine_radio_setFrequency(OpenMote* self, uint8_t frequency) {
+   simengine_mote_t* m;
+
+   m = self->simengine;
+   m->frequency   = frequency;
+   m->radioState  = RADIOSTATE_FREQUENCY_SET;
+}
+
+void simengine_radio_rfOff(OpenMote* self) {
+   simengine_mote_t* m;
+
+   m = self->simengine;
+   // drop the frame being sent or received
+   m->radioGen++;
+   m->radioState  = RADIOSTATE_RFOFF;
+}
+
+void simengine_radio_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len) {
+   simengine_mote_t* m;
+
+   m = self->simengine;
+   if (len>SIMENGINE_RADIO_BUFLEN) {
+      len = SIMENGINE_RADIO_BUFLEN;
+   }
+   memcpy(m->txBuf,packet,len);
+   m->txLen       = len;
+   m->radioState  = RADIOSTATE_PACKET_LOADED;
+}
+
+void simengine_radio_txEnable(OpenMote* self) {
+   self->simengine->radioState = RADIOSTATE_TX_ENABLED;
+}
+
+/**
+\brief Start sending the loaded frame.
+
+It goes on the air PORT_delayTx ticks later, but the neighbors get it right
+away, as this is what lets the partitions run ahead of each other. Turning the
+radio off before then only cuts the start and end of frame interrupts.
+*/
+void simengine_radio_txNow(OpenMote* self) {
+   simengine_mote_t*  m;
+   simengine_frame_t* frame;
+   uint64_t           start;
+   uint16_t           i;
+
+   m = self->simengine;
+   m->radioState  = RADIOSTATE_TRANSMITTING;
+   start = m->partition->now+PORT_delayTx;
+   simengine_schedule(m,start,SIMENGINE_EVT_TX_START,m->radioGen);
+   m->partition->stats.numFramesTx++;
+
+   if (m->numLinks==0) {
+      return;
+   }
+   frame = malloc(sizeof(simengine_frame_t));
+   if (frame==NULL) {
+      printf("[CRITICAL] simengine can not allocate a frame\r\n");
+      return;
+   }
+   frame->refs = m->numLinks;
+   frame->len  = m->txLen;
+   memcpy(frame->buf,m->txBuf,m->txLen);
+   for (i=0;i<m->numLinks;i++) {
+      simengine_sendFrame(m,&m->links[i],start,frame);
+   }
+}
+
+void simengine_radio_rxEnable(OpenMote* self) {
+   // the radio listens as soon as RX is enabled, rxNow has nothing left to do
+   self->simengine->radioState = RADIOSTATE_LISTENING;
+}
+
+void simengine_radio_getReceivedFrame(OpenMote* self,
+                                      uint8_t* pBufRead,
+                                      uint8_t* pLenRead,
+                                      uint8_t  maxBufLen,
+                                       int8_t* pRssi,
+                                      uint8_t* pLqi,
+                                         bool* pCrc) {
+   simengine_mote_t* m;
+   uint8_t           len;
+
+   m = self->simengine;
+   len = m->rxLen<maxBufLen ? m->rxLen : maxBufLen;
+   memcpy(pBufRead,m->rxBuf,len);
+   *pLenRead      = len;
+   *pRssi         = m->rxRssi;
+   *pLqi          = SIMENGINE_LQI;
+   *pCrc          = m->rxCrc;
+}
+
+//=========================== uart ============================================
+
+/**
+\brief The mote writes bytes to its UART.
+
+The bytes are kept until Python drains them, and a TX interrupt follows once
+they are out.
+
+\param[in] requestInput the mote is asking for input, release the bytes
+   Python injected to it.
+*/
+void simengine_uart_write(OpenMote* self, uint8_t* buffer, uint16_t len, bool requestInput) {
+   simengine_mote_t* m;
+   uint16_t          i;
+   uint64_t          time;
+
+   m = self->simengine;
+   for (i=0;i<len;i++) {
+      if ((uint16_t)(m->uartTxW+1)%SIMENGINE_UART_BUFLEN==m->uartTxR) {
+         m->partition->stats.numUartOverflows += len-i;
+         break;
+      }
+      m->uartTxBuf[m->uartTxW] = buffer[i];
+      m->uartTxW = (m->uartTxW+1)%SIMENGINE_UART_BUFLEN;
+   }
+   time = m->partition->now+len*SIMENGINE_UART_BYTE_TICKS;
+   simengine_schedule(m,time,SIMENGINE_EVT_UART_TX,0);
+
+   if (requestInput) {
+      while (m->uartRxScheduled<(uint16_t)(m->uartRxW-m->uartRxR+SIMENGINE_UART_BUFLEN)%SIMENGINE_UART_BUFLEN) {
+         m->uartRxScheduled++;
+         time += SIMENGINE_UART_BYTE_TICKS;
+         simengine_schedule(m,time,SIMENGINE_EVT_UART_RX,0);
+      }
+   }
+}
+
+uint8_t simengine_uart_readByte(OpenMote* self) {
+   simengine_mote_t* m;
+   uint8_t           byte;
+
+   m = self->simengine;
+   if (m->uartRxR==m->uartRxW) {
+      return 0;
+   }
+   byte = m->uartRxBuf[m->uartRxR];
+   m->uartRxR = (m->uartRxR+1)%SIMENGINE_UART_BUFLEN;
+   if (m->uartRxScheduled>0) {
+      m->uartRxScheduled--;
+   }
+   return byte;
+}
+
+/**
+\brief Python takes the bytes the mote wrote to its UART.
+
+\returns the number of bytes copied into buffer.
+*/
+uint16_t simengine_uart_drain(OpenMote* self, uint8_t* buffer, uint16_t maxLen) {
+   simengine_mote_t* m;
+   uint16_t          len;
+
+   m = self->simengine;
+   len = 0;
+   while (m->uartTxR!=m->uartTxW && len<maxLen) {
+      buffer[len++] = m->uartTxBuf[m->uartTxR];
+      m->uartTxR = (m->uartTxR+1)%SIMENGINE_UART_BUFLEN;
+   }
+   return len;
+}
+
+/**
+\brief Python sends bytes to the mote's UART.
+
+They are delivered when the mote next asks for input.
+
+\returns the number of bytes accepted.
+*/
+uint16_t simengine_uart_inject(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   simengine_mote_t* m;
+   uint16_t          i;
+
+   m = self->simengine;
+   for (i=0;i<len;i++) {
+      if ((uint16_t)(m->uartRxW+1)%SIMENGINE_UART_BUFLEN==m->uartRxR) {
+         simengine_vars.stats.numUartOverflows += len-i;
+         break;
+      }
+      m->uartRxBuf[m->uartRxW] = buffer[i];
+      m->uartRxW = (m->uartRxW+1)%SIMENGINE_UART_BUFLEN;
+   }
+   return i;
+}
+
+//=========================== private =========================================
+
+//===== partitions
+
+/**
+\brief Spread the motes over the given number of partitions.
+
+Neighbors are usually attached one after the other, contiguous blocks of motes
+keep most of their frames inside a partition.
+*/
+void simengine_partition(uint8_t numPartitions) {
+   simengine_queue_t old[SIMENGINE_MAXTHREADS];
+   simengine_event_t* event;
+   uint32_t           j;
+   uint16_t           i;
+   uint8_t            p;
+
+   // take the pending events out of their partitions
+   for (p=0;p<SIMENGINE_MAXTHREADS;p++) {
+      old[p] = simengine_vars.partitions[p].events;
+      memset(&simengine_vars.partitions[p].events,0,sizeof(simengine_queue_t));
+   }
+
+   for (i=0;i<simengine_vars.numMotes;i++) {
+      p = (uint32_t)i*numPartitions/simengine_vars.numMotes;
+      simengine_vars.motes[i]->partition = &simengine_vars.partitions[p];
+   }
+
+   // and put them back into the partition of their mote
+   for (p=0;p<SIMENGINE_MAXTHREADS;p++) {
+      for (j=0;j<old[p].numEvents;j++) {
+         event = &old[p].events[j];
+         simengine_push(&simengine_vars.motes[event->moteId]->partition->events,event);
+      }
+      free(old[p].events);
+   }
+
+   simengine_vars.numPartitions = numPartitions;
+}
+
+/**
+\brief Run the partitions in parallel until the given time.
+
+Each window runs the events up to PORT_delayTx past the earliest pending one:
+no frame sent in the window can reach a mote before its end.
+*/
+void simengine_runParallel(uint64_t end) {
+   simengine_partition_t* p;
+   uint64_t               next;
+   uint8_t                numWorkers;
+   uint8_t                i;
+
+   sem_init(&simengine_vars.done,0,0);
+   simengine_vars.stopping = FALSE;
+   numWorkers = 0;
+   for (i=0;i<simengine_vars.numPartitions;i++) {
+      p = &simengine_vars.partitions[i];
+      sem_init(&p->start,0,0);
+      p->hasThread = pthread_create(&p->thread,NULL,simengine_worker,p)==0;
+      if (p->hasThread) {
+         numWorkers++;
+      } else {
+         // this thread runs the partition itself
+         printf("[CRITICAL] simengine can not start a worker thread\r\n");
+      }
+   }
+
+   while (simengine_nextTime(&next) && next<=end) {
+      simengine_vars.windowEnd = next+PORT_delayTx;
+      if (simengine_vars.windowEnd>end+1) {
+         simengine_vars.windowEnd = end+1;
+      }
+      simengine_vars.stats.numWindows++;
+
+      for (i=0;i<simengine_vars.numPartitions;i++) {
+         p = &simengine_vars.partitions[i];
+         if (p->hasThread) {
+            sem_post(&p->start);
+         }
+      }
+      for (i=0;i<simengine_vars.numPartitions;i++) {
+         p = &simengine_vars.partitions[i];
+         if (p->hasThread==FALSE) {
+            simengine_runWindow(p,simengine_vars.windowEnd);
+         }
+      }
+      for (i=0;i<numWorkers;i++) {
+         sem_wait(&simengine_vars.done);
+      }
+
+      simengine_exchange();
+   }
+
+   simengine_vars.stopping = TRUE;
+   for (i=0;i<simengine_vars.numPartitions;i++) {
+      p = &simengine_vars.partitions[i];
+      if (p->hasThread) {
+         sem_post(&p->start);
+         pthread_join(p->thread,NULL);
+      }
+      sem_destroy(&p->start);
+   }
+   sem_destroy(&simengine_vars.done);
+}
+
+void* simengine_worker(void* arg) {
+   simengine_partition_t* p;
+
+   p = arg;
+   while (1) {
+      sem_wait(&p->start);
+      if (simengine_vars.stopping) {
+         break;
+      }
+      simengine_runWindow(p,simengine_vars.windowEnd);
+      sem_post(&simengine_vars.done);
+   }
+   return NULL;
+}
+
+/**
+\brief Run the events of partition p which happen before windowEnd.
+*/
+void simengine_runWindow(simengine_partition_t* p, uint64_t windowEnd) {
+   simengine_event_t event;
+   simengine_mote_t* m;
+
+   while (p->events.numEvents>0 && p->events.events[0].time<windowEnd) {
+      simengine_pop(&p->events,&event);
+      m = simengine_vars.motes[event.moteId];
+      if (simengine_isStale(m,&event)) {
+         continue;
+      }
+      p->now = event.time;
+
+      // the interrupt
+      if (simengine_dispatch(m,&event)==FALSE) {
+         continue;
+      }
+      p->stats.numEvents++;
+
+      // the tasks it posted
+      m->running = TRUE;
+      sem_post(&m->awake);
+      simengine_waitAsleep(m);
+   }
+}
+
+/**
+\brief Hand the frames sent during the last window to their receivers.
+*/
+void simengine_exchange(void) {
+   simengine_queue_t* outbox;
+   simengine_event_t* event;
+   uint32_t           j;
+   uint8_t            p;
+
+   for (p=0;p<simengine_vars.numPartitions;p++) {
+      outbox = &simengine_vars.partitions[p].outbox;
+      for (j=0;j<outbox->numEvents;j++) {
+         event = &outbox->events[j];
+         simengine_push(&simengine_vars.motes[event->moteId]->partition->events,event);
+      }
+      outbox->numEvents = 0;
+   }
+}
+
+/**
+\brief Time of the earliest pending event, over all partitions.
+
+\returns FALSE if no event is pending.
+*/
+bool simengine_nextTime(uint64_t* time) {
+   simengine_queue_t* events;
+   bool               found;
+   uint8_t            p;
+
+   found = FALSE;
+   for (p=0;p<simengine_vars.numPartitions;p++) {
+      events = &simengine_vars.partitions[p].events;
+      if (events->numEvents>0 && (found==FALSE || events->events[0].time<*time)) {
+         *time = events->events[0].time;
+         found = TRUE;
+      }
+   }
+   return found;
+}
+
+uint32_t simengine_countEvents(void) {
+   uint32_t numEvents;
+   uint8_t  p;
+
+   numEvents = 0;
+   for (p=0;p<SIMENGINE_MAXTHREADS;p++) {
+      numEvents += simengine_vars.partitions[p].stats.numEvents;
+   }
+   return numEvents;
+}
+
+//===== events
+
+void simengine_schedule(simengine_mote_t* m, uint64_t time, uint8_t type, uint32_t gen) {
+   simengine_event_t event;
+
+   memset(&event,0,sizeof(simengine_event_t));
+   event.time    = time;
+   event.seq     = (m->seq++<<SIMENGINE_SEQ_SHIFT)|m->id;
+   event.moteId  = m->id;
+   event.type    = type;
+   event.gen     = gen;
+   simengine_push(&m->partition->events,&event);
+}
+
+/**
+\brief Mote m sends a frame over one of its links.
+
+A receiver in another partition only gets it at the end of the window.
+*/
+void simengine_sendFrame(simengine_mote_t* m, simengine_link_t* link, uint64_t time, simengine_frame_t* frame) {
+   simengine_mote_t*  r;
+   simengine_queue_t* outbox;
+   simengine_event_t  event;
+
+   r = simengine_vars.motes[link->dst];
+
+   event.time       = time;
+   event.seq        = (m->seq++<<SIMENGINE_SEQ_SHIFT)|m->id;
+   event.frame      = frame;
+   event.gen        = 0;
+   event.pdr        = link->pdr;
+   event.moteId     = r->id;
+   event.type       = SIMENGINE_EVT_RX_START;
+   event.frequency  = m->frequency;
+   event.rssi       = link->rssi;
+
+   if (r->partition==m->partition) {
+      simengine_push(&m->partition->events,&event);
+      return;
+   }
+   outbox = &m->partition->outbox;
+   if (outbox->numEvents==outbox->maxEvents && simengine_grow(outbox)==FALSE) {
+      if (__sync_sub_and_fetch(&frame->refs,1)==0) {
+         free(frame);
+      }
+      return;
+   }
+   outbox->events[outbox->numEvents++] = event;
+}
+
+bool simengine_grow(simengine_queue_t* q) {
+   simengine_event_t* events;
+   uint32_t           maxEvents;
+
+   maxEvents = q->maxEvents ? 2*q->maxEvents : SIMENGINE_EVENTS_INIT;
+   events    = realloc(q->events,maxEvents*sizeof(simengine_event_t));
+   if (events==NULL) {
+      printf("[CRITICAL] simengine can not grow its event queue\r\n");
+      return FALSE;
+   }
+   q->events    = events;
+   q->maxEvents = maxEvents;
+   return TRUE;
+}
+
+void simengine_push(simengine_queue_t* q, simengine_event_t* event) {
+   uint32_t pos;
+   uint32_t parent;
+
+   if (q->numEvents==q->maxEvents && simengine_grow(q)==FALSE) {
+      return;
+   }
+
+   // sift up
+   pos = q->numEvents++;
+   while (pos>0) {
+      parent = (pos-1)/2;
+      if (!simengine_isBefore(event,&q->events[parent])) {
+         break;
+      }
+      q->events[pos] = q->events[parent];
+      pos = parent;
+   }
+   q->events[pos] = *event;
+}
+
+bool simengine_pop(simengine_queue_t* q, simengine_event_t* event) {
+   simengine_event_t last;
+   uint32_t          pos;
+   uint32_t          child;
+
+   if (q->numEvents==0) {
+      return FALSE;
+   }
+   *event = q->events[0];
+   last   = q->events[--q->numEvents];
+
+   // sift down
+   pos = 0;
+   while (2*pos+1<q->numEvents) {
+      child = 2*pos+1;
+      if (
+         child+1<q->numEvents &&
+         simengine_isBefore(&q->events[child+1],&q->events[child])
+      ) {
+         child++;
+      }
+      if (!simengine_isBefore(&q->events[child],&last)) {
+         break;
+      }
+      q->events[pos] = q->events[child];
+      pos = child;
+   }
+   q->events[pos] = last;
+   return TRUE;
+}
+
+bool simengine_isBefore(simengine_event_t* a, simengine_event_t* b) {
+   if (a->time!=b->time) {
+      return a->time<b->time;
+   }
+   return a->seq<b->seq;
+}
+
+/**
+\brief Has the event been overtaken since it was scheduled?
+
+A new compare value replaces the pending one, and turning the radio off drops
+the frame being sent or received. A frame reaching the antenna is never stale,
+the state of the radio at that time decides what becomes of it.
+*/
+bool simengine_isStale(simengine_mote_t* m, simengine_event_t* event) {
+   switch (event->type) {
+      case SIMENGINE_EVT_SCTIMER:
+         return event->gen!=m->timerGen;
+      case SIMENGINE_EVT_TX_START:
+      case SIMENGINE_EVT_TX_END:
+      case SIMENGINE_EVT_RX_END:
+         return event->gen!=m->radioGen;
+      default:
+         return FALSE;
+   }
+}
+
+/**
+\brief Deliver the interrupt of an event to mote m.
+
+\returns FALSE if the event raised no interrupt.
+*/
+bool simengine_dispatch(simengine_mote_t* m, simengine_event_t* event) {
+   OpenMote* self;
+   uint64_t  now;
+
+   self = m->mote;
+   now  = m->partition->now;
+   switch (event->type) {
+      case SIMENGINE_EVT_SCTIMER:
+         sctimer_intr_compare(self);
+         break;
+      case SIMENGINE_EVT_TX_START:
+         m->txEnd = now+simengine_frameDuration(m->txLen);
+         simengine_schedule(m,m->txEnd,SIMENGINE_EVT_TX_END,m->radioGen);
+         radio_intr_startOfFrame(self,(uint32_t)now);
+         break;
+      case SIMENGINE_EVT_TX_END:
+         m->radioState = RADIOSTATE_TXRX_DONE;
+         radio_intr_endOfFrame(self,(uint32_t)now);
+         break;
+      case SIMENGINE_EVT_RX_START:
+         return simengine_receive(m,event);
+      case SIMENGINE_EVT_RX_END:
+         m->radioState = RADIOSTATE_TXRX_DONE;
+         radio_intr_endOfFrame(self,(uint32_t)now);
+         break;
+      case SIMENGINE_EVT_UART_TX:
+         if (self->uart_icb.txCb!=NULL) {
+            uart_intr_tx(self);
+         }
+         break;
+      case SIMENGINE_EVT_UART_RX:
+         if (self->uart_icb.rxCb!=NULL) {
+            uart_intr_rx(self);
+         }
+         break;
+   }
+   return TRUE;
+}
+
+/**
+\brief A frame reaches the antenna of mote m.
+
+A mote listening on the same frequency locks onto it, unless the link loses
+it. A mote already receiving a frame gets a collision instead: the frame it is
+receiving is corrupted.
+
+\returns TRUE if the mote locked onto the frame.
+*/
+bool simengine_receive(simengine_mote_t* m, simengine_event_t* event) {
+   simengine_frame_t*     frame;
+   simengine_partition_t* p;
+   bool                   locked;
+
+   frame  = event->frame;
+   p      = m->partition;
+   locked = FALSE;
+
+   if (event->frequency==m->frequency) {
+      if (m->radioState==RADIOSTATE_RECEIVING && m->rxEnd>p->now) {
+         p->stats.numCollisions++;
+         m->rxCrc = FALSE;
+      } else if (m->radioState==RADIOSTATE_LISTENING) {
+         if ((simengine_rand(m)&0xffff)>=event->pdr) {
+            p->stats.numFramesLost++;
+         } else {
+            p->stats.numFramesRx++;
+            memcpy(m->rxBuf,frame->buf,frame->len);
+            m->rxLen      = frame->len;
+            m->rxRssi     = event->rssi;
+            m->rxCrc      = TRUE;
+            m->rxEnd      = p->now+simengine_frameDuration(frame->len);
+            m->radioState = RADIOSTATE_RECEIVING;
+            simengine_schedule(m,m->rxEnd,SIMENGINE_EVT_RX_END,m->radioGen);
+            radio_intr_startOfFrame(m->mote,(uint32_t)p->now);
+            locked = TRUE;
+         }
+      }
+   }
+
+   // the receivers of a frame may run in different threads
+   if (__sync_sub_and_fetch(&frame->refs,1)==0) {
+      free(frame);
+   }
+   return locked;
+}
+
+void simengine_waitAsleep(simengine_mote_t* m) {
+   if (m->running==FALSE) {
+      return;
+   }
+   sem_wait(&m->asleep);
+   m->running = FALSE;
+}
+
+/**
+\brief Time on the air of a frame, in ticks.
+
+The PHY adds 6 bytes (preamble, SFD and length) and sends 250kbps, that is
+32us per byte.
+*/
+uint64_t simengine_frameDuration(uint8_t len) {
+   return ((uint64_t)(len+6)*32*SIMENGINE_TICKS_PER_S+999999)/1000000;
+}
+
+/**
+\brief Seed of the random generator of a mote.
+
+Each mote draws from a generator of its own, so that the outcome of a run does
+not depend on the order the partitions run in.
+*/
+uint32_t simengine_moteSeed(uint16_t id) {
+   uint32_t seed;
+
+   seed = simengine_vars.seed^((uint32_t)(id+1)*0x9e3779b9);
+   // xorshift must not start from 0
+   return seed ? seed : SIMENGINE_SEED_DEFAULT;
+}
+
+uint32_t simengine_rand(simengine_mote_t* m) {
+   uint32_t x;
+
+   x  = m->random;
+   x ^= x<<13;
+   x ^= x>>17;
+   x ^= x<<5;
+   m->random = x;
+   return x;
+}
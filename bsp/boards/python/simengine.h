@@ -0,0 +1,109 @@
+/**
+\brief Native event engine for the Python board.
+
+By default, every BSP call of an emulated mote is forwarded to Python. A mote
+attached to this engine instead has its radio, sctimer, UART, leds and
+debugpins emulated in C, and runs without the GIL. The engine runs the attached
+motes in simulated time order, either one at a time or spread over worker
+threads. Python is left with the coarse-grained hooks: topology, UART
+injection and statistics.
+*/
+
+#ifndef __SIMENGINE_H
+#define __SIMENGINE_H
+
+#include "stdint.h"
+#include "toolchain_defs.h"
+#include "board_info.h"
+
+//=========================== define ==========================================
+
+/// Maximum number of motes which can be attached to the engine
+#ifndef SIMENGINE_MAXMOTES
+#define SIMENGINE_MAXMOTES        1024
+#endif
+
+/// Maximum number of worker threads a run can be spread over
+#ifndef SIMENGINE_MAXTHREADS
+#define SIMENGINE_MAXTHREADS      64
+#endif
+
+#define SIMENGINE_TICKS_PER_S     32768
+#define SIMENGINE_UART_BUFLEN     1024
+#define SIMENGINE_UART_BYTE_TICKS 3      // 3@32768Hz = 92us, about a byte at 115200 baud
+#define SIMENGINE_RADIO_BUFLEN    128
+#define SIMENGINE_PDR_ONE         65536  // a PDR of 100%
+#define SIMENGINE_LQI             0xff
+
+#define SIMENGINE_LED_ERROR       0x01
+#define SIMENGINE_LED_RADIO       0x02
+#define SIMENGINE_LED_SYNC        0x04
+#define SIMENGINE_LED_DEBUG       0x08
+#define SIMENGINE_LED_ALL         0x0f
+
+typedef enum {
+   SIMENGINE_EVT_SCTIMER          = 0,
+   SIMENGINE_EVT_TX_START,
+   SIMENGINE_EVT_TX_END,
+   SIMENGINE_EVT_RX_START,                 // a frame reaches the antenna
+   SIMENGINE_EVT_RX_END,
+   SIMENGINE_EVT_UART_TX,
+   SIMENGINE_EVT_UART_RX,
+} simengine_event_type_t;
+
+//=========================== typedef =========================================
+
+typedef struct OpenMote OpenMote;
+typedef struct simengine_mote_t simengine_mote_t;
+
+typedef struct {
+   uint32_t             numEvents;          // events dispatched
+   uint32_t             numWindows;         // synchronization windows of the parallel runs
+   uint32_t             numFramesTx;        // frames put on the air
+   uint32_t             numFramesRx;        // frames a mote started receiving
+   uint32_t             numFramesLost;      // frames lost on a link, following its PDR
+   uint32_t             numCollisions;      // frames corrupted by an overlapping one
+   uint32_t             numUartOverflows;   // bytes dropped from a full UART buffer
+} simengine_stats_t;
+
+//=========================== prototypes ======================================
+
+// admin
+int                 simengine_attach(OpenMote* self);
+void                simengine_seed(uint32_t seed);
+int                 simengine_setLink(uint16_t src, uint16_t dst, uint32_t pdr, int8_t rssi);
+uint32_t            simengine_run(uint64_t duration, uint8_t numThreads);
+uint64_t            simengine_getTime(void);
+void                simengine_getStats(simengine_stats_t* stats);
+// board
+void                simengine_board_sleep(OpenMote* self);
+// leds
+uint8_t             simengine_leds_get(OpenMote* self);
+void                simengine_leds_set(OpenMote* self, uint8_t leds);
+// sctimer
+PORT_TIMER_WIDTH    simengine_sctimer_readCounter(OpenMote* self);
+void                simengine_sctimer_setCompare(OpenMote* self, PORT_TIMER_WIDTH value);
+void                simengine_sctimer_enable(OpenMote* self);
+void                simengine_sctimer_disable(OpenMote* self);
+// radio
+void                simengine_radio_reset(OpenMote* self);
+void                simengine_radio_setFrequency(OpenMote* self, uint8_t frequency);
+void                simengine_radio_rfOff(OpenMote* self);
+void                simengine_radio_loadPacket(OpenMote* self, uint8_t* packet, uint16_t len);
+void                simengine_radio_txEnable(OpenMote* self);
+void                simengine_radio_txNow(OpenMote* self);
+void                simengine_radio_rxEnable(OpenMote* self);
+void                simengine_radio_getReceivedFrame(OpenMote* self,
+                                                     uint8_t* pBufRead,
+                                                     uint8_t* pLenRead,
+                                                     uint8_t  maxBufLen,
+                                                      int8_t* pRssi,
+                                                     uint8_t* pLqi,
+                                                        bool* pCrc);
+// uart
+void                simengine_uart_write(OpenMote* self, uint8_t* buffer, uint16_t len, bool requestInput);
+uint8_t             simengine_uart_readByte(OpenMote* self);
+uint16_t            simengine_uart_drain(OpenMote* self, uint8_t* buffer, uint16_t maxLen);
+uint16_t            simengine_uart_inject(OpenMote* self, uint8_t* buffer, uint16_t len);
+
+#endif
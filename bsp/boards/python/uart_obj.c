@@ -37,6 +37,11 @@ void uart_init(OpenMote* self) {
    printf("C@0x%x: uart_init()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_init],NULL);
    if (result == NULL) {
@@ -57,6 +62,11 @@ void uart_enableInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_enableInterrupts()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_enableInterrupts],NULL);
    if (result == NULL) {
@@ -77,6 +87,11 @@ void uart_disableInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_disableInterrupts()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_disableInterrupts],NULL);
    if (result == NULL) {
@@ -97,6 +112,11 @@ void uart_clearRxInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_clearRxInterrupts()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_clearRxInterrupts],NULL);
    if (result == NULL) {
@@ -117,6 +137,11 @@ void uart_clearTxInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_clearTxInterrupts()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_clearTxInterrupts],NULL);
    if (result == NULL) {
@@ -143,6 +168,12 @@ void uart_writeByte(OpenMote* self, uint8_t byteToWrite) {
    printf("C@0x%x: uart_writeByte()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      simengine_uart_write(self,&byteToWrite,1,FALSE);
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",byteToWrite);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_writeByte],arglist);
@@ -159,6 +190,68 @@ void uart_writeByte(OpenMote* self, uint8_t byteToWrite) {
 }
 #endif
 
+/**
+\brief Send a block of bytes, as a board with a DMA-driven UART does.
+
+The TX interrupt follows once the whole block is out. Python takes the block at
+once and has no notion of transmission time, the transfer of a mote it
+emulates completes right away.
+*/
+void uart_writeBufferByLen(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   PyObject*   frame;
+   PyObject*   arglist;
+   PyObject*   result;
+   PyObject*   item;
+   uint16_t    i;
+   int         res;
+   
+#ifdef TRACE_ON
+   printf("C@0x%x: uart_writeBufferByLen(buffer=%x,len=%d)... \n",
+      self,
+      buffer,
+      len
+   );
+#endif
+   
+   // emulated natively
+   if (self->simengine!=NULL) {
+      // the UART receives while it transmits, Python's input can follow
+      simengine_uart_write(self,buffer,len,TRUE);
+      return;
+   }
+   
+   // forward to Python
+   frame      = PyList_New(len);
+   if (frame==NULL) {
+      printf("[CRITICAL] PyList_New(%d) failed in uart_writeBufferByLen\r\n",len);
+      return;
+   }
+   for (i=0;i<len;i++) {
+      item    = PyInt_FromLong(buffer[i]);
+      res     = PyList_SetItem(frame,i,item);
+      if (res!=0) {
+         printf("[CRITICAL] uart_writeBufferByLen() failed setting list item\r\n");
+         return;
+      }
+   }
+   arglist    = Py_BuildValue("(O)",frame);
+   result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_writeBufferByLen_FASTSIM],arglist);
+   if (result == NULL) {
+      printf("[CRITICAL] uart_writeBufferByLen() returned NULL\r\n");
+      return;
+   }
+   Py_DECREF(result);
+   Py_DECREF(arglist);
+   Py_DECREF(frame);
+   
+   // the block is out
+   uart_intr_tx(self);
+   
+#ifdef TRACE_ON
+   printf("C@0x%x: ...done.\n",self);
+#endif
+}
+
 void uart_writeCircularBuffer_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t* outputBufIdxR, uint8_t* outputBufIdxW) {
    PyObject*   frame;
    PyObject*   arglist;
@@ -167,6 +260,7 @@ void uart_writeCircularBuffer_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t*
    int         res;
    uint8_t     len;
    uint8_t     i;
+   uint8_t     bytes[256];
    
 #ifdef TRACE_ON
    printf("C@0x%x: uart_writeCircularBuffer_FASTSIM(buffer=%x,outputBufIdxR=%x,outputBufIdxW=%x)... \n",
@@ -177,6 +271,17 @@ void uart_writeCircularBuffer_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t*
    );
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      // the indices wrap around the 256-byte buffer, unwrap it
+      len = 0;
+      while (*outputBufIdxR!=*outputBufIdxW) {
+         bytes[len++] = buffer[(*outputBufIdxR)++];
+      }
+      simengine_uart_write(self,bytes,len,FALSE);
+      return;
+   }
+   
    // forward to Python
    len        = (*outputBufIdxW)-(*outputBufIdxR);
    frame      = PyList_New(len);
@@ -226,6 +331,13 @@ void uart_writeBufferByLen_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t len)
    );
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      // the mote sends its request frame, Python's input can follow
+      simengine_uart_write(self,buffer,len,TRUE);
+      return;
+   }
+   
    // forward to Python
    frame      = PyList_New(len);
    if (frame==NULL) {
@@ -263,6 +375,11 @@ uint8_t uart_readByte(OpenMote* self) {
    printf("C@0x%x: uart_readByte()... \n",self);
 #endif
    
+   // emulated natively
+   if (self->simengine!=NULL) {
+      return simengine_uart_readByte(self);
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_readByte],NULL);
    if (result == NULL) {
@@ -71,6 +71,11 @@ to this board.
 
 #define SYNC_ACCURACY                       1     // ticks
 
+//===== CRC
+
+// flash is tight on the MSP430f1611: use the 16-entry table (see opencrc.h)
+#define OPENCRC_STRATEGY                    OPENCRC_STRATEGY_NIBBLE
+
 //=========================== variables =======================================
 
 // The variables below are used by CoAP's registration engine.
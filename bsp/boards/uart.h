@@ -38,6 +38,9 @@ void    uart_disableInterrupts(void);
 void    uart_clearRxInterrupts(void);
 void    uart_clearTxInterrupts(void);
 void    uart_writeByte(uint8_t byteToWrite);
+#ifdef UART_DMA_ENABLED
+void    uart_writeBufferByLen(uint8_t* buffer, uint16_t len);
+#endif
 #ifdef FASTSIM
 void    uart_writeCircularBuffer_FASTSIM(uint8_t* buffer, uint8_t* outputBufIdxR, uint8_t* outputBufIdxW);
 #endif
@@ -0,0 +1,76 @@
+/**
+\brief Declaration of the "opencrc" driver.
+
+Shared CRC-16 engine (reflected polynomial x^16+x^12+x^5+1, i.e. 0x8408) used
+both by HDLC framing on the serial line (initial value HDLC_CRCINIT) and by
+the IEEE802.15.4 FCS (initial value 0x0000).
+
+Several strategies are available, trading flash for speed:
+- OPENCRC_STRATEGY_NIBBLE: 16-entry table, 2 lookups per byte (32B of flash).
+- OPENCRC_STRATEGY_TABLE:  256-entry table, 1 lookup per byte (512B of flash).
+- OPENCRC_STRATEGY_SLICE4: 4x256-entry tables, 4 bytes per iteration (2kB of
+  flash), for 32-bit targets.
+
+A board selects its strategy by defining OPENCRC_STRATEGY in its board_info.h.
+*/
+
+#ifndef __OPENCRC_H
+#define __OPENCRC_H
+
+#include "opendefs.h"
+
+/**
+\addtogroup drivers
+\{
+\addtogroup OpenCrc
+\{
+*/
+
+//=========================== define ==========================================
+
+#define OPENCRC_STRATEGY_NIBBLE    1
+#define OPENCRC_STRATEGY_TABLE     2
+#define OPENCRC_STRATEGY_SLICE4    3
+
+#ifndef OPENCRC_STRATEGY
+   #if defined(OPENSIM) || defined(__arm__)
+      #define OPENCRC_STRATEGY     OPENCRC_STRATEGY_SLICE4
+   #else
+      #define OPENCRC_STRATEGY     OPENCRC_STRATEGY_TABLE
+   #endif
+#endif
+
+// the 256-entry table is needed by both the table and slice-by-4 strategies
+#if OPENCRC_STRATEGY==OPENCRC_STRATEGY_TABLE
+   #define OPENCRC_TABLE_ENABLED
+#elif OPENCRC_STRATEGY==OPENCRC_STRATEGY_SLICE4
+   #define OPENCRC_TABLE_ENABLED
+   #define OPENCRC_SLICE4_ENABLED
+#elif OPENCRC_STRATEGY!=OPENCRC_STRATEGY_NIBBLE
+   #error "unsupported OPENCRC_STRATEGY"
+#endif
+
+//=========================== typedef =========================================
+
+//=========================== prototypes ======================================
+
+// strategy selected at compile time
+uint16_t opencrc_update(uint16_t crc, uint8_t* buf, uint16_t len);
+uint16_t opencrc_updateByte(uint16_t crc, uint8_t byte);
+
+// individual strategies, available for cross-checking
+uint16_t opencrc_updateBitwise(uint16_t crc, uint8_t* buf, uint16_t len);
+uint16_t opencrc_updateNibble(uint16_t crc, uint8_t* buf, uint16_t len);
+#ifdef OPENCRC_TABLE_ENABLED
+uint16_t opencrc_updateTable(uint16_t crc, uint8_t* buf, uint16_t len);
+#endif
+#ifdef OPENCRC_SLICE4_ENABLED
+uint16_t opencrc_updateSlice4(uint16_t crc, uint8_t* buf, uint16_t len);
+#endif
+
+/**
+\}
+\}
+*/
+
+#endif
@@ -14,7 +14,7 @@
 //=========================== public ==========================================
 
 uint16_t crcIteration(uint16_t crc, uint8_t byte) {
-   return (crc >> 8) ^ fcstab[(crc ^ byte) & 0xff];
+   return opencrc_updateByte(crc,byte);
 }
 
 //=========================== private =========================================
@@ -23,6 +23,8 @@
 #include "icmpv6rpl.h"
 #include "icmpv6echo.h"
 #include "sf0.h"
+#include "scheduler.h"
+#include "opentelemetry.h"
 
 //=========================== variables =======================================
 
@@ -40,6 +42,7 @@ owerror_t openserial_printInfoErrorCritical(
 );
 
 // command handlers
+void openserial_handleRxFrame(void);
 void openserial_handleEcho(uint8_t* but, uint8_t bufLen);
 void openserial_get6pInfo(uint8_t commandId, uint8_t* code,uint8_t* cellOptions,uint8_t* numCells,cellInfo_ht* celllist_add,cellInfo_ht* celllist_delete,uint8_t* listOffset,uint8_t* maxListLen,uint8_t ptr, uint8_t commandLen);
 void openserial_handleCommands(void);
@@ -47,7 +50,15 @@ void openserial_handleCommands(void);
 // misc
 void openserial_board_reset_cb(opentimers_id_t id);
 
+#ifdef OPENSERIAL_FULL_DUPLEX
+// full-duplex
+void openserial_startDuplex(void);
+void openserial_txNext(void);
+void openserial_input_task_cb(void);
+#endif
+
 // HDLC output
+void outputBufWrite(uint8_t b);
 void outputHdlcOpen(void);
 void outputHdlcWrite(uint8_t b);
 void outputHdlcClose(void);
@@ -70,6 +81,9 @@ void openserial_init() {
     // reset variable
     memset(&openserial_vars,0,sizeof(openserial_vars_t));
     
+    // the registry has to be ready before the modules register with it
+    opentelemetry_init();
+    
     // admin
     openserial_vars.mode               = MODE_OFF;
     openserial_vars.debugPrintCounter  = 0;
@@ -88,11 +102,19 @@ void openserial_init() {
     openserial_vars.busyReceiving      = FALSE;
     openserial_vars.inputEscaping      = FALSE;
     openserial_vars.inputBufFill       = 0;
+#ifdef OPENSERIAL_FULL_DUPLEX
+    openserial_vars.inputTaskPending   = FALSE;
+    openserial_vars.inputRingIdxW      = 0;
+    openserial_vars.inputRingIdxR      = 0;
+#endif
     
     // ouput
     openserial_vars.outputBufFilled    = FALSE;
     openserial_vars.outputBufIdxR      = 0;
     openserial_vars.outputBufIdxW      = 0;
+#ifdef OPENSERIAL_FULL_DUPLEX
+    openserial_vars.outputBusy         = FALSE;
+#endif
     
     // set callbacks
     uart_setCallbacks(
@@ -266,6 +288,25 @@ owerror_t openserial_printSniffedPacket(uint8_t* buffer, uint8_t length, uint8_t
     return E_SUCCESS;
 }
 
+owerror_t openserial_printTelemetry(uint8_t* buffer, uint8_t length) {
+    uint8_t  i;
+    INTERRUPT_DECLARATION();
+    
+    DISABLE_INTERRUPTS();
+    openserial_vars.outputBufFilled  = TRUE;
+    outputHdlcOpen();
+    outputHdlcWrite(SERFRAME_MOTE2PC_TELEMETRY);
+    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
+    outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
+    for (i=0;i<length;i++){
+        outputHdlcWrite(buffer[i]);
+    }
+    outputHdlcClose();
+    ENABLE_INTERRUPTS();
+    
+    return E_SUCCESS;
+}
+
 //===== retrieving inputBuffer
 
 uint8_t openserial_getInputBufferFilllevel() {
@@ -307,6 +348,23 @@ uint8_t openserial_getInputBuffer(uint8_t* bufferToWrite, uint8_t maxNumBytes) {
 //===== scheduling
 
 void openserial_startInput() {
+#ifdef OPENSERIAL_FULL_DUPLEX
+    uint8_t inputRingFree;
+    INTERRUPT_DECLARATION();
+    
+    // ask for input only if a frame of any length fits in the input ring
+    DISABLE_INTERRUPTS();
+    inputRingFree = openserial_vars.inputRingIdxR-openserial_vars.inputRingIdxW-1;
+    if (inputRingFree>SERIAL_INPUT_BUFFER_SIZE) {
+        openserial_vars.outputBufFilled  = TRUE;
+        outputHdlcOpen();
+        outputHdlcWrite(SERFRAME_MOTE2PC_REQUEST);
+        outputHdlcClose();
+    }
+    ENABLE_INTERRUPTS();
+    
+    openserial_startDuplex();
+#else
     INTERRUPT_DECLARATION();
     
     if (openserial_vars.inputBufFill>0) {
@@ -339,14 +397,50 @@ void openserial_startInput() {
     uart_writeByte(openserial_vars.reqFrame[openserial_vars.reqFrameIdx]);
 #endif
     ENABLE_INTERRUPTS();
+#endif
 }
 
 void openserial_startOutput() {
+#ifndef OPENSERIAL_TELEMETRY
     uint8_t debugPrintCounter;
+#endif
+    uint16_t numOutputFramesDropped;
+    scheduler_dbg_t schedulerDbg;
     INTERRUPT_DECLARATION();
     
+    //=== report tasks the scheduler had to drop, it can not print itself
+    
+    scheduler_getDbg(&schedulerDbg);
+    if (schedulerDbg.numTasksDropped!=openserial_vars.numTasksDroppedReported) {
+        openserial_printError(
+            COMPONENT_OPENWSN,
+            ERR_TASK_LIST_OVERFLOW,
+            (errorparameter_t)(schedulerDbg.numTasksDropped-openserial_vars.numTasksDroppedReported),
+            (errorparameter_t)schedulerDbg.lastDroppedPrio
+        );
+        openserial_vars.numTasksDroppedReported = schedulerDbg.numTasksDropped;
+    }
+    
+    //=== report frames which did not fit in the output buffer
+    
+    DISABLE_INTERRUPTS();
+    numOutputFramesDropped = openserial_vars.numOutputFramesDropped;
+    ENABLE_INTERRUPTS();
+    if (numOutputFramesDropped!=openserial_vars.numOutputFramesDroppedReported) {
+        openserial_printError(
+            COMPONENT_OPENSERIAL,
+            ERR_OUTPUT_BUFFER_OVERFLOW,
+            (errorparameter_t)(numOutputFramesDropped-openserial_vars.numOutputFramesDroppedReported),
+            (errorparameter_t)0
+        );
+        openserial_vars.numOutputFramesDroppedReported = numOutputFramesDropped;
+    }
+    
     //=== made modules print debug information
     
+#ifdef OPENSERIAL_TELEMETRY
+    opentelemetry_print();
+#else
     DISABLE_INTERRUPTS();
     openserial_vars.debugPrintCounter = (openserial_vars.debugPrintCounter+1)%STATUS_MAX;
     debugPrintCounter = openserial_vars.debugPrintCounter;
@@ -406,9 +500,13 @@ void openserial_startOutput() {
             openserial_vars.debugPrintCounter=0;
             ENABLE_INTERRUPTS();
     }
+#endif
     
     //=== flush TX buffer
     
+#ifdef OPENSERIAL_FULL_DUPLEX
+    openserial_startDuplex();
+#else
     uart_clearTxInterrupts();
     uart_clearRxInterrupts();          // clear possible pending interrupts
     uart_enableInterrupts();           // Enable USCI_A1 TX & RX interrupt
@@ -429,11 +527,18 @@ void openserial_startOutput() {
         openserial_stop();
     }
     ENABLE_INTERRUPTS();
+#endif
 }
 
+/**
+\brief Stop the serial activity, and hand the frame just received to the stack.
+
+In full-duplex mode, input and output are never stopped: this function does
+nothing, received frames are handed to the stack by a task.
+*/
 void openserial_stop() {
+#ifndef OPENSERIAL_FULL_DUPLEX
     uint8_t inputBufFill;
-    uint8_t cmdByte;
     bool    busyReceiving;
     INTERRUPT_DECLARATION();
 
@@ -461,39 +566,14 @@ void openserial_stop() {
     }
     
     if (busyReceiving==FALSE && inputBufFill>0) {
-        DISABLE_INTERRUPTS();
-        cmdByte = openserial_vars.inputBuf[0];
-        ENABLE_INTERRUPTS();
-        // call hard-coded commands
-        // FIXME: needs to be replaced by registered commands only
-        switch (cmdByte) {
-            case SERFRAME_PC2MOTE_SETROOT:
-                idmanager_triggerAboutRoot();
-                break;
-            case SERFRAME_PC2MOTE_RESET:
-                board_reset();
-                break;
-            case SERFRAME_PC2MOTE_DATA:
-                openbridge_triggerData();
-                break;
-            case SERFRAME_PC2MOTE_TRIGGERSERIALECHO:
-                openserial_handleEcho(&openserial_vars.inputBuf[1],inputBufFill-1);
-                break;
-            case SERFRAME_PC2MOTE_COMMAND:
-                openserial_handleCommands();
-                break;
-        }
-        // call registered commands
-        if (openserial_vars.registeredCmd!=NULL && openserial_vars.registeredCmd->cmdId==cmdByte) {
-            
-            openserial_vars.registeredCmd->cb();
-        }
+        openserial_handleRxFrame();
     }
     
     DISABLE_INTERRUPTS();
     openserial_vars.inputBufFill  = 0;
     openserial_vars.busyReceiving = FALSE;
     ENABLE_INTERRUPTS();
+#endif
 }
 
 //===== debugprint
@@ -557,6 +637,45 @@ owerror_t openserial_printInfoErrorCritical(
 
 //===== command handlers
 
+/**
+\brief Hand the frame in the input buffer to the command it is for.
+*/
+void openserial_handleRxFrame(void) {
+    uint8_t inputBufFill;
+    uint8_t cmdByte;
+    INTERRUPT_DECLARATION();
+    
+    DISABLE_INTERRUPTS();
+    inputBufFill = openserial_vars.inputBufFill;
+    cmdByte      = openserial_vars.inputBuf[0];
+    ENABLE_INTERRUPTS();
+    
+    // call hard-coded commands
+    // FIXME: needs to be replaced by registered commands only
+    switch (cmdByte) {
+        case SERFRAME_PC2MOTE_SETROOT:
+            idmanager_triggerAboutRoot();
+            break;
+        case SERFRAME_PC2MOTE_RESET:
+            board_reset();
+            break;
+        case SERFRAME_PC2MOTE_DATA:
+            openbridge_triggerData();
+            break;
+        case SERFRAME_PC2MOTE_TRIGGERSERIALECHO:
+            openserial_handleEcho(&openserial_vars.inputBuf[1],inputBufFill-1);
+            break;
+        case SERFRAME_PC2MOTE_COMMAND:
+            openserial_handleCommands();
+            break;
+    }
+    // call registered commands
+    if (openserial_vars.registeredCmd!=NULL && openserial_vars.registeredCmd->cmdId==cmdByte) {
+        
+        openserial_vars.registeredCmd->cb();
+    }
+}
+
 void openserial_handleEcho(uint8_t* buf, uint8_t bufLen){
     // echo back what you received
     openserial_printData(
@@ -813,17 +932,139 @@ void openserial_board_reset_cb(opentimers_id_t id) {
     board_reset();
 }
 
+#ifdef OPENSERIAL_FULL_DUPLEX
+//===== full-duplex
+
+/**
+\brief Start input and output at the same time, unless already started.
+*/
+void openserial_startDuplex(void) {
+    uint8_t mode;
+    INTERRUPT_DECLARATION();
+    
+    DISABLE_INTERRUPTS();
+    mode = openserial_vars.mode;
+    ENABLE_INTERRUPTS();
+    
+    if (mode!=MODE_DUPLEX) {
+        uart_clearTxInterrupts();
+        uart_clearRxInterrupts();      // clear possible pending interrupts
+        uart_enableInterrupts();       // Enable USCI_A1 TX & RX interrupt
+    }
+    
+    DISABLE_INTERRUPTS();
+    openserial_vars.mode = MODE_DUPLEX;
+    if (openserial_vars.outputBusy==FALSE) {
+        openserial_txNext();
+    }
+    ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Hand the next bytes of the output buffer to the UART.
+
+Called with interrupts disabled, while the UART is not transmitting. With
+UART_DMA_ENABLED, all the bytes up to the write index, or up to the end of the
+buffer, are sent as one block: they stay in the buffer until the block is out.
+*/
+void openserial_txNext(void) {
+    
+    if (openserial_vars.outputBufIdxR==openserial_vars.outputBufIdxW) {
+        // nothing left to send
+        openserial_vars.outputBusy       = FALSE;
+        openserial_vars.outputBufFilled  = FALSE;
+        return;
+    }
+    
+    openserial_vars.outputBusy           = TRUE;
+#ifdef UART_DMA_ENABLED
+    if (openserial_vars.outputBufIdxW>openserial_vars.outputBufIdxR) {
+        openserial_vars.outputBlockLen   = openserial_vars.outputBufIdxW-openserial_vars.outputBufIdxR;
+    } else {
+        openserial_vars.outputBlockLen   = SERIAL_OUTPUT_BUFFER_SIZE-openserial_vars.outputBufIdxR;
+    }
+    uart_writeBufferByLen(
+        &openserial_vars.outputBuf[openserial_vars.outputBufIdxR],
+        openserial_vars.outputBlockLen
+    );
+#else
+    uart_writeByte(openserial_vars.outputBuf[openserial_vars.outputBufIdxR++]);
+#endif
+}
+
+/**
+\brief Hand the frames waiting in the input ring to the stack, oldest first.
+
+Each frame is copied to the input buffer, where the command handlers read it.
+Its room in the ring is freed before it is handled, so the UART keeps
+receiving meanwhile.
+*/
+void openserial_input_task_cb(void) {
+    uint8_t frameLen;
+    uint8_t i;
+    bool    frameWaiting;
+    INTERRUPT_DECLARATION();
+    
+    DISABLE_INTERRUPTS();
+    openserial_vars.inputTaskPending = FALSE;
+    ENABLE_INTERRUPTS();
+    
+    while (TRUE) {
+        DISABLE_INTERRUPTS();
+        frameWaiting = openserial_vars.inputRingIdxR!=openserial_vars.inputRingIdxW;
+        ENABLE_INTERRUPTS();
+        if (frameWaiting==FALSE) {
+            break;
+        }
+        
+        // the ISR only writes past the write index, the frame can be read as is
+        frameLen = openserial_vars.inputRing[openserial_vars.inputRingIdxR];
+        for (i=0;i<frameLen;i++) {
+            openserial_vars.inputBuf[i] = openserial_vars.inputRing[(uint8_t)(openserial_vars.inputRingIdxR+1+i)];
+        }
+        
+        DISABLE_INTERRUPTS();
+        openserial_vars.inputBufFill   = frameLen;
+        openserial_vars.inputRingIdxR += 1+frameLen;
+        ENABLE_INTERRUPTS();
+        
+        openserial_handleRxFrame();
+        
+        DISABLE_INTERRUPTS();
+        openserial_vars.inputBufFill   = 0;
+        ENABLE_INTERRUPTS();
+    }
+}
+#endif
+
 //===== hdlc (output)
 
+/**
+\brief Add a byte to the output buffer, unless it overwrites bytes not sent yet.
+*/
+port_INLINE void outputBufWrite(uint8_t b) {
+    if (
+        openserial_vars.outputFrameOverflow==TRUE ||
+        (uint8_t)(openserial_vars.outputBufIdxW+1)==openserial_vars.outputBufIdxR
+    ) {
+        openserial_vars.outputFrameOverflow                          = TRUE;
+    } else {
+        openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]   = b;
+    }
+}
 /**
 \brief Start an HDLC frame in the output buffer.
 */
 port_INLINE void outputHdlcOpen() {
+    // remember where the frame starts, to drop it if it does not fit
+    openserial_vars.outputFrameIdxW                                  = openserial_vars.outputBufIdxW;
+    openserial_vars.outputFrameOverflow                              = FALSE;
+
     // initialize the value of the CRC
     openserial_vars.outputCrc                                        = HDLC_CRCINIT;
 
     // write the opening HDLC flag
-    openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]       = HDLC_FLAG;
+    outputBufWrite(HDLC_FLAG);
 }
 /**
 \brief Add a byte to the outgoing HDLC frame being built.
@@ -835,10 +1076,10 @@ port_INLINE void outputHdlcWrite(uint8_t b) {
     
     // add byte to buffer
     if (b==HDLC_FLAG || b==HDLC_ESCAPE) {
-        openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]   = HDLC_ESCAPE;
+        outputBufWrite(HDLC_ESCAPE);
         b                                                            = b^HDLC_ESCAPE_MASK;
     }
-    openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]       = b;
+    outputBufWrite(b);
 }
 /**
 \brief Finalize the outgoing HDLC frame.
@@ -854,7 +1095,22 @@ port_INLINE void outputHdlcClose() {
     outputHdlcWrite((finalCrc>>8)&0xff);
 
     // write the closing HDLC flag
-    openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]       = HDLC_FLAG;
+    outputBufWrite(HDLC_FLAG);
+
+    if (openserial_vars.outputFrameOverflow==TRUE) {
+        // the frame does not fit, drop it as a whole
+        openserial_vars.outputBufIdxW                                = openserial_vars.outputFrameIdxW;
+        openserial_vars.numOutputFramesDropped++;
+    }
+#ifdef OPENSERIAL_FULL_DUPLEX
+    else if (
+        openserial_vars.mode==MODE_DUPLEX &&
+        openserial_vars.outputBusy==FALSE
+    ) {
+        // the UART is idle, send the frame right away
+        openserial_txNext();
+    }
+#endif
 }
 
 //===== hdlc (input)
@@ -864,7 +1120,11 @@ port_INLINE void outputHdlcClose() {
 */
 port_INLINE void inputHdlcOpen() {
     // reset the input buffer index
+#ifdef OPENSERIAL_FULL_DUPLEX
+    openserial_vars.inputFrameLen                                    = 0;
+#else
     openserial_vars.inputBufFill                                     = 0;
+#endif
 
     // initialize the value of the CRC
     openserial_vars.inputCrc                                         = HDLC_CRCINIT;
@@ -882,8 +1142,16 @@ port_INLINE void inputHdlcWrite(uint8_t b) {
         }
         
         // add byte to input buffer
+#ifdef OPENSERIAL_FULL_DUPLEX
+        // in the input ring, behind the length byte of the frame, if it fits
+        if (openserial_vars.inputFrameLen<(uint8_t)(openserial_vars.inputRingIdxR-openserial_vars.inputRingIdxW-1)) {
+            openserial_vars.inputRing[(uint8_t)(openserial_vars.inputRingIdxW+1+openserial_vars.inputFrameLen)] = b;
+        }
+        openserial_vars.inputFrameLen++;
+#else
         openserial_vars.inputBuf[openserial_vars.inputBufFill] = b;
         openserial_vars.inputBufFill++;
+#endif
         
         // iterate through CRC calculator
         openserial_vars.inputCrc = crcIteration(openserial_vars.inputCrc,b);
@@ -899,12 +1167,36 @@ port_INLINE void inputHdlcClose() {
         // the CRC is correct
         
         // remove the CRC from the input buffer
+#ifdef OPENSERIAL_FULL_DUPLEX
+        openserial_vars.inputFrameLen   -= 2;
+        
+        // queue the frame, and have the stack handle it
+        if (
+            openserial_vars.inputFrameLen>0 &&
+            openserial_vars.inputFrameLen<=SERIAL_INPUT_BUFFER_SIZE
+        ) {
+            openserial_vars.inputRing[openserial_vars.inputRingIdxW] = openserial_vars.inputFrameLen;
+            openserial_vars.inputRingIdxW += 1+openserial_vars.inputFrameLen;
+            if (openserial_vars.inputTaskPending==FALSE) {
+                openserial_vars.inputTaskPending = TRUE;
+                scheduler_push_task(openserial_input_task_cb,TASKPRIO_OPENSERIAL);
+            }
+        } else {
+            // shorter than its CRC
+            openserial_vars.inputFrameLen = 0;
+        }
+#else
         openserial_vars.inputBufFill    -= 2;
+#endif
     } else {
         // the CRC is incorrect
         
         // drop the incoming fram
+#ifdef OPENSERIAL_FULL_DUPLEX
+        openserial_vars.inputFrameLen    = 0;
+#else
         openserial_vars.inputBufFill     = 0;
+#endif
     }
 }
 
@@ -927,6 +1219,16 @@ void isr_openserial_tx() {
                 uart_writeByte(openserial_vars.outputBuf[openserial_vars.outputBufIdxR++]);
             }
             break;
+#ifdef OPENSERIAL_FULL_DUPLEX
+        case MODE_DUPLEX:
+#ifdef UART_DMA_ENABLED
+            // the whole block is out, free its room
+            openserial_vars.outputBufIdxR  += openserial_vars.outputBlockLen;
+            openserial_vars.outputBlockLen  = 0;
+#endif
+            openserial_txNext();
+            break;
+#endif
         case MODE_OFF:
             default:
             break;
@@ -939,14 +1241,18 @@ void isr_openserial_rx() {
     uint8_t inputBufFill;
 
     // stop if I'm not in input mode
-    if (openserial_vars.mode!=MODE_INPUT) {
+    if ((openserial_vars.mode&MODE_INPUT)==0) {
         return;
     }
 
     // read byte just received
     rxbyte = uart_readByte();
     // keep length
+#ifdef OPENSERIAL_FULL_DUPLEX
+    inputBufFill=openserial_vars.inputFrameLen;
+#else
     inputBufFill=openserial_vars.inputBufFill;
+#endif
     
     if (
         openserial_vars.busyReceiving==FALSE  &&
@@ -971,6 +1277,22 @@ void isr_openserial_rx() {
 
         // add the byte just received
         inputHdlcWrite(rxbyte);
+#ifdef OPENSERIAL_FULL_DUPLEX
+        if (
+            openserial_vars.inputFrameLen+1>SERIAL_INPUT_BUFFER_SIZE ||
+            openserial_vars.inputFrameLen>=(uint8_t)(openserial_vars.inputRingIdxR-openserial_vars.inputRingIdxW-1)
+        ){
+            // input ring overflow, drop the frame but keep receiving
+            openserial_printError(
+                COMPONENT_OPENSERIAL,
+                ERR_INPUT_BUFFER_OVERFLOW,
+                (errorparameter_t)0,
+                (errorparameter_t)0
+            );
+            openserial_vars.inputFrameLen      = 0;
+            openserial_vars.busyReceiving      = FALSE;
+        }
+#else
         if (openserial_vars.inputBufFill+1>SERIAL_INPUT_BUFFER_SIZE){
             // input buffer overflow
             openserial_printError(
@@ -983,6 +1305,7 @@ void isr_openserial_rx() {
             openserial_vars.busyReceiving      = FALSE;
             openserial_stop();
         }
+#endif
     } else if (
         openserial_vars.busyReceiving==TRUE   &&
         rxbyte==HDLC_FLAG
@@ -992,7 +1315,11 @@ void isr_openserial_rx() {
         // finalize the HDLC frame
         inputHdlcClose();
         
+#ifdef OPENSERIAL_FULL_DUPLEX
+        if (openserial_vars.inputFrameLen==0){
+#else
         if (openserial_vars.inputBufFill==0){
+#endif
             // invalid HDLC frame
             openserial_printError(
                 COMPONENT_OPENSERIAL,
@@ -1003,7 +1330,9 @@ void isr_openserial_rx() {
         }
          
         openserial_vars.busyReceiving      = FALSE;
+#ifndef OPENSERIAL_FULL_DUPLEX
         openserial_stop();
+#endif
     }
     
     openserial_vars.lastRxByte = rxbyte;
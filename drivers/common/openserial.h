@@ -35,11 +35,50 @@
 */
 #define SERIAL_INPUT_BUFFER_SIZE  200
 
+/**
+\brief Full-duplex operation of the serial port.
+
+By default, the serial port is half-duplex: the MAC layer alternates between
+input and output, and a single input frame is accepted each time input is
+started. When OPENSERIAL_FULL_DUPLEX is defined, input and output run at the
+same time and are never stopped: received frames are queued in an input ring
+and handed to the stack by a task, and frames are transmitted as soon as they
+are written.
+
+In full-duplex mode, a board which defines UART_DMA_ENABLED transmits the
+output buffer in blocks through uart_writeBufferByLen(), which raises a single
+TX interrupt once the whole block is sent. Other boards transmit one byte per
+TX interrupt.
+*/
+#ifdef OPENSERIAL_FULL_DUPLEX
+/**
+\brief Number of bytes of the serial input ring, in bytes.
+
+Each received frame takes its length plus one byte in the ring.
+
+\warning should be exactly 256 so wrap-around on the index does not require
+         the use of a slow modulo operator.
+*/
+#define SERIAL_INPUT_RING_SIZE    256 // leave at 256!
+#endif
+
+/**
+\brief Delta-encoded status output.
+
+By default, openserial asks one module per serial output slot to print a
+status element with its debugPrint_* function, so refreshing a whole table on
+the host takes one slot per row. When OPENSERIAL_TELEMETRY is defined, the
+modules register their status elements with the opentelemetry registry
+instead, and each serial output slot carries a single telemetry frame with the
+bytes which changed. See opentelemetry.h for the frame format.
+*/
+
 /// Modes of the openserial module.
 enum {
    MODE_OFF    = 0, ///< The module is off, no serial activity.
    MODE_INPUT  = 1, ///< The serial is listening or receiving bytes.
-   MODE_OUTPUT = 2  ///< The serial is transmitting bytes.
+   MODE_OUTPUT = 2, ///< The serial is transmitting bytes.
+   MODE_DUPLEX = 3  ///< The serial is receiving and transmitting at the same time.
 };
 
 // frames sent mote->PC
@@ -50,6 +89,7 @@ enum {
 #define SERFRAME_MOTE2PC_CRITICAL                ((uint8_t)'C')
 #define SERFRAME_MOTE2PC_REQUEST                 ((uint8_t)'R')
 #define SERFRAME_MOTE2PC_SNIFFED_PACKET          ((uint8_t)'P')
+#define SERFRAME_MOTE2PC_TELEMETRY               ((uint8_t)'T')
 
 #ifndef DO_NOT_USE_FRAGMENTATION
 #define SERFRAME_MOTE2PC_BRIDGE                  ((uint8_t)'B')
@@ -106,6 +146,9 @@ typedef struct {
     uint8_t             mode;
     uint8_t             debugPrintCounter;
     openserial_rsvpt*   registeredCmd;
+    uint16_t            numTasksDroppedReported;
+    uint16_t            numOutputFramesDropped;
+    uint16_t            numOutputFramesDroppedReported;
     // input
     uint8_t             reqFrame[1+1+2+1]; // flag (1B), command (2B), CRC (2B), flag (1B)
     uint8_t             reqFrameIdx;
@@ -115,12 +158,27 @@ typedef struct {
     uint16_t            inputCrc;
     uint8_t             inputBufFill;
     uint8_t             inputBuf[SERIAL_INPUT_BUFFER_SIZE];
+#ifdef OPENSERIAL_FULL_DUPLEX
+    bool                inputTaskPending;  // the task handing frames to the stack is scheduled
+    uint8_t             inputFrameLen;     // number of bytes of the frame being received
+    uint8_t             inputRingIdxW;     // end of the last complete frame
+    uint8_t             inputRingIdxR;     // oldest frame not handed to the stack
+    uint8_t             inputRing[SERIAL_INPUT_RING_SIZE];
+#endif
     // output
     bool                outputBufFilled;
+    bool                outputFrameOverflow;
     uint16_t            outputCrc;
+    uint8_t             outputFrameIdxW;   // start of the frame being written
     uint8_t             outputBufIdxW;
     uint8_t             outputBufIdxR;
     uint8_t             outputBuf[SERIAL_OUTPUT_BUFFER_SIZE];
+#ifdef OPENSERIAL_FULL_DUPLEX
+    bool                outputBusy;        // the UART is transmitting bytes of outputBuf
+#ifdef UART_DMA_ENABLED
+    uint16_t            outputBlockLen;    // bytes handed to the UART, freed once sent
+#endif
+#endif
 } openserial_vars_t;
 
 // admin
@@ -153,6 +211,7 @@ owerror_t openserial_printCritical(
 );
 owerror_t openserial_printData(uint8_t* buffer, uint8_t length);
 owerror_t openserial_printSniffedPacket(uint8_t* buffer, uint8_t length, uint8_t channel);
+owerror_t openserial_printTelemetry(uint8_t* buffer, uint8_t length);
 
 #ifndef DO_NOT_USE_FRAGMENTATION
 owerror_t openserial_printBridge(uint8_t* buffer, uint8_t length);
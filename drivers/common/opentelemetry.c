@@ -0,0 +1,305 @@
+/**
+\brief Definition of the "opentelemetry" driver.
+*/
+
+#include "opendefs.h"
+#include "opentelemetry.h"
+#include "openserial.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+opentelemetry_vars_t opentelemetry_vars;
+
+//=========================== prototypes ======================================
+
+owerror_t opentelemetry_register(
+   uint8_t                    statusType,
+   uint8_t                    numRows,
+   uint8_t                    rowLen,
+   uint8_t*                   counters,
+   opentelemetry_getRow_cbt   getRow,
+   uint8_t                    period
+);
+void      opentelemetry_readRow(
+   opentelemetry_entry_t*     entry,
+   uint8_t                    row,
+   uint8_t*                   buf
+);
+bool      opentelemetry_writeRecords(
+   uint8_t*                   frame,
+   uint8_t*                   frameLen,
+   opentelemetry_entry_t*     entry,
+   uint8_t                    row,
+   uint8_t*                   buf,
+   bool                       force
+);
+void      opentelemetry_nextRow(uint8_t* entryIdx, uint8_t* row);
+
+//=========================== public ==========================================
+
+/**
+\brief Initialize this module.
+*/
+void opentelemetry_init() {
+   memset(&opentelemetry_vars,0,sizeof(opentelemetry_vars_t));
+}
+
+/**
+\brief Register counters, sent as a single status element.
+
+The counters are read directly from memory, each time a telemetry frame is
+built.
+
+\param[in] statusType The STATUS_* the counters are reported as.
+\param[in] counters   The counters.
+\param[in] len        The number of bytes to report, starting at counters.
+\param[in] period     Look for changes every period serial output slots.
+
+\returns E_SUCCESS if the counters were registered, E_FAIL otherwise.
+*/
+owerror_t opentelemetry_registerCounters(
+   uint8_t                    statusType,
+   uint8_t*                   counters,
+   uint8_t                    len,
+   uint8_t                    period
+) {
+   return opentelemetry_register(statusType,1,len,counters,NULL,period);
+}
+
+/**
+\brief Register a table, sent as one status element per row.
+
+\param[in] statusType The STATUS_* the rows are reported as.
+\param[in] numRows    The number of rows of the table.
+\param[in] rowLen     The number of bytes getRow writes, for each row.
+\param[in] getRow     The function which formats a row of the table.
+\param[in] period     Look for changes every period serial output slots.
+
+\returns E_SUCCESS if the table was registered, E_FAIL otherwise.
+*/
+owerror_t opentelemetry_registerTable(
+   uint8_t                    statusType,
+   uint8_t                    numRows,
+   uint8_t                    rowLen,
+   opentelemetry_getRow_cbt   getRow,
+   uint8_t                    period
+) {
+   return opentelemetry_register(statusType,numRows,rowLen,NULL,getRow,period);
+}
+
+/**
+\brief Print the changes to the registered status elements, over serial.
+
+Called by openserial at each serial output slot, in place of the debugPrint_*
+functions. The search for changes resumes where the previous frame ran out of
+room, so a large table does not starve the elements registered after it.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool opentelemetry_print() {
+   uint8_t                    frame[OPENTELEMETRY_FRAME_LEN];
+   uint8_t                    frameLen;
+   uint8_t                    buf[OPENTELEMETRY_MAXROWLEN];
+   uint8_t                    entryIdx;
+   uint8_t                    row;
+   uint16_t                   numRows;
+   uint16_t                   i;
+   bool                       isFull;
+   opentelemetry_entry_t*     entry;
+
+   if (opentelemetry_vars.numEntries==0) {
+      return FALSE;
+   }
+
+   frame[0]  = opentelemetry_vars.seqNum;
+   frameLen  = 1;
+
+   // count the rows, to visit each of them at most once
+   numRows   = 0;
+   for (i=0;i<opentelemetry_vars.numEntries;i++) {
+      numRows += opentelemetry_vars.entries[i].numRows;
+   }
+
+   //=== changed bytes
+
+   entryIdx  = opentelemetry_vars.deltaEntry;
+   row       = opentelemetry_vars.deltaRow;
+   isFull    = FALSE;
+   for (i=0;i<numRows;i++) {
+      entry  = &opentelemetry_vars.entries[entryIdx];
+      if ((opentelemetry_vars.numSlots&entry->periodMask)==0) {
+         opentelemetry_readRow(entry,row,buf);
+         if (opentelemetry_writeRecords(frame,&frameLen,entry,row,buf,FALSE)==FALSE) {
+            // resume from this row, its remaining changes go in the next frame
+            isFull = TRUE;
+            break;
+         }
+      }
+      opentelemetry_nextRow(&entryIdx,&row);
+   }
+   opentelemetry_vars.deltaEntry = entryIdx;
+   opentelemetry_vars.deltaRow   = row;
+   opentelemetry_vars.numSlots++;
+
+   //=== rolling refresh
+
+   entry     = &opentelemetry_vars.entries[opentelemetry_vars.refreshEntry];
+   if (opentelemetry_vars.refreshCountdown>0) {
+      opentelemetry_vars.refreshCountdown--;
+   } else if (
+         isFull==FALSE &&
+         frameLen+OPENTELEMETRY_RECORD_HDR_LEN+entry->rowLen<=OPENTELEMETRY_FRAME_LEN
+      ) {
+      opentelemetry_readRow(entry,opentelemetry_vars.refreshRow,buf);
+      opentelemetry_writeRecords(frame,&frameLen,entry,opentelemetry_vars.refreshRow,buf,TRUE);
+      opentelemetry_nextRow(&opentelemetry_vars.refreshEntry,&opentelemetry_vars.refreshRow);
+      opentelemetry_vars.refreshCountdown = OPENTELEMETRY_REFRESH_PERIOD-1;
+   }
+
+   if (frameLen==1) {
+      // no records
+      return FALSE;
+   }
+
+   // the sequence number advances even if openserial drops the frame, so
+   // the host sees the gap
+   openserial_printTelemetry(frame,frameLen);
+   opentelemetry_vars.seqNum++;
+
+   return TRUE;
+}
+
+//=========================== private =========================================
+
+owerror_t opentelemetry_register(
+   uint8_t                    statusType,
+   uint8_t                    numRows,
+   uint8_t                    rowLen,
+   uint8_t*                   counters,
+   opentelemetry_getRow_cbt   getRow,
+   uint8_t                    period
+) {
+#ifdef OPENSERIAL_TELEMETRY
+   opentelemetry_entry_t* entry;
+
+   if (
+         opentelemetry_vars.numEntries>=OPENTELEMETRY_MAXENTRIES                    ||
+         numRows==0 || rowLen==0 || rowLen>OPENTELEMETRY_MAXROWLEN                  ||
+         period==0  || (period&(period-1))!=0                                       ||
+         opentelemetry_vars.shadowLen+(uint16_t)numRows*rowLen>OPENTELEMETRY_SHADOW_LEN
+      ) {
+      openserial_printError(
+         COMPONENT_OPENSERIAL,
+         ERR_TELEMETRY_REGISTRY_FULL,
+         (errorparameter_t)statusType,
+         (errorparameter_t)rowLen
+      );
+      return E_FAIL;
+   }
+
+   entry                          = &opentelemetry_vars.entries[opentelemetry_vars.numEntries];
+   entry->statusType              = statusType;
+   entry->numRows                 = numRows;
+   entry->rowLen                  = rowLen;
+   entry->periodMask              = period-1;
+   entry->counters                = counters;
+   entry->getRow                  = getRow;
+   entry->shadowIdx               = opentelemetry_vars.shadowLen;
+
+   opentelemetry_vars.shadowLen  += (uint16_t)numRows*rowLen;
+   opentelemetry_vars.numEntries++;
+#endif
+
+   return E_SUCCESS;
+}
+
+void opentelemetry_readRow(opentelemetry_entry_t* entry, uint8_t row, uint8_t* buf) {
+   if (entry->counters!=NULL) {
+      memcpy(buf,entry->counters,entry->rowLen);
+   } else {
+      entry->getRow(row,buf);
+   }
+}
+
+/**
+\brief Append the bytes of a status element which differ from its shadow.
+
+Runs of changed bytes separated by fewer unchanged bytes than a record header
+are sent as a single record. The shadow is updated with the bytes written.
+
+\param[in,out] frame    The telemetry frame being built.
+\param[in,out] frameLen The number of bytes in frame.
+\param[in]     entry    The registered entry the status element belongs to.
+\param[in]     row      The row of the status element.
+\param[in]     buf      The current value of the status element.
+\param[in]     force    Write the whole status element, changed or not.
+
+\returns TRUE if all the changes were written, FALSE if the frame is full.
+*/
+bool opentelemetry_writeRecords(
+   uint8_t*                   frame,
+   uint8_t*                   frameLen,
+   opentelemetry_entry_t*     entry,
+   uint8_t                    row,
+   uint8_t*                   buf,
+   bool                       force
+) {
+   uint8_t*  shadow;
+   uint8_t   start;
+   uint8_t   end;
+   uint8_t   len;
+   uint8_t   i;
+
+   shadow = &opentelemetry_vars.shadow[entry->shadowIdx+(uint16_t)row*entry->rowLen];
+
+   i = 0;
+   while (i<entry->rowLen) {
+      if (force==FALSE && buf[i]==shadow[i]) {
+         i++;
+         continue;
+      }
+
+      // find the end of the run
+      start  = i;
+      end    = i+1;
+      for (i=end;i<entry->rowLen && i-end<OPENTELEMETRY_RECORD_HDR_LEN;i++) {
+         if (force==TRUE || buf[i]!=shadow[i]) {
+            end = i+1;
+         }
+      }
+
+      if (*frameLen+OPENTELEMETRY_RECORD_HDR_LEN>=OPENTELEMETRY_FRAME_LEN) {
+         return FALSE;
+      }
+      len = end-start;
+      if (len>OPENTELEMETRY_FRAME_LEN-*frameLen-OPENTELEMETRY_RECORD_HDR_LEN) {
+         len = OPENTELEMETRY_FRAME_LEN-*frameLen-OPENTELEMETRY_RECORD_HDR_LEN;
+      }
+
+      frame[(*frameLen)++] = entry->statusType;
+      frame[(*frameLen)++] = row;
+      frame[(*frameLen)++] = start;
+      frame[(*frameLen)++] = len;
+      memcpy(&frame[*frameLen],&buf[start],len);
+      memcpy(&shadow[start],&buf[start],len);
+      *frameLen += len;
+
+      if (start+len<end) {
+         // the run was cut
+         return FALSE;
+      }
+      i = end;
+   }
+
+   return TRUE;
+}
+
+void opentelemetry_nextRow(uint8_t* entryIdx, uint8_t* row) {
+   (*row)++;
+   if (*row>=opentelemetry_vars.entries[*entryIdx].numRows) {
+      *row      = 0;
+      *entryIdx = (*entryIdx+1)%opentelemetry_vars.numEntries;
+   }
+}
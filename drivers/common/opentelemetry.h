@@ -0,0 +1,110 @@
+/**
+\brief Declaration of the "opentelemetry" driver.
+
+Modules register their status counters and tables with this registry. When
+OPENSERIAL_TELEMETRY is defined, openserial no longer prints one status element
+per serial slot with the debugPrint_* functions. It calls opentelemetry_print()
+instead, which sends only the bytes which changed since they were last sent,
+packed into a single telemetry frame.
+
+A telemetry frame carries a one-byte sequence number, followed by records:
+
+<pre>
+| statusType | row | offset | length | length bytes of the status element |
+</pre>
+
+Each record patches the copy of one status element (a row of a table, row 0
+for counters) the host keeps. The host starts from all-zero elements. The
+bytes of a status element are the ones the corresponding debugPrint_*
+function prints. To let the host recover from a lost frame, which it detects
+by a gap in the sequence numbers, every OPENTELEMETRY_REFRESH_PERIOD-th frame
+also carries the next status element of a rolling full refresh, if it has room
+for it.
+*/
+
+#ifndef __OPENTELEMETRY_H
+#define __OPENTELEMETRY_H
+
+/**
+\addtogroup drivers
+\{
+\addtogroup OpenTelemetry
+\{
+*/
+
+#include "opendefs.h"
+
+//=========================== define ==========================================
+
+#ifdef OPENSERIAL_TELEMETRY
+#define OPENTELEMETRY_MAXENTRIES       16
+#define OPENTELEMETRY_SHADOW_LEN       1024     // bytes, for all registered status elements
+#else
+// registrations are ignored, keep the registry as small as possible
+#define OPENTELEMETRY_MAXENTRIES       1
+#define OPENTELEMETRY_SHADOW_LEN       1
+#endif
+
+#define OPENTELEMETRY_MAXROWLEN        64       // largest status element, in bytes
+#define OPENTELEMETRY_FRAME_LEN        96       // largest telemetry frame payload, in bytes
+#define OPENTELEMETRY_RECORD_HDR_LEN   4        // statusType, row, offset, length
+#define OPENTELEMETRY_REFRESH_PERIOD   8        // frames between two status elements of the refresh
+
+/// Sampling periods, in serial output slots. A period must be a power of 2.
+#define OPENTELEMETRY_PERIOD_ALWAYS    1
+#define OPENTELEMETRY_PERIOD_SLOW      16       // for elements which change at (almost) every slot
+
+//=========================== typedef =========================================
+
+typedef void (*opentelemetry_getRow_cbt)(uint8_t row, uint8_t* buf);
+
+typedef struct {
+   uint8_t                    statusType;    // STATUS_*
+   uint8_t                    numRows;
+   uint8_t                    rowLen;
+   uint8_t                    periodMask;    // sampled when numSlots&periodMask is 0
+   uint8_t*                   counters;      // registered counters, NULL for a table
+   opentelemetry_getRow_cbt   getRow;        // fills buf with one row of a table
+   uint16_t                   shadowIdx;     // first byte of this entry in shadow
+} opentelemetry_entry_t;
+
+//=========================== module variables ================================
+
+typedef struct {
+   opentelemetry_entry_t      entries[OPENTELEMETRY_MAXENTRIES];
+   uint8_t                    numEntries;
+   uint8_t                    shadow[OPENTELEMETRY_SHADOW_LEN]; // status elements as last sent
+   uint16_t                   shadowLen;
+   uint8_t                    seqNum;
+   uint8_t                    numSlots;      // serial output slots, sent a frame or not
+   uint8_t                    deltaEntry;    // where the next frame resumes looking for changes
+   uint8_t                    deltaRow;
+   uint8_t                    refreshEntry;  // next status element of the rolling refresh
+   uint8_t                    refreshRow;
+   uint8_t                    refreshCountdown; // frames until the next refresh
+} opentelemetry_vars_t;
+
+//=========================== prototypes ======================================
+
+void      opentelemetry_init(void);
+owerror_t opentelemetry_registerCounters(
+   uint8_t                    statusType,
+   uint8_t*                   counters,
+   uint8_t                    len,
+   uint8_t                    period
+);
+owerror_t opentelemetry_registerTable(
+   uint8_t                    statusType,
+   uint8_t                    numRows,
+   uint8_t                    rowLen,
+   opentelemetry_getRow_cbt   getRow,
+   uint8_t                    period
+);
+bool      opentelemetry_print(void);
+
+/**
+\}
+\}
+*/
+
+#endif
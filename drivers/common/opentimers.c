@@ -4,6 +4,11 @@
 This driver uses a single hardware timer, which it virtualizes to support
 at most MAX_NUM_TIMERS timers.
 
+Running timers are kept in a binary min-heap, ordered by how far their compare
+value is past lastTimeout. The earliest timer is at the root, so expiring and
+scheduling timers costs O(log MAX_NUM_TIMERS), plus the few timers falling
+within TIMERTHRESHOLD of the earliest one, which are looked at for priority.
+
 \author Tengfei Chang <tengfei.chang@inria.fr>, April 2017.
  */
 
@@ -20,7 +25,15 @@ opentimers_vars_t opentimers_vars;
 
 //=========================== prototypes ======================================
 
-void  opentimers_timer_callback(void);
+void             opentimers_timer_callback(void);
+PORT_TIMER_WIDTH opentimers_gap(opentimers_id_t id);
+bool             opentimers_isEarlier(opentimers_id_t id1, opentimers_id_t id2);
+void             opentimers_heapInsert(opentimers_id_t id);
+void             opentimers_heapRemove(opentimers_id_t id);
+void             opentimers_heapSiftUp(uint8_t pos);
+void             opentimers_heapSiftDown(uint8_t pos);
+uint8_t          opentimers_heapCollect(PORT_TIMER_WIDTH maxGap, uint8_t* ids);
+void             opentimers_setNextCompare(void);
 
 //=========================== public ==========================================
 
@@ -77,21 +90,17 @@ void opentimers_scheduleIn(opentimers_id_t    id,
                            time_type_t        uint_type, 
                            timer_type_t       timer_type, 
                            opentimers_cbt     cb){
-    uint8_t  i;
-    uint8_t  idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
     // 1. make sure the timer exist
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isUsed && i == id){
-            break;
-        }
-    }
-    if (i==MAX_NUM_TIMERS){
+    if (id>=MAX_NUM_TIMERS || opentimers_vars.timersBuf[id].isUsed==FALSE){
         // doesn't find the timer
         return;
     }
     
+    // a running timer is rescheduled
+    if (opentimers_vars.timersBuf[id].isrunning){
+        opentimers_heapRemove(id);
+    }
+    
     opentimers_vars.timersBuf[id].timerType = timer_type;
     
     // 2. updat the timer content
@@ -114,49 +123,13 @@ void opentimers_scheduleIn(opentimers_id_t    id,
     
     opentimers_vars.timersBuf[id].isrunning           = TRUE;
     opentimers_vars.timersBuf[id].callback            = cb;
+    opentimers_heapInsert(id);
     
     // 3. find the next timer to fire
     
     // only execute update the currenttimeout if I am not inside of ISR or the ISR itself will do this.
     if (opentimers_vars.insideISR==FALSE){
-        timerGap     = opentimers_vars.timersBuf[0].currentCompareValue-opentimers_vars.lastTimeout;
-        idToSchedule = 0;
-        for (i=1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastTimeout;
-                if (tempTimerGap < timerGap){
-                    // if a timer "i" has low priority but has compare value less than 
-                    // candidate timer "idToSchedule" more than TIMERTHRESHOLD ticks, 
-                    // replace candidate timer by this timer "i".
-                    if (opentimers_vars.timersBuf[i].priority > opentimers_vars.timersBuf[idToSchedule].priority){
-                        if (timerGap-tempTimerGap > TIMERTHRESHOLD){
-                            timerGap     = tempTimerGap;
-                            idToSchedule = i;
-                        }
-                    } else {
-                        // a timer "i" has higher priority than candidate timer "idToSchedule" 
-                        // and compare value less than candidate timer replace candidate 
-                        // timer by timer "i".
-                        timerGap     = tempTimerGap;
-                        idToSchedule = i;
-                    }
-                } else {
-                    // if a timer "i" has higher priority than candidate timer "idToSchedule" 
-                    // and its compare value is larger than timer "i" no more than TIMERTHRESHOLD ticks,
-                    // replace candidate timer by timer "i".
-                    if (opentimers_vars.timersBuf[i].priority < opentimers_vars.timersBuf[idToSchedule].priority){
-                        if (tempTimerGap - timerGap < TIMERTHRESHOLD){
-                            timerGap     = tempTimerGap;
-                            idToSchedule = i;
-                        }
-                    }
-                }
-            }
-        }
-        
-        // if I got here, assign the next to be fired timer to given timer
-        opentimers_vars.currentTimeout = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentTimeout);
+        opentimers_setNextCompare();
     }
     opentimers_vars.running        = TRUE;
 }
@@ -178,21 +151,17 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
                                  PORT_TIMER_WIDTH   reference , 
                                  time_type_t        uint_type, 
                                  opentimers_cbt     cb){
-    uint8_t  i;
-    uint8_t idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
     // 1. make sure the timer exist
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isUsed && i == id){
-            break;
-        }
-    }
-    if (i==MAX_NUM_TIMERS){
+    if (id>=MAX_NUM_TIMERS || opentimers_vars.timersBuf[id].isUsed==FALSE){
         // doesn't find the timer
         return;
     }
     
+    // a running timer is rescheduled
+    if (opentimers_vars.timersBuf[id].isrunning){
+        opentimers_heapRemove(id);
+    }
+    
     // absolute scheduling is for one shot timer
     opentimers_vars.timersBuf[id].timerType = TIMER_ONESHOT;
     
@@ -216,49 +185,13 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
 
     opentimers_vars.timersBuf[id].isrunning           = TRUE;
     opentimers_vars.timersBuf[id].callback            = cb;
+    opentimers_heapInsert(id);
     
     // 3. find the next timer to fire
     
     // only execute update the currenttimeout if I am not inside of ISR or the ISR itself will do this.
     if (opentimers_vars.insideISR==FALSE){
-        timerGap     = opentimers_vars.timersBuf[0].currentCompareValue-opentimers_vars.lastTimeout;
-        idToSchedule = 0;
-        for (i=1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastTimeout;
-                if (tempTimerGap < timerGap){
-                    // if a timer "i" has low priority but has compare value less than 
-                    // candidate timer "idToSchedule" more than TIMERTHRESHOLD ticks, 
-                    // replace candidate timer by this timer "i".
-                    if (opentimers_vars.timersBuf[i].priority > opentimers_vars.timersBuf[idToSchedule].priority){
-                        if (timerGap-tempTimerGap > TIMERTHRESHOLD){
-                            timerGap     = tempTimerGap;
-                            idToSchedule = i;
-                        }
-                    } else {
-                        // a timer "i" has higher priority than candidate timer "idToSchedule" 
-                        // and compare value less than candidate timer replace candidate 
-                        // timer by timer "i".
-                        timerGap     = tempTimerGap;
-                        idToSchedule = i;
-                    }
-                } else {
-                    // if a timer "i" has higher priority than candidate timer "idToSchedule" 
-                    // and its compare value is larger than timer "i" no more than TIMERTHRESHOLD ticks,
-                    // replace candidate timer by timer "i".
-                    if (opentimers_vars.timersBuf[i].priority < opentimers_vars.timersBuf[idToSchedule].priority){
-                        if (tempTimerGap - timerGap < TIMERTHRESHOLD){
-                            timerGap     = tempTimerGap;
-                            idToSchedule = i;
-                        }
-                    }
-                }
-            }
-        }
-        
-        // if I got here, assign the next to be fired timer to given timer
-        opentimers_vars.currentTimeout = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentTimeout);
+        opentimers_setNextCompare();
     }
     opentimers_vars.running        = TRUE;
 }
@@ -272,6 +205,9 @@ isrunning as false. The timer may be recover later.
 \param[in] id the timer id
  */
 void opentimers_cancel(opentimers_id_t id){
+    if (opentimers_vars.timersBuf[id].isrunning){
+        opentimers_heapRemove(id);
+    }
     opentimers_vars.timersBuf[id].isrunning = FALSE;
     opentimers_vars.timersBuf[id].callback  = NULL;
 }
@@ -287,6 +223,9 @@ Reset the whole entry of given timer including the id.
  */
 bool opentimers_destroy(opentimers_id_t id){
     if (id<MAX_NUM_TIMERS){
+        if (opentimers_vars.timersBuf[id].isrunning){
+            opentimers_heapRemove(id);
+        }
         memset(&opentimers_vars.timersBuf[id],0,sizeof(opentimers_t));
         return TRUE;
     } else {
@@ -341,126 +280,265 @@ void opentimers_setPriority(opentimers_id_t id, uint8_t priority){
 /**
 \brief this is the callback function of opentimer2.
 
-This function is called when sctimer interrupt happens. The function looks the 
-whole timer buffer and find out the correct timer responding to the interrupt
-and call the callback recorded for that timer.
+This function is called when sctimer interrupt happens. The expired timers are
+the running ones whose compare value lies between lastTimeout and the compare
+value which just fired; they are collected from the top of the heap. The ones
+with the highest priority get their callback called, the others are left in the
+heap and will be scheduled right away.
  */
 void opentimers_timer_callback(void){
-    uint8_t i;
-    uint8_t j;
-    uint8_t idToCallCB;
-    uint8_t idToSchedule;
+    uint8_t          i;
+    uint8_t          j;
+    uint8_t          numExpired;
+    uint8_t          idsExpired[MAX_NUM_TIMERS];
+    uint8_t          priority;
     PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
-    PORT_TIMER_WIDTH tempLastTimeout = opentimers_vars.currentTimeout;
-    // 1. find the expired timer
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isrunning==TRUE){
-            // all timers in the past within TIMERTHRESHOLD ticks
-            // (probably with low priority) will mared as Expired.
-            if (opentimers_vars.currentTimeout-opentimers_vars.timersBuf[i].currentCompareValue <= TIMERTHRESHOLD){
-                // this timer expired, mark as expired
-                opentimers_vars.timersBuf[i].hasExpired = TRUE;
-                // find the fired timer who has the smallest currentTimeout as last Timeout
-                if (tempLastTimeout>opentimers_vars.timersBuf[i].currentCompareValue){
-                    tempLastTimeout = opentimers_vars.timersBuf[i].currentCompareValue;
-                }
-            }
-        }
-    }
+    PORT_TIMER_WIDTH startISR;
+    PORT_TIMER_WIDTH durationISR;
     
-    // update lastTimeout
-    opentimers_vars.lastTimeout                               = tempLastTimeout;
+    startISR = sctimer_readCounter();
+    
+    // 1. find the expired timers
+    timerGap   = opentimers_vars.currentTimeout-opentimers_vars.lastTimeout;
+    numExpired = opentimers_heapCollect(timerGap,idsExpired);
+    
+    // update lastTimeout, the earliest expired timer becomes the reference.
+    // Nothing left in the heap is earlier than it, so the heap stays ordered.
+    if (numExpired>0){
+        opentimers_vars.lastTimeout = opentimers_vars.timersBuf[opentimers_vars.heap[0]].currentCompareValue;
+    } else {
+        opentimers_vars.lastTimeout = opentimers_vars.currentTimeout;
+    }
+    timerGap = opentimers_vars.currentTimeout-opentimers_vars.lastTimeout;
     
     // 2. call the callback of expired timers
     opentimers_vars.insideISR = TRUE;
     
-    idToCallCB = TOO_MANY_TIMERS_ERROR;
-    // find out the timer expired with highest priority 
-    for (j=0;j<MAX_NUM_TIMERS;j++){
-        if (opentimers_vars.timersBuf[j].hasExpired == TRUE){
-            if (idToCallCB==TOO_MANY_TIMERS_ERROR){
-                idToCallCB = j;
-            } else {
-                if (opentimers_vars.timersBuf[j].priority<opentimers_vars.timersBuf[idToCallCB].priority){
-                    idToCallCB = j;
-                }
-            }
+    // find out the timer expired with highest priority
+    priority = 0xff;
+    for (i=0;i<numExpired;i++){
+        if (opentimers_vars.timersBuf[idsExpired[i]].priority<priority){
+            priority = opentimers_vars.timersBuf[idsExpired[i]].priority;
         }
     }
-    if (idToCallCB==TOO_MANY_TIMERS_ERROR){
-        // no more timer expired
-    } else {
-        // call all timers expired having the same priority with timer idToCallCB
-        for (j=0;j<MAX_NUM_TIMERS;j++){
-            if (
-                opentimers_vars.timersBuf[j].hasExpired == TRUE &&
-                opentimers_vars.timersBuf[j].priority   == opentimers_vars.timersBuf[idToCallCB].priority
-            ){
-                opentimers_vars.timersBuf[j].lastCompareValue    = opentimers_vars.timersBuf[j].currentCompareValue;
-                if (opentimers_vars.timersBuf[j].wraps_remaining==0){
-                    opentimers_vars.timersBuf[j].isrunning           = FALSE;
-                    opentimers_vars.timersBuf[j].hasExpired          = FALSE;
-                    opentimers_vars.timersBuf[j].callback(j);
-                    if (opentimers_vars.timersBuf[j].timerType==TIMER_PERIODIC){
-                        opentimers_scheduleIn(j,
-                                              opentimers_vars.timersBuf[j].totalTimerPeriod,
-                                              TIME_TICS,
-                                              TIMER_PERIODIC,
-                                              opentimers_vars.timersBuf[j].callback
-                        );
-                    }
-                } else {
-                    opentimers_vars.timersBuf[j].wraps_remaining--;
-                    if (opentimers_vars.timersBuf[j].wraps_remaining == 0){
-                        opentimers_vars.timersBuf[j].currentCompareValue = (opentimers_vars.timersBuf[j].totalTimerPeriod+opentimers_vars.timersBuf[j].lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-                    } else {
-                        opentimers_vars.timersBuf[j].currentCompareValue = opentimers_vars.timersBuf[j].lastCompareValue + MAX_TICKS_IN_SINGLE_CLOCK;
-                    }
-                    opentimers_vars.timersBuf[j].hasExpired          = FALSE;
-                }
+    // call all timers expired having that priority
+    for (i=0;i<numExpired;i++){
+        j = idsExpired[i];
+        if (
+            opentimers_vars.timersBuf[j].priority   != priority ||
+            opentimers_vars.timersBuf[j].isrunning  == FALSE    ||
+            opentimers_gap(j)                        > timerGap
+        ){
+            // lower priority, or cancelled/rescheduled by an earlier callback
+            continue;
+        }
+        opentimers_vars.timersBuf[j].lastCompareValue    = opentimers_vars.timersBuf[j].currentCompareValue;
+        opentimers_heapRemove(j);
+        if (opentimers_vars.timersBuf[j].wraps_remaining==0){
+            opentimers_vars.timersBuf[j].isrunning           = FALSE;
+            opentimers_vars.timersBuf[j].callback(j);
+            if (opentimers_vars.timersBuf[j].timerType==TIMER_PERIODIC){
+                opentimers_scheduleIn(j,
+                                      opentimers_vars.timersBuf[j].totalTimerPeriod,
+                                      TIME_TICS,
+                                      TIMER_PERIODIC,
+                                      opentimers_vars.timersBuf[j].callback
+                );
             }
+        } else {
+            opentimers_vars.timersBuf[j].wraps_remaining--;
+            if (opentimers_vars.timersBuf[j].wraps_remaining == 0){
+                opentimers_vars.timersBuf[j].currentCompareValue = (opentimers_vars.timersBuf[j].totalTimerPeriod+opentimers_vars.timersBuf[j].lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+            } else {
+                opentimers_vars.timersBuf[j].currentCompareValue = opentimers_vars.timersBuf[j].lastCompareValue + MAX_TICKS_IN_SINGLE_CLOCK;
+            }
+            opentimers_heapInsert(j);
         }
     }
     opentimers_vars.insideISR = FALSE;
-      
-    // 3. find the next timer to be fired
-    timerGap     = opentimers_vars.timersBuf[0].currentCompareValue+opentimers_vars.timersBuf[0].wraps_remaining*MAX_TICKS_IN_SINGLE_CLOCK-opentimers_vars.lastTimeout;
-    idToSchedule = 0;
-    for (i=1;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isrunning){
-            tempTimerGap = opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastTimeout;
-            if (tempTimerGap < timerGap){
-                // if a timer "i" has low priority but has compare value less than 
-                // candidate timer "idToSchedule" more than TIMERTHRESHOLD ticks, 
-                // replace candidate timer by this timer "i".
-                if (opentimers_vars.timersBuf[i].priority > opentimers_vars.timersBuf[idToSchedule].priority){
-                    if (timerGap-tempTimerGap > TIMERTHRESHOLD){
-                        timerGap     = tempTimerGap;
-                        idToSchedule = i;
-                    }
-                } else {
-                    // a timer "i" has higher priority than candidate timer "idToSchedule" 
-                    // and compare value less than candidate timer replace candidate 
-                    // timer by timer "i".
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            } else {
-                // if a timer "i" has higher priority than candidate timer "idToSchedule" 
-                // and its compare value is larger than timer "i" no more than TIMERTHRESHOLD ticks,
-                // replace candidate timer by timer "i".
-                if (opentimers_vars.timersBuf[i].priority < opentimers_vars.timersBuf[idToSchedule].priority){
-                    if (tempTimerGap - timerGap < TIMERTHRESHOLD){
-                        timerGap     = tempTimerGap;
-                        idToSchedule = i;
-                    }
-                }
+    
+    // 3. find the next timer to be fired and reschedule it
+    opentimers_setNextCompare();
+    
+    // 4. keep track of the time spent in here
+    durationISR = sctimer_readCounter()-startISR;
+    if (durationISR>opentimers_vars.maxDurationISR){
+        opentimers_vars.maxDurationISR = durationISR;
+    }
+    if (durationISR>MAX_DURATION_ISR){
+        opentimers_vars.numOverrunsISR++;
+    }
+}
+
+//=========================== private =========================================
+
+/**
+\brief how far the compare value of a timer is past lastTimeout.
+
+This is the key the heap is ordered by.
+ */
+PORT_TIMER_WIDTH opentimers_gap(opentimers_id_t id){
+    return opentimers_vars.timersBuf[id].currentCompareValue-opentimers_vars.lastTimeout;
+}
+
+/**
+\brief should timer id1 sit above timer id2 in the heap?
+
+Timers expiring at the same time are ordered by priority.
+ */
+bool opentimers_isEarlier(opentimers_id_t id1, opentimers_id_t id2){
+    PORT_TIMER_WIDTH gap1;
+    PORT_TIMER_WIDTH gap2;
+    
+    gap1 = opentimers_gap(id1);
+    gap2 = opentimers_gap(id2);
+    if (gap1!=gap2){
+        return gap1<gap2;
+    }
+    return opentimers_vars.timersBuf[id1].priority<opentimers_vars.timersBuf[id2].priority;
+}
+
+void opentimers_heapInsert(opentimers_id_t id){
+    uint8_t pos;
+    
+    pos                                   = opentimers_vars.heapSize++;
+    opentimers_vars.heap[pos]             = id;
+    opentimers_vars.timersBuf[id].heapIndex = pos;
+    opentimers_heapSiftUp(pos);
+}
+
+void opentimers_heapRemove(opentimers_id_t id){
+    opentimers_id_t moved;
+    uint8_t         pos;
+    
+    pos   = opentimers_vars.timersBuf[id].heapIndex;
+    moved = opentimers_vars.heap[--opentimers_vars.heapSize];
+    if (moved!=id){
+        // move the last entry into the hole, it may need to go either way
+        opentimers_vars.heap[pos]                  = moved;
+        opentimers_vars.timersBuf[moved].heapIndex = pos;
+        opentimers_heapSiftUp(pos);
+        opentimers_heapSiftDown(opentimers_vars.timersBuf[moved].heapIndex);
+    }
+}
+
+void opentimers_heapSiftUp(uint8_t pos){
+    opentimers_id_t id;
+    uint8_t         parent;
+    
+    id = opentimers_vars.heap[pos];
+    while (pos>0){
+        parent = (pos-1)/2;
+        if (opentimers_isEarlier(id,opentimers_vars.heap[parent])==FALSE){
+            break;
+        }
+        opentimers_vars.heap[pos] = opentimers_vars.heap[parent];
+        opentimers_vars.timersBuf[opentimers_vars.heap[pos]].heapIndex = pos;
+        pos = parent;
+    }
+    opentimers_vars.heap[pos]             = id;
+    opentimers_vars.timersBuf[id].heapIndex = pos;
+}
+
+void opentimers_heapSiftDown(uint8_t pos){
+    opentimers_id_t id;
+    uint8_t         child;
+    
+    id = opentimers_vars.heap[pos];
+    while (2*pos+1<opentimers_vars.heapSize){
+        child = 2*pos+1;
+        if (
+            child+1<opentimers_vars.heapSize &&
+            opentimers_isEarlier(opentimers_vars.heap[child+1],opentimers_vars.heap[child])
+        ){
+            child++;
+        }
+        if (opentimers_isEarlier(opentimers_vars.heap[child],id)==FALSE){
+            break;
+        }
+        opentimers_vars.heap[pos] = opentimers_vars.heap[child];
+        opentimers_vars.timersBuf[opentimers_vars.heap[pos]].heapIndex = pos;
+        pos = child;
+    }
+    opentimers_vars.heap[pos]             = id;
+    opentimers_vars.timersBuf[id].heapIndex = pos;
+}
+
+/**
+\brief collect the running timers whose gap is at most maxGap.
+
+Subtrees rooted at a later timer are skipped, so this only visits the timers
+returned plus their direct children.
+
+\param[in]  maxGap the largest gap to collect.
+\param[out] ids    the ids of the timers found, at least MAX_NUM_TIMERS long.
+
+\returns the number of timers found.
+ */
+uint8_t opentimers_heapCollect(PORT_TIMER_WIDTH maxGap, uint8_t* ids){
+    uint8_t stack[MAX_NUM_TIMERS];
+    uint8_t stackSize;
+    uint8_t numIds;
+    uint8_t pos;
+    
+    numIds    = 0;
+    stackSize = 0;
+    if (opentimers_vars.heapSize>0){
+        stack[stackSize++] = 0;
+    }
+    while (stackSize>0){
+        pos = stack[--stackSize];
+        if (opentimers_gap(opentimers_vars.heap[pos])>maxGap){
+            continue;
+        }
+        ids[numIds++] = opentimers_vars.heap[pos];
+        if (2*pos+1<opentimers_vars.heapSize){
+            stack[stackSize++] = 2*pos+1;
+        }
+        if (2*pos+2<opentimers_vars.heapSize){
+            stack[stackSize++] = 2*pos+2;
+        }
+    }
+    return numIds;
+}
+
+/**
+\brief program the sctimer with the next timer to fire.
+
+This is the earliest running timer, unless a timer with a higher priority
+expires less than TIMERTHRESHOLD ticks after it.
+ */
+void opentimers_setNextCompare(void){
+    uint8_t          i;
+    uint8_t          numCandidates;
+    uint8_t          idsCandidate[MAX_NUM_TIMERS];
+    uint8_t          idToSchedule;
+    PORT_TIMER_WIDTH maxGap;
+    
+    if (opentimers_vars.heapSize==0){
+        // nothing to schedule
+        return;
+    }
+    
+    idToSchedule = opentimers_vars.heap[0];
+    maxGap       = opentimers_gap(idToSchedule);
+    if (maxGap<(PORT_TIMER_WIDTH)(maxGap+TIMERTHRESHOLD-1)){
+        maxGap  += TIMERTHRESHOLD-1;
+    }
+    numCandidates = opentimers_heapCollect(maxGap,idsCandidate);
+    for (i=0;i<numCandidates;i++){
+        if (opentimers_vars.timersBuf[idsCandidate[i]].priority<opentimers_vars.timersBuf[idToSchedule].priority){
+            idToSchedule = idsCandidate[i];
+        } else {
+            if (
+                opentimers_vars.timersBuf[idsCandidate[i]].priority==opentimers_vars.timersBuf[idToSchedule].priority &&
+                opentimers_isEarlier(idsCandidate[i],idToSchedule)
+            ){
+                idToSchedule = idsCandidate[i];
             }
         }
     }
     
-    // 4. reschedule the timer
     opentimers_vars.currentTimeout = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
     opentimers_vars.lastCompare[opentimers_vars.index] = opentimers_vars.currentTimeout;
     opentimers_vars.index = (opentimers_vars.index+1)&0x0F;
@@ -29,7 +29,9 @@
 #define TIMERTHRESHOLD 10
 
 /// Maximum number of timers that can run concurrently
+#ifndef MAX_NUM_TIMERS
 #define MAX_NUM_TIMERS             10
+#endif
 #define MAX_TICKS_IN_SINGLE_CLOCK  (uint32_t)(((PORT_TIMER_WIDTH)0xFFFFFFFF)>>1)
 //#define MAX_TICKS_IN_SINGLE_CLOCK  0x7FFF
 #define TOO_MANY_TIMERS_ERROR      255
@@ -58,8 +60,8 @@ typedef struct {
    bool                 isrunning;          // is running?
    bool                 isUsed;             // true when this entry is occupied
    timer_type_t         timerType;          // the timer type
-   bool                 hasExpired;         // in case there are more than one interrupt occur at same time
    uint8_t              priority;           // high priority timer could take over the compare timer scheduled early than it for TIMERTHRESHOLD ticks.
+   uint8_t              heapIndex;          // position in the heap of running timers
    opentimers_cbt       callback;           // function to call when elapses
 } opentimers_t;
 
@@ -73,6 +75,10 @@ typedef struct {
    PORT_TIMER_WIDTH     lastCompare[16];    // for debugging purpose
    uint8_t              index;              // index for lastCompare array
    bool                 insideISR;          // whether the function of opentimer is called inside of ISR or not
+   uint8_t              heap[MAX_NUM_TIMERS]; // ids of the running timers, as a min-heap on the gap past lastTimeout
+   uint8_t              heapSize;           // number of running timers
+   PORT_TIMER_WIDTH     maxDurationISR;     // longest time spent in the sctimer interrupt, in ticks
+   uint16_t             numOverrunsISR;     // number of interrupts that took longer than MAX_DURATION_ISR
 } opentimers_vars_t;
 
 //=========================== prototypes ======================================
@@ -60,7 +60,9 @@ static const uint8_t infoStackName[] = "OpenWSN ";
 #endif
 #endif
 
+#ifndef MAXNUMNEIGHBORS
 #define MAXNUMNEIGHBORS  10
+#endif
 
 // maximum celllist length
 #define CELLLIST_MAX_LEN 3
@@ -302,6 +304,20 @@ enum {
    // openmemory
    ERR_MEMORY_NO_AVAILABLE             = 0x4e, // no available memory
    ERR_MEMORY_OVERLAPS                 = 0x4f, // a memory area overlaps
+   // kernel
+   ERR_TASK_LIST_OVERFLOW              = 0x50, // task list overflown, {0} task(s) dropped, last one of priority {1}
+   // opencoap
+   ERR_COAP_DUPLICATE_PATH             = 0x51, // CoAP resource of component {0} has the path of an already registered one
+   ERR_COAP_PATH_TABLE_FULL            = 0x52, // no room to index the path of CoAP resource of component {0}
+   // openserial
+   ERR_OUTPUT_BUFFER_OVERFLOW          = 0x53, // the output buffer has overflown, {0} frame(s) dropped
+   ERR_TELEMETRY_REGISTRY_FULL         = 0x54, // no room to register status element {0} of {1} bytes for telemetry
+   // icmpv6rpl
+   ERR_ROUTE_TABLE_FULL                = 0x55, // no room for the downward route to mote {0}, all {1} routes are used
+   // openqueue
+   ERR_NEIGHBOR_QUEUE_FULL             = 0x56, // packet to neighbor {0} dropped, {1} packets to it are queued already
+   // sixtop
+   ERR_SIXTOP_NO_TRANSACTION           = 0x57, // 6P response with seqNum {0} matches no request, the one pending has seqNum {1}
 };
 
 //=========================== typedef =========================================
@@ -66,7 +66,9 @@
 #ifndef FREERTOS_CONFIG_H
 #define FREERTOS_CONFIG_H
 
+#ifndef OPENSIM
 #include <msp430x44x.h>
+#endif
 
 /*
 Two interrupt examples are provided -
@@ -111,13 +113,13 @@ occurs.
  *----------------------------------------------------------*/
 
 #define configUSE_PREEMPTION		1
-#define configUSE_IDLE_HOOK			1
+#define configUSE_IDLE_HOOK			0
 #define configUSE_TICK_HOOK			0
 #define configCPU_CLOCK_HZ			( ( unsigned long ) 7995392 ) /* Clock setup from main.c in the demo application. */
 #define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
-#define configMAX_PRIORITIES		( 4 )
+#define configMAX_PRIORITIES		( 5 ) /* The idle task, below the task of each band of scheduler.c. */
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 50 )
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 1700 ) )
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 2600 ) ) /* The tasks and semaphores of scheduler.c. */
 #define configMAX_TASK_NAME_LEN		( 8 )
 #define configUSE_TRACE_FACILITY	0
 #define configUSE_16_BIT_TICKS		1
@@ -131,10 +133,10 @@ occurs.
 to exclude the API function. */
 
 #define INCLUDE_vTaskPrioritySet			0
-#define INCLUDE_uxTaskPriorityGet			0
+#define INCLUDE_uxTaskPriorityGet			1
 #define INCLUDE_vTaskDelete					1
 #define INCLUDE_vTaskCleanUpResources		0
-#define INCLUDE_vTaskSuspend				0
+#define INCLUDE_vTaskSuspend				1 /* Block without timeout. */
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark 0
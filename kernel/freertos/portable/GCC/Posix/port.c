@@ -0,0 +1,162 @@
+/*
+    FreeRTOS port for POSIX hosts, see portmacro.h.
+
+    1 tab == 4 spaces!
+*/
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the POSIX port.
+ *----------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <ucontext.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The context of a task. The stack FreeRTOS allocates for the task holds a
+pointer to it. */
+typedef struct xTASK_CONTEXT
+{
+	ucontext_t		xContext;
+	void			*pvStack;			/*< The native stack the task runs on. */
+	TaskFunction_t	pxCode;
+	void			*pvParameters;
+} TaskContext_t;
+
+/* The first member of the TCB of a task is the top of its stack. */
+extern PRIVILEGED_DATA void * volatile pxCurrentTCB;
+
+/* Each thread runs a kernel of its own. */
+PRIVILEGED_DATA static UBaseType_t uxCriticalNesting = 0;
+PRIVILEGED_DATA static BaseType_t xPortYieldPending = pdFALSE;
+PRIVILEGED_DATA static ucontext_t xSchedulerContext;	/*< Where vPortEndScheduler() returns to. */
+
+/*
+ * The context of the task whose TCB is given.
+ */
+static TaskContext_t *prvGetContext( void *pxTCB );
+
+/*
+ * Entry point of the native stack of every task.
+ */
+static void prvTaskEntry( void );
+
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+TaskContext_t *pxContext;
+
+	pxContext = ( TaskContext_t * ) malloc( sizeof( TaskContext_t ) );
+	if( pxContext == NULL )
+	{
+		abort();
+	}
+	pxContext->pvStack = malloc( portNATIVE_STACK_SIZE );
+	if( pxContext->pvStack == NULL )
+	{
+		abort();
+	}
+	pxContext->pxCode = pxCode;
+	pxContext->pvParameters = pvParameters;
+
+	getcontext( &( pxContext->xContext ) );
+	pxContext->xContext.uc_stack.ss_sp = pxContext->pvStack;
+	pxContext->xContext.uc_stack.ss_size = portNATIVE_STACK_SIZE;
+	pxContext->xContext.uc_link = NULL;
+	makecontext( &( pxContext->xContext ), prvTaskEntry, 0 );
+
+	*pxTopOfStack = ( StackType_t ) pxContext;
+
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+	/* Run the tasks until vPortEndScheduler() is called. */
+	swapcontext( &xSchedulerContext, &( prvGetContext( pxCurrentTCB )->xContext ) );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	setcontext( &xSchedulerContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+TaskContext_t *pxFrom, *pxTo;
+
+	if( uxCriticalNesting > 0 )
+	{
+		/* Yield when the critical section is left, as an interrupt pending
+		while interrupts are masked would. */
+		xPortYieldPending = pdTRUE;
+		return;
+	}
+
+	pxFrom = prvGetContext( pxCurrentTCB );
+	vTaskSwitchContext();
+	pxTo = prvGetContext( pxCurrentTCB );
+
+	if( pxTo != pxFrom )
+	{
+		swapcontext( &( pxFrom->xContext ), &( pxTo->xContext ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	if( uxCriticalNesting > 0 )
+	{
+		uxCriticalNesting--;
+
+		if( ( uxCriticalNesting == 0 ) && ( xPortYieldPending != pdFALSE ) )
+		{
+			xPortYieldPending = pdFALSE;
+			vPortYield();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+TaskContext_t *pxContext;
+
+	/* Never the running task, prvDeleteTCB() is called from the idle task. */
+	pxContext = prvGetContext( pxTCB );
+	free( pxContext->pvStack );
+	free( pxContext );
+}
+/*-----------------------------------------------------------*/
+
+static TaskContext_t *prvGetContext( void *pxTCB )
+{
+	return ( TaskContext_t * ) **( ( StackType_t ** ) pxTCB );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskEntry( void )
+{
+TaskContext_t *pxContext;
+
+	pxContext = prvGetContext( pxCurrentTCB );
+	pxContext->pxCode( pxContext->pvParameters );
+
+	/* Tasks must not return. */
+	abort();
+}
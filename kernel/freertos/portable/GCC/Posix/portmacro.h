@@ -0,0 +1,116 @@
+/*
+    FreeRTOS port for POSIX hosts, used by the python board.
+
+    All the tasks of a kernel run on the thread which started its scheduler,
+    each on a stack of its own, switching with swapcontext(). The variables of
+    the kernel are thread-local, so each thread which starts a scheduler runs a
+    separate kernel: this is what lets each simulated mote run its own.
+
+    There are no interrupts, and no tick: a task runs until it blocks or yields,
+    and the tick count never advances. The application must only run interrupt
+    handlers while the thread of the kernel is blocked (e.g. while the board
+    sleeps), and they must not call the API of the kernel.
+
+    1 tab == 4 spaces!
+*/
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*-----------------------------------------------------------
+ * Port specific definitions.
+ *
+ * The settings in this file configure FreeRTOS correctly for the
+ * given hardware and compiler.
+ *
+ * These settings should not be altered.
+ *-----------------------------------------------------------
+ */
+
+/* Type definitions. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uintptr_t
+#define portBASE_TYPE	long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define portPOINTER_SIZE_TYPE	uintptr_t
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffff
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+#endif
+/*-----------------------------------------------------------*/
+
+/* One kernel per thread. Defining MPU_WRAPPERS_H keeps mpu_wrappers.h, which
+portable.h includes after this file, from defining these as nothing. */
+#define MPU_WRAPPERS_H
+#define PRIVILEGED_FUNCTION
+#define PRIVILEGED_DATA				_Thread_local
+#define portUSING_MPU_WRAPPERS		0
+/*-----------------------------------------------------------*/
+
+/* Interrupt control macros, there are no interrupts to mask. */
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+/*-----------------------------------------------------------*/
+
+/* Critical section control macros. A yield requested within a critical
+section happens when the outermost one is left. */
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+#define portENTER_CRITICAL()		vPortEnterCritical()
+#define portEXIT_CRITICAL()			vPortExitCritical()
+/*-----------------------------------------------------------*/
+
+/* Task utilities. */
+extern void vPortYield( void );
+#define portYIELD()					vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired ) if( xSwitchRequired ) vPortYield()
+#define portYIELD_FROM_ISR( x )		portEND_SWITCHING_ISR( x )
+#define portNOP()
+
+/* Free the native stack of a deleted task. */
+extern void vPortCleanUpTCB( void *pxTCB );
+#define portCLEAN_UP_TCB( pxTCB )	vPortCleanUpTCB( pxTCB )
+/*-----------------------------------------------------------*/
+
+/* Hardware specifics. */
+/* The stack of a task is an array of pointers, aligned in any case. With 8, the
+mask tasks.c aligns the top of stack with is an unsigned int, which would
+clear the upper half of 64-bit addresses. */
+#define portBYTE_ALIGNMENT			4
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+
+/* The native stack each task runs on. The stack FreeRTOS allocates for a task
+only holds a pointer to its context. */
+#ifndef portNATIVE_STACK_SIZE
+	#define portNATIVE_STACK_SIZE	( 256 * 1024 )
+#endif
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
@@ -1,5 +1,29 @@
 /**
-\brief Task scheduler.
+\brief FreeRTOS scheduler.
+
+The task priorities are split into bands of consecutive priorities, see
+scheduler_bandStart. Each band is run by a FreeRTOS task, with the FreeRTOS
+priority of scheduler_bandPrio. Within a band, tasks run in the same order as
+with OpenOS: oldest of the highest priority first. A task pushed to a band
+preempts the task running in a band of lower FreeRTOS priority, rather than
+waiting for it to complete.
+
+The modules of the stack share variables without protecting them from each
+other's tasks, so all the priorities of the stack form a single band. Only the
+serial input, which calls into the stack as the UART interrupt does in
+half-duplex mode, runs in a band of its own, above it.
+
+\note There is no band for the applications below the stack: a long CoAP or
+   OSCOAP handler does NOT get preempted by the MAC notifications. A received
+   request is handled within the TASKPRIO_SIXTOP_NOTIF_RX task which passed it
+   up the stack, and the TASKPRIO_COAP tasks of the applications call into the
+   stack modules directly. Moving the applications to a band of their own
+   first requires passing received requests to them as tasks, and their calls
+   into the stack to be pushed as tasks of the stack band, or protected.
+
+The FreeRTOS task of the lowest band never blocks. When it runs out of tasks,
+all the bands above it have too, and it puts the board to sleep. The tasks
+pushed while the board sleeps are handed to their band when it wakes up.
 
 \author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2014.
 */
@@ -9,26 +33,358 @@
 #include "board.h"
 #include "debugpins.h"
 #include "leds.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+//=========================== define ==========================================
+
+// index of the lowest set bit, i.e. the highest pending priority
+#if defined(__GNUC__)
+#define SCHEDULER_FIRST_PRIO(bitmap)   ((uint8_t)__builtin_ctz(bitmap))
+#else
+#define SCHEDULER_FIRST_PRIO(bitmap)   scheduler_firstPrio(bitmap)
+#endif
+
+// size of the FreeRTOS stack of the task of each band, in words
+#ifndef SCHEDULER_STACK_SIZE
+#define SCHEDULER_STACK_SIZE           (configMINIMAL_STACK_SIZE*4)
+#endif
+
+// the band of the lowest FreeRTOS priority, the stack, which puts the board to sleep
+#define SCHEDULER_BAND_LOWEST          0
+
+#if SCHEDULER_NUMBANDS>=configMAX_PRIORITIES
+#error "configMAX_PRIORITIES too small for the bands of the scheduler"
+#endif
+
+// parameter FreeRTOS passes to the task of each band
+#ifdef OPENSIM
+#define SCHEDULER_TASK_PARAM           self     // the mote it runs
+#else
+#define SCHEDULER_TASK_PARAM           NULL
+#endif
+
+// ports which can not switch tasks from an interrupt do it at the next tick
+#ifndef portEND_SWITCHING_ISR
+#define portEND_SWITCHING_ISR(x)       (void)(x)
+#endif
+
+// whether the caller is an interrupt handler, read before disabling interrupts
+#if defined(OPENSIM)
+// handlers only run while the board sleeps, when no band is woken up
+#define SCHEDULER_IS_IN_ISR()          FALSE
+#elif defined(__ICC430__)
+// handlers run with GIE cleared, a task pushing with interrupts disabled is
+// taken for one, and switches at the next tick
+#define SCHEDULER_IS_IN_ISR()          ((__get_interrupt_state()&0x0008)==0)
+#else
+#define SCHEDULER_IS_IN_ISR()          ((READ_SR&0x0008)==0)
+#endif
 
 //=========================== variables =======================================
 
 scheduler_vars_t scheduler_vars;
 scheduler_dbg_t  scheduler_dbg;
 
+// first priority of each band, followed by the end of the last one
+static const uint8_t scheduler_bandStart[SCHEDULER_NUMBANDS+1] = {
+   TASKPRIO_SIXTOP_NOTIF_RX,      // stack: MAC, network, applications and timers
+   TASKPRIO_OPENSERIAL,           // serial input
+   TASKPRIO_MAX,
+};
+
+// FreeRTOS priority of the task of each band, the idle task is below them all
+static const UBaseType_t scheduler_bandPrio[SCHEDULER_NUMBANDS] = {
+   tskIDLE_PRIORITY+1,            // stack
+   tskIDLE_PRIORITY+2,            // serial input, preempts the stack like the UART interrupt
+};
+
 //=========================== prototypes ======================================
 
+void     scheduler_bandTask(void* self);
+void     scheduler_runBand(void);
+bool     scheduler_runTask(uint8_t band);
+void     scheduler_sleep(void);
+uint8_t  scheduler_getBand(task_prio_t prio);
+uint16_t scheduler_bandMask(uint8_t band);
+uint8_t  scheduler_firstPrio(uint16_t bitmap);
+
 //=========================== public ==========================================
 
-void scheduler_init() {   
-   // TODO: fill in as part of FW-16.
+void scheduler_init() {
+   uint8_t i;
+
+   // initialization module variables
+   memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
+   memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
+
+   // all task containers are free, no priority has pending tasks
+   for (i=0;i<TASK_LIST_DEPTH;i++) {
+      scheduler_vars.taskBuf[i].next = i+1<TASK_LIST_DEPTH ? i+1 : TASK_NONE;
+   }
+   scheduler_vars.freeHead        = 0;
+   for (i=0;i<TASKPRIO_MAX;i++) {
+      scheduler_vars.fifo[i].head = TASK_NONE;
+      scheduler_vars.fifo[i].tail = TASK_NONE;
+   }
+
+   // create the task of each band, they start running in scheduler_start()
+   for (i=0;i<SCHEDULER_NUMBANDS;i++) {
+      if (i!=SCHEDULER_BAND_LOWEST) {
+         scheduler_vars.bandSem[i] = xSemaphoreCreateBinary();
+         if (scheduler_vars.bandSem[i]==NULL) {
+            // FreeRTOS heap too small
+            leds_error_blink();
+            return;
+         }
+      }
+      if (
+            xTaskCreate(
+               scheduler_bandTask,
+               "band",
+               SCHEDULER_STACK_SIZE,
+               SCHEDULER_TASK_PARAM,
+               scheduler_bandPrio[i],
+               NULL
+            )!=pdPASS
+         ) {
+         // FreeRTOS heap too small
+         leds_error_blink();
+         return;
+      }
+   }
+
+   // enable the scheduler's interrupt so SW can wake up the scheduler
+   SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start() {
-   // TODO: fill in as part of FW-16.
+   vTaskStartScheduler();
 }
 
  void scheduler_push_task(task_cbt cb, task_prio_t prio) {
-   // TODO: fill in as part of FW-16.
+   taskList_fifo_t* fifo;
+   uint8_t          taskId;
+   uint8_t          band;
+   bool             isSleeping;
+   bool             isInIsr;
+   BaseType_t       isWoken;
+   INTERRUPT_DECLARATION();
+
+   isInIsr = SCHEDULER_IS_IN_ISR();
+
+   DISABLE_INTERRUPTS();
+
+   if (prio<TASKPRIO_SIXTOP_NOTIF_RX || prio>=TASKPRIO_MAX) {
+      // TASKPRIO_NONE, or out of range of the queues. This should never happen!
+
+      // we can not print from within the kernel. Instead, blink the error
+      // LED, then drop the task and record it like an overflow
+      leds_error_blink();
+      scheduler_dbg.numTasksDropped++;
+      scheduler_dbg.lastDroppedPrio = prio;
+      ENABLE_INTERRUPTS();
+      return;
+   }
+
+   // take an empty task container
+   taskId = scheduler_vars.freeHead;
+   if (taskId==TASK_NONE) {
+      // task list has overflown. This should never happpen!
+
+      // we can not print from within the kernel. Instead, drop the task and
+      // record it, openserial reports it at its next output
+      scheduler_dbg.numTasksDropped++;
+      scheduler_dbg.lastDroppedPrio = prio;
+      ENABLE_INTERRUPTS();
+      return;
+   }
+   scheduler_vars.freeHead        = scheduler_vars.taskBuf[taskId].next;
+
+   // fill that task container with this task
+   scheduler_vars.taskBuf[taskId].cb   = cb;
+   scheduler_vars.taskBuf[taskId].next = TASK_NONE;
+
+   // append it to the tasks of the same priority
+   fifo                           = &scheduler_vars.fifo[prio];
+   if (fifo->tail==TASK_NONE) {
+      fifo->head                  = taskId;
+      scheduler_vars.prioBitmap  |= 1u<<prio;
+   } else {
+      scheduler_vars.taskBuf[fifo->tail].next = taskId;
+   }
+   fifo->tail                     = taskId;
+   // maintain debug stats
+   scheduler_dbg.numTasksCur++;
+   if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
+      scheduler_dbg.numTasksMax   = scheduler_dbg.numTasksCur;
+   }
+
+   isSleeping                     = scheduler_vars.isSleeping;
+
+   ENABLE_INTERRUPTS();
+
+   // wake up the task of the band. The lowest band checks its tasks without
+   // being woken up, and hands the tasks pushed while the board sleeps to
+   // their band when it wakes up.
+   band = scheduler_getBand(prio);
+   if (band!=SCHEDULER_BAND_LOWEST && isSleeping==FALSE) {
+      if (isInIsr) {
+         isWoken = pdFALSE;
+         xSemaphoreGiveFromISR(scheduler_vars.bandSem[band],&isWoken);
+         portEND_SWITCHING_ISR(isWoken);
+      } else {
+         xSemaphoreGive(scheduler_vars.bandSem[band]);
+      }
+   }
+}
+
+void scheduler_getDbg(scheduler_dbg_t* dbg) {
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   memcpy(dbg,&scheduler_dbg,sizeof(scheduler_dbg_t));
+   ENABLE_INTERRUPTS();
 }
 
 //=========================== private =========================================
+
+/**
+\brief Body of the FreeRTOS task of each band.
+
+\param[in] self The mote the task runs, on the python board. Unused otherwise.
+*/
+void scheduler_bandTask(void* self) {
+   scheduler_runBand();
+}
+
+void scheduler_runBand() {
+   uint8_t band;
+
+   band = 0;
+   while (scheduler_bandPrio[band]!=uxTaskPriorityGet(NULL)) {
+      band++;
+   }
+   while (1) {
+      if (band==SCHEDULER_BAND_LOWEST) {
+         scheduler_sleep();
+      } else {
+         xSemaphoreTake(scheduler_vars.bandSem[band],portMAX_DELAY);
+      }
+      while (scheduler_runTask(band)==TRUE);
+   }
+}
+
+/**
+\brief Execute the oldest task of the highest pending priority of a band.
+
+\param[in] band The band to execute a task of.
+
+\returns TRUE if a task was executed, FALSE if the band has no pending task.
+*/
+bool scheduler_runTask(uint8_t band) {
+   taskList_fifo_t* fifo;
+   taskList_item_t  thisTask;
+   uint8_t          taskId;
+   uint8_t          prio;
+   uint16_t         pending;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   pending                  = scheduler_vars.prioBitmap & scheduler_bandMask(band);
+   if (pending==0) {
+      ENABLE_INTERRUPTS();
+      return FALSE;
+   }
+
+   prio                     = SCHEDULER_FIRST_PRIO(pending);
+   fifo                     = &scheduler_vars.fifo[prio];
+   taskId                   = fifo->head;
+   thisTask                 = scheduler_vars.taskBuf[taskId];
+
+   // shift that priority's queue by one task
+   fifo->head               = thisTask.next;
+   if (fifo->head==TASK_NONE) {
+      fifo->tail            = TASK_NONE;
+      scheduler_vars.prioBitmap &= ~(1u<<prio);
+   }
+
+   // free up this task container
+   scheduler_vars.taskBuf[taskId].cb   = NULL;
+   scheduler_vars.taskBuf[taskId].next = scheduler_vars.freeHead;
+   scheduler_vars.freeHead  = taskId;
+   scheduler_dbg.numTasksCur--;
+
+   ENABLE_INTERRUPTS();
+
+   // execute the current task
+   thisTask.cb();
+
+   return TRUE;
+}
+
+/**
+\brief Put the board to sleep if no task is pending, from the lowest band.
+
+Returns after handing the tasks of the other bands to their FreeRTOS task,
+which preempts the caller.
+*/
+void scheduler_sleep() {
+   uint16_t pending;
+   uint8_t  band;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   if (scheduler_vars.prioBitmap==0) {
+      scheduler_vars.isSleeping = TRUE;
+      ENABLE_INTERRUPTS();
+
+      debugpins_task_clr();
+      board_sleep();
+      debugpins_task_set();                      // IAR should halt here if nothing to do
+
+      DISABLE_INTERRUPTS();
+      scheduler_vars.isSleeping = FALSE;
+   }
+   pending = scheduler_vars.prioBitmap;
+   ENABLE_INTERRUPTS();
+
+   for (band=0;band<SCHEDULER_NUMBANDS;band++) {
+      if (band!=SCHEDULER_BAND_LOWEST && (pending & scheduler_bandMask(band))!=0) {
+         xSemaphoreGive(scheduler_vars.bandSem[band]);
+      }
+   }
+}
+
+uint8_t scheduler_getBand(task_prio_t prio) {
+   uint8_t band;
+
+   band = SCHEDULER_NUMBANDS-1;
+   while (prio<scheduler_bandStart[band]) {
+      band--;
+   }
+   return band;
+}
+
+/**
+\brief Bits of the priorities of a band, in the bitmap of pending priorities.
+*/
+uint16_t scheduler_bandMask(uint8_t band) {
+   return ((1u<<scheduler_bandStart[band+1])-1) & ~((1u<<scheduler_bandStart[band])-1);
+}
+
+/**
+\brief Index of the lowest bit set, for compilers without a builtin.
+*/
+uint8_t scheduler_firstPrio(uint16_t bitmap) {
+   uint8_t prio;
+
+   prio = 0;
+   while ((bitmap & 0x0001)==0) {
+      bitmap >>= 1;
+      prio++;
+   }
+   return prio;
+}
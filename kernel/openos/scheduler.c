@@ -10,6 +10,15 @@
 #include "debugpins.h"
 #include "leds.h"
 
+//=========================== define ==========================================
+
+// index of the lowest set bit, i.e. the highest pending priority
+#if defined(__GNUC__)
+#define SCHEDULER_FIRST_PRIO(bitmap)   ((uint8_t)__builtin_ctz(bitmap))
+#else
+#define SCHEDULER_FIRST_PRIO(bitmap)   scheduler_firstPrio(bitmap)
+#endif
+
 //=========================== variables =======================================
 
 scheduler_vars_t scheduler_vars;
@@ -18,44 +27,66 @@ scheduler_dbg_t  scheduler_dbg;
 //=========================== prototypes ======================================
 
 void consumeTask(uint8_t taskId);
+uint8_t scheduler_firstPrio(uint16_t bitmap);
 
 //=========================== public ==========================================
 
 void scheduler_init() {   
+   uint8_t i;
    
    // initialization module variables
    memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
    memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
    
+   // all task containers are free, no priority has pending tasks
+   for (i=0;i<TASK_LIST_DEPTH;i++) {
+      scheduler_vars.taskBuf[i].next = i+1<TASK_LIST_DEPTH ? i+1 : TASK_NONE;
+   }
+   scheduler_vars.freeHead        = 0;
+   for (i=0;i<TASKPRIO_MAX;i++) {
+      scheduler_vars.fifo[i].head = TASK_NONE;
+      scheduler_vars.fifo[i].tail = TASK_NONE;
+   }
+   
    // enable the scheduler's interrupt so SW can wake up the scheduler
    SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start() {
-   taskList_item_t* pThisTask;
+   taskList_fifo_t* fifo;
+   taskList_item_t  thisTask;
+   uint8_t          taskId;
+   uint8_t          prio;
    while (1) {
-      while(scheduler_vars.task_list!=NULL) {
-         // there is still at least one task in the linked-list of tasks
+      while(scheduler_vars.prioBitmap!=0) {
+         // there is still at least one task pending
          
     	 INTERRUPT_DECLARATION();
     	 DISABLE_INTERRUPTS();
 
-         // the task to execute is the one at the head of the queue
-         pThisTask                = scheduler_vars.task_list;
+         // the task to execute is the oldest of the highest priority
+         prio                     = SCHEDULER_FIRST_PRIO(scheduler_vars.prioBitmap);
+         fifo                     = &scheduler_vars.fifo[prio];
+         taskId                   = fifo->head;
+         thisTask                 = scheduler_vars.taskBuf[taskId];
+         
+         // shift that priority's queue by one task
+         fifo->head               = thisTask.next;
+         if (fifo->head==TASK_NONE) {
+            fifo->tail            = TASK_NONE;
+            scheduler_vars.prioBitmap &= ~(1u<<prio);
+         }
          
-         // shift the queue by one task
-         scheduler_vars.task_list = pThisTask->next;
+         // free up this task container
+         scheduler_vars.taskBuf[taskId].cb   = NULL;
+         scheduler_vars.taskBuf[taskId].next = scheduler_vars.freeHead;
+         scheduler_vars.freeHead  = taskId;
+         scheduler_dbg.numTasksCur--;
          
          ENABLE_INTERRUPTS();
 
          // execute the current task
-         pThisTask->cb();
-         
-         // free up this task container
-         pThisTask->cb            = NULL;
-         pThisTask->prio          = TASKPRIO_NONE;
-         pThisTask->next          = NULL;
-         scheduler_dbg.numTasksCur--;
+         thisTask.cb();
       }
       debugpins_task_clr();
       board_sleep();
@@ -64,40 +95,51 @@ void scheduler_start() {
 }
 
  void scheduler_push_task(task_cbt cb, task_prio_t prio) {
-   taskList_item_t*  taskContainer;
-   taskList_item_t** taskListWalker;
+   taskList_fifo_t* fifo;
+   uint8_t          taskId;
    INTERRUPT_DECLARATION();
    
    DISABLE_INTERRUPTS();
    
-   // find an empty task container
-   taskContainer = &scheduler_vars.taskBuf[0];
-   while (taskContainer->cb!=NULL &&
-          taskContainer<=&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-      taskContainer++;
-   }
-   if (taskContainer>&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-      // task list has overflown. This should never happpen!
+   if (prio<TASKPRIO_SIXTOP_NOTIF_RX || prio>=TASKPRIO_MAX) {
+      // TASKPRIO_NONE, or out of range of the queues. This should never happen!
    
-      // we can not print from within the kernel. Instead:
-      // blink the error LED
+      // we can not print from within the kernel. Instead, blink the error
+      // LED, then drop the task and record it like an overflow
       leds_error_blink();
-      // reset the board
-      board_reset();
+      scheduler_dbg.numTasksDropped++;
+      scheduler_dbg.lastDroppedPrio = prio;
+      ENABLE_INTERRUPTS();
+      return;
    }
+   
+   // take an empty task container
+   taskId = scheduler_vars.freeHead;
+   if (taskId==TASK_NONE) {
+      // task list has overflown. This should never happpen!
+      
+      // we can not print from within the kernel. Instead, drop the task and
+      // record it, openserial reports it at its next output
+      scheduler_dbg.numTasksDropped++;
+      scheduler_dbg.lastDroppedPrio = prio;
+      ENABLE_INTERRUPTS();
+      return;
+   }
+   scheduler_vars.freeHead        = scheduler_vars.taskBuf[taskId].next;
+   
    // fill that task container with this task
-   taskContainer->cb              = cb;
-   taskContainer->prio            = prio;
+   scheduler_vars.taskBuf[taskId].cb   = cb;
+   scheduler_vars.taskBuf[taskId].next = TASK_NONE;
    
-   // find position in queue
-   taskListWalker                 = &scheduler_vars.task_list;
-   while (*taskListWalker!=NULL &&
-          (*taskListWalker)->prio <= taskContainer->prio) {
-      taskListWalker              = (taskList_item_t**)&((*taskListWalker)->next);
+   // append it to the tasks of the same priority
+   fifo                           = &scheduler_vars.fifo[prio];
+   if (fifo->tail==TASK_NONE) {
+      fifo->head                  = taskId;
+      scheduler_vars.prioBitmap  |= 1u<<prio;
+   } else {
+      scheduler_vars.taskBuf[fifo->tail].next = taskId;
    }
-   // insert at that position
-   taskContainer->next            = *taskListWalker;
-   *taskListWalker                = taskContainer;
+   fifo->tail                     = taskId;
    // maintain debug stats
    scheduler_dbg.numTasksCur++;
    if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
@@ -107,4 +149,26 @@ void scheduler_start() {
    ENABLE_INTERRUPTS();
 }
 
+void scheduler_getDbg(scheduler_dbg_t* dbg) {
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   memcpy(dbg,&scheduler_dbg,sizeof(scheduler_dbg_t));
+   ENABLE_INTERRUPTS();
+}
+
 //=========================== private =========================================
+
+/**
+\brief Index of the lowest bit set, for compilers without a builtin.
+*/
+uint8_t scheduler_firstPrio(uint16_t bitmap) {
+   uint8_t prio;
+   
+   prio = 0;
+   while ((bitmap & 0x0001)==0) {
+      bitmap >>= 1;
+      prio++;
+   }
+   return prio;
+}
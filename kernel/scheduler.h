@@ -28,33 +28,56 @@ typedef enum {
    TASKPRIO_BUTTON                = 0x09,
    TASKPRIO_SIXTOP_TIMEOUT        = 0x0a,
    TASKPRIO_SNIFFER               = 0x0b,
-   TASKPRIO_MAX                   = 0x0c,
+   TASKPRIO_OPENSERIAL            = 0x0c,
+   TASKPRIO_MAX                   = 0x0d,
 } task_prio_t;
 
+#ifndef TASK_LIST_DEPTH
 #define TASK_LIST_DEPTH           10
+#endif
+
+#define TASK_NONE                 0xff
+
+#if TASK_LIST_DEPTH>=TASK_NONE
+#error "TASK_LIST_DEPTH too large for the task container indices"
+#endif
+
+#ifdef KERNEL_FREERTOS
+#define SCHEDULER_NUMBANDS        2     // FreeRTOS tasks the priorities are split among
+#endif
 
 //=========================== typedef =========================================
 
 typedef void (*task_cbt)(void);
 
-typedef struct task_llist_t {
+typedef struct {
    task_cbt                       cb;
-   task_prio_t                    prio;
-   void*                          next;
+   uint8_t                        next;  // next task of the same priority, or next free container
 } taskList_item_t;
 
+typedef struct {
+   uint8_t                        head;
+   uint8_t                        tail;
+} taskList_fifo_t;
+
 //=========================== module variables ================================
 
 typedef struct {
    taskList_item_t                taskBuf[TASK_LIST_DEPTH];
-   taskList_item_t*               task_list;
-   uint8_t                        numTasksCur;
-   uint8_t                        numTasksMax;
+   taskList_fifo_t                fifo[TASKPRIO_MAX];   // pending tasks of each priority
+   uint16_t                       prioBitmap;           // bit prio set if fifo[prio] not empty
+   uint8_t                        freeHead;
+#ifdef KERNEL_FREERTOS
+   void*                          bandSem[SCHEDULER_NUMBANDS]; // SemaphoreHandle_t waking up the task of each band
+   bool                           isSleeping;           // tasks pushed now are handed to their band on wake-up
+#endif
 } scheduler_vars_t;
 
 typedef struct {
    uint8_t                        numTasksCur;
    uint8_t                        numTasksMax;
+   uint16_t                       numTasksDropped;      // pushed while all containers were used
+   task_prio_t                    lastDroppedPrio;
 } scheduler_dbg_t;
 
 //=========================== prototypes ======================================
@@ -62,6 +85,7 @@ typedef struct {
 void scheduler_init(void);
 void scheduler_start(void);
 void scheduler_push_task(task_cbt task_cb, task_prio_t prio);
+void scheduler_getDbg(scheduler_dbg_t* dbg);
 
 /**
 \}
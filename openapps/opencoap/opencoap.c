@@ -48,6 +48,11 @@ void opencoap_forward_message(OpenQueueEntry_t *msg,
         open_addr_t* destIP,
         uint16_t destPortNumber);
 
+uint8_t opencoap_path_hash(uint8_t parent, uint8_t* segment, uint8_t segmentLen);
+uint8_t opencoap_path_find(uint8_t parent, uint8_t* segment, uint8_t segmentLen, bool create);
+void opencoap_path_index(coap_resource_desc_t* desc);
+coap_resource_desc_t* opencoap_path_lookup(coap_option_iht* options, uint8_t optionsLen);
+
 //=========================== public ==========================================
 
 //===== from stack
@@ -61,8 +66,9 @@ void opencoap_init() {
 
    pos = 0;
 
-   // initialize the resource linked list
+   // initialize the resource linked list and its path index
    opencoap_vars.resources     = NULL;
+   memset(&opencoap_vars.pathIndex[0],0,sizeof(opencoap_vars.pathIndex));
    
    // initialize the messageID
    opencoap_vars.messageID     = openrandom_get16b();
@@ -126,6 +132,7 @@ void opencoap_receive(OpenQueueEntry_t* msg) {
 
    // init returnCode
    securityReturnCode = 0;
+   blindContext = NULL;
 
    // take ownership over the received packet
    msg->owner                = COMPONENT_OPENCOAP;
@@ -270,62 +277,15 @@ void opencoap_receive(OpenQueueEntry_t* msg) {
       }
 
 
-      // find the resource which matches
-      
-      // start with the first resource in the linked list
-      temp_desc = opencoap_vars.resources;
-      
-      // iterate until matching resource found, or no match
-      while (found==FALSE && securityReturnCode==0) {
-         if (
-               coap_incomingOptions[0].type==COAP_OPTION_NUM_URIPATH    &&
-               coap_incomingOptions[1].type==COAP_OPTION_NUM_URIPATH    &&
-               temp_desc->path0len>0                                   &&
-               temp_desc->path0val!=NULL                               &&
-               temp_desc->path1len>0                                   &&
-               temp_desc->path1val!=NULL
-            ) {
-            // resource has a path of form path0/path1
-               
-            if (
-                  coap_incomingOptions[0].length==temp_desc->path0len                               &&
-                  memcmp(coap_incomingOptions[0].pValue,temp_desc->path0val,temp_desc->path0len)==0 &&
-                  coap_incomingOptions[1].length==temp_desc->path1len                               &&
-                  memcmp(coap_incomingOptions[1].pValue,temp_desc->path1val,temp_desc->path1len)==0
-               ) {
-               if (temp_desc->securityContext != NULL && 
-                   blindContext != temp_desc->securityContext) {
-                   securityReturnCode = COAP_CODE_RESP_UNAUTHORIZED;
-               }
-                found = TRUE;
-            };
-         
-         } else if (
-               coap_incomingOptions[0].type==COAP_OPTION_NUM_URIPATH    &&
-               temp_desc->path0len>0                            &&
-               temp_desc->path0val!=NULL
-            ) {
-            // resource has a path of form path0
-               
-            if (
-                  coap_incomingOptions[0].length==temp_desc->path0len                               &&
-                  memcmp(coap_incomingOptions[0].pValue,temp_desc->path0val,temp_desc->path0len)==0
-               ) {
-               if (temp_desc->securityContext != NULL && 
-                   blindContext != temp_desc->securityContext) {
-                   securityReturnCode = COAP_CODE_RESP_UNAUTHORIZED;
-               }
-               found = TRUE;
-            };
-         };
-         
-         // iterate to next resource, if not found
-         if (found==FALSE) {
-            if (temp_desc->next!=NULL) {
-               temp_desc = temp_desc->next;
-            } else {
-               break;
+      // find the resource which matches, from the Uri-Path option(s)
+      if (securityReturnCode==0) {
+         temp_desc = opencoap_path_lookup(coap_incomingOptions, coap_incomingOptionsLen);
+         if (temp_desc!=NULL) {
+            if (temp_desc->securityContext != NULL && 
+                blindContext != temp_desc->securityContext) {
+                securityReturnCode = COAP_CODE_RESP_UNAUTHORIZED;
             }
+            found = TRUE;
          }
       }
    
@@ -466,9 +426,9 @@ void opencoap_receive(OpenQueueEntry_t* msg) {
    
    // fill in packet metadata
    if (found==TRUE) {
-      msg->creator                     = temp_desc->componentID;
+      openqueue_setCreator(msg,temp_desc->componentID);
    } else {
-      msg->creator                     = COMPONENT_OPENCOAP;
+      openqueue_setCreator(msg,COMPONENT_OPENCOAP);
    }
    msg->l4_protocol                    = IANA_UDP;
    temp_l4_destination_port            = msg->l4_destination_port;
@@ -601,7 +561,8 @@ This function is called by a CoAP resource when it starts, allowing it to
 receive data sent to that resource.
 
 Registration consists in adding a new resource at the end of the linked list
-of resources.
+of resources, and indexing its path. A resource with the same path as an
+already registered one is not indexed, so it will not receive requests.
 
 \param[in] desc The description of the CoAP resource.
 */
@@ -612,6 +573,9 @@ void opencoap_register(coap_resource_desc_t* desc) {
    // should point to NULL, indicating the end of the linked list.
    desc->next = NULL;
    
+   // index its path, requests are dispatched from it
+   opencoap_path_index(desc);
+   
    // if this is the first resource, simply have resources point to it
    if (opencoap_vars.resources==NULL) {
       opencoap_vars.resources = desc;
@@ -1169,3 +1133,148 @@ void opencoap_forward_message(OpenQueueEntry_t *msg,
       openqueue_freePacketBuffer(outgoingPacket);
     }
 }
+
+//===== resource path index
+
+/*
+The path index is a trie of the Uri-Path segments of the registered resources,
+stored in an open-addressing hash table: a segment is found from the slot of
+its parent segment and its own bytes. Looking up a request is one probe
+sequence per Uri-Path option, however many resources are registered.
+*/
+
+uint8_t opencoap_path_hash(uint8_t parent, uint8_t* segment, uint8_t segmentLen) {
+   uint16_t hash;
+   uint8_t  i;
+   
+   hash = parent;
+   for (i=0;i<segmentLen;i++) {
+      hash = hash*31+segment[i];
+   }
+   return (uint8_t)(hash^(hash>>8)) & (OPENCOAP_PATH_TABLE_SIZE-1);
+}
+
+/**
+\brief Find the slot of a path segment in the index.
+
+\param[in] parent     The slot of the previous segment, or OPENCOAP_PATH_ROOT.
+\param[in] segment    The bytes of the segment.
+\param[in] segmentLen The length of the segment.
+\param[in] create     Whether to add the segment if it is not indexed yet.
+
+\returns The slot of the segment, or OPENCOAP_PATH_NONE if it is not indexed
+   (or could not be added).
+*/
+uint8_t opencoap_path_find(uint8_t parent, uint8_t* segment, uint8_t segmentLen, bool create) {
+   coap_path_node_t* node;
+   uint8_t           slot;
+   uint8_t           probes;
+   
+   slot = opencoap_path_hash(parent,segment,segmentLen);
+   for (probes=0;probes<OPENCOAP_PATH_TABLE_SIZE;probes++) {
+      node = &opencoap_vars.pathIndex[slot];
+      if (node->segment==NULL) {
+         if (create==FALSE) {
+            break;
+         }
+         node->segment    = segment;
+         node->segmentLen = segmentLen;
+         node->parent     = parent;
+         node->desc       = NULL;
+         return slot;
+      }
+      if (
+            node->parent==parent                          &&
+            node->segmentLen==segmentLen                  &&
+            memcmp(node->segment,segment,segmentLen)==0
+         ) {
+         return slot;
+      }
+      slot = (slot+1) & (OPENCOAP_PATH_TABLE_SIZE-1);
+   }
+   return OPENCOAP_PATH_NONE;
+}
+
+void opencoap_path_index(coap_resource_desc_t* desc) {
+   uint8_t  node;
+   uint8_t  part;
+   uint8_t* val;
+   uint8_t  len;
+   uint8_t  start;
+   uint8_t  i;
+   
+   // resources without a path only send requests
+   if (desc->path0len==0 || desc->path0val==NULL) {
+      return;
+   }
+   
+   node = OPENCOAP_PATH_ROOT;
+   for (part=0;part<2;part++) {
+      val = (part==0) ? desc->path0val : desc->path1val;
+      len = (part==0) ? desc->path0len : desc->path1len;
+      if (len==0 || val==NULL) {
+         break;
+      }
+      // each part is one or more segments, separated by '/'
+      start = 0;
+      for (i=0;i<=len;i++) {
+         if (i==len || val[i]=='/') {
+            node = opencoap_path_find(node,&val[start],i-start,TRUE);
+            if (node==OPENCOAP_PATH_NONE) {
+               openserial_printError(
+                  COMPONENT_OPENCOAP,ERR_COAP_PATH_TABLE_FULL,
+                  (errorparameter_t)desc->componentID,
+                  (errorparameter_t)0
+               );
+               return;
+            }
+            start = i+1;
+         }
+      }
+   }
+   
+   if (opencoap_vars.pathIndex[node].desc!=NULL) {
+      openserial_printError(
+         COMPONENT_OPENCOAP,ERR_COAP_DUPLICATE_PATH,
+         (errorparameter_t)desc->componentID,
+         (errorparameter_t)0
+      );
+      return;
+   }
+   opencoap_vars.pathIndex[node].desc = desc;
+}
+
+/**
+\brief Find the resource a request is for.
+
+The resource with the longest registered path which is a prefix of the
+Uri-Path of the request handles it, so that a resource also receives the
+requests for the sub-paths it did not register.
+
+\param[in] options    The options of the request.
+\param[in] optionsLen The number of options.
+
+\returns The resource, or NULL if none matches.
+*/
+coap_resource_desc_t* opencoap_path_lookup(coap_option_iht* options, uint8_t optionsLen) {
+   coap_resource_desc_t* desc;
+   uint8_t               node;
+   uint8_t               i;
+   
+   desc = NULL;
+   node = OPENCOAP_PATH_ROOT;
+   for (i=0;i<optionsLen;i++) {
+      // options are sorted, Uri-Path ones follow each other
+      if (options[i].type!=COAP_OPTION_NUM_URIPATH) {
+         continue;
+      }
+      node = opencoap_path_find(node,options[i].pValue,options[i].length,FALSE);
+      if (node==OPENCOAP_PATH_NONE) {
+         break;
+      }
+      if (opencoap_vars.pathIndex[node].desc!=NULL) {
+         desc = opencoap_vars.pathIndex[node].desc;
+      }
+   }
+   return desc;
+}
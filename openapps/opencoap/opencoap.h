@@ -28,6 +28,14 @@ static const uint8_t ipAddr_motedata[]  = {0x20, 0x01, 0x04, 0x70, 0x00, 0x66, 0
 static const uint8_t ipAddr_ringmaster[] = {0xbb, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
 
+/// the number of slots of the resource path index, a power of 2 not above 128
+#ifndef OPENCOAP_PATH_TABLE_SIZE
+#define OPENCOAP_PATH_TABLE_SIZE       32
+#endif
+
+#define OPENCOAP_PATH_ROOT             0xfe // parent of the top-level segments
+#define OPENCOAP_PATH_NONE             0xff
+
 /// the maximum number of options in a RX'ed CoAP message
 #define MAX_COAP_OPTIONS               10 //3 before but we want gets with more options
 
@@ -184,6 +192,7 @@ typedef void (*callbackSendDone_cbt)(OpenQueueEntry_t* msg,
 
 typedef struct coap_resource_desc_t coap_resource_desc_t;
 
+// path0val and path1val may each hold several segments, separated by '/'
 struct coap_resource_desc_t {
    uint8_t                      path0len;
    uint8_t*                     path0val;
@@ -198,6 +207,14 @@ struct coap_resource_desc_t {
    coap_resource_desc_t*        next;
 };
 
+// a Uri-Path segment in the resource path index
+typedef struct {
+   uint8_t*                     segment;       // NULL if the slot is free
+   uint8_t                      segmentLen;
+   uint8_t                      parent;        // slot of the previous segment
+   coap_resource_desc_t*        desc;          // NULL if no resource has this path
+} coap_path_node_t;
+
 typedef struct { 
    uint8_t               key[16];
    uint8_t               buffer[STATELESS_PROXY_STATE_LEN + STATELESS_PROXY_TAG_LEN];
@@ -209,6 +226,7 @@ typedef struct {
 typedef struct {
    udp_resource_desc_t          desc;
    coap_resource_desc_t*        resources;
+   coap_path_node_t             pathIndex[OPENCOAP_PATH_TABLE_SIZE];
    bool                         busySending;
    uint8_t                      delayCounter;
    uint16_t                     messageID;
@@ -16,6 +16,14 @@
 
 openoscoap_vars_t openoscoap_vars;
 
+// COSE Encrypt0 structure ["Encrypt0", h'', external_aad] up to the external
+// AAD, identical for every message
+static const uint8_t aadPrefix[] = {
+   0x83,                                          // array of 3 elements
+   0x68, 'E', 'n', 'c', 'r', 'y', 'p', 't', '0',  // text string of 8 bytes
+   0x40,                                          // empty byte string
+};
+
 //=========================== prototype =======================================
 owerror_t hkdf_derive_parameter(uint8_t* buffer,
         uint8_t* masterSecret, 
@@ -48,9 +56,10 @@ void openoscoap_encode_compressed_COSE(OpenQueueEntry_t* msg,
         uint8_t* requestKid, 
         uint8_t requestKidLen);
 
-void xor_arrays(uint8_t* s1, uint8_t* s2, uint8_t* dst, uint8_t len);
-
-void flip_first_bit(uint8_t* source, uint8_t* dst, uint8_t len);
+void openoscoap_construct_nonce(uint8_t* iv, 
+        uint16_t sequenceNumber, 
+        bool response, 
+        uint8_t* nonce);
 
 bool replay_window_check(oscoap_security_context_t *context, uint16_t sequenceNumber);
 void replay_window_update(oscoap_security_context_t *context, uint16_t sequenceNumber);
@@ -168,7 +177,7 @@ owerror_t openoscoap_protect_message(
     uint8_t aad[AAD_MAX_LEN];
     uint8_t aadLen;
     uint8_t nonce[AES_CCM_16_64_128_IV_LEN];
-    uint8_t partialIV[AES_CCM_16_64_128_IV_LEN];
+    uint8_t partialIV[2];
     uint8_t* requestSeq;
     uint8_t requestSeqLen;
     uint8_t *requestKid;
@@ -184,8 +193,7 @@ owerror_t openoscoap_protect_message(
     }
 
     // convert sequence number to array and strip leading zeros
-    memset(partialIV, 0x00, AES_CCM_16_64_128_IV_LEN);
-    requestSeq = &partialIV[AES_CCM_16_64_128_IV_LEN - 2];
+    requestSeq = &partialIV[0];
     requestSeqLen = openoscoap_convert_sequence_number(sequenceNumber, &requestSeq);
 
     if (is_request(code)) {
@@ -216,7 +224,7 @@ owerror_t openoscoap_protect_message(
     payloadLen = msg->length;
     // shift payload to leave space for authentication tag
     packetfunctions_reserveHeaderSize(msg, AES_CCM_16_64_128_TAG_LEN);
-    memcpy(&msg->payload[0], payload, payloadLen);
+    memmove(&msg->payload[0], payload, payloadLen);
     // update payload pointer but leave length intact
     payload = &msg->payload[0];
 
@@ -242,12 +250,8 @@ owerror_t openoscoap_protect_message(
     }
     
     // construct nonce 
-    if (is_request(code)) {
-        xor_arrays(context->senderIV, partialIV, nonce, AES_CCM_16_64_128_IV_LEN); 
-    }
-    else {
-        flip_first_bit(context->senderIV, nonce, AES_CCM_16_64_128_IV_LEN);
-        xor_arrays(nonce, partialIV, nonce, AES_CCM_16_64_128_IV_LEN);
+    openoscoap_construct_nonce(context->senderIV, sequenceNumber, !is_request(code), nonce);
+    if (!is_request(code)) {
         // do not encode sequence number and ID in the response
         requestSeq = NULL;
         requestSeqLen = 0;
@@ -299,7 +303,7 @@ owerror_t openoscoap_unprotect_message(
         uint16_t sequenceNumber) {
  
     uint8_t nonce[AES_CCM_16_64_128_IV_LEN];
-    uint8_t partialIV[AES_CCM_16_64_128_IV_LEN];
+    uint8_t partialIV[2];
     uint8_t *requestKid;
     uint8_t requestKidLen;
     uint8_t* requestSeq;
@@ -348,8 +352,7 @@ owerror_t openoscoap_unprotect_message(
     }
 
     // convert sequence number to array and strip leading zeros
-    memset(partialIV, 0x00, AES_CCM_16_64_128_IV_LEN);
-    requestSeq = &partialIV[AES_CCM_16_64_128_IV_LEN - 2];
+    requestSeq = &partialIV[0];
     requestSeqLen = openoscoap_convert_sequence_number(sequenceNumber, &requestSeq);
 
     aadLen = openoscoap_construct_aad(aad,
@@ -374,13 +377,7 @@ owerror_t openoscoap_unprotect_message(
     }
  
     // construct nonce 
-    if (is_request(code)) {
-        xor_arrays(context->recipientIV, partialIV, nonce, AES_CCM_16_64_128_IV_LEN); 
-    }
-    else {
-        flip_first_bit(context->recipientIV, nonce, AES_CCM_16_64_128_IV_LEN);
-        xor_arrays(nonce, partialIV, nonce, AES_CCM_16_64_128_IV_LEN);
-    }
+    openoscoap_construct_nonce(context->recipientIV, sequenceNumber, !is_request(code), nonce);
     
     decStatus = cryptoengine_aes_ccms_dec(aad,
                                     aadLen,
@@ -550,15 +547,13 @@ uint8_t openoscoap_construct_aad(uint8_t* buffer,
         uint8_t requestSeqLen
         ) {
     uint8_t* ptr;
-    uint8_t externalAAD[EAAD_MAX_LEN];
     uint8_t externalAADLen;
-    uint8_t ret;
-    const uint8_t encrypt0[] = "Encrypt0";
 
-    ret = 0;
+    // the external AAD is encoded in place, after the constant prefix and
+    // the header of the byte string holding it
     externalAADLen = 0;
 
-    ptr = externalAAD;
+    ptr = &buffer[sizeof(aadPrefix) + 1];
     externalAADLen += cborencoder_put_array(&ptr, 6);
     externalAADLen += cborencoder_put_unsigned(&ptr, version);
     externalAADLen += cborencoder_put_unsigned(&ptr, code);
@@ -577,16 +572,11 @@ uint8_t openoscoap_construct_aad(uint8_t* buffer,
         return 0;
     }
 
-    ptr = buffer;
-    ret += cborencoder_put_array(&ptr, 3); // COSE Encrypt0 structure with 3 elements
-    // first element: "Encrypt0"
-    ret += cborencoder_put_text(&ptr, (char *) encrypt0, sizeof(encrypt0) - 1); 
-    // second element: empty byte string
-    ret += cborencoder_put_bytes(&ptr, 0, NULL); 
-    // third element: external AAD from OSCOAP
-    ret += cborencoder_put_bytes(&ptr, externalAADLen, externalAAD);
+    memcpy(buffer, aadPrefix, sizeof(aadPrefix));
+    // third element: byte string shorter than 24 bytes, length in the header
+    buffer[sizeof(aadPrefix)] = 0x40 | externalAADLen;
     
-    return ret;
+    return sizeof(aadPrefix) + 1 + externalAADLen;
 }
 
 void openoscoap_encode_compressed_COSE(OpenQueueEntry_t* msg, 
@@ -619,16 +609,22 @@ void openoscoap_encode_compressed_COSE(OpenQueueEntry_t* msg,
 }
 
 
-void xor_arrays(uint8_t* s1, uint8_t* s2, uint8_t* dst, uint8_t len) {
-    uint8_t i;
-    for (i = 0; i < len; i++) {
-        dst[i] = s1[i] ^ s2[i];
-    }
-}
+/**
+\brief Construct the AEAD nonce of a message.
 
-void flip_first_bit(uint8_t* source, uint8_t* dst, uint8_t len){
-    memcpy(dst, source, len);
-    dst[0] = dst[0] ^ 0x80;
+The nonce is the context IV with the sequence number XORed into its last
+bytes, and its first bit flipped for a response.
+*/
+void openoscoap_construct_nonce(uint8_t* iv, 
+        uint16_t sequenceNumber, 
+        bool response, 
+        uint8_t* nonce) {
+    memcpy(nonce, iv, AES_CCM_16_64_128_IV_LEN);
+    if (response) {
+        nonce[0] ^= 0x80;
+    }
+    nonce[AES_CCM_16_64_128_IV_LEN - 2] ^= (sequenceNumber >> 8) & 0xff;
+    nonce[AES_CCM_16_64_128_IV_LEN - 1] ^= (sequenceNumber >> 0) & 0xff;
 }
 
 bool replay_window_check(oscoap_security_context_t *context, uint16_t sequenceNumber) {
@@ -64,10 +64,9 @@
  * Add "length" to the length.
  * Set Corrupted when overflow has occurred.
  */
-static uint32_t addTemp;
 #define SHA224_256AddLength(context, length)               \
-  (addTemp = (context)->Length_Low, (context)->Corrupted = \
-    (((context)->Length_Low += (length)) < addTemp) &&     \
+  ((context)->Corrupted =                                  \
+    (((context)->Length_Low += (length)) < (length)) &&    \
     (++(context)->Length_High == 0) ? shaInputTooLong :    \
                                       (context)->Corrupted )
 
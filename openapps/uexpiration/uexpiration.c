@@ -9,9 +9,6 @@
 //=========================== variables =======================================
 
 uexpiration_vars_t uexpiration_vars;
-uint16_t seqno = 0;
-static uint16_t d_flag = 0, delay = 0,max_num_pkts = 0,pkt_interval = 0;
-OpenQueueEntry_t req;
 
 //=========================== prototypes ======================================
 
@@ -37,7 +34,7 @@ void uexpiration_receive(OpenQueueEntry_t* request) {
    uint8_t    index = 0, len = 0, arg_num = 0; 
    uint8_t    arg_len[4];
    
-   memcpy(&req, request, sizeof(OpenQueueEntry_t));
+   memcpy(&uexpiration_vars.req, request, sizeof(OpenQueueEntry_t));
  
    while(index<request->length) {
       if(request->payload[index] != ',') {
@@ -52,23 +49,23 @@ void uexpiration_receive(OpenQueueEntry_t* request) {
    }
     
    memcpy(&buffer,&request->payload[0],arg_len[0]);   
-   pkt_interval =   atoi(buffer);
+   uexpiration_vars.pkt_interval =   atoi(buffer);
 
    memcpy(&buffer,&clr_buffer,5); 
    memcpy(&buffer[5-arg_len[1]],&request->payload[arg_len[0]+1],arg_len[1]);   
-   max_num_pkts =   atoi(buffer);  
+   uexpiration_vars.max_num_pkts =   atoi(buffer);  
 
    memcpy(&buffer,&clr_buffer,5);     
    memcpy(&buffer[5-arg_len[2]],&request->payload[arg_len[0]+arg_len[1]+2],arg_len[2]);   
-   delay =   atoi(buffer);
+   uexpiration_vars.delay =   atoi(buffer);
    
    memcpy(&buffer,&clr_buffer,5);     
    memcpy(&buffer[5-arg_len[3]],&request->payload[arg_len[0]+arg_len[1]+arg_len[2]+3],arg_len[3]);   
-   d_flag =   atoi(buffer);  
+   uexpiration_vars.d_flag =   atoi(buffer);  
    
-   seqno = 0; // Reinitialize on next trigger 
+   uexpiration_vars.seqno = 0; // Reinitialize on next trigger 
 	
-	 uexpiration_vars.period = pkt_interval;	  
+	 uexpiration_vars.period = uexpiration_vars.pkt_interval;	  
 	 // start periodic timer
    uexpiration_vars.timerId = opentimers_create();
    opentimers_scheduleIn(
@@ -104,24 +101,24 @@ void uexpiration_task_cb() {
    reply->creator                       = COMPONENT_UEXPIRATION;
    
    //Deadline header parameters
-   reply->max_delay                     = delay; /* Max delay(in ms) before which the packet should reach the receiver */   
+   reply->max_delay                     = uexpiration_vars.delay; /* Max delay(in ms) before which the packet should reach the receiver */   
    reply->orgination_time_flag          = 1; /* Origination Time present ? */
-   reply->drop_flag                     = d_flag; /* Packet to be dropped if time expires */
+   reply->drop_flag                     = uexpiration_vars.d_flag; /* Packet to be dropped if time expires */
    
    reply->l4_protocol                   = IANA_UDP;
-   temp_l4_destination_port             = req.l4_destination_port;
-   reply->l4_destination_port           = req.l4_sourcePortORicmpv6Type;
+   temp_l4_destination_port             = uexpiration_vars.req.l4_destination_port;
+   reply->l4_destination_port           = uexpiration_vars.req.l4_sourcePortORicmpv6Type;
    reply->l4_sourcePortORicmpv6Type     = temp_l4_destination_port;
    reply->l3_destinationAdd.type        = ADDR_128B;
-   memcpy(&reply->l3_destinationAdd.addr_128b[0],&req.l3_sourceAdd.addr_128b[0],16);  
+   memcpy(&reply->l3_destinationAdd.addr_128b[0],&uexpiration_vars.req.l3_sourceAdd.addr_128b[0],16);  
    
    // Seq number in payload
    packetfunctions_reserveHeaderSize(reply,sizeof(uint16_t));
-   reply->payload[1] = (uint8_t)((seqno & 0xff00)>>8);
-   reply->payload[0] = (uint8_t)(seqno & 0x00ff); 
+   reply->payload[1] = (uint8_t)((uexpiration_vars.seqno & 0xff00)>>8);
+   reply->payload[0] = (uint8_t)(uexpiration_vars.seqno & 0x00ff); 
        
    //To stop periodic txn of data
-   if(++seqno > max_num_pkts) {
+   if(++uexpiration_vars.seqno > uexpiration_vars.max_num_pkts) {
       opentimers_destroy(uexpiration_vars.timerId);
    } else {
       opentimers_scheduleIn(
@@ -15,6 +15,7 @@
 #include "sixtop.h"
 #include "adaptive_sync.h"
 #include "sctimer.h"
+#include "opentelemetry.h"
 #ifndef DO_NOT_USE_FRAGMENTATION
 #include "openmemory.h"
 #endif
@@ -138,6 +139,11 @@ void ieee154e_init() {
    resetStats();
    ieee154e_stats.numDeSync                 = 0;
    
+   // status reported over serial
+   opentelemetry_registerCounters(STATUS_ISSYNC,(uint8_t*)&ieee154e_vars.isSync,sizeof(uint8_t),OPENTELEMETRY_PERIOD_ALWAYS);
+   opentelemetry_registerCounters(STATUS_ASN,(uint8_t*)&ieee154e_vars.asn,sizeof(asn_t),OPENTELEMETRY_PERIOD_SLOW);
+   opentelemetry_registerCounters(STATUS_MACSTATS,(uint8_t*)&ieee154e_stats,sizeof(ieee154e_stats_t),OPENTELEMETRY_PERIOD_SLOW);
+   
    // switch radio on
    radio_rfOn();
    
@@ -289,6 +295,7 @@ void isr_ieee154e_newSlot(opentimers_id_t id) {
       if (idmanager_getIsDAGroot()==TRUE) {
          changeIsSync(TRUE);
          ieee154e_resetAsn();
+         schedule_syncSlotOffset(ieee154e_vars.slotOffset);
          ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
       } else {
          activity_synchronize_newSlot();
@@ -874,11 +881,8 @@ port_INLINE void activity_ti1ORri1() {
       // find the next one
       ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
       if (idmanager_getIsSlotSkip() && idmanager_getIsDAGroot()==FALSE) {
-          if (ieee154e_vars.nextActiveSlotOffset>ieee154e_vars.slotOffset) {
-               ieee154e_vars.numOfSleepSlots = ieee154e_vars.nextActiveSlotOffset-ieee154e_vars.slotOffset;
-          } else {
-               ieee154e_vars.numOfSleepSlots = schedule_getFrameLength()+ieee154e_vars.nextActiveSlotOffset-ieee154e_vars.slotOffset; 
-          }
+          // the next active slot may belong to any slotframe
+          ieee154e_vars.numOfSleepSlots = schedule_getNumSlotsToNextActive();
           
           opentimers_scheduleAbsolute(
               ieee154e_vars.timerId,                            // timerId
@@ -1040,11 +1044,7 @@ port_INLINE void activity_ti1ORri1() {
          }
          // possibly skip additional slots if enabled
          if (idmanager_getIsSlotSkip() && idmanager_getIsDAGroot()==FALSE) {
-             if (ieee154e_vars.nextActiveSlotOffset>ieee154e_vars.slotOffset) {
-                 ieee154e_vars.numOfSleepSlots = ieee154e_vars.nextActiveSlotOffset-ieee154e_vars.slotOffset+NUMSERIALRX-1;
-             } else {
-                 ieee154e_vars.numOfSleepSlots = schedule_getFrameLength()+ieee154e_vars.nextActiveSlotOffset-ieee154e_vars.slotOffset+NUMSERIALRX-1; 
-             }
+             ieee154e_vars.numOfSleepSlots = schedule_getNumSlotsToNextActive()+NUMSERIALRX-1;
               
              //only increase ASN by numOfSleepSlots-NUMSERIALRX
              for (i=0;i<ieee154e_vars.numOfSleepSlots-NUMSERIALRX;i++){
@@ -1368,7 +1368,7 @@ port_INLINE void activity_tie5() {
         notif_sendDone(ieee154e_vars.dataToSend,E_FAIL);
     } else {
         // return packet to the virtual COMPONENT_SIXTOP_TO_IEEE802154E component
-        ieee154e_vars.dataToSend->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+        openqueue_macPutBackPacket(ieee154e_vars.dataToSend);
     }
    
     // reset local variable
@@ -2694,7 +2694,7 @@ void notif_sendDone(OpenQueueEntry_t* packetSent, owerror_t error) {
    memcpy(&packetSent->l2_asn,&ieee154e_vars.asn,sizeof(asn_t));
    // associate this packet with the virtual component
    // COMPONENT_IEEE802154E_TO_RES so RES can knows it's for it
-   packetSent->owner              = COMPONENT_IEEE802154E_TO_SIXTOP;
+   openqueue_macPutPacket(packetSent);
    // post RES's sendDone task
    scheduler_push_task(task_sixtopNotifSendDone,TASKPRIO_SIXTOP_NOTIF_TXDONE);
    // wake up the scheduler
@@ -2708,7 +2708,7 @@ void notif_receive(OpenQueueEntry_t* packetReceived) {
    schedule_indicateRx(&packetReceived->l2_asn);
    // associate this packet with the virtual component
    // COMPONENT_IEEE802154E_TO_SIXTOP so sixtop can knows it's for it
-   packetReceived->owner          = COMPONENT_IEEE802154E_TO_SIXTOP;
+   openqueue_macPutPacket(packetReceived);
    // post RES's Receive task
    scheduler_push_task(task_sixtopNotifReceive,TASKPRIO_SIXTOP_NOTIF_RX);
    // wake up the scheduler
@@ -2882,7 +2882,7 @@ void endSlot() {
          notif_sendDone(ieee154e_vars.dataToSend,E_FAIL);
       } else {
          // return packet to the virtual COMPONENT_SIXTOP_TO_IEEE802154E component
-         ieee154e_vars.dataToSend->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+         openqueue_macPutBackPacket(ieee154e_vars.dataToSend);
       }
       
       // reset local variable
@@ -5,6 +5,7 @@
 #include "idmanager.h"
 #include "openserial.h"
 #include "IEEE802154E.h"
+#include "opentelemetry.h"
 
 //=========================== variables =======================================
 
@@ -22,10 +23,14 @@ void registerNewNeighbor(
      );
 bool isNeighbor(open_addr_t* neighbor);
 void removeNeighbor(uint8_t neighborIndex);
-bool isThisRowMatching(
-        open_addr_t* address,
-        uint8_t      rowNumber
-     );
+void neighbors_getStatusRow(uint8_t row, uint8_t* buf);
+uint16_t  neighbors_computeLinkMetric(uint8_t index);
+dagrank_t neighbors_getPathCost(uint8_t index);
+void neighbors_updateLinkMetric(uint8_t index);
+void neighbors_updateCandidate(uint8_t index);
+uint8_t neighbors_hashAddress(open_addr_t* address);
+void neighbors_indexInsert(uint8_t index);
+void neighbors_indexRemove(uint8_t index);
 
 //=========================== public ==========================================
 
@@ -33,11 +38,26 @@ bool isThisRowMatching(
 \brief Initializes this module.
 */
 void neighbors_init() {
+   uint8_t i;
    
    // clear module variables
    memset(&neighbors_vars,0,sizeof(neighbors_vars_t));
    // The .used fields get reset to FALSE by this memset.
+   for (i=0;i<MAXNUMNEIGHBORS;i++) {
+      neighbors_vars.linkMetric[i] = neighbors_computeLinkMetric(i);
+   }
+   neighbors_vars.bestCandidate          = NEIGHBORS_NOCANDIDATE;
+   neighbors_vars.bestCandidatePathCost  = MAXDAGRANK;
+   memset(neighbors_vars.addrIndex,NEIGHBORS_HASHEMPTY,sizeof(neighbors_vars.addrIndex));
    
+   // status reported over serial
+   opentelemetry_registerTable(
+      STATUS_NEIGHBORS,
+      MAXNUMNEIGHBORS,
+      sizeof(debugNeighborEntry_t),
+      neighbors_getStatusRow,
+      OPENTELEMETRY_PERIOD_ALWAYS
+   );
 }
 
 //===== getters
@@ -60,6 +80,39 @@ uint8_t neighbors_getNumNeighbors() {
    return returnVal;
 }
 
+/**
+\brief Find the row of the neighbor table a neighbor is in.
+
+The row does not change for as long as the neighbor stays in the table, so it
+can be passed to the functions of this module which take an index.
+
+\param[in]  address The address of the neighbor, a 64-bit address.
+\param[out] index   The index of that neighbor in the neighbor table.
+
+\returns TRUE if that neighbor is in the table, FALSE otherwise, as for an
+   address which is not a 64-bit one.
+*/
+bool neighbors_getNeighborIndex(open_addr_t* address, uint8_t* index) {
+   uint8_t slot;
+   uint8_t row;
+   
+   if (address->type!=ADDR_64B) {
+      return FALSE;
+   }
+   
+   // probe from the home slot of that address, up to the next free slot
+   slot = neighbors_hashAddress(address);
+   while (neighbors_vars.addrIndex[slot]!=NEIGHBORS_HASHEMPTY) {
+      row = neighbors_vars.addrIndex[slot];
+      if (packetfunctions_sameAddress(address,&neighbors_vars.neighbors[row].addr_64b)) {
+         *index = row;
+         return TRUE;
+      }
+      slot = (slot+1)&(NEIGHBORS_HASHSIZE-1);
+   }
+   return FALSE;
+}
+
 dagrank_t neighbors_getNeighborRank(uint8_t index) {
    return neighbors_vars.neighbors[index].DAGrank;
 }
@@ -126,23 +179,18 @@ bool neighbors_getNeighborNoResource(uint8_t index){
 
 uint8_t neighbors_getGeneration(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            break;
-        }
+    if (neighbors_getNeighborIndex(address,&i)==FALSE){
+        return 0;
     }
     return neighbors_vars.neighbors[i].generation;
 }
 
 uint8_t neighbors_getSequenceNumber(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            break;
-        }
+    if (neighbors_getNeighborIndex(address,&i)==FALSE){
+        return 0;
     }
     return neighbors_vars.neighbors[i].sequenceNumber;
-
 }
 
 //===== interrogators
@@ -175,12 +223,11 @@ bool neighbors_isStableNeighbor(open_addr_t* address) {
          return returnVal;
    }
    
-   // iterate through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(&temp_addr_64b,i) && neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
-         returnVal  = TRUE;
-         break;
-      }
+   if (
+         neighbors_getNeighborIndex(&temp_addr_64b,&i)==TRUE &&
+         neighbors_vars.neighbors[i].stableNeighbor==TRUE
+      ) {
+      returnVal  = TRUE;
    }
    
    return returnVal;
@@ -222,12 +269,8 @@ bool neighbors_isInsecureNeighbor(open_addr_t* address) {
          return returnVal;
    }
    
-   // iterate through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(address,i)) {
-         returnVal  = neighbors_vars.neighbors[i].insecure;
-         break;
-      }
+   if (neighbors_getNeighborIndex(address,&i)==TRUE) {
+      returnVal  = neighbors_vars.neighbors[i].insecure;
    }
    
    return returnVal;
@@ -324,49 +367,46 @@ void neighbors_indicateRx(open_addr_t* l2_src,
    
    // update existing neighbor
    newNeighbor = TRUE;
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(l2_src,i)) {
-         
-         // this is not a new neighbor
-         newNeighbor = FALSE;
-         
-         // whether the neighbor is considered as secure or not
-         neighbors_vars.neighbors[i].insecure = insecure;
-
-         // update numRx, rssi, asn
-         neighbors_vars.neighbors[i].numRx++;
-         neighbors_vars.neighbors[i].rssi=rssi;
-         memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
-         //update jp
-         if (joinPrioPresent==TRUE){
-            neighbors_vars.neighbors[i].joinPrio=joinPrio;
-         }
-         
-         // update stableNeighbor, switchStabilityCounter
-         if (neighbors_vars.neighbors[i].stableNeighbor==FALSE) {
-            if (neighbors_vars.neighbors[i].rssi>BADNEIGHBORMAXRSSI) {
-               neighbors_vars.neighbors[i].switchStabilityCounter++;
-               if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
-                  neighbors_vars.neighbors[i].switchStabilityCounter=0;
-                  neighbors_vars.neighbors[i].stableNeighbor=TRUE;
-               }
-            } else {
+   if (neighbors_getNeighborIndex(l2_src,&i)==TRUE) {
+      
+      // this is not a new neighbor
+      newNeighbor = FALSE;
+      
+      // whether the neighbor is considered as secure or not
+      neighbors_vars.neighbors[i].insecure = insecure;
+
+      // update numRx, rssi, asn
+      neighbors_vars.neighbors[i].numRx++;
+      neighbors_vars.neighbors[i].rssi=rssi;
+      memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
+      //update jp
+      if (joinPrioPresent==TRUE){
+         neighbors_vars.neighbors[i].joinPrio=joinPrio;
+      }
+      
+      // update stableNeighbor, switchStabilityCounter
+      if (neighbors_vars.neighbors[i].stableNeighbor==FALSE) {
+         if (neighbors_vars.neighbors[i].rssi>BADNEIGHBORMAXRSSI) {
+            neighbors_vars.neighbors[i].switchStabilityCounter++;
+            if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
                neighbors_vars.neighbors[i].switchStabilityCounter=0;
+               neighbors_vars.neighbors[i].stableNeighbor=TRUE;
+               neighbors_updateCandidate(i);
             }
-         } else if (neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
-            if (neighbors_vars.neighbors[i].rssi<GOODNEIGHBORMINRSSI) {
-               neighbors_vars.neighbors[i].switchStabilityCounter++;
-               if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
-                  neighbors_vars.neighbors[i].switchStabilityCounter=0;
-                   neighbors_vars.neighbors[i].stableNeighbor=FALSE;
-               }
-            } else {
+         } else {
+            neighbors_vars.neighbors[i].switchStabilityCounter=0;
+         }
+      } else if (neighbors_vars.neighbors[i].stableNeighbor==TRUE) {
+         if (neighbors_vars.neighbors[i].rssi<GOODNEIGHBORMINRSSI) {
+            neighbors_vars.neighbors[i].switchStabilityCounter++;
+            if (neighbors_vars.neighbors[i].switchStabilityCounter>=SWITCHSTABILITYTHRESHOLD) {
                neighbors_vars.neighbors[i].switchStabilityCounter=0;
+                neighbors_vars.neighbors[i].stableNeighbor=FALSE;
+                neighbors_updateCandidate(i);
             }
+         } else {
+            neighbors_vars.neighbors[i].switchStabilityCounter=0;
          }
-         
-         // stop looping
-         break;
       }
    }
    
@@ -404,62 +444,50 @@ void neighbors_indicateTx(open_addr_t* l2_dest,
       return;
    }
    
-   // loop through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(l2_dest,i)) {
-         // handle roll-over case
-        
-          if (neighbors_vars.neighbors[i].numTx>(0xff-numTxAttempts)) {
-              neighbors_vars.neighbors[i].numWraps++; //counting the number of times that tx wraps.
-              neighbors_vars.neighbors[i].numTx/=2;
-              neighbors_vars.neighbors[i].numTxACK/=2;
-           }
-         // update statistics
-        neighbors_vars.neighbors[i].numTx += numTxAttempts; 
-        
-        if (was_finally_acked==TRUE) {
-            neighbors_vars.neighbors[i].numTxACK++;
-            memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
-        }
-        // #TODO : investigate this TX wrap thing! @incorrect in the meantime
-        // DB (Nov 2015) I believe this is correct. The ratio numTx/numTxAck is still a correct approximation
-        // of ETX after scaling down by a factor 2. Obviously, each one of numTx and numTxAck is no longer an
-        // accurate count of the related events, so don't rely of them to keep track of frames sent and ack received,
-        // and don't use numTx as a frame sequence number!
-        // The scaling means that older events have less weight when the scaling occurs. It is a way of progressively
-        // forgetting about the ancient past and giving more importance to recent observations.
-        break;
+   if (neighbors_getNeighborIndex(l2_dest,&i)==TRUE) {
+      // handle roll-over case
+      
+      if (neighbors_vars.neighbors[i].numTx>(0xff-numTxAttempts)) {
+         neighbors_vars.neighbors[i].numWraps++; //counting the number of times that tx wraps.
+         neighbors_vars.neighbors[i].numTx/=2;
+         neighbors_vars.neighbors[i].numTxACK/=2;
       }
+      // update statistics
+      neighbors_vars.neighbors[i].numTx += numTxAttempts;
+      
+      if (was_finally_acked==TRUE) {
+         neighbors_vars.neighbors[i].numTxACK++;
+         memcpy(&neighbors_vars.neighbors[i].asn,asnTs,sizeof(asn_t));
+      }
+      neighbors_updateLinkMetric(i);
+      // #TODO : investigate this TX wrap thing! @incorrect in the meantime
+      // DB (Nov 2015) I believe this is correct. The ratio numTx/numTxAck is still a correct approximation
+      // of ETX after scaling down by a factor 2. Obviously, each one of numTx and numTxAck is no longer an
+      // accurate count of the related events, so don't rely of them to keep track of frames sent and ack received,
+      // and don't use numTx as a frame sequence number!
+      // The scaling means that older events have less weight when the scaling occurs. It is a way of progressively
+      // forgetting about the ancient past and giving more importance to recent observations.
    }
 }
 
 void neighbors_updateSequenceNumber(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            neighbors_vars.neighbors[i].sequenceNumber = (neighbors_vars.neighbors[i].sequenceNumber+1) & 0x0F;
-            break;
-        }
+    if (neighbors_getNeighborIndex(address,&i)==TRUE){
+        neighbors_vars.neighbors[i].sequenceNumber = (neighbors_vars.neighbors[i].sequenceNumber+1) & 0x0F;
     }
 }
 
 void neighbors_updateGeneration(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            neighbors_vars.neighbors[i].generation = (neighbors_vars.neighbors[i].generation+1)%9;
-            break;
-        }
+    if (neighbors_getNeighborIndex(address,&i)==TRUE){
+        neighbors_vars.neighbors[i].generation = (neighbors_vars.neighbors[i].generation+1)%9;
     }
 }
 
 void neighbors_resetGeneration(open_addr_t* address){
     uint8_t i;
-    for (i=0;i<MAXNUMNEIGHBORS;i++){
-        if (packetfunctions_sameAddress(address, &neighbors_vars.neighbors[i].addr_64b)){
-            neighbors_vars.neighbors[i].generation = 0;
-            break;
-        }
+    if (neighbors_getNeighborIndex(address,&i)==TRUE){
+        neighbors_vars.neighbors[i].generation = 0;
     }
 }
 
@@ -490,18 +518,15 @@ bool  neighbors_getNeighborEui64(open_addr_t* address, uint8_t addr_type, uint8_
 
 void neighbors_setNeighborRank(uint8_t index, dagrank_t rank) {
    neighbors_vars.neighbors[index].DAGrank=rank;
-
+   neighbors_updateCandidate(index);
 }
 
 void neighbors_setNeighborNoResource(open_addr_t* address){
    uint8_t i;
    
-   // loop through neighbor table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(address,i)) {
-          neighbors_vars.neighbors[i].f6PNORES = TRUE;
-          break;
-      }
+   if (neighbors_getNeighborIndex(address,&i)==TRUE) {
+      neighbors_vars.neighbors[i].f6PNORES = TRUE;
+      neighbors_updateCandidate(i);
    }
 }
 
@@ -515,35 +540,37 @@ void neighbors_setPreferredParent(uint8_t index, bool isPreferred){
 \brief return the link cost to a neighbor, expressed as a rank increase from this neighbor to this node
 
 This really belongs to icmpv6rpl but it would require a much more complex interface to the neighbor table
-*/
 
+The link cost is computed each time the statistics of the link change, not
+on each call.
+*/
 uint16_t neighbors_getLinkMetric(uint8_t index) {
-    uint16_t  rankIncrease;
-    uint32_t  rankIncreaseIntermediary; // stores intermediary results of rankIncrease calculation
+    return neighbors_vars.linkMetric[index];
+}
 
-    // we assume that this neighbor has already been checked for being in use         
-    // calculate link cost to this neighbor
-    if (neighbors_vars.neighbors[index].numTxACK==0) {
-        if (neighbors_vars.neighbors[index].numTx<=DEFAULTLINKCOST){
-            rankIncrease = (3*DEFAULTLINKCOST-2)*MINHOPRANKINCREASE;
-        } else {
-            rankIncrease = (3*LARGESTLINKCOST-2)*MINHOPRANKINCREASE;
-        }
-    } else {
-        //6TiSCH minimal draft using OF0 for rank computation: ((3*numTx/numTxAck)-2)*minHopRankIncrease
-        // numTx is on 8 bits, so scaling up 10 bits won't lead to saturation
-        // but this <<10 followed by >>10 does not provide any benefit either. Result is the same.
-        rankIncreaseIntermediary = (((uint32_t)neighbors_vars.neighbors[index].numTx) << 10);
-        rankIncreaseIntermediary = (3*rankIncreaseIntermediary * MINHOPRANKINCREASE) / ((uint32_t)neighbors_vars.neighbors[index].numTxACK);
-        rankIncreaseIntermediary = rankIncreaseIntermediary - ((uint32_t)(2 * MINHOPRANKINCREASE)<<10);
-        // this could still overflow for numTx large and numTxAck small, Casting to 16 bits will yiel the least significant bits
-        if (rankIncreaseIntermediary >= (65536<<10)) {
-            rankIncrease = 65535;
-        } else {
-            rankIncrease = (uint16_t)(rankIncreaseIntermediary >> 10);
-        }
+/**
+\brief Retrieve the neighbor with the lowest cost path to the DAG root.
+
+Candidates are the neighbors which are in use, stable, not marked as having no
+resource and which advertised a DAG rank. The path cost through a candidate is
+its DAG rank plus the link metric to it. Among equal costs, the lowest index
+wins.
+
+The candidate is kept up to date as the neighbor table changes, so calling
+this function does not scan the table.
+
+\param[out] index    The index of the candidate in the neighbor table.
+\param[out] pathCost The path cost through the candidate.
+
+\returns TRUE if there is a candidate, FALSE otherwise.
+*/
+bool neighbors_getBestParentCandidate(uint8_t* index, dagrank_t* pathCost) {
+    if (neighbors_vars.bestCandidate==NEIGHBORS_NOCANDIDATE) {
+        return FALSE;
     }
-    return rankIncrease;
+    *index    = neighbors_vars.bestCandidate;
+    *pathCost = neighbors_vars.bestCandidatePathCost;
+    return TRUE;
 }
 
 //===== maintenance
@@ -668,14 +695,26 @@ status information about several modules in the OpenWSN stack.
 bool debugPrint_neighbors() {
    debugNeighborEntry_t temp;
    neighbors_vars.debugRow=(neighbors_vars.debugRow+1)%MAXNUMNEIGHBORS;
-   temp.row=neighbors_vars.debugRow;
-   temp.neighborEntry=neighbors_vars.neighbors[neighbors_vars.debugRow];
+   neighbors_getStatusRow(neighbors_vars.debugRow,(uint8_t*)&temp);
    openserial_printStatus(STATUS_NEIGHBORS,(uint8_t*)&temp,sizeof(debugNeighborEntry_t));
    return TRUE;
 }
 
 //=========================== private =========================================
 
+/**
+\brief Format a row of the neighbor table, as reported over serial.
+
+\param[in]  row The row of the neighbor table.
+\param[out] buf Where to write the debugNeighborEntry_t.
+*/
+void neighbors_getStatusRow(uint8_t row, uint8_t* buf) {
+   debugNeighborEntry_t temp;
+   temp.row=row;
+   temp.neighborEntry=neighbors_vars.neighbors[row];
+   memcpy(buf,&temp,sizeof(debugNeighborEntry_t));
+}
+
 void registerNewNeighbor(open_addr_t* address,
                          int8_t       rssi,
                          asn_t*       asnTimestamp,
@@ -703,6 +742,7 @@ void registerNewNeighbor(open_addr_t* address,
             neighbors_vars.neighbors[i].stableNeighbor         = TRUE;
             neighbors_vars.neighbors[i].switchStabilityCounter = 0;
             memcpy(&neighbors_vars.neighbors[i].addr_64b,address,sizeof(open_addr_t));
+            neighbors_indexInsert(i);
             neighbors_vars.neighbors[i].DAGrank                = DEFAULTDAGRANK;
             // since we don't have a DAG rank at this point, no need to call for routing table update
             neighbors_vars.neighbors[i].rssi                   = rssi;
@@ -714,6 +754,7 @@ void registerNewNeighbor(open_addr_t* address,
             if (joinPrioPresent==TRUE){
                neighbors_vars.neighbors[i].joinPrio=joinPrio;
             }
+            neighbors_updateLinkMetric(i);
             
             break;
          }
@@ -729,19 +770,15 @@ void registerNewNeighbor(open_addr_t* address,
 }
 
 bool isNeighbor(open_addr_t* neighbor) {
-   uint8_t i=0;
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (isThisRowMatching(neighbor,i)) {
-         return TRUE;
-      }
-   }
-   return FALSE;
+   uint8_t i;
+   return neighbors_getNeighborIndex(neighbor,&i);
 }
 
 void removeNeighbor(uint8_t neighborIndex) {
-#ifndef DO_NOT_USE_FRAGMENTATION
-   fragment_deleteNeighbor(&(neighbors_vars.neighbors[neighborIndex].addr_64b));
-#endif
+   neighbors_indexRemove(neighborIndex);
+#ifndef DO_NOT_USE_FRAGMENTATION
+   fragment_deleteNeighbor(&(neighbors_vars.neighbors[neighborIndex].addr_64b));
+#endif
    neighbors_vars.neighbors[neighborIndex].used                      = FALSE;
    neighbors_vars.neighbors[neighborIndex].parentPreference          = 0;
    neighbors_vars.neighbors[neighborIndex].stableNeighbor            = FALSE;
@@ -758,19 +795,182 @@ void removeNeighbor(uint8_t neighborIndex) {
    neighbors_vars.neighbors[neighborIndex].asn.bytes2and3            = 0;
    neighbors_vars.neighbors[neighborIndex].asn.byte4                 = 0;
    neighbors_vars.neighbors[neighborIndex].f6PNORES                  = FALSE;
+   neighbors_updateLinkMetric(neighborIndex);
+}
+
+/**
+\brief Compute the link metric to a neighbor, from its link statistics.
+
+\returns The rank increase from this neighbor to this node.
+*/
+uint16_t neighbors_computeLinkMetric(uint8_t index) {
+    uint16_t  rankIncrease;
+    uint32_t  rankIncreaseIntermediary; // stores intermediary results of rankIncrease calculation
+
+    // we assume that this neighbor has already been checked for being in use         
+    // calculate link cost to this neighbor
+    if (neighbors_vars.neighbors[index].numTxACK==0) {
+        if (neighbors_vars.neighbors[index].numTx<=DEFAULTLINKCOST){
+            rankIncrease = (3*DEFAULTLINKCOST-2)*MINHOPRANKINCREASE;
+        } else {
+            rankIncrease = (3*LARGESTLINKCOST-2)*MINHOPRANKINCREASE;
+        }
+    } else {
+        //6TiSCH minimal draft using OF0 for rank computation: ((3*numTx/numTxAck)-2)*minHopRankIncrease
+        // numTx is on 8 bits, so scaling up 10 bits won't lead to saturation
+        // but this <<10 followed by >>10 does not provide any benefit either. Result is the same.
+        rankIncreaseIntermediary = (((uint32_t)neighbors_vars.neighbors[index].numTx) << 10);
+        rankIncreaseIntermediary = (3*rankIncreaseIntermediary * MINHOPRANKINCREASE) / ((uint32_t)neighbors_vars.neighbors[index].numTxACK);
+        rankIncreaseIntermediary = rankIncreaseIntermediary - ((uint32_t)(2 * MINHOPRANKINCREASE)<<10);
+        // this could still overflow for numTx large and numTxAck small, Casting to 16 bits will yiel the least significant bits
+        if (rankIncreaseIntermediary >= (65536<<10)) {
+            rankIncrease = 65535;
+        } else {
+            rankIncrease = (uint16_t)(rankIncreaseIntermediary >> 10);
+        }
+    }
+    return rankIncrease;
+}
+
+/**
+\brief The path cost to the DAG root through a neighbor.
+
+\returns MAXDAGRANK if this neighbor can not be a parent.
+*/
+dagrank_t neighbors_getPathCost(uint8_t index) {
+    uint32_t  pathCost;
+    
+    if (
+        neighbors_isStableNeighborByIndex(index)==FALSE     ||
+        neighbors_vars.neighbors[index].f6PNORES==TRUE      ||
+        neighbors_vars.neighbors[index].DAGrank==DEFAULTDAGRANK
+    ) {
+        return MAXDAGRANK;
+    }
+    pathCost = (uint32_t)neighbors_vars.neighbors[index].DAGrank+neighbors_vars.linkMetric[index];
+    if (pathCost>MAXDAGRANK) {
+        return MAXDAGRANK;
+    }
+    return (dagrank_t)pathCost;
+}
+
+/**
+\brief Recompute the link metric to a neighbor, after its statistics changed.
+*/
+void neighbors_updateLinkMetric(uint8_t index) {
+    neighbors_vars.linkMetric[index] = neighbors_computeLinkMetric(index);
+    neighbors_updateCandidate(index);
+}
+
+/**
+\brief Update the best parent candidate, after the path cost through a neighbor
+    may have changed.
+
+Only when the path cost through the current candidate increases is the
+neighbor table scanned for a new one.
+*/
+void neighbors_updateCandidate(uint8_t index) {
+    dagrank_t pathCost;
+    uint8_t   i;
+    
+    pathCost = neighbors_getPathCost(index);
+    
+    if (index!=neighbors_vars.bestCandidate) {
+        if (
+            pathCost!=MAXDAGRANK &&
+            (
+                neighbors_vars.bestCandidate==NEIGHBORS_NOCANDIDATE       ||
+                pathCost<neighbors_vars.bestCandidatePathCost             ||
+                (
+                    pathCost==neighbors_vars.bestCandidatePathCost        &&
+                    index<neighbors_vars.bestCandidate
+                )
+            )
+        ) {
+            neighbors_vars.bestCandidate          = index;
+            neighbors_vars.bestCandidatePathCost  = pathCost;
+        }
+        return;
+    }
+    
+    if (pathCost<=neighbors_vars.bestCandidatePathCost) {
+        // still the cheapest, no other neighbor can tie with a lower index
+        neighbors_vars.bestCandidatePathCost      = pathCost;
+        return;
+    }
+    
+    // the candidate got worse, look for a cheaper one
+    neighbors_vars.bestCandidate                  = NEIGHBORS_NOCANDIDATE;
+    neighbors_vars.bestCandidatePathCost          = MAXDAGRANK;
+    for (i=0;i<MAXNUMNEIGHBORS;i++) {
+        pathCost = neighbors_getPathCost(i);
+        if (pathCost<neighbors_vars.bestCandidatePathCost) {
+            neighbors_vars.bestCandidate          = i;
+            neighbors_vars.bestCandidatePathCost  = pathCost;
+        }
+    }
 }
 
 //=========================== helpers =========================================
 
-bool isThisRowMatching(open_addr_t* address, uint8_t rowNumber) {
-   switch (address->type) {
-      case ADDR_64B:
-         return neighbors_vars.neighbors[rowNumber].used &&
-                packetfunctions_sameAddress(address,&neighbors_vars.neighbors[rowNumber].addr_64b);
-      default:
-         openserial_printCritical(COMPONENT_NEIGHBORS,ERR_WRONG_ADDR_TYPE,
-                               (errorparameter_t)address->type,
-                               (errorparameter_t)3);
-         return FALSE;
+/**
+\brief The home slot of an address in the address index.
+
+EUI-64s of motes of a same deployment mostly differ in their last byte.
+*/
+uint8_t neighbors_hashAddress(open_addr_t* address) {
+   return address->addr_64b[7]&(NEIGHBORS_HASHSIZE-1);
+}
+
+/**
+\brief Add a row of the neighbor table to the address index.
+
+The address index uses linear probing. MAXNUMNEIGHBORS is smaller than
+NEIGHBORS_HASHSIZE, so there is always a free slot.
+*/
+void neighbors_indexInsert(uint8_t index) {
+   uint8_t slot;
+   
+   slot = neighbors_hashAddress(&neighbors_vars.neighbors[index].addr_64b);
+   while (neighbors_vars.addrIndex[slot]!=NEIGHBORS_HASHEMPTY) {
+      slot = (slot+1)&(NEIGHBORS_HASHSIZE-1);
+   }
+   neighbors_vars.addrIndex[slot] = index;
+}
+
+/**
+\brief Remove a row of the neighbor table from the address index.
+
+The slot freed is filled by moving back the next entries of its cluster which
+could otherwise no longer be reached from their home slot, so no tombstones
+are needed.
+*/
+void neighbors_indexRemove(uint8_t index) {
+   uint8_t hole;
+   uint8_t slot;
+   uint8_t home;
+   
+   hole = neighbors_hashAddress(&neighbors_vars.neighbors[index].addr_64b);
+   while (neighbors_vars.addrIndex[hole]!=index) {
+      if (neighbors_vars.addrIndex[hole]==NEIGHBORS_HASHEMPTY) {
+         // not indexed
+         return;
+      }
+      hole = (hole+1)&(NEIGHBORS_HASHSIZE-1);
+   }
+   
+   slot = hole;
+   while (1) {
+      slot = (slot+1)&(NEIGHBORS_HASHSIZE-1);
+      if (neighbors_vars.addrIndex[slot]==NEIGHBORS_HASHEMPTY) {
+         break;
+      }
+      home = neighbors_hashAddress(&neighbors_vars.neighbors[neighbors_vars.addrIndex[slot]].addr_64b);
+      // move it back unless its home slot lies between the hole and it
+      if (((slot-home)&(NEIGHBORS_HASHSIZE-1))>=((slot-hole)&(NEIGHBORS_HASHSIZE-1))) {
+         neighbors_vars.addrIndex[hole] = neighbors_vars.addrIndex[slot];
+         hole = slot;
+      }
    }
+   neighbors_vars.addrIndex[hole] = NEIGHBORS_HASHEMPTY;
 }
@@ -23,6 +23,26 @@
 #define DEFAULTDAGRANK            MAXDAGRANK
 #define MINHOPRANKINCREASE        256  //default value in RPL and Minimal 6TiSCH draft
 
+#define NEIGHBORS_NOCANDIDATE     0xff // no neighbor can be a parent
+
+// number of slots of the address index, a power of 2 larger than MAXNUMNEIGHBORS
+#ifndef NEIGHBORS_HASHSIZE
+#if   MAXNUMNEIGHBORS<=16
+#define NEIGHBORS_HASHSIZE        32
+#elif MAXNUMNEIGHBORS<=32
+#define NEIGHBORS_HASHSIZE        64
+#elif MAXNUMNEIGHBORS<=64
+#define NEIGHBORS_HASHSIZE        128
+#else
+#define NEIGHBORS_HASHSIZE        256
+#endif
+#endif
+#define NEIGHBORS_HASHEMPTY       0xff // free slot of the address index
+
+#if MAXNUMNEIGHBORS>=NEIGHBORS_HASHSIZE || NEIGHBORS_HASHSIZE>256
+#error "NEIGHBORS_HASHSIZE must be larger than MAXNUMNEIGHBORS, and at most 256"
+#endif
+
 
 //=========================== typedef =========================================
 
@@ -47,6 +67,10 @@ END_PACK
    
 typedef struct {
    neighborRow_t        neighbors[MAXNUMNEIGHBORS];
+   uint16_t             linkMetric[MAXNUMNEIGHBORS];  // rank increase to each neighbor, see neighbors_getLinkMetric()
+   uint8_t              bestCandidate;                // neighbor with the lowest path cost, or NEIGHBORS_NOCANDIDATE
+   dagrank_t            bestCandidatePathCost;
+   uint8_t              addrIndex[NEIGHBORS_HASHSIZE]; // row of each neighbor in use, by hash of its address
    dagrank_t            myDAGrank;
    uint8_t              debugRow;
 } neighbors_vars_t;
@@ -58,7 +82,9 @@ void          neighbors_init(void);
 // getters
 dagrank_t     neighbors_getNeighborRank(uint8_t index);
 uint8_t       neighbors_getNumNeighbors(void);
+bool          neighbors_getNeighborIndex(open_addr_t* address, uint8_t* index);
 uint16_t      neighbors_getLinkMetric(uint8_t index);
+bool          neighbors_getBestParentCandidate(uint8_t* index, dagrank_t* pathCost);
 open_addr_t*  neighbors_getKANeighbor(uint16_t kaPeriod);
 open_addr_t*  neighbors_getJoinProxy(void);
 bool          neighbors_getNeighborNoResource(uint8_t index);
@@ -7,6 +7,8 @@
 #include "idmanager.h"
 #include "sf0.h"
 #include "icmpv6rpl.h"
+#include "IEEE802154E.h"
+#include "opentelemetry.h"
 
 //=========================== variables =======================================
 
@@ -14,7 +16,21 @@ schedule_vars_t schedule_vars;
 
 //=========================== prototypes ======================================
 
-void schedule_resetEntry(scheduleEntry_t* pScheduleEntry);
+void     schedule_resetEntry(scheduleEntry_t* pScheduleEntry);
+scheduleSlotframe_t* schedule_getSlotframe(uint8_t frameHandle);
+uint8_t  schedule_getRow(scheduleSlotframe_t* slotframe, slotOffset_t slotOffset);
+uint8_t  schedule_getPreviousRow(scheduleSlotframe_t* slotframe, slotOffset_t slotOffset);
+uint16_t schedule_getDistance(scheduleSlotframe_t* slotframe, slotOffset_t slotOffset);
+scheduleEntry_t* schedule_findNextEntry(scheduleSlotframe_t* slotframe);
+scheduleSlotframe_t* schedule_getNextSlotframe(void);
+scheduleEntry_t* schedule_getActiveEntry(void);
+uint16_t schedule_updateSlotsToNextActive(void);
+slotOffset_t schedule_getAsnModulo(frameLength_t frameLength);
+void     schedule_incrementAsn(uint16_t numSlots);
+uint8_t  schedule_findNeighbor(open_addr_t* neighbor);
+void     schedule_indexEntry(uint8_t row);
+void     schedule_unindexEntry(uint8_t row);
+void     schedule_getStatusRow(uint8_t row, uint8_t* buf);
 
 //=========================== public ==========================================
 
@@ -35,8 +51,27 @@ void schedule_init() {
    for (running_slotOffset=0;running_slotOffset<MAXACTIVESLOTS;running_slotOffset++) {
       schedule_resetEntry(&schedule_vars.scheduleBuf[running_slotOffset]);
    }
+   // the default slotframe, its length is set once known
+   schedule_vars.numSlotframes   = 1;
+   schedule_vars.slotframes[0].handle = SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_HANDLE;
+   memset(&schedule_vars.slotframes[0].slotRow[0],SCHEDULE_NOROW,sizeof(schedule_vars.slotframes[0].slotRow));
    schedule_vars.backoffExponent = MINBE-1;
    schedule_vars.maxActiveSlots = MAXACTIVESLOTS;
+#ifdef SCHEDULE_UNICAST_SLOTFRAME_LENGTH
+   // the slotframe of the dedicated cells, aligned once synchronized
+   schedule_addSlotframe(SCHEDULE_UNICAST_SLOTFRAME_HANDLE,SCHEDULE_UNICAST_SLOTFRAME_LENGTH);
+#endif
+   
+   // status reported over serial
+   opentelemetry_registerTable(
+      STATUS_SCHEDULE,
+      MAXACTIVESLOTS,
+      sizeof(debugScheduleEntry_t),
+      schedule_getStatusRow,
+      OPENTELEMETRY_PERIOD_ALWAYS
+   );
+   // backoffExponent is followed by backoff in schedule_vars_t
+   opentelemetry_registerCounters(STATUS_BACKOFF,&schedule_vars.backoffExponent,2,OPENTELEMETRY_PERIOD_ALWAYS);
    
    start_slotOffset = SCHEDULE_MINIMAL_6TISCH_SLOTOFFSET;
    if (idmanager_getIsDAGroot()==TRUE) {
@@ -67,7 +102,7 @@ void schedule_startDAGroot() {
    
    start_slotOffset = SCHEDULE_MINIMAL_6TISCH_SLOTOFFSET;
    // set frame length, handle and number (default 1 by now)
-   if (schedule_vars.frameLength == 0) {
+   if (schedule_vars.slotframes[0].length == 0) {
        // slotframe length is not set, set it to default length
        schedule_setFrameLength(SLOTFRAME_LENGTH);
    } else {
@@ -105,31 +140,7 @@ bool debugPrint_schedule() {
    schedule_vars.debugPrintRow         = (schedule_vars.debugPrintRow+1)%schedule_vars.maxActiveSlots;
    
    // gather status data
-   temp.row                            = schedule_vars.debugPrintRow;
-   temp.slotOffset                     = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].slotOffset;
-   temp.type                           = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].type;
-   temp.shared                         = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].shared;
-   temp.channelOffset                  = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].channelOffset;
-   memcpy(
-      &temp.neighbor,
-      &schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].neighbor,
-      sizeof(open_addr_t)
-   );
-   temp.numRx                          = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].numRx;
-   temp.numTx                          = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].numTx;
-   temp.numTxACK                       = \
-      schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].numTxACK;
-   memcpy(
-      &temp.lastUsedAsn,
-      &schedule_vars.scheduleBuf[schedule_vars.debugPrintRow].lastUsedAsn,
-      sizeof(asn_t)
-   );
+   schedule_getStatusRow(schedule_vars.debugPrintRow,(uint8_t*)&temp);
    
    // send status data over serial port
    openserial_printStatus(
@@ -169,7 +180,7 @@ bool debugPrint_backoff() {
 //=== from 6top (writing the schedule)
 
 /**
-\brief Set frame length.
+\brief Set the length of the default slotframe.
 
 \param newFrameLength The new frame length.
 */
@@ -178,24 +189,44 @@ void schedule_setFrameLength(frameLength_t newFrameLength) {
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   schedule_vars.frameLength = newFrameLength;
+   schedule_vars.slotframes[0].length = newFrameLength;
    if (newFrameLength <= MAXACTIVESLOTS) {
       schedule_vars.maxActiveSlots = newFrameLength;
    }
    ENABLE_INTERRUPTS();
+   
+   if (newFrameLength > MAXSLOTFRAMELENGTH) {
+      // the slot offsets past MAXSLOTFRAMELENGTH can not be scheduled
+      openserial_printError(
+         COMPONENT_SCHEDULE,ERR_SCHEDULE_OVERFLOWN,
+         (errorparameter_t)newFrameLength,
+         (errorparameter_t)MAXSLOTFRAMELENGTH
+      );
+   }
 }
 
 /**
-\brief Set frame handle.
+\brief Set the handle of the default slotframe.
 
 \param frameHandle The new frame handle.
 */
 void schedule_setFrameHandle(uint8_t frameHandle) {
+   uint8_t row;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   schedule_vars.frameHandle = frameHandle;
+   // the cells of the default slotframe follow it
+   for (row=0;row<MAXACTIVESLOTS;row++) {
+      if (
+            schedule_vars.scheduleBuf[row].type!=CELLTYPE_OFF
+            &&
+            schedule_vars.scheduleBuf[row].frameHandle==schedule_vars.slotframes[0].handle
+         ) {
+         schedule_vars.scheduleBuf[row].frameHandle = frameHandle;
+      }
+   }
+   schedule_vars.slotframes[0].handle = frameHandle;
    
    ENABLE_INTERRUPTS();
 }
@@ -216,7 +247,97 @@ void schedule_setFrameNumber(uint8_t frameNumber) {
 }
 
 /**
-\brief Get the information of a specific slot.
+\brief Add a slotframe to the schedule.
+
+The new slotframe starts empty, aligned on the ASN of the current timeslot.
+Its cells are added with schedule_addActiveSlotInFrame().
+
+\param frameHandle      The handle of the new slotframe. The lower the handle,
+   the higher the priority of its cells.
+\param frameLength      The length of the new slotframe, in slots.
+*/
+owerror_t schedule_addSlotframe(uint8_t frameHandle, frameLength_t frameLength) {
+   scheduleSlotframe_t* slotframe;
+   
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   
+   if (
+         schedule_getSlotframe(frameHandle)!=NULL        ||
+         schedule_vars.numSlotframes==MAXSLOTFRAMES      ||
+         frameLength==0                                  ||
+         frameLength>MAXSLOTFRAMELENGTH
+      ) {
+      ENABLE_INTERRUPTS();
+      openserial_printError(
+         COMPONENT_SCHEDULE,ERR_SCHEDULE_OVERFLOWN,
+         (errorparameter_t)frameHandle,
+         (errorparameter_t)frameLength
+      );
+      return E_FAIL;
+   }
+   
+   slotframe = &schedule_vars.slotframes[schedule_vars.numSlotframes++];
+   slotframe->handle             = frameHandle;
+   slotframe->length             = frameLength;
+   slotframe->slotOffset         = schedule_getAsnModulo(frameLength);
+   slotframe->nextEntry          = NULL;
+   memset(&slotframe->slotRow[0],SCHEDULE_NOROW,sizeof(slotframe->slotRow));
+   
+   ENABLE_INTERRUPTS();
+   return E_SUCCESS;
+}
+
+/**
+\brief Remove a slotframe, and all its cells, from the schedule.
+
+The default slotframe can not be removed.
+
+\param frameHandle      The handle of the slotframe to remove.
+*/
+owerror_t schedule_removeSlotframe(uint8_t frameHandle) {
+   scheduleSlotframe_t* slotframe;
+   uint8_t              i;
+   
+   INTERRUPT_DECLARATION();
+   
+   slotframe = schedule_getSlotframe(frameHandle);
+   if (slotframe==NULL || slotframe==&schedule_vars.slotframes[0]) {
+      openserial_printError(
+         COMPONENT_SCHEDULE,ERR_FREEING_ERROR,
+         (errorparameter_t)frameHandle,
+         (errorparameter_t)0
+      );
+      return E_FAIL;
+   }
+   
+   // remove its cells
+   while (slotframe->nextEntry!=NULL) {
+      if (
+         schedule_removeActiveSlotInFrame(
+            frameHandle,
+            slotframe->nextEntry->slotOffset,
+            &slotframe->nextEntry->neighbor
+         )==E_FAIL
+      ) {
+         return E_FAIL;
+      }
+   }
+   
+   DISABLE_INTERRUPTS();
+   
+   // close the gap in the table of slotframes
+   schedule_vars.numSlotframes--;
+   for (i=slotframe-&schedule_vars.slotframes[0];i<schedule_vars.numSlotframes;i++) {
+      memcpy(&schedule_vars.slotframes[i],&schedule_vars.slotframes[i+1],sizeof(scheduleSlotframe_t));
+   }
+   
+   ENABLE_INTERRUPTS();
+   return E_SUCCESS;
+}
+
+/**
+\brief Get the information of a specific slot of the default slotframe.
 
 \param slotOffset
 \param neighbor
@@ -227,21 +348,38 @@ void  schedule_getSlotInfo(
    open_addr_t*         neighbor,
    slotinfo_element_t*  info
 ){
+   schedule_getSlotInfoInFrame(schedule_getFrameHandle(),slotOffset,neighbor,info);
+}
+
+/**
+\brief Get the information of a specific slot of a slotframe.
+
+\param frameHandle      The handle of the slotframe
+\param slotOffset
+\param neighbor
+\param info
+*/
+void  schedule_getSlotInfoInFrame(
+   uint8_t              frameHandle,
+   slotOffset_t         slotOffset,
+   open_addr_t*         neighbor,
+   slotinfo_element_t*  info
+){
    
+   scheduleSlotframe_t* slotframe;
    scheduleEntry_t* slotContainer;
-  
-   // find an empty schedule entry container
-   slotContainer = &schedule_vars.scheduleBuf[0];
-   while (slotContainer<=&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]) {
-       //check that this entry for that neighbour and timeslot is not already scheduled.
-       if (packetfunctions_sameAddress(neighbor,&(slotContainer->neighbor))&& (slotContainer->slotOffset==slotOffset)){
-               //it exists so this is an update.
-               info->link_type                 = slotContainer->type;
-               info->shared                    =slotContainer->shared;
-               info->channelOffset             = slotContainer->channelOffset;
-               return; //as this is an update. No need to re-insert as it is in the same position on the list.
-        }
-        slotContainer++;
+   uint8_t          row;
+   
+   slotframe = schedule_getSlotframe(frameHandle);
+   row = slotframe==NULL ? SCHEDULE_NOROW : schedule_getRow(slotframe,slotOffset);
+   if (row!=SCHEDULE_NOROW) {
+      slotContainer = &schedule_vars.scheduleBuf[row];
+      if (packetfunctions_sameAddress(neighbor,&(slotContainer->neighbor))) {
+         info->link_type                 = slotContainer->type;
+         info->shared                    = slotContainer->shared;
+         info->channelOffset             = slotContainer->channelOffset;
+         return;
+      }
    }
    //return cell type off.
    info->link_type                 = CELLTYPE_OFF;
@@ -259,7 +397,7 @@ uint16_t  schedule_getMaxActiveSlots() {
 }
 
 /**
-\brief Add a new active slot into the schedule.
+\brief Add a new active slot into the default slotframe.
 
 \param slotOffset       The slotoffset of the new slot
 \param type             The type of the cell
@@ -275,24 +413,55 @@ owerror_t schedule_addActiveSlot(
       channelOffset_t channelOffset,
       open_addr_t*    neighbor
    ) {
+   return schedule_addActiveSlotInFrame(
+      schedule_getFrameHandle(),
+      slotOffset,
+      type,
+      shared,
+      channelOffset,
+      neighbor
+   );
+}
+
+/**
+\brief Add a new active slot into a slotframe.
+
+\param frameHandle      The handle of the slotframe
+\param slotOffset       The slotoffset of the new slot
+\param type             The type of the cell
+\param shared           Whether this cell is shared (TRUE) or not (FALSE).
+\param channelOffset    The channelOffset of the new slot
+\param neighbor         The neighbor associated with this cell (all 0's if
+   none)
+*/
+owerror_t schedule_addActiveSlotInFrame(
+      uint8_t         frameHandle,
+      slotOffset_t    slotOffset,
+      cellType_t      type,
+      bool            shared,
+      channelOffset_t channelOffset,
+      open_addr_t*    neighbor
+   ) {
+   scheduleSlotframe_t* slotframe;
    scheduleEntry_t* slotContainer;
    scheduleEntry_t* previousSlotWalker;
-   scheduleEntry_t* nextSlotWalker;
+   uint8_t          row;
+   uint8_t          previousRow;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
+   slotframe = schedule_getSlotframe(frameHandle);
+   
    // find an empty schedule entry container
-   slotContainer = &schedule_vars.scheduleBuf[0];
-   while (
-         slotContainer->type!=CELLTYPE_OFF &&
-         slotContainer<=&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]
-      ) {
-      slotContainer++;
+   for (row=0;row<schedule_vars.maxActiveSlots;row++) {
+      if (schedule_vars.scheduleBuf[row].type==CELLTYPE_OFF) {
+         break;
+      }
    }
    
    // abort it schedule overflow
-   if (slotContainer>&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]) {
+   if (slotframe==NULL || row==schedule_vars.maxActiveSlots || slotOffset>=MAXSLOTFRAMELENGTH) {
       ENABLE_INTERRUPTS();
       openserial_printError(
          COMPONENT_SCHEDULE,ERR_SCHEDULE_OVERFLOWN,
@@ -302,68 +471,53 @@ owerror_t schedule_addActiveSlot(
       return E_FAIL;
    }
    
+   // abort if slot is already in schedule
+   if (slotframe->slotRow[slotOffset]!=SCHEDULE_NOROW) {
+      ENABLE_INTERRUPTS();
+      openserial_printError(
+         COMPONENT_SCHEDULE,ERR_SCHEDULE_ADDDUPLICATESLOT,
+         (errorparameter_t)slotOffset,
+         (errorparameter_t)0
+      );
+      return E_FAIL;
+   }
+   slotContainer = &schedule_vars.scheduleBuf[row];
+   
    // fill that schedule entry with parameters passed
    slotContainer->slotOffset                = slotOffset;
    slotContainer->type                      = type;
    slotContainer->shared                    = shared;
    slotContainer->channelOffset             = channelOffset;
    memcpy(&slotContainer->neighbor,neighbor,sizeof(open_addr_t));
+   slotContainer->frameHandle               = frameHandle;
    
-   // insert in circular list
-   if (schedule_vars.currentScheduleEntry==NULL) {
-      // this is the first active slot added
+   // insert in the circular list of the slotframe, after the active slot preceding it
+   previousRow = schedule_getPreviousRow(slotframe,slotOffset);
+   if (previousRow==SCHEDULE_NOROW) {
+      // this is the first active slot added to this slotframe
       
       // the next slot of this slot is this slot
       slotContainer->next                   = slotContainer;
-      
-      // current slot points to this slot
-      schedule_vars.currentScheduleEntry    = slotContainer;
    } else  {
-      // this is NOT the first active slot added
-      
-      // find position in schedule
-      previousSlotWalker                    = schedule_vars.currentScheduleEntry;
-      while (1) {
-         nextSlotWalker                     = previousSlotWalker->next;
-         if (
-               (
-                     (previousSlotWalker->slotOffset <  slotContainer->slotOffset) &&
-                     (slotContainer->slotOffset <  nextSlotWalker->slotOffset)
-               )
-               ||
-               (
-                     (previousSlotWalker->slotOffset <  slotContainer->slotOffset) &&
-                     (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
-               )
-               ||
-               (
-                     (slotContainer->slotOffset <  nextSlotWalker->slotOffset) &&
-                     (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
-               )
-         ) {
-            break;
-         }
-         if (previousSlotWalker->slotOffset == slotContainer->slotOffset) {
-            // slot is already in schedule
-            openserial_printError(
-               COMPONENT_SCHEDULE,ERR_SCHEDULE_ADDDUPLICATESLOT,
-               (errorparameter_t)slotContainer->slotOffset,
-               (errorparameter_t)0
-            );
-            // reset the entry
-            slotContainer->slotOffset                = 0;
-            slotContainer->type                      = CELLTYPE_OFF;
-            slotContainer->shared                    = FALSE;
-            slotContainer->channelOffset             = 0;
-            memset(&slotContainer->neighbor,0,sizeof(open_addr_t));
-            ENABLE_INTERRUPTS();
-            return E_FAIL;
-         }
-         previousSlotWalker                 = nextSlotWalker;
-      }
-      // insert between previousSlotWalker and nextSlotWalker
+      // this is NOT the first active slot added to this slotframe
+      previousSlotWalker                    = &schedule_vars.scheduleBuf[previousRow];
+      slotContainer->next                   = previousSlotWalker->next;
       previousSlotWalker->next              = slotContainer;
-      slotContainer->next                   = nextSlotWalker;
+   }
+   schedule_indexEntry(row);
+   
+   // it might be the next active slot of the slotframe
+   if (
+         slotframe->nextEntry==NULL
+         ||
+         schedule_getDistance(slotframe,slotOffset)<schedule_getDistance(slotframe,slotframe->nextEntry->slotOffset)
+      ) {
+      slotframe->nextEntry                  = slotContainer;
+   }
+   
+   // current slot points to the first active slot added
+   if (schedule_vars.currentScheduleEntry==NULL) {
+      schedule_vars.currentScheduleEntry    = slotContainer;
    }
    
    ENABLE_INTERRUPTS();
@@ -371,34 +525,49 @@ owerror_t schedule_addActiveSlot(
 }
 
 /**
-\brief Remove an active slot from the schedule.
+\brief Remove an active slot from the default slotframe.
 
 \param slotOffset       The slotoffset of the slot to remove.
 \param neighbor         The neighbor associated with this cell (all 0's if
    none)
 */
 owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, open_addr_t* neighbor) {
+   return schedule_removeActiveSlotInFrame(schedule_getFrameHandle(),slotOffset,neighbor);
+}
+
+/**
+\brief Remove an active slot from a slotframe.
+
+\param frameHandle      The handle of the slotframe
+\param slotOffset       The slotoffset of the slot to remove.
+\param neighbor         The neighbor associated with this cell (all 0's if
+   none)
+*/
+owerror_t schedule_removeActiveSlotInFrame(
+      uint8_t         frameHandle,
+      slotOffset_t    slotOffset,
+      open_addr_t*    neighbor
+   ) {
+   scheduleSlotframe_t* slotframe;
+   scheduleSlotframe_t* nextSlotframe;
    scheduleEntry_t* slotContainer;
    scheduleEntry_t* previousSlotWalker;
+   uint8_t          row;
+   uint8_t          previousRow;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
    // find the schedule entry
-   slotContainer = &schedule_vars.scheduleBuf[0];
-   while (slotContainer<=&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]) {
-      if (
-            slotContainer->slotOffset==slotOffset
-            &&
-            packetfunctions_sameAddress(neighbor,&(slotContainer->neighbor))
-            ){
-         break;
-      }
-      slotContainer++;
-   }
+   slotframe = schedule_getSlotframe(frameHandle);
+   row = slotframe==NULL ? SCHEDULE_NOROW : schedule_getRow(slotframe,slotOffset);
    
    // abort it could not find
-   if (slotContainer>&schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots-1]) {
+   if (
+         row==SCHEDULE_NOROW
+         ||
+         packetfunctions_sameAddress(neighbor,&(schedule_vars.scheduleBuf[row].neighbor))==FALSE
+      ) {
       ENABLE_INTERRUPTS();
       openserial_printCritical(
          COMPONENT_SCHEDULE,ERR_FREEING_ERROR,
@@ -407,38 +576,40 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, open_addr_t* neighb
       );
       return E_FAIL;
    }
+   slotContainer = &schedule_vars.scheduleBuf[row];
    
    // remove from linked list
-   if (slotContainer->next==slotContainer) {
-      // this is the last active slot
+   previousRow = schedule_getPreviousRow(slotframe,slotOffset);
+   if (previousRow==SCHEDULE_NOROW) {
+      // this is the last active slot of this slotframe
       
       // the next slot of this slot is NULL
       slotContainer->next                   = NULL;
+      slotframe->nextEntry                  = NULL;
       
-      // current slot points to this slot
-      schedule_vars.currentScheduleEntry    = NULL;
-   } else  {
-      // this is NOT the last active slot
-      
-      // find the previous in the schedule
-      previousSlotWalker                    = schedule_vars.currentScheduleEntry;
-      
-      while (1) {
-         if (previousSlotWalker->next==slotContainer){
-            break;
-         }
-         previousSlotWalker                 = previousSlotWalker->next;
+      // update current slot if points to slot I just removed, to the next
+      // active slot of the other slotframes, if any
+      if (schedule_vars.currentScheduleEntry==slotContainer) {
+         nextSlotframe                      = schedule_getNextSlotframe();
+         schedule_vars.currentScheduleEntry = nextSlotframe==NULL ? NULL : nextSlotframe->nextEntry;
       }
+   } else  {
+      // this is NOT the last active slot of this slotframe
       
       // remove this element from the linked list, i.e. have the previous slot
       // "jump" to slotContainer's next
+      previousSlotWalker                    = &schedule_vars.scheduleBuf[previousRow];
       previousSlotWalker->next              = slotContainer->next;
       
-      // update current slot if points to slot I just removed
+      // update next and current slot if they point to slot I just removed
+      if (slotframe->nextEntry==slotContainer) {
+         slotframe->nextEntry               = slotContainer->next;
+      }
       if (schedule_vars.currentScheduleEntry==slotContainer) {
          schedule_vars.currentScheduleEntry = slotContainer->next;
       }
    }
+   schedule_unindexEntry(row);
    
    // reset removed schedule entry
    schedule_resetEntry(slotContainer);
@@ -449,54 +620,60 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, open_addr_t* neighb
 }
 
 bool schedule_isSlotOffsetAvailable(uint16_t slotOffset){
-   
-   scheduleEntry_t* scheduleWalker;
+   return schedule_isSlotOffsetAvailableInFrame(schedule_getFrameHandle(),slotOffset);
+}
+
+/**
+\brief Whether a slot offset of a slotframe is free to schedule a cell in.
+
+\param frameHandle      The handle of the slotframe
+\param slotOffset       The slot offset.
+
+\returns FALSE if there is no such slotframe.
+*/
+bool schedule_isSlotOffsetAvailableInFrame(uint8_t frameHandle, uint16_t slotOffset){
+   scheduleSlotframe_t* slotframe;
+   bool returnVal;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   if (slotOffset>=schedule_vars.frameLength){
+   slotframe = schedule_getSlotframe(frameHandle);
+   if (slotframe==NULL || slotOffset>=slotframe->length || slotOffset>=MAXSLOTFRAMELENGTH){
       ENABLE_INTERRUPTS();
       return FALSE;
    }
    
-   scheduleWalker = schedule_vars.currentScheduleEntry;
-   do {
-      if(slotOffset == scheduleWalker->slotOffset){
-          ENABLE_INTERRUPTS();
-          return FALSE;
-      }
-      scheduleWalker = scheduleWalker->next;
-   }while(scheduleWalker!=schedule_vars.currentScheduleEntry);
+   returnVal = slotframe->slotRow[slotOffset]==SCHEDULE_NOROW;
    
    ENABLE_INTERRUPTS();
    
-   return TRUE;
+   return returnVal;
 }
 
 uint16_t  schedule_getCellsCounts(uint8_t frameID,cellType_t type, open_addr_t* neighbor){
     uint16_t         count = 0;
-    scheduleEntry_t* scheduleWalker;
+    uint8_t          i;
+    uint8_t          row;
    
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
     
-    if (frameID != SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_HANDLE){
-        ENABLE_INTERRUPTS();
-        return 0;
+    // walk the cells of that neighbor only
+    i = schedule_findNeighbor(neighbor);
+    if (i<schedule_vars.numNeighbors){
+        row = schedule_vars.neighborRow[i];
+        while (row!=SCHEDULE_NOROW){
+            if (
+                type == schedule_vars.scheduleBuf[row].type &&
+                frameID == schedule_vars.scheduleBuf[row].frameHandle
+            ){
+                count++;
+            }
+            row = schedule_vars.scheduleBuf[row].nextNeighborRow;
+        }
     }
    
-    scheduleWalker = schedule_vars.currentScheduleEntry;
-    do {
-       if(
-          packetfunctions_sameAddress(&(scheduleWalker->neighbor),neighbor) &&
-          type == scheduleWalker->type
-       ){
-           count++;
-       }
-       scheduleWalker = scheduleWalker->next;
-    }while(scheduleWalker!=schedule_vars.currentScheduleEntry);
-   
     ENABLE_INTERRUPTS();
     return count;
 }
@@ -505,18 +682,109 @@ void schedule_removeAllCells(
     open_addr_t*   previousHop
     ){
     uint8_t i;
+    uint8_t row;
     
-    // remove all entries in schedule with previousHop address
-    for(i=0;i<MAXACTIVESLOTS;i++){
-        if (packetfunctions_sameAddress(&(schedule_vars.scheduleBuf[i].neighbor),previousHop)){
-           schedule_removeActiveSlot(
-              schedule_vars.scheduleBuf[i].slotOffset,
-              previousHop
-           );
+    // remove all entries of that slotframe with previousHop address
+    while ((i=schedule_findNeighbor(previousHop))<schedule_vars.numNeighbors){
+        row = schedule_vars.neighborRow[i];
+        while (row!=SCHEDULE_NOROW && schedule_vars.scheduleBuf[row].frameHandle!=slotframeID){
+            row = schedule_vars.scheduleBuf[row].nextNeighborRow;
+        }
+        if (
+            row==SCHEDULE_NOROW ||
+            schedule_removeActiveSlotInFrame(
+               slotframeID,
+               schedule_vars.scheduleBuf[row].slotOffset,
+               previousHop
+            )==E_FAIL
+        ){
+            break;
         }
     }
 }
 
+/**
+\brief Find the TX cell to a neighbor which delivers worst, compared to the
+   other TX cells to that neighbor.
+
+Only the dedicated cells with at least MIN_NUMTX_FOR_PDR transmissions count,
+and at least two of them are needed to tell a bad cell from a bad link. The
+worst one is picked if its PDR is below PDR_THRESHOLD percent of the average
+PDR of these cells, e.g. when it collides with the cell of a neighboring
+subtree.
+
+\param[in]  frameID  The slotframe the cells belong to.
+\param[in]  neighbor The neighbor.
+\param[out] cell     The cell to relocate.
+
+\returns TRUE if a cell is to be relocated, FALSE otherwise.
+*/
+bool schedule_getCellToRelocate(
+      uint8_t        frameID,
+      open_addr_t*   neighbor,
+      cellInfo_ht*   cell
+   ){
+    uint8_t          i;
+    uint8_t          row;
+    uint8_t          worstRow;
+    uint8_t          numCells;
+    uint32_t         sumTx;
+    uint32_t         sumTxACK;
+    scheduleEntry_t* e;
+    bool             returnVal;
+    
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+    
+    numCells  = 0;
+    sumTx     = 0;
+    sumTxACK  = 0;
+    worstRow  = SCHEDULE_NOROW;
+    
+    // walk the cells of that neighbor only
+    i = schedule_findNeighbor(neighbor);
+    if (i<schedule_vars.numNeighbors){
+        row = schedule_vars.neighborRow[i];
+        while (row!=SCHEDULE_NOROW){
+            e = &schedule_vars.scheduleBuf[row];
+            if (
+                e->type        == CELLTYPE_TX        &&
+                e->shared      == FALSE              &&
+                e->frameHandle == frameID            &&
+                e->numTx       >= MIN_NUMTX_FOR_PDR
+            ){
+                numCells++;
+                sumTx    += e->numTx;
+                sumTxACK += e->numTxACK;
+                // numTxACK/numTx lower than the worst so far
+                if (
+                    worstRow==SCHEDULE_NOROW ||
+                    (uint16_t)e->numTxACK*schedule_vars.scheduleBuf[worstRow].numTx <
+                    (uint16_t)schedule_vars.scheduleBuf[worstRow].numTxACK*e->numTx
+                ){
+                    worstRow = row;
+                }
+            }
+            row = e->nextNeighborRow;
+        }
+    }
+    
+    // worst PDR < PDR_THRESHOLD% of sumTxACK/sumTx
+    returnVal = FALSE;
+    if (numCells>=2){
+        e = &schedule_vars.scheduleBuf[worstRow];
+        if ((uint32_t)e->numTxACK*100*sumTx < (uint32_t)PDR_THRESHOLD*sumTxACK*e->numTx){
+            cell->slotoffset    = e->slotOffset;
+            cell->channeloffset = e->channelOffset;
+            cell->isUsed        = TRUE;
+            returnVal           = TRUE;
+        }
+    }
+    
+    ENABLE_INTERRUPTS();
+    return returnVal;
+}
+
 scheduleEntry_t* schedule_getCurrentScheduleEntry(){
     return schedule_vars.currentScheduleEntry;
 }
@@ -524,19 +792,14 @@ scheduleEntry_t* schedule_getCurrentScheduleEntry(){
 //=== from otf
 uint8_t schedule_getNumOfSlotsByType(cellType_t type){
    uint8_t returnVal;
-   scheduleEntry_t* scheduleWalker;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
    returnVal = 0;
-   scheduleWalker = schedule_vars.currentScheduleEntry;
-   do {
-      if(type == scheduleWalker->type){
-          returnVal += 1;
-      }
-      scheduleWalker = scheduleWalker->next;
-   }while(scheduleWalker!=schedule_vars.currentScheduleEntry);
+   if (type<NUMCELLTYPES) {
+      returnVal = schedule_vars.numCellsByType[type];
+   }
    
    ENABLE_INTERRUPTS();
    
@@ -544,18 +807,12 @@ uint8_t schedule_getNumOfSlotsByType(cellType_t type){
 }
 
 uint8_t schedule_getNumberOfFreeEntries(){
-   uint8_t i; 
    uint8_t counter;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   counter = 0;
-   for(i=0;i<MAXACTIVESLOTS;i++) {
-      if(schedule_vars.scheduleBuf[i].type == CELLTYPE_OFF){
-         counter++;
-      }
-   }
+   counter = MAXACTIVESLOTS-schedule_vars.numActiveSlots;
    
    ENABLE_INTERRUPTS();
    
@@ -564,13 +821,47 @@ uint8_t schedule_getNumberOfFreeEntries(){
 
 //=== from IEEE802154E: reading the schedule and updating statistics
 
+/**
+\brief Align the schedule on the slot offset of the default slotframe.
+
+The other slotframes are aligned on the ASN the MAC layer is at.
+*/
 void schedule_syncSlotOffset(slotOffset_t targetSlotOffset) {
+   scheduleSlotframe_t* slotframe;
+   scheduleEntry_t*     entry;
+   uint8_t              asn[5];
+   uint8_t              i;
+   uint8_t              row;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   while (schedule_vars.currentScheduleEntry->slotOffset!=targetSlotOffset) {
-      schedule_advanceSlot();
+   ieee154e_getAsn(asn);
+   schedule_vars.currentAsn.bytes0and1 = asn[0] | (asn[1]<<8);
+   schedule_vars.currentAsn.bytes2and3 = asn[2] | (asn[3]<<8);
+   schedule_vars.currentAsn.byte4      = asn[4];
+   
+   for (i=0;i<schedule_vars.numSlotframes;i++) {
+      slotframe = &schedule_vars.slotframes[i];
+      if (i==0) {
+         slotframe->slotOffset = targetSlotOffset;
+      } else {
+         slotframe->slotOffset = schedule_getAsnModulo(slotframe->length);
+      }
+      slotframe->nextEntry     = schedule_findNextEntry(slotframe);
+   }
+   
+   // jump to the target slot, or to the active slot of the default slotframe
+   // right before it if it is not active
+   entry = schedule_getActiveEntry();
+   if (entry==NULL && targetSlotOffset<MAXSLOTFRAMELENGTH) {
+      row = schedule_getPreviousRow(&schedule_vars.slotframes[0],targetSlotOffset);
+      if (row!=SCHEDULE_NOROW) {
+         entry = &schedule_vars.scheduleBuf[row];
+      }
+   }
+   if (entry!=NULL) {
+      schedule_vars.currentScheduleEntry = entry;
    }
    
    ENABLE_INTERRUPTS();
@@ -578,26 +869,76 @@ void schedule_syncSlotOffset(slotOffset_t targetSlotOffset) {
 
 /**
 \brief advance to next active slot
+
+The schedule moves by the number of slots last reported to the MAC layer
+through schedule_getNextActiveSlotOffset(), so it stays aligned with it even if
+cells were added or removed in the meantime. When cells of several slotframes
+are active in that timeslot, the one of the slotframe with the lowest handle is
+used.
 */
 void schedule_advanceSlot() {
+   scheduleSlotframe_t* slotframe;
+   scheduleEntry_t*     entry;
+   uint16_t             numSlots;
+   uint16_t             distance;
+   frameLength_t        frameLength;
+   uint8_t              i;
    
    INTERRUPT_DECLARATION();
-   DISABLE_INTERRUPTS();  
-   schedule_vars.currentScheduleEntry = schedule_vars.currentScheduleEntry->next;
+   DISABLE_INTERRUPTS();
+   
+   numSlots = schedule_vars.slotsToNextActive;
+   if (numSlots==0) {
+      numSlots = schedule_updateSlotsToNextActive();
+   }
+   schedule_vars.slotsToNextActive = 0;
+   
+   for (i=0;i<schedule_vars.numSlotframes;i++) {
+      slotframe   = &schedule_vars.slotframes[i];
+      frameLength = slotframe->length==0 ? MAXSLOTFRAMELENGTH : slotframe->length;
+      distance    = slotframe->nextEntry==NULL ? 0 : schedule_getDistance(slotframe,slotframe->nextEntry->slotOffset);
+      slotframe->slotOffset = (slotframe->slotOffset+numSlots)%frameLength;
+      if (distance==numSlots) {
+         // its next active slot is now
+         slotframe->nextEntry = slotframe->nextEntry->next;
+      } else if (distance!=0 && distance<numSlots) {
+         // a cell was added since the MAC layer was told, and is now behind
+         slotframe->nextEntry = schedule_findNextEntry(slotframe);
+      }
+   }
+   schedule_incrementAsn(numSlots);
+   
+   entry = schedule_getActiveEntry();
+   if (entry==NULL) {
+      // the cell was removed since, use the next one
+      slotframe = schedule_getNextSlotframe();
+      if (slotframe!=NULL) {
+         entry  = slotframe->nextEntry;
+      }
+   }
+   if (entry!=NULL) {
+      schedule_vars.currentScheduleEntry = entry;
+   }
    
    ENABLE_INTERRUPTS();
 }
 
 /**
 \brief return slotOffset of next active slot
+
+This is a slot offset in the default slotframe. The next active slot of any
+slotframe is never further away than the length of the default slotframe, since
+the latter always holds active slots (minimal and serial cells).
 */
 slotOffset_t schedule_getNextActiveSlotOffset() {
-   slotOffset_t res;   
+   slotOffset_t  res;
+   frameLength_t frameLength;
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   res = ((scheduleEntry_t*)(schedule_vars.currentScheduleEntry->next))->slotOffset;
+   frameLength = schedule_vars.slotframes[0].length==0 ? MAXSLOTFRAMELENGTH : schedule_vars.slotframes[0].length;
+   res = (schedule_vars.slotframes[0].slotOffset+schedule_updateSlotsToNextActive())%frameLength;
    
    ENABLE_INTERRUPTS();
    
@@ -605,7 +946,26 @@ slotOffset_t schedule_getNextActiveSlotOffset() {
 }
 
 /**
-\brief Get the frame length.
+\brief Number of slots from the current timeslot to the next active one,
+   over all slotframes.
+
+\returns 1 if the schedule is empty.
+*/
+uint16_t schedule_getNumSlotsToNextActive() {
+   uint16_t res;
+   
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   
+   res = schedule_updateSlotsToNextActive();
+   
+   ENABLE_INTERRUPTS();
+   
+   return res;
+}
+
+/**
+\brief Get the length of the default slotframe.
 
 \returns The frame length.
 */
@@ -615,7 +975,29 @@ frameLength_t schedule_getFrameLength() {
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   returnVal = schedule_vars.frameLength;
+   returnVal = schedule_vars.slotframes[0].length;
+   
+   ENABLE_INTERRUPTS();
+   
+   return returnVal;
+}
+
+/**
+\brief Get the length of a slotframe.
+
+\param frameHandle      The handle of the slotframe
+
+\returns The frame length, 0 if there is no such slotframe.
+*/
+frameLength_t schedule_getSlotframeLength(uint8_t frameHandle) {
+   scheduleSlotframe_t* slotframe;
+   frameLength_t        returnVal;
+   
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   
+   slotframe = schedule_getSlotframe(frameHandle);
+   returnVal = slotframe==NULL ? 0 : slotframe->length;
    
    ENABLE_INTERRUPTS();
    
@@ -623,7 +1005,7 @@ frameLength_t schedule_getFrameLength() {
 }
 
 /**
-\brief Get the frame handle.
+\brief Get the handle of the default slotframe.
 
 \returns The frame handle.
 */
@@ -633,7 +1015,7 @@ uint8_t schedule_getFrameHandle() {
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
-   returnVal = schedule_vars.frameHandle;
+   returnVal = schedule_vars.slotframes[0].handle;
    
    ENABLE_INTERRUPTS();
    
@@ -827,11 +1209,20 @@ void schedule_indicateTx(asn_t* asnTimestamp, bool succesfullTx) {
 
 bool schedule_getOneCellAfterOffset(uint8_t metadata,uint8_t offset,open_addr_t* neighbor, uint8_t cellOptions, uint16_t* slotoffset, uint16_t* channeloffset){
    bool returnVal;
+   scheduleSlotframe_t* slotframe;
    scheduleEntry_t* scheduleWalker;
    cellType_t type;
+   slotOffset_t running_slotOffset;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
+   // the metadata is the handle of the slotframe
+   slotframe = schedule_getSlotframe(metadata);
+   if (slotframe==NULL){
+      ENABLE_INTERRUPTS();
+      return FALSE;
+   }
+   
    // translate cellOptions to cell type 
    if (cellOptions == LINKOPTIONS_TX){
       type = CELLTYPE_TX;
@@ -843,17 +1234,20 @@ bool schedule_getOneCellAfterOffset(uint8_t metadata,uint8_t offset,open_addr_t*
       type = CELLTYPE_TXRX;
    }
    
+   // the first cell of that type, in slot offset order
    returnVal      = FALSE;
-   scheduleWalker = &schedule_vars.scheduleBuf[0]; // fisrt entry record slotoffset 0
-   do {
-      if(type == scheduleWalker->type && scheduleWalker->slotOffset >= offset){
+   for (running_slotOffset=offset;running_slotOffset<MAXSLOTFRAMELENGTH;running_slotOffset++){
+      if (slotframe->slotRow[running_slotOffset]==SCHEDULE_NOROW){
+         continue;
+      }
+      scheduleWalker = &schedule_vars.scheduleBuf[slotframe->slotRow[running_slotOffset]];
+      if(type == scheduleWalker->type){
          *slotoffset    = scheduleWalker->slotOffset;
          *channeloffset = scheduleWalker->channelOffset;
          returnVal      = TRUE;
          break;
       }
-      scheduleWalker = scheduleWalker->next;
-   }while(scheduleWalker!=&schedule_vars.scheduleBuf[0]);
+   }
    
    ENABLE_INTERRUPTS();
    
@@ -881,4 +1275,329 @@ void schedule_resetEntry(scheduleEntry_t* e) {
    e->lastUsedAsn.bytes2and3 = 0;
    e->lastUsedAsn.byte4      = 0;
    e->next                   = NULL;
+   e->nextNeighborRow        = SCHEDULE_NOROW;
+   e->frameHandle            = 0;
+}
+
+/**
+\brief Format a row of the schedule, as reported over serial.
+
+\param[in]  row The row of the schedule.
+\param[out] buf Where to write the debugScheduleEntry_t.
+*/
+void schedule_getStatusRow(uint8_t row, uint8_t* buf) {
+   debugScheduleEntry_t temp;
+   
+   temp.row                            = row;
+   temp.slotOffset                     = schedule_vars.scheduleBuf[row].slotOffset;
+   temp.type                           = schedule_vars.scheduleBuf[row].type;
+   temp.shared                         = schedule_vars.scheduleBuf[row].shared;
+   temp.channelOffset                  = schedule_vars.scheduleBuf[row].channelOffset;
+   memcpy(
+      &temp.neighbor,
+      &schedule_vars.scheduleBuf[row].neighbor,
+      sizeof(open_addr_t)
+   );
+   temp.numRx                          = schedule_vars.scheduleBuf[row].numRx;
+   temp.numTx                          = schedule_vars.scheduleBuf[row].numTx;
+   temp.numTxACK                       = schedule_vars.scheduleBuf[row].numTxACK;
+   memcpy(
+      &temp.lastUsedAsn,
+      &schedule_vars.scheduleBuf[row].lastUsedAsn,
+      sizeof(asn_t)
+   );
+   
+   memcpy(buf,&temp,sizeof(debugScheduleEntry_t));
+}
+
+/**
+\brief The slotframe with the given handle.
+
+\returns NULL if there is no such slotframe.
+*/
+scheduleSlotframe_t* schedule_getSlotframe(uint8_t frameHandle) {
+   uint8_t i;
+   
+   for (i=0;i<schedule_vars.numSlotframes;i++) {
+      if (schedule_vars.slotframes[i].handle==frameHandle) {
+         return &schedule_vars.slotframes[i];
+      }
+   }
+   return NULL;
+}
+
+/**
+\brief Row of the cell at the given slot offset of a slotframe.
+
+\returns SCHEDULE_NOROW if the slot offset is not active.
+*/
+uint8_t schedule_getRow(scheduleSlotframe_t* slotframe, slotOffset_t slotOffset) {
+   if (slotOffset>=MAXSLOTFRAMELENGTH) {
+      return SCHEDULE_NOROW;
+   }
+   return slotframe->slotRow[slotOffset];
+}
+
+/**
+\brief Row of the active slot which comes before the given slot offset.
+
+The slotframe wraps around: if no slot is active before the slot offset, this
+is the last active slot of the slotframe.
+
+\pre slotOffset is below MAXSLOTFRAMELENGTH.
+
+\returns SCHEDULE_NOROW if no other slot is active.
+*/
+uint8_t schedule_getPreviousRow(scheduleSlotframe_t* slotframe, slotOffset_t slotOffset) {
+   slotOffset_t i;
+   uint8_t      row;
+   
+   for (i=1;i<MAXSLOTFRAMELENGTH;i++) {
+      row = slotframe->slotRow[(slotOffset+MAXSLOTFRAMELENGTH-i)%MAXSLOTFRAMELENGTH];
+      if (row!=SCHEDULE_NOROW) {
+         return row;
+      }
+   }
+   return SCHEDULE_NOROW;
+}
+
+/**
+\brief Number of slots from the current timeslot of a slotframe to the given
+   slot offset.
+
+The current timeslot itself is a full slotframe away.
+*/
+uint16_t schedule_getDistance(scheduleSlotframe_t* slotframe, slotOffset_t slotOffset) {
+   frameLength_t frameLength;
+   uint16_t      distance;
+   
+   frameLength = slotframe->length==0 ? MAXSLOTFRAMELENGTH : slotframe->length;
+   distance    = (slotOffset+frameLength-slotframe->slotOffset%frameLength)%frameLength;
+   
+   return distance==0 ? frameLength : distance;
+}
+
+/**
+\brief First active slot of a slotframe after its current timeslot.
+
+\returns NULL if the slotframe has no active slot.
+*/
+scheduleEntry_t* schedule_findNextEntry(scheduleSlotframe_t* slotframe) {
+   frameLength_t frameLength;
+   slotOffset_t  i;
+   uint8_t       row;
+   
+   frameLength = slotframe->length==0 ? MAXSLOTFRAMELENGTH : slotframe->length;
+   for (i=1;i<=frameLength;i++) {
+      row = schedule_getRow(slotframe,(slotframe->slotOffset+i)%frameLength);
+      if (row!=SCHEDULE_NOROW) {
+         return &schedule_vars.scheduleBuf[row];
+      }
+   }
+   return NULL;
+}
+
+/**
+\brief The slotframe with the closest next active slot.
+
+On a tie, the slotframe with the lowest handle.
+
+\returns NULL if the schedule is empty.
+*/
+scheduleSlotframe_t* schedule_getNextSlotframe() {
+   scheduleSlotframe_t* slotframe;
+   scheduleSlotframe_t* nextSlotframe;
+   uint16_t             distance;
+   uint16_t             minDistance;
+   uint8_t              i;
+   
+   nextSlotframe = NULL;
+   minDistance   = 0;
+   for (i=0;i<schedule_vars.numSlotframes;i++) {
+      slotframe = &schedule_vars.slotframes[i];
+      if (slotframe->nextEntry==NULL) {
+         continue;
+      }
+      distance = schedule_getDistance(slotframe,slotframe->nextEntry->slotOffset);
+      if (
+            nextSlotframe==NULL                                        ||
+            distance<minDistance                                       ||
+            (distance==minDistance && slotframe->handle<nextSlotframe->handle)
+         ) {
+         nextSlotframe = slotframe;
+         minDistance   = distance;
+      }
+   }
+   return nextSlotframe;
+}
+
+/**
+\brief The cell active in the current timeslot.
+
+When several slotframes have an active slot in the current timeslot, the one of
+the slotframe with the lowest handle wins.
+
+\returns NULL if no slot is active in the current timeslot.
+*/
+scheduleEntry_t* schedule_getActiveEntry() {
+   scheduleSlotframe_t* slotframe;
+   scheduleEntry_t*     entry;
+   uint8_t              i;
+   uint8_t              row;
+   
+   entry = NULL;
+   for (i=0;i<schedule_vars.numSlotframes;i++) {
+      slotframe = &schedule_vars.slotframes[i];
+      row       = schedule_getRow(slotframe,slotframe->slotOffset);
+      if (
+            row!=SCHEDULE_NOROW &&
+            (entry==NULL || slotframe->handle<entry->frameHandle)
+         ) {
+         entry  = &schedule_vars.scheduleBuf[row];
+      }
+   }
+   return entry;
+}
+
+/**
+\brief Number of slots to the next active slot, over all slotframes.
+
+This is remembered as the number of slots the MAC layer waits before calling
+schedule_advanceSlot().
+
+\pre This function assumes interrupts are already disabled.
+
+\returns 1 if the schedule is empty.
+*/
+uint16_t schedule_updateSlotsToNextActive() {
+   scheduleSlotframe_t* slotframe;
+   
+   slotframe = schedule_getNextSlotframe();
+   if (slotframe==NULL) {
+      schedule_vars.slotsToNextActive = 1;
+   } else {
+      schedule_vars.slotsToNextActive = schedule_getDistance(slotframe,slotframe->nextEntry->slotOffset);
+   }
+   return schedule_vars.slotsToNextActive;
+}
+
+/**
+\brief Slot offset of the current timeslot in a slotframe of the given length.
+*/
+slotOffset_t schedule_getAsnModulo(frameLength_t frameLength) {
+   uint32_t slotOffset;
+   
+   if (frameLength==0) {
+      return 0;
+   }
+   
+   slotOffset = schedule_vars.currentAsn.byte4;
+   slotOffset = slotOffset % frameLength;
+   slotOffset = slotOffset << 16;
+   slotOffset = slotOffset + schedule_vars.currentAsn.bytes2and3;
+   slotOffset = slotOffset % frameLength;
+   slotOffset = slotOffset << 16;
+   slotOffset = slotOffset + schedule_vars.currentAsn.bytes0and1;
+   slotOffset = slotOffset % frameLength;
+   
+   return (slotOffset_t)slotOffset;
+}
+
+/**
+\brief Move the ASN of the current timeslot forward.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_incrementAsn(uint16_t numSlots) {
+   uint32_t low;
+   
+   low = (uint32_t)schedule_vars.currentAsn.bytes0and1+numSlots;
+   schedule_vars.currentAsn.bytes0and1 = (uint16_t)low;
+   if (low>0xffff) {
+      schedule_vars.currentAsn.bytes2and3++;
+      if (schedule_vars.currentAsn.bytes2and3==0) {
+         schedule_vars.currentAsn.byte4++;
+      }
+   }
+}
+
+/**
+\brief Index in neighborRow of the cells of the given neighbor.
+
+\returns numNeighbors if there is no cell with that neighbor.
+*/
+uint8_t schedule_findNeighbor(open_addr_t* neighbor) {
+   uint8_t i;
+   
+   for (i=0;i<schedule_vars.numNeighbors;i++) {
+      if (packetfunctions_sameAddress(neighbor,&schedule_vars.scheduleBuf[schedule_vars.neighborRow[i]].neighbor)) {
+         break;
+      }
+   }
+   return i;
+}
+
+/**
+\brief Add the entry at the given row to the indexes of the schedule.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_indexEntry(uint8_t row) {
+   scheduleEntry_t* e;
+   uint8_t          i;
+   
+   e = &schedule_vars.scheduleBuf[row];
+   
+   schedule_getSlotframe(e->frameHandle)->slotRow[e->slotOffset] = row;
+   
+   i = schedule_findNeighbor(&e->neighbor);
+   if (i==schedule_vars.numNeighbors) {
+      e->nextNeighborRow                 = SCHEDULE_NOROW;
+      schedule_vars.numNeighbors++;
+   } else {
+      e->nextNeighborRow                 = schedule_vars.neighborRow[i];
+   }
+   schedule_vars.neighborRow[i]          = row;
+   
+   schedule_vars.numActiveSlots++;
+   if (e->type<NUMCELLTYPES) {
+      schedule_vars.numCellsByType[e->type]++;
+   }
+}
+
+/**
+\brief Remove the entry at the given row from the indexes of the schedule.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_unindexEntry(uint8_t row) {
+   scheduleEntry_t* e;
+   uint8_t          i;
+   uint8_t          walker;
+   
+   e = &schedule_vars.scheduleBuf[row];
+   
+   schedule_getSlotframe(e->frameHandle)->slotRow[e->slotOffset] = SCHEDULE_NOROW;
+   
+   i = schedule_findNeighbor(&e->neighbor);
+   if (schedule_vars.neighborRow[i]==row) {
+      if (e->nextNeighborRow==SCHEDULE_NOROW) {
+         // last cell with that neighbor
+         schedule_vars.neighborRow[i]    = schedule_vars.neighborRow[--schedule_vars.numNeighbors];
+      } else {
+         schedule_vars.neighborRow[i]    = e->nextNeighborRow;
+      }
+   } else {
+      walker = schedule_vars.neighborRow[i];
+      while (schedule_vars.scheduleBuf[walker].nextNeighborRow!=row) {
+         walker = schedule_vars.scheduleBuf[walker].nextNeighborRow;
+      }
+      schedule_vars.scheduleBuf[walker].nextNeighborRow = e->nextNeighborRow;
+   }
+   e->nextNeighborRow                    = SCHEDULE_NOROW;
+   
+   schedule_vars.numActiveSlots--;
+   if (e->type<NUMCELLTYPES) {
+      schedule_vars.numCellsByType[e->type]--;
+   }
 }
@@ -19,6 +19,30 @@ The superframe reappears over time and can be arbitrarily long.
 */
 #define SLOTFRAME_LENGTH    11 //should be 101
 
+/**
+\brief Longest slotframe the schedule can index, in slots.
+
+The schedule keeps one byte per slot offset up to this value, to find the cell
+at a given slot offset without walking the schedule. Cells can not be added at
+a slot offset beyond it.
+*/
+#ifndef MAXSLOTFRAMELENGTH
+#define MAXSLOTFRAMELENGTH  101
+#endif
+
+/**
+\brief Maximum number of slotframes in the schedule.
+
+The slotframes coexist, each with its own length. The first one is the default
+slotframe, the one the minimal schedule uses; it sets the pace of the slot
+offset the MAC layer keeps. 6top uses the slotframe a 6P request names, see
+SCHEDULE_UNICAST_SLOTFRAME_HANDLE. When cells of several slotframes fall in the
+same timeslot, the one in the slotframe with the lowest handle is used.
+*/
+#ifndef MAXSLOTFRAMES
+#define MAXSLOTFRAMES       2
+#endif
+
 //draft-ietf-6tisch-minimal-06
 #define SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS                      1
 #define SCHEDULE_MINIMAL_6TISCH_SLOTOFFSET                        0
@@ -26,6 +50,24 @@ The superframe reappears over time and can be arbitrarily long.
 #define SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_HANDLE          0 //id of slotframe
 #define SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_NUMBER          1 //1 slotframe by default.
 
+/**
+\brief Slotframe of the dedicated cells 6P negotiates for SF0.
+
+By default, these cells are in the default slotframe. Defining
+SCHEDULE_UNICAST_SLOTFRAME_LENGTH adds a slotframe of that length for them, so
+that the default slotframe (minimal and serial cells) can be kept short while
+the dedicated cells repeat less often. All the motes of a network must agree
+on it: the handle is carried in the metadata of the 6P requests.
+*/
+#ifdef SCHEDULE_UNICAST_SLOTFRAME_LENGTH
+#define SCHEDULE_UNICAST_SLOTFRAME_HANDLE   (SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_HANDLE+1)
+#if SCHEDULE_UNICAST_SLOTFRAME_LENGTH>MAXSLOTFRAMELENGTH || MAXSLOTFRAMES<2
+#error "the unicast slotframe does not fit in the schedule"
+#endif
+#else
+#define SCHEDULE_UNICAST_SLOTFRAME_HANDLE   SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_HANDLE
+#endif
+
 #define NUMSERIALRX          3
 
 /*
@@ -53,6 +95,9 @@ in your schedule, so not to waste RAM.
 */
 #define MAXACTIVESLOTS       (SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS+NUMSERIALRX+NUMSLOTSOFF)
 
+/// marks the absence of a row in the indexes of the schedule
+#define SCHEDULE_NOROW       0xff
+
 /**
 \brief Minimum backoff exponent.
 
@@ -98,6 +143,8 @@ typedef enum {
    CELLTYPE_MORESERIALRX     = 5
 } cellType_t;
 
+#define NUMCELLTYPES         (CELLTYPE_MORESERIALRX+1)
+
 typedef struct {
    slotOffset_t    slotOffset;
    cellType_t      type;
@@ -108,9 +155,19 @@ typedef struct {
    uint8_t         numTx;
    uint8_t         numTxACK;
    asn_t           lastUsedAsn;
-   void*           next;
+   void*           next;               // next cell of the same slotframe
+   uint8_t         nextNeighborRow;    // next cell with the same neighbor, SCHEDULE_NOROW if last
+   uint8_t         frameHandle;        // slotframe the cell belongs to
 } scheduleEntry_t;
 
+typedef struct {
+   uint8_t          handle;
+   frameLength_t    length;                        // 0 while unknown
+   slotOffset_t     slotOffset;                    // slot offset of the current timeslot in this slotframe
+   scheduleEntry_t* nextEntry;                     // next active cell after the current timeslot, NULL if none
+   uint8_t          slotRow[MAXSLOTFRAMELENGTH];   // row of the cell at each slot offset, SCHEDULE_NOROW if none
+} scheduleSlotframe_t;
+
 BEGIN_PACK
 typedef struct {
    uint8_t         row;
@@ -138,10 +195,16 @@ typedef struct {
 
 typedef struct {
    scheduleEntry_t  scheduleBuf[MAXACTIVESLOTS];
-   scheduleEntry_t* currentScheduleEntry;
-   frameLength_t    frameLength;
+   scheduleEntry_t* currentScheduleEntry;          // cell used in the current timeslot, over all slotframes
+   asn_t            currentAsn;                    // ASN of the current timeslot
+   scheduleSlotframe_t slotframes[MAXSLOTFRAMES];  // the default slotframe first
+   uint8_t          numSlotframes;
+   uint16_t         slotsToNextActive;             // distance to the next active timeslot, as last reported to the MAC
+   uint8_t          neighborRow[MAXACTIVESLOTS];   // row of the first cell of each neighbor
+   uint8_t          numNeighbors;
+   uint8_t          numActiveSlots;
+   uint8_t          numCellsByType[NUMCELLTYPES];
    frameLength_t    maxActiveSlots;
-   uint8_t          frameHandle;
    uint8_t          frameNumber;
    uint8_t          backoffExponent;
    uint8_t          backoff;
@@ -160,6 +223,11 @@ bool               debugPrint_backoff(void);
 void               schedule_setFrameLength(frameLength_t newFrameLength);
 void               schedule_setFrameHandle(uint8_t frameHandle);
 void               schedule_setFrameNumber(uint8_t frameNumber);
+owerror_t          schedule_addSlotframe(
+   uint8_t              frameHandle,
+   frameLength_t        frameLength
+);
+owerror_t          schedule_removeSlotframe(uint8_t frameHandle);
 owerror_t          schedule_addActiveSlot(
    slotOffset_t         slotOffset,
    cellType_t           type,
@@ -167,12 +235,26 @@ owerror_t          schedule_addActiveSlot(
    uint8_t              channelOffset,
    open_addr_t*         neighbor
 );
+owerror_t          schedule_addActiveSlotInFrame(
+   uint8_t              frameHandle,
+   slotOffset_t         slotOffset,
+   cellType_t           type,
+   bool                 shared,
+   uint8_t              channelOffset,
+   open_addr_t*         neighbor
+);
 
 void               schedule_getSlotInfo(
    slotOffset_t         slotOffset,                      
    open_addr_t*         neighbor,
    slotinfo_element_t*  info
 );
+void               schedule_getSlotInfoInFrame(
+   uint8_t              frameHandle,
+   slotOffset_t         slotOffset,
+   open_addr_t*         neighbor,
+   slotinfo_element_t*  info
+);
 
 uint16_t           schedule_getMaxActiveSlots(void);
 
@@ -180,7 +262,17 @@ owerror_t          schedule_removeActiveSlot(
    slotOffset_t         slotOffset,
    open_addr_t*         neighbor
 );
+owerror_t          schedule_removeActiveSlotInFrame(
+   uint8_t              frameHandle,
+   slotOffset_t         slotOffset,
+   open_addr_t*         neighbor
+);
 bool               schedule_isSlotOffsetAvailable(uint16_t slotOffset);
+bool               schedule_isSlotOffsetAvailableInFrame(
+   uint8_t              frameHandle,
+   uint16_t             slotOffset
+);
+frameLength_t      schedule_getSlotframeLength(uint8_t frameHandle);
 uint16_t          schedule_getCellsCounts(
     uint8_t frameID,
     cellType_t type,
@@ -192,11 +284,17 @@ void              schedule_removeAllCells(
 );
 scheduleEntry_t*  schedule_getCurrentScheduleEntry(void);
 uint8_t           schedule_getNumOfSlotsByType(cellType_t type);
+bool              schedule_getCellToRelocate(
+   uint8_t        frameID,
+   open_addr_t*   neighbor,
+   cellInfo_ht*   cell
+);
 uint8_t           schedule_getNumberOfFreeEntries(void);
 // from IEEE802154E
 void               schedule_syncSlotOffset(slotOffset_t targetSlotOffset);
 void               schedule_advanceSlot(void);
 slotOffset_t       schedule_getNextActiveSlotOffset(void);
+uint16_t           schedule_getNumSlotsToNextActive(void);
 frameLength_t      schedule_getFrameLength(void);
 uint8_t            schedule_getFrameHandle(void);
 uint8_t            schedule_getFrameNumber(void);
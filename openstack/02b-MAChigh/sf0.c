@@ -7,11 +7,14 @@
 #include "idmanager.h"
 #include "openapps.h"
 #include "openrandom.h"
+#include "openqueue.h"
 
 //=========================== definition =====================================
 
 #define SF0_ID            0
 #define SF0THRESHOLD      2
+// in slotframes: cells delivering badly are looked for this often
+#define SF0_HOUSEKEEPING_PERIOD 16
 
 //=========================== variables =======================================
 
@@ -20,6 +23,7 @@ sf0_vars_t sf0_vars;
 //=========================== prototypes ======================================
 
 void sf0_bandwidthEstimate_task(void);
+void sf0_housekeeping_task(void);
 // sixtop callback 
 uint16_t sf0_getMetadata(void);
 metadata_t sf0_translateMetadata(void);
@@ -36,6 +40,11 @@ void sf0_init(void) {
 // this function is called once per slotframe. 
 void sf0_notifyNewSlotframe(void) {
    scheduler_push_task(sf0_bandwidthEstimate_task,TASKPRIO_SF0);
+   
+   sf0_vars.housekeepingCounter = (sf0_vars.housekeepingCounter+1)%SF0_HOUSEKEEPING_PERIOD;
+   if (sf0_vars.housekeepingCounter==0) {
+      scheduler_push_task(sf0_housekeeping_task,TASKPRIO_SF0);
+   }
 }
 
 void sf0_setBackoff(uint8_t value){
@@ -49,7 +58,8 @@ uint8_t sf0_getsfid(void){
 }
 
 uint16_t sf0_getMetadata(void){
-    return SCHEDULE_MINIMAL_6TISCH_DEFAULT_SLOTFRAME_HANDLE;
+    // the cells are in the unicast slotframe, the default one unless configured
+    return SCHEDULE_UNICAST_SLOTFRAME_HANDLE;
 }
 
 metadata_t sf0_translateMetadata(void){
@@ -88,6 +98,8 @@ void sf0_bandwidthEstimate_task(void){
     int8_t         bw_outgoing;
     int8_t         bw_incoming;
     int8_t         bw_self;
+    int8_t         bw_required;
+    uint8_t        backlog;
     cellInfo_ht    celllist_add[CELLLIST_MAX_LEN];
     cellInfo_ht    celllist_delete[CELLLIST_MAX_LEN];
     
@@ -120,20 +132,32 @@ void sf0_bandwidthEstimate_task(void){
     // By default, it's set to zero.
     // bw_self = openapps_getBandwidth(COMPONENT_UINJECT);
     bw_self = sf0_vars.numAppPacketsPerSlotFrame;
+    bw_required = bw_incoming+bw_self;
+    
+    // packets waiting for the parent, which more than the scheduled cells
+    // can send in a slotframe: the cells are short of the actual traffic
+    backlog = openqueue_getNeighborDepth(&neighbor);
+    if (backlog>bw_outgoing && backlog>bw_required) {
+        bw_required = backlog;
+    }
     
     // In SF0, scheduledCells = bw_outgoing
-    //         requiredCells  = bw_incoming + bw_self
+    //         requiredCells  = max(bw_incoming + bw_self, backlog)
     // when scheduledCells<requiredCells, add one or more cell
     
-    if (bw_outgoing <= bw_incoming+bw_self){
-        if (sf0_candidateAddCellList(celllist_add,bw_incoming+bw_self-bw_outgoing+1)==FALSE){
+    if (bw_outgoing <= bw_required){
+        if (bw_required-bw_outgoing+1>CELLLIST_MAX_LEN) {
+            // as many as a single request carries, the next ones add the rest
+            bw_required = bw_outgoing+CELLLIST_MAX_LEN-1;
+        }
+        if (sf0_candidateAddCellList(celllist_add,bw_required-bw_outgoing+1)==FALSE){
             // failed to get cell list to add
             return;
         }
         sixtop_request(
             IANA_6TOP_CMD_ADD,                  // code
             &neighbor,                          // neighbor
-            bw_incoming+bw_self-bw_outgoing+1,  // number cells
+            bw_required-bw_outgoing+1,          // number cells
             LINKOPTIONS_TX,                     // cellOptions
             celllist_add,                       // celllist to add
             NULL,                               // celllist to delete (not used)
@@ -143,7 +167,7 @@ void sf0_bandwidthEstimate_task(void){
         );
     } else {
         // remove cell(s)
-        if ( (bw_incoming+bw_self) < (bw_outgoing-SF0THRESHOLD)) {
+        if ( bw_required < (bw_outgoing-SF0THRESHOLD)) {
             if (sf0_candidateRemoveCellList(celllist_delete,&neighbor,SF0THRESHOLD)==FALSE){
                 // failed to get cell list to delete
                 return;
@@ -165,6 +189,61 @@ void sf0_bandwidthEstimate_task(void){
     }
 }
 
+/**
+\brief Relocate the TX cell to the parent which delivers worst.
+
+A cell delivering much worse than the others to the same parent likely collides
+with a cell scheduled in a neighboring subtree, it is moved elsewhere through a
+6P RELOCATE. A link delivering badly on all its cells is left to RPL.
+*/
+void sf0_housekeeping_task(void){
+    open_addr_t    neighbor;
+    cellInfo_ht    celllist_add[CELLLIST_MAX_LEN];
+    cellInfo_ht    celllist_relocate[CELLLIST_MAX_LEN];
+    
+    // no cells to a parent if I'm a DAGroot
+    if (idmanager_getIsDAGroot()){
+        return;
+    }
+    
+    // the parent was busy, leave it alone for now
+    if (sf0_vars.backoff>0){
+        return;
+    }
+    
+    // get preferred parent
+    if (icmpv6rpl_getPreferredParentEui64(&neighbor)==FALSE) {
+        return;
+    }
+    
+    memset(celllist_relocate,0,sizeof(celllist_relocate));
+    if (
+        schedule_getCellToRelocate(
+            SCHEDULE_UNICAST_SLOTFRAME_HANDLE,
+            &neighbor,
+            &celllist_relocate[0]
+        )==FALSE
+    ){
+        // all cells deliver alike
+        return;
+    }
+    if (sf0_candidateAddCellList(celllist_add,1)==FALSE){
+        // failed to get cell list to relocate to
+        return;
+    }
+    sixtop_request(
+        IANA_6TOP_CMD_RELOCATE,             // code
+        &neighbor,                          // neighbor
+        1,                                  // number cells
+        LINKOPTIONS_TX,                     // cellOptions
+        celllist_add,                       // candidate celllist
+        celllist_relocate,                  // celllist to relocate
+        SF0_ID,                             // sfid
+        0,                                  // list command offset (not used)
+        0                                   // list command maximum celllist (not used)
+    );
+}
+
 void sf0_appPktPeriod(uint8_t numAppPacketsPerSlotFrame){
     sf0_vars.numAppPacketsPerSlotFrame = numAppPacketsPerSlotFrame;
 }
@@ -175,13 +254,23 @@ bool sf0_candidateAddCellList(
    ){
     uint8_t i;
     frameLength_t slotoffset;
+    frameLength_t frameLength;
     uint8_t numCandCells;
     
+    frameLength = schedule_getSlotframeLength(SCHEDULE_UNICAST_SLOTFRAME_HANDLE);
+    if (frameLength==0) {
+        // the default slotframe is not known yet
+        return FALSE;
+    }
+    
     memset(cellList,0,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
     numCandCells=0;
     for(i=0;i<CELLLIST_MAX_LEN;i++){
-        slotoffset = openrandom_get16b()%schedule_getFrameLength();
-        if(schedule_isSlotOffsetAvailable(slotoffset)==TRUE){
+        slotoffset = openrandom_get16b()%frameLength;
+        if(
+            schedule_isSlotOffsetAvailableInFrame(SCHEDULE_UNICAST_SLOTFRAME_HANDLE,slotoffset)==TRUE &&
+            sixtop_isSlotOffsetReserved(slotoffset)==FALSE
+        ){
             cellList[numCandCells].slotoffset       = slotoffset;
             cellList[numCandCells].channeloffset    = openrandom_get16b()%16;
             cellList[numCandCells].isUsed           = TRUE;
@@ -207,8 +296,8 @@ bool sf0_candidateRemoveCellList(
    
    memset(cellList,0,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
    numCandCells    = 0;
-   for(i=0;i<schedule_getFrameLength();i++){
-      schedule_getSlotInfo(i,neighbor,&info);
+   for(i=0;i<schedule_getSlotframeLength(SCHEDULE_UNICAST_SLOTFRAME_HANDLE);i++){
+      schedule_getSlotInfoInFrame(SCHEDULE_UNICAST_SLOTFRAME_HANDLE,i,neighbor,&info);
       if(info.link_type == CELLTYPE_TX){
          cellList[numCandCells].slotoffset       = i;
          cellList[numCandCells].channeloffset    = info.channelOffset;
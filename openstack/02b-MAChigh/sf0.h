@@ -17,6 +17,7 @@
 typedef struct {
    uint8_t numAppPacketsPerSlotFrame;
    uint8_t backoff;
+   uint8_t housekeepingCounter;   // counter to determine when to look for cells to relocate
 } sf0_vars_t;
 
 //=========================== module variables ================================
@@ -16,6 +16,7 @@
 #include "IEEE802154_security.h"
 #include "idmanager.h"
 #include "schedule.h"
+#include "opentelemetry.h"
 
 //=========================== define ==========================================
 
@@ -45,6 +46,9 @@ void          timer_sixtop_sendEb_fired(void);
 void          timer_sixtop_management_fired(void);
 void          sixtop_sendEB(void);
 void          sixtop_sendKA(void);
+#ifdef SIXTOP_EB_TRICKLE
+uint8_t       sixtop_getEbTrickleDoublings(void);
+#endif
 
 //=== six2six task
 
@@ -71,6 +75,8 @@ void sixtop_six2six_notifyReceive(
 
 //=== helper functions
 
+sixtop_transaction_t* sixtop_getTransaction(open_addr_t* neighbor);
+sixtop_transaction_t* sixtop_getFreeTransaction(void);
 bool          sixtop_addCells(
    uint8_t              slotframeID,
    cellInfo_ht*         cellList,
@@ -95,10 +101,15 @@ bool sixtop_areAvailableCellsToBeRemoved(
     open_addr_t* neighbor,
     uint8_t      cellOptions
 );
+void          sixtop_trimRelocationList(
+    cellInfo_ht*         relocationList,
+    cellInfo_ht*         candidateList
+);
 
 //=========================== public ==========================================
 
 void sixtop_init() {
+    uint8_t i;
     
     sixtop_vars.periodMaintenance  = 872 +(openrandom_get16b()&0xff);
     sixtop_vars.busySendingKA      = FALSE;
@@ -108,9 +119,25 @@ void sixtop_init() {
     sixtop_vars.kaPeriod           = MAXKAPERIOD;
     sixtop_vars.ebPeriod           = EBPERIOD;
     sixtop_vars.isResponseEnabled  = TRUE;
-    sixtop_vars.six2six_state      = SIX_STATE_IDLE;
+    for (i=0;i<SIXTOP_MAX_TRANSACTIONS;i++){
+        sixtop_vars.transactions[i].six2six_state = SIX_STATE_IDLE;
+    }
+    
+    // status reported over serial
+    opentelemetry_registerCounters(STATUS_KAPERIOD,(uint8_t*)&sixtop_vars.kaPeriod,sizeof(uint16_t),OPENTELEMETRY_PERIOD_ALWAYS);
     
     sixtop_vars.ebSendingTimerId   = opentimers_create();
+#ifdef SIXTOP_EB_TRICKLE
+    opentrickle_start(
+        &sixtop_vars.ebTrickle,
+        sixtop_vars.ebSendingTimerId,
+        sixtop_sendingEb_timer_cb,
+        (uint32_t)sixtop_vars.ebPeriod*1000,
+        sixtop_getEbTrickleDoublings(),
+        SIXTOP_EB_TRICKLE_K
+    );
+    sixtop_vars.isEbSuppressed     = FALSE;
+#else
     opentimers_scheduleIn(
         sixtop_vars.ebSendingTimerId,
         sixtop_vars.periodMaintenance,
@@ -118,6 +145,7 @@ void sixtop_init() {
         TIMER_ONESHOT,
         sixtop_sendingEb_timer_cb
     );
+#endif
     
     sixtop_vars.maintenanceTimerId   = opentimers_create();
     opentimers_scheduleIn(
@@ -143,9 +171,31 @@ void sixtop_setEBPeriod(uint8_t ebPeriod) {
     if(ebPeriod != 0) {
         // convert parameter to miliseconds
         sixtop_vars.ebPeriod = ebPeriod;
+#ifdef SIXTOP_EB_TRICKLE
+        opentrickle_start(
+            &sixtop_vars.ebTrickle,
+            sixtop_vars.ebSendingTimerId,
+            sixtop_sendingEb_timer_cb,
+            (uint32_t)sixtop_vars.ebPeriod*1000,
+            sixtop_getEbTrickleDoublings(),
+            SIXTOP_EB_TRICKLE_K
+        );
+#endif
     }
 }
 
+/**
+\brief Indicate the DAGrank or the parent of this mote changed.
+
+With SIXTOP_EB_TRICKLE, this resets the Trickle timer of the EBs, which carry
+the DAGrank.
+*/
+void sixtop_indicateRoutingChange() {
+#ifdef SIXTOP_EB_TRICKLE
+    opentrickle_reset(&sixtop_vars.ebTrickle);
+#endif
+}
+
 void  sixtop_setSFcallback(
     sixtop_sf_getsfid           cb0,
     sixtop_sf_getmetadata       cb1, 
@@ -178,13 +228,21 @@ owerror_t sixtop_request(
     uint8_t           scheduleGeneration;
     uint8_t           sequenceNumber;
     owerror_t         outcome;
+    sixtop_transaction_t* transaction;
    
     // filter parameters: handler, status and neighbor
     if(
-        sixtop_vars.six2six_state != SIX_STATE_IDLE   ||
-        neighbor                  == NULL
+        neighbor                        == NULL   ||
+        sixtop_getTransaction(neighbor) != NULL
     ){
-        // neighbor can't be none or previous transcation doesn't finishe yet
+        // neighbor can't be none or previous transcation with it doesn't finishe yet
+        return E_FAIL;
+    }
+    
+    // get a free transaction
+    transaction = sixtop_getFreeTransaction();
+    if (transaction==NULL){
+        // all the transactions are pending, with other neighbors
         return E_FAIL;
     }
    
@@ -206,9 +264,15 @@ owerror_t sixtop_request(
    
     memcpy(&(pkt->l2_nextORpreviousHop),neighbor,sizeof(open_addr_t));
     if (celllist_toBeDeleted != NULL){
-        memcpy(sixtop_vars.celllist_toDelete,celllist_toBeDeleted,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
+        memcpy(transaction->celllist_toDelete,celllist_toBeDeleted,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
     }
-    sixtop_vars.cellOptions = cellOptions;
+    // the cells offered to the neighbor are not given to anyone else until it answers
+    if (code == IANA_6TOP_CMD_ADD || code == IANA_6TOP_CMD_RELOCATE){
+        memcpy(transaction->celllist_toAdd,celllist_toBeAdded,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
+    } else {
+        memset(transaction->celllist_toAdd,0,CELLLIST_MAX_LEN*sizeof(cellInfo_ht));
+    }
+    transaction->cellOptions = cellOptions;
     
     len  = 0;
     if (
@@ -323,25 +387,27 @@ owerror_t sixtop_request(
     
     if (outcome == E_SUCCESS){
         neighbors_updateSequenceNumber(neighbor);
+        memcpy(&(transaction->neighbor),neighbor,sizeof(open_addr_t));
+        transaction->seqNum = sequenceNumber;
         //update states
         switch(code){
         case IANA_6TOP_CMD_ADD:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_ADDREQUEST_SENDDONE;
+            transaction->six2six_state = SIX_STATE_WAIT_ADDREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_DELETE:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_DELETEREQUEST_SENDDONE;
+            transaction->six2six_state = SIX_STATE_WAIT_DELETEREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_RELOCATE:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_RELOCATEREQUEST_SENDDONE;
+            transaction->six2six_state = SIX_STATE_WAIT_RELOCATEREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_COUNT:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_COUNTREQUEST_SENDDONE;
+            transaction->six2six_state = SIX_STATE_WAIT_COUNTREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_LIST:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_LISTREQUEST_SENDDONE;
+            transaction->six2six_state = SIX_STATE_WAIT_LISTREQUEST_SENDDONE;
             break;
         case IANA_6TOP_CMD_CLEAR:
-            sixtop_vars.six2six_state = SIX_STATE_WAIT_CLEARREQUEST_SENDDONE;
+            transaction->six2six_state = SIX_STATE_WAIT_CLEARREQUEST_SENDDONE;
             break;
         }
     } else {
@@ -350,6 +416,36 @@ owerror_t sixtop_request(
     return outcome;
 }
 
+/**
+\brief Tell whether a slot offset is offered in a pending ADD or RELOCATE.
+
+The neighbor may pick any of the cells offered, so they stay reserved until
+the transaction completes or times out.
+
+\param[in] slotOffset The slot offset to check.
+
+\returns TRUE if a pending transaction offers a cell at that slot offset.
+*/
+bool sixtop_isSlotOffsetReserved(uint16_t slotOffset){
+    uint8_t i;
+    uint8_t j;
+    
+    for (i=0;i<SIXTOP_MAX_TRANSACTIONS;i++){
+        if (sixtop_vars.transactions[i].six2six_state == SIX_STATE_IDLE){
+            continue;
+        }
+        for (j=0;j<CELLLIST_MAX_LEN;j++){
+            if (
+                sixtop_vars.transactions[i].celllist_toAdd[j].isUsed &&
+                sixtop_vars.transactions[i].celllist_toAdd[j].slotoffset == slotOffset
+            ){
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
 //======= from upper layer
 
 owerror_t sixtop_send(OpenQueueEntry_t *msg) {
@@ -490,6 +586,10 @@ void task_sixtopNotifReceive() {
     // send the packet up the stack, if it qualifies
     switch (msg->l2_frameType) {
     case IEEE154_TYPE_BEACON:
+#ifdef SIXTOP_EB_TRICKLE
+        // a neighbor advertises the network already
+        opentrickle_consistent(&sixtop_vars.ebTrickle);
+#endif
     case IEEE154_TYPE_DATA:
     case IEEE154_TYPE_CMD:
         if (msg->length>0) {
@@ -601,12 +701,27 @@ owerror_t sixtop_send_internal(
         &(msg->l2_nextORpreviousHop)
     );
     // change owner to IEEE802154E fetches it from queue
-    msg->owner  = COMPONENT_SIXTOP_TO_IEEE802154E;
-    return E_SUCCESS;
+    return openqueue_sixtopPutPacket(msg);
 }
 
 // timer interrupt callbacks
 void sixtop_sendingEb_timer_cb(opentimers_id_t id){
+#ifdef SIXTOP_EB_TRICKLE
+    bool isAtT;
+    
+    isAtT = sixtop_vars.ebTrickle.isBeforeT;
+    if (
+        opentrickle_fired(&sixtop_vars.ebTrickle) ||
+        (isAtT && sixtop_vars.isEbSuppressed)
+    ) {
+        // never stay silent two intervals in a row, the neighbors which
+        // only hear this mote through its EBs would remove it
+        sixtop_vars.isEbSuppressed = FALSE;
+        scheduler_push_task(timer_sixtop_sendEb_fired,TASKPRIO_SIXTOP);
+    } else if (isAtT) {
+        sixtop_vars.isEbSuppressed = TRUE;
+    }
+#else
     scheduler_push_task(timer_sixtop_sendEb_fired,TASKPRIO_SIXTOP);
     // update the period
     sixtop_vars.periodMaintenance  = 872 +(openrandom_get16b()&0xff);
@@ -617,6 +732,7 @@ void sixtop_sendingEb_timer_cb(opentimers_id_t id){
         TIMER_ONESHOT,
         sixtop_sendingEb_timer_cb
     );
+#endif
 }
 
 void sixtop_maintenance_timer_cb(opentimers_id_t id) {
@@ -630,6 +746,10 @@ void sixtop_timeout_timer_cb(opentimers_id_t id) {
 //======= EB/KA task
 
 void timer_sixtop_sendEb_fired(){
+#ifdef SIXTOP_EB_TRICKLE
+    // the Trickle timer decides when
+    sixtop_sendEB();
+#else
     sixtop_vars.ebCounter = (sixtop_vars.ebCounter+1)%sixtop_vars.ebPeriod;
     switch (sixtop_vars.ebCounter) {
     case 0:
@@ -639,7 +759,34 @@ void timer_sixtop_sendEb_fired(){
     default:
         break;
     }
+#endif
+}
+
+#ifdef SIXTOP_EB_TRICKLE
+/**
+\brief Number of doublings of the EB period into the longest Trickle interval.
+
+The EBs of a mote are at most three intervals apart, see
+sixtop_sendingEb_timer_cb(). The longest interval is kept under a quarter of
+DESYNCTIMEOUT, after which its neighbors remove it, and under
+SIXTOP_EB_TRICKLE_DOUBLINGS doublings.
+*/
+uint8_t sixtop_getEbTrickleDoublings() {
+    uint32_t timeout;
+    uint32_t interval;
+    uint8_t  doublings;
+    
+    // in ms
+    timeout   = ((uint32_t)DESYNCTIMEOUT*ieee154e_getSlotDuration()*305)/10000;
+    interval  = (uint32_t)sixtop_vars.ebPeriod*1000;
+    doublings = 0;
+    while (doublings<SIXTOP_EB_TRICKLE_DOUBLINGS && interval*2<=timeout/4) {
+        interval *= 2;
+        doublings++;
+    }
+    return doublings;
 }
+#endif
 
 /**
 \brief Timer handlers which triggers MAC management task.
@@ -850,54 +997,78 @@ port_INLINE void sixtop_sendKA() {
 //======= six2six task
 
 void timer_sixtop_six2six_timeout_fired(void) {
-    // timeout timer fired, reset the state of sixtop to idle
-    sixtop_vars.six2six_state = SIX_STATE_IDLE;
-    opentimers_cancel(sixtop_vars.timeoutTimerId);
+    uint8_t i;
+    bool    isWaiting;
+    
+    // reset the transactions whose response has not come in time to idle
+    isWaiting = FALSE;
+    for (i=0;i<SIXTOP_MAX_TRANSACTIONS;i++){
+        if (sixtop_vars.transactions[i].six2six_state < SIX_STATE_WAIT_ADDRESPONSE){
+            continue;
+        }
+        sixtop_vars.transactions[i].timeout--;
+        if (sixtop_vars.transactions[i].timeout==0){
+            sixtop_vars.transactions[i].six2six_state = SIX_STATE_IDLE;
+        } else {
+            isWaiting = TRUE;
+        }
+    }
+    
+    // no more responses to wait for
+    if (isWaiting==FALSE){
+        opentimers_cancel(sixtop_vars.timeoutTimerId);
+    }
 }
 
 void sixtop_six2six_sendDone(OpenQueueEntry_t* msg, owerror_t error){
     
     bool scheduleChanged;
+    sixtop_transaction_t* transaction;
     msg->owner = COMPONENT_SIXTOP_RES;
     
     // if this is a request send done
-    if (msg->l2_sixtop_messageType == SIXTOP_CELL_REQUEST){
+    transaction = sixtop_getTransaction(&(msg->l2_nextORpreviousHop));
+    if (msg->l2_sixtop_messageType == SIXTOP_CELL_REQUEST && transaction != NULL){
         if(error == E_FAIL) {
             // reset handler and state if the request is failed to send out
-            sixtop_vars.six2six_state = SIX_STATE_IDLE;
+            transaction->six2six_state = SIX_STATE_IDLE;
         } else {
             // the packet has been sent out successfully
-            switch (sixtop_vars.six2six_state) {
+            switch (transaction->six2six_state) {
             case SIX_STATE_WAIT_ADDREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_ADDRESPONSE;
+                transaction->six2six_state = SIX_STATE_WAIT_ADDRESPONSE;
                 break;
             case SIX_STATE_WAIT_DELETEREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_DELETERESPONSE;
+                transaction->six2six_state = SIX_STATE_WAIT_DELETERESPONSE;
                 break;
             case SIX_STATE_WAIT_RELOCATEREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_RELOCATERESPONSE;
+                transaction->six2six_state = SIX_STATE_WAIT_RELOCATERESPONSE;
                 break;
             case SIX_STATE_WAIT_LISTREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_LISTRESPONSE;
+                transaction->six2six_state = SIX_STATE_WAIT_LISTRESPONSE;
                 break;
             case SIX_STATE_WAIT_COUNTREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_COUNTRESPONSE;
+                transaction->six2six_state = SIX_STATE_WAIT_COUNTRESPONSE;
                 break;
             case SIX_STATE_WAIT_CLEARREQUEST_SENDDONE:
-                sixtop_vars.six2six_state = SIX_STATE_WAIT_CLEARRESPONSE;
+                transaction->six2six_state = SIX_STATE_WAIT_CLEARRESPONSE;
                 break;
             default:
                 // should never happen
                 break;
             }
-            // start timeout timer if I am waiting for a response
-            opentimers_scheduleIn(
-                sixtop_vars.timeoutTimerId,
-                SIX2SIX_TIMEOUT_MS,
-                TIME_MS,
-                TIMER_ONESHOT,
-                sixtop_timeout_timer_cb
-            );
+            // wait for the response for at least SIX2SIX_TIMEOUT_MS
+            transaction->timeout = SIX2SIX_TIMEOUT_MS/SIX2SIX_TIMEOUT_TICK_MS+1;
+            // start timeout timer if I am the first one waiting for a response
+            if (opentimers_isRunning(sixtop_vars.timeoutTimerId)==FALSE){
+                opentimers_scheduleIn(
+                    sixtop_vars.timeoutTimerId,
+                    SIX2SIX_TIMEOUT_TICK_MS,
+                    TIME_MS,
+                    TIMER_PERIODIC,
+                    sixtop_timeout_timer_cb
+                );
+            }
         }
     }
     
@@ -1066,6 +1237,7 @@ void sixtop_six2six_notifyReceive(
     uint8_t           response_pktLen   = 0;
     cellInfo_ht       celllist_list[CELLLIST_MAX_LEN];
     bool              scheduleChanged;
+    sixtop_transaction_t* transaction;
     
     if (type == SIXTOP_CELL_REQUEST){
         // if this is a 6p request message
@@ -1108,8 +1280,8 @@ void sixtop_six2six_notifyReceive(
                 returnCode = IANA_6TOP_RC_GEN_ERR;
                 break;
             }
-            // previous 6p transcation check
-            if (sixtop_vars.six2six_state != SIX_STATE_IDLE){
+            // previous 6p transcation with this neighbor check
+            if (sixtop_getTransaction(&(pkt->l2_nextORpreviousHop)) != NULL){
                 returnCode = IANA_6TOP_RC_RESET;
                 break;
             }
@@ -1210,7 +1382,7 @@ void sixtop_six2six_notifyReceive(
                 } else {
                     cellOptions_transformed = cellOptions;
                 }
-                for(i=0; i<schedule_getFrameLength(); i++) {
+                for(i=0; i<schedule_getSlotframeLength(metadata); i++) {
                     if (
                         schedule_getOneCellAfterOffset(
                             metadata,
@@ -1360,6 +1532,11 @@ void sixtop_six2six_notifyReceive(
                         }
                     }
                 }
+                // the cells no candidate was picked for stay where they are
+                sixtop_trimRelocationList(
+                    response_pkt->l2_sixtop_celllist_delete,
+                    response_pkt->l2_sixtop_celllist_add
+                );
                 returnCode = IANA_6TOP_RC_SUCCESS;
                 break;
             }
@@ -1423,10 +1600,23 @@ void sixtop_six2six_notifyReceive(
     
     if (type == SIXTOP_CELL_RESPONSE) {
         // this is a 6p response message
+        
+        // it answers the request pending with that neighbor, if any
+        transaction = sixtop_getTransaction(&(pkt->l2_nextORpreviousHop));
+        if (transaction == NULL || transaction->seqNum != seqNum){
+            // the request timed out, or this is the response to an earlier one
+            openserial_printError(
+                COMPONENT_SIXTOP,
+                ERR_SIXTOP_NO_TRANSACTION,
+                (errorparameter_t)seqNum,
+                (errorparameter_t)(transaction == NULL ? 0xff : transaction->seqNum)
+            );
+            return;
+        }
       
         // if the code is SUCCESS
         if (code == IANA_6TOP_RC_SUCCESS || code == IANA_6TOP_RC_EOL){
-            switch(sixtop_vars.six2six_state){
+            switch(transaction->six2six_state){
             case SIX_STATE_WAIT_ADDRESPONSE:
                 i = 0;
                 memset(pkt->l2_sixtop_celllist_add,0,sizeof(pkt->l2_sixtop_celllist_add));
@@ -1445,7 +1635,7 @@ void sixtop_six2six_notifyReceive(
                         sixtop_vars.cb_sf_getMetadata(),     // frame id 
                         pkt->l2_sixtop_celllist_add,  // celllist to be added
                         &(pkt->l2_nextORpreviousHop), // neighbor that cells to be added to
-                        sixtop_vars.cellOptions       // cell options
+                        transaction->cellOptions      // cell options
                     ) == TRUE
                 ) { 
                     neighbors_updateGeneration(&(pkt->l2_nextORpreviousHop));
@@ -1455,9 +1645,9 @@ void sixtop_six2six_notifyReceive(
                 if (
                     sixtop_removeCells(
                         sixtop_vars.cb_sf_getMetadata(),
-                        sixtop_vars.celllist_toDelete,
+                        transaction->celllist_toDelete,
                         &(pkt->l2_nextORpreviousHop),
-                        sixtop_vars.cellOptions
+                        transaction->cellOptions
                     ) == TRUE
                 ) {
                     neighbors_updateGeneration(&(pkt->l2_nextORpreviousHop));
@@ -1476,17 +1666,22 @@ void sixtop_six2six_notifyReceive(
                     pktLen -= 4;
                     i++;
                 }
+                // the cells the neighbor picked no candidate for stay where they are
+                sixtop_trimRelocationList(
+                    transaction->celllist_toDelete,
+                    pkt->l2_sixtop_celllist_add
+                );
                 scheduleChanged  = sixtop_removeCells(
                                         sixtop_vars.cb_sf_getMetadata(),
-                                        sixtop_vars.celllist_toDelete,
+                                        transaction->celllist_toDelete,
                                         &(pkt->l2_nextORpreviousHop),
-                                        sixtop_vars.cellOptions
+                                        transaction->cellOptions
                                    );
                 scheduleChanged |= sixtop_addCells(
                                         sixtop_vars.cb_sf_getMetadata(),     // frame id 
                                         pkt->l2_sixtop_celllist_add,  // celllist to be added
                                         &(pkt->l2_nextORpreviousHop), // neighbor that cells to be added to
-                                        sixtop_vars.cellOptions       // cell options
+                                        transaction->cellOptions      // cell options
                                    );
                 if (scheduleChanged) {
                     neighbors_updateGeneration(&(pkt->l2_nextORpreviousHop));
@@ -1500,7 +1695,7 @@ void sixtop_six2six_notifyReceive(
                     COMPONENT_SIXTOP,
                     ERR_SIXTOP_COUNT,
                     (errorparameter_t)numCells,
-                    (errorparameter_t)sixtop_vars.six2six_state
+                    (errorparameter_t)transaction->six2six_state
                 );
                 break;
             case SIX_STATE_WAIT_LISTRESPONSE:
@@ -1542,15 +1737,51 @@ void sixtop_six2six_notifyReceive(
             COMPONENT_SIXTOP,
             ERR_SIXTOP_RETURNCODE,
             (errorparameter_t)code,
-            (errorparameter_t)sixtop_vars.six2six_state
+            (errorparameter_t)transaction->six2six_state
         );
-        sixtop_vars.six2six_state   = SIX_STATE_IDLE;
-        opentimers_cancel(sixtop_vars.timeoutTimerId);
+        transaction->six2six_state  = SIX_STATE_IDLE;
     }
 }
 
 //======= helper functions
 
+/**
+\brief Find the 6P transaction pending with a neighbor.
+
+\param[in] neighbor The neighbor the request was sent to.
+
+\returns The transaction, or NULL if there is none.
+*/
+sixtop_transaction_t* sixtop_getTransaction(open_addr_t* neighbor){
+    uint8_t i;
+    
+    for (i=0;i<SIXTOP_MAX_TRANSACTIONS;i++){
+        if (
+            sixtop_vars.transactions[i].six2six_state != SIX_STATE_IDLE &&
+            packetfunctions_sameAddress(&(sixtop_vars.transactions[i].neighbor),neighbor)
+        ){
+            return &(sixtop_vars.transactions[i]);
+        }
+    }
+    return NULL;
+}
+
+/**
+\brief Find a transaction which is not pending.
+
+\returns The transaction, or NULL if they are all pending.
+*/
+sixtop_transaction_t* sixtop_getFreeTransaction(void){
+    uint8_t i;
+    
+    for (i=0;i<SIXTOP_MAX_TRANSACTIONS;i++){
+        if (sixtop_vars.transactions[i].six2six_state == SIX_STATE_IDLE){
+            return &(sixtop_vars.transactions[i]);
+        }
+    }
+    return NULL;
+}
+
 bool sixtop_addCells(
     uint8_t      slotframeID,
     cellInfo_ht* cellList,
@@ -1589,7 +1820,8 @@ bool sixtop_addCells(
     for(i = 0;i<CELLLIST_MAX_LEN;i++){
         if (cellList[i].isUsed){
             hasCellsAdded = TRUE;
-            schedule_addActiveSlot(
+            schedule_addActiveSlotInFrame(
+                slotframeID,
                 cellList[i].slotoffset,
                 type,
                 isShared,
@@ -1636,7 +1868,8 @@ bool sixtop_removeCells(
     for(i=0;i<CELLLIST_MAX_LEN;i++){
         if (cellList[i].isUsed){
             hasCellsRemoved = TRUE;
-            schedule_removeActiveSlot(
+            schedule_removeActiveSlotInFrame(
+                slotframeID,
                 cellList[i].slotoffset,
                 &temp_neighbor
             );
@@ -1665,7 +1898,10 @@ bool sixtop_areAvailableCellsToBeScheduled(
         available = FALSE;
     } else {
         do {
-            if(schedule_isSlotOffsetAvailable(cellList[i].slotoffset) == TRUE){
+            if(
+                schedule_isSlotOffsetAvailableInFrame(frameID,cellList[i].slotoffset) == TRUE &&
+                sixtop_isSlotOffsetReserved(cellList[i].slotoffset)    == FALSE
+            ){
                 numbOfavailableCells++;
             } else {
                 // mark the cell
@@ -1729,9 +1965,9 @@ bool sixtop_areAvailableCellsToBeRemoved(
             if (cellList[i].isUsed){
                 memset(&info,0,sizeof(slotinfo_element_t));
                 if (type==CELLTYPE_TXRX){
-                    schedule_getSlotInfo(cellList[i].slotoffset,&anycastAddr,&info);
+                    schedule_getSlotInfoInFrame(frameID,cellList[i].slotoffset,&anycastAddr,&info);
                 } else {
-                    schedule_getSlotInfo(cellList[i].slotoffset,neighbor,&info);
+                    schedule_getSlotInfoInFrame(frameID,cellList[i].slotoffset,neighbor,&info);
                 }
                 if(info.link_type != type){
                     available = FALSE;
@@ -1756,3 +1992,35 @@ bool sixtop_areAvailableCellsToBeRemoved(
     }
     return available;
 }
+
+/**
+\brief Keep in a list of cells to relocate only as many cells as candidates
+   were picked for them.
+
+The first cells of the list move to the candidates, in order, the others stay
+where they are. The neighbor may pick fewer candidates than cells asked for,
+or none at all.
+*/
+void sixtop_trimRelocationList(
+    cellInfo_ht* relocationList,
+    cellInfo_ht* candidateList
+    ){
+    uint8_t i;
+    uint8_t numCandidates;
+    
+    numCandidates = 0;
+    for (i=0;i<CELLLIST_MAX_LEN;i++){
+        if (candidateList[i].isUsed){
+            numCandidates++;
+        }
+    }
+    for (i=0;i<CELLLIST_MAX_LEN;i++){
+        if (relocationList[i].isUsed){
+            if (numCandidates>0){
+                numCandidates--;
+            } else {
+                relocationList[i].isUsed = FALSE;
+            }
+        }
+    }
+}
@@ -10,6 +10,7 @@
 
 #include "opentimers.h"
 #include "opendefs.h"
+#include "opentrickle.h"
 
 //=========================== define ==========================================
 // 201 is the first available subIE ID for experimental use: 
@@ -80,11 +81,33 @@ typedef enum {
 //=========================== typedef =========================================
 
 #define SIX2SIX_TIMEOUT_MS 4000
+// period of the timer the timeouts of all the transactions are counted with
+#define SIX2SIX_TIMEOUT_TICK_MS 500
+// number of 6P transactions which can be pending at once, one per neighbor
+#ifndef SIXTOP_MAX_TRANSACTIONS
+#define SIXTOP_MAX_TRANSACTIONS 4
+#endif
+#ifdef SIXTOP_EB_TRICKLE
+// EBs are sent on a Trickle timer of Imin the EB period
+#define SIXTOP_EB_TRICKLE_DOUBLINGS 4 // longest interval 16 EB periods, see sixtop_getEbTrickleDoublings
+#define SIXTOP_EB_TRICKLE_K         3 // EBs heard in an interval to stay silent
+#endif
 typedef uint8_t                 (*sixtop_sf_getsfid)(void);
 typedef uint16_t                (*sixtop_sf_getmetadata)(void);
 typedef metadata_t              (*sixtop_sf_translatemetadata)(void);
 typedef void (*sixtop_sf_handle_callback)(uint8_t arg);
 
+// a 6P transaction this mote started, free when its state is SIX_STATE_IDLE
+typedef struct {
+   open_addr_t                  neighbor;                // the neighbor the request was sent to
+   six2six_state_t              six2six_state;
+   uint8_t                      seqNum;                  // sequence number of the request
+   uint8_t                      cellOptions;
+   cellInfo_ht                  celllist_toDelete[CELLLIST_MAX_LEN];
+   cellInfo_ht                  celllist_toAdd[CELLLIST_MAX_LEN]; // cells offered by an ADD or RELOCATE, reserved while pending
+   uint8_t                      timeout;                 // periods of the timeout timer left to wait for the response
+} sixtop_transaction_t;
+
 //=========================== module variables ================================
 
 typedef struct {
@@ -95,15 +118,16 @@ typedef struct {
    uint8_t                      mgtTaskCounter;          // counter to determine what management task to do
    uint8_t              ebCounter;               // counter to determine when to send EB
    opentimers_id_t      ebSendingTimerId;        // EB sending timer id
+#ifdef SIXTOP_EB_TRICKLE
+   opentrickle_t                ebTrickle;               // Trickle timer the EBs are sent on
+   bool                         isEbSuppressed;          // TRUE when no EB was sent in the last interval
+#endif
    opentimers_id_t      maintenanceTimerId;
-   opentimers_id_t      timeoutTimerId;          // TimeOut timer id
+   opentimers_id_t      timeoutTimerId;          // TimeOut timer id, runs while a response is waited for
    uint16_t                     kaPeriod;                // period of sending KA
    uint16_t                     ebPeriod;                // period of sending EB
-   six2six_state_t              six2six_state;
-   uint8_t                      commandID;
+   sixtop_transaction_t         transactions[SIXTOP_MAX_TRANSACTIONS];
    bool                         isResponseEnabled;
-   uint8_t                      cellOptions;
-   cellInfo_ht                  celllist_toDelete[CELLLIST_MAX_LEN];
    sixtop_sf_getsfid            cb_sf_getsfid;
    sixtop_sf_getmetadata        cb_sf_getMetadata;
    sixtop_sf_translatemetadata  cb_sf_translateMetadata;
@@ -116,6 +140,7 @@ typedef struct {
 void      sixtop_init(void);
 void      sixtop_setKaPeriod(uint16_t kaPeriod);
 void      sixtop_setEBPeriod(uint8_t ebPeriod);
+void      sixtop_indicateRoutingChange(void);
 void      sixtop_setSFcallback(
     sixtop_sf_getsfid     cb0,
     sixtop_sf_getmetadata cb1, 
@@ -134,6 +159,7 @@ owerror_t sixtop_request(
     uint16_t     listingOffset,
     uint16_t     listingMaxNumCells
 );
+bool      sixtop_isSlotOffsetReserved(uint16_t slotOffset);
 // from upper layer
 owerror_t sixtop_send(OpenQueueEntry_t *msg);
 // from lower layer
@@ -10,6 +10,7 @@
 #include "openbridge.h"
 #include "openserial.h"
 #include "openqueue.h"
+#include "openmemory.h"
 #include "IEEE802154.h"
 #include "IEEE802154_security.h"
 
@@ -25,6 +26,11 @@ uint16_t fragment_getNewTag(void);
 owerror_t fragment_startSend(FragmentQueueEntry_t* buffer);
 void fragment_tryToSend(FragmentQueueEntry_t* buffer);
 void fragment_finishSend(FragmentQueueEntry_t* buffer, owerror_t error);
+void fragment_gather(FragmentQueueEntry_t* buffer, uint16_t offset, uint8_t* dst, uint16_t length);
+void fragment_releaseChain(FragmentQueueEntry_t* buffer);
+void fragment_cutThrough(FragmentQueueEntry_t* buffer);
+uint16_t fragment_receivedPrefix(FragmentQueueEntry_t* buffer);
+void fragment_releaseSent(FragmentQueueEntry_t* buffer);
 
 // to implement on lower layers?
 uint8_t fragment_askL2HeaderSize(OpenQueueEntry_t* msg);
@@ -243,6 +249,16 @@ bool fragment_retrieveHeader(OpenQueueEntry_t* msg) {
          open_addr_t addr;
          OpenQueueEntry_t* old_msg;
 
+         if ( buffer->in_use == FRAGMENT_FW ) {
+            // part of it may have been sent already: drop what is left
+            ENABLE_INTERRUPTS();
+            openserial_printError(COMPONENT_FRAGMENT, ERR_FRAGMENT_OVERLAPS,
+                                   (errorparameter_t)1,
+                                   (errorparameter_t)0);
+            openqueue_freePacketBuffer(msg);
+            fragment_doCancel(buffer);
+            return TRUE;
+         }
          if ( (action = buffer->action) == FRAGMENT_ACTION_OPENBRIDGE ) {
 	    tag  = buffer->datagram_tag;
 	    size = buffer->datagram_size;
@@ -330,6 +346,18 @@ void fragment_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
       }
       return;
    }
+   if ( buffer && buffer->in_use == FRAGMENT_FW && buffer->other.fw_busy ) {
+      buffer->other.fw_busy = FALSE;
+      if ( error == E_SUCCESS && buffer->action == FRAGMENT_ACTION_FORWARD ) {
+         fragment_cutThrough(buffer);
+      } else if ( buffer->action == FRAGMENT_ACTION_TIMEREXPIRED ) {
+         fragment_finishSend(buffer, E_FAIL);
+      } else {
+         // drop what is left of the datagram
+         fragment_doCancel(buffer);
+      }
+      return;
+   }
 
    openserial_printError(COMPONENT_FRAGMENT,ERR_UNEXPECTED_SENDDONE,
                           (errorparameter_t)0,
@@ -339,6 +367,7 @@ void fragment_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
         && ! openmemory_sameMemoryArea(buffer->payload, msg->payload) ) {
          openmemory_freeMemory(buffer->payload);
       }
+      fragment_releaseChain(buffer);
       fragment_freeBuffer(buffer);
    }
    openqueue_freePacketBuffer(msg);
@@ -374,6 +403,7 @@ bool fragment_removeCreatedBy(OpenQueueEntry_t* msg, uint8_t creator) {
    if ( buffer->payload ) {
       openmemory_freeMemory(buffer->payload);
    }
+   fragment_releaseChain(buffer);
    fragment_resetBuffer(buffer);
 
    return TRUE;
@@ -532,13 +562,26 @@ FragmentQueueEntry_t* fragment_searchBufferFromMsg_a(OpenQueueEntry_t* msg) {
 owerror_t fragment_startSend(FragmentQueueEntry_t* buffer) {
    uint8_t               l2_hsize;
    uint8_t               max_fragment;
+   uint8_t*              auxPacket;
    OpenQueueEntry_t*     msg;
 
    msg = buffer->msg;
    // last check: forwarding could make it smaller
    l2_hsize     = fragment_askL2HeaderSize(buffer->msg);
    max_fragment = FRAGMENT_DATA_UTIL - l2_hsize;
-   if ( msg->length <= max_fragment ) {
+   buffer->creator = msg->creator;
+   if ( buffer->in_use == FRAGMENT_FW ) {
+      // forwarding: the received fragments are kept as they are, frames
+      // are built in a new packet
+      if ( (auxPacket = openmemory_getMemory(0)) == NULL ) {
+         openserial_printError(COMPONENT_FRAGMENT, ERR_NO_FREE_PACKET_BUFFER,
+                               (errorparameter_t)1,
+                               (errorparameter_t)0);
+         fragment_doCancel(buffer);
+         return E_FAIL;
+      }
+      msg->packet = auxPacket;
+   } else if ( msg->length <= max_fragment ) {
       // assign payload to msg
       openmemory_freeMemory(msg->packet);
       msg->payload = buffer->payload;
@@ -547,10 +590,9 @@ owerror_t fragment_startSend(FragmentQueueEntry_t* buffer) {
       return  sixtop_send(msg);
    }
 
-   buffer->creator       = msg->creator;
-   msg->creator          = COMPONENT_FRAGMENT;
-   buffer->datagram_tag  = fragment_getNewTag();
-   buffer->datagram_size = msg->length;
+   openqueue_setCreator(msg,COMPONENT_FRAGMENT);
+   buffer->other.txdata.datagram_tag      = fragment_getNewTag();
+   buffer->other.txdata.datagram_size     = msg->length;
 
    buffer->other.txdata.actual_sent       = 0;
    buffer->other.txdata.size              = (max_fragment - FRAGMENT_FRAG1_HL) & 0xF8;
@@ -558,7 +600,12 @@ owerror_t fragment_startSend(FragmentQueueEntry_t* buffer) {
    buffer->other.txdata.max_fragment_size = (max_fragment - FRAGMENT_FRAGN_HL) & 0xF8;
 
    // Start sending the different frames
-   fragment_tryToSend(buffer);
+   if ( buffer->in_use == FRAGMENT_FW ) {
+      buffer->other.fw_busy = FALSE;
+      fragment_cutThrough(buffer);
+   } else {
+      fragment_tryToSend(buffer);
+   }
 
    return E_SUCCESS;
 }
@@ -573,7 +620,7 @@ void fragment_tryToSend(FragmentQueueEntry_t* buffer) {
 
    actual_sent = buffer->other.txdata.actual_sent;
    // check if message has been sent
-   if ( actual_sent == buffer->datagram_size ) {
+   if ( actual_sent == buffer->other.txdata.datagram_size ) {
       fragment_finishSend(buffer, E_SUCCESS);
       return;
    }
@@ -582,18 +629,22 @@ void fragment_tryToSend(FragmentQueueEntry_t* buffer) {
    actual_frag_size = buffer->other.txdata.size;
    pkt              = buffer->msg;
    pkt->payload     = &(pkt->packet[FRAGMENT_DATA_INIT - actual_frag_size]);
-   memcpy(pkt->payload,
-          buffer->payload + actual_sent,
-          actual_frag_size * sizeof(uint8_t));
+   if ( buffer->in_use == FRAGMENT_FW ) {
+      fragment_gather(buffer, actual_sent, pkt->payload, actual_frag_size);
+   } else {
+      memcpy(pkt->payload,
+             buffer->payload + actual_sent,
+             actual_frag_size * sizeof(uint8_t));
+   }
    pkt->length      = actual_frag_size;
    if ( buffer->other.txdata.fragn ) { // offset
       packetfunctions_reserveHeaderSize(pkt, sizeof(uint8_t));
       SET_OFFSET(pkt, actual_sent>>3);
    }
    packetfunctions_reserveHeaderSize(pkt, 2 * sizeof(uint8_t));
-   SET_TAG(pkt, buffer->datagram_tag);
+   SET_TAG(pkt, buffer->other.txdata.datagram_tag);
    packetfunctions_reserveHeaderSize(pkt, 2 * sizeof(uint8_t));
-   SET_SIZE(pkt, buffer->datagram_size);
+   SET_SIZE(pkt, buffer->other.txdata.datagram_size);
    if ( buffer->other.txdata.fragn ) {
       pkt->payload[0] |= (IPHC_DISPATCH_FRAGN << IPHC_FRAGMENT);
    } else {
@@ -605,15 +656,24 @@ void fragment_tryToSend(FragmentQueueEntry_t* buffer) {
    actual_sent      = actual_sent + actual_frag_size;
    actual_frag_size = buffer->other.txdata.max_fragment_size;
    // last fragment?
-   if ( actual_frag_size > buffer->datagram_size - actual_sent ) {
-      actual_frag_size = buffer->datagram_size - actual_sent;
+   if ( actual_frag_size > buffer->other.txdata.datagram_size - actual_sent ) {
+      actual_frag_size = buffer->other.txdata.datagram_size - actual_sent;
    }
    buffer->other.txdata.actual_sent = actual_sent;
    buffer->other.txdata.size        = actual_frag_size;
+   if ( buffer->in_use == FRAGMENT_FW ) {
+      // it has been copied to the frame
+      fragment_releaseSent(buffer);
+   }
 
    // try to send fragment
    if ( sixtop_send(pkt) == E_FAIL ) {
-      fragment_finishSend(buffer, E_FAIL);
+      if ( buffer->in_use == FRAGMENT_FW ) {
+         buffer->other.fw_busy = FALSE;
+         fragment_doCancel(buffer);
+      } else {
+         fragment_finishSend(buffer, E_FAIL);
+      }
    }
 }
 
@@ -633,12 +693,237 @@ void fragment_finishSend(FragmentQueueEntry_t* buffer, owerror_t error)
       openmemory_freeMemory(pkt->packet);
       pkt->payload = buffer->payload;
       pkt->packet  = openmemory_firstSegmentAddr(pkt->payload);
+   } else if ( buffer->in_use == FRAGMENT_FW ) {
+      if ( buffer->other.fw_payload ) { // restore FRAG1 to msg
+         if ( ! openmemory_sameMemoryArea(buffer->other.fw_payload, pkt->packet) ) {
+            openmemory_freeMemory(pkt->packet);
+         }
+         pkt->payload = buffer->other.fw_payload;
+         pkt->packet  = openmemory_firstSegmentAddr(pkt->payload);
+      }
+      fragment_releaseChain(buffer);
    }
-   pkt->creator = buffer->creator;
+   openqueue_setCreator(pkt,buffer->creator);
    fragment_freeBuffer(buffer);
    forwarding_sendDone(pkt, error);
 }
 
+/**
+\brief Copy a part of a forwarded datagram out of the fragments it was
+       received in.
+
+\note  The datagram is FRAG1, as rewritten by IPHC, followed by the
+       payload of the FRAGN fragments. These did not move: their position
+       in the datagram is shifted by the size change of FRAG1.
+
+\param buffer The fragmentation buffer of the forwarded datagram.
+\param offset Position of the first byte to copy, in the datagram.
+\param dst    Where to copy to.
+\param length The number of bytes to copy.
+*/
+void fragment_gather(FragmentQueueEntry_t* buffer, uint16_t offset,
+                     uint8_t* dst, uint16_t length) {
+   uint8_t  i;
+   int16_t  start;
+   int16_t  end;
+   int16_t  from;
+   int16_t  to;
+
+   // FRAG1
+   if ( offset < buffer->other.fw_length && buffer->other.fw_payload != NULL ) {
+      to = buffer->other.fw_length - offset;
+      if ( to > length ) {
+         to = length;
+      }
+      memcpy(dst, buffer->other.fw_payload + offset, to);
+   }
+
+   // FRAGN
+   for ( i = 0; i < buffer->number; i++ ) {
+      if ( buffer->other.rxlist[i].fragment_offset == 0
+        || buffer->other.rxlist[i].fragment == NULL ) {
+         continue;
+      }
+      start = (buffer->other.rxlist[i].fragment_offset<<3) - buffer->offset;
+      end   = start + buffer->other.rxlist[i].fragment_size;
+      from  = start > (int16_t)offset ? start : (int16_t)offset;
+      to    = end < (int16_t)(offset+length) ? end : (int16_t)(offset+length);
+      if ( from < to ) {
+         memcpy(dst + (from - offset),
+                buffer->other.rxlist[i].fragment + FRAGMENT_FRAGN_HL + (from - start),
+                to - from);
+      }
+   }
+}
+
+/**
+\brief Free the fragments a forwarded datagram is held in.
+
+\note  FRAG1 is freed only if the message has moved to another packet.
+*/
+void fragment_releaseChain(FragmentQueueEntry_t* buffer) {
+   uint8_t i;
+
+   if ( buffer->in_use != FRAGMENT_FW ) {
+      return;
+   }
+   for ( i = 0; i < buffer->number; i++ ) {
+      if ( buffer->other.rxlist[i].fragment ) {
+         openmemory_freeMemory(buffer->other.rxlist[i].fragment);
+         buffer->other.rxlist[i].fragment = NULL;
+      }
+   }
+   if ( buffer->other.fw_payload != NULL
+     && (   buffer->msg == NULL
+         || ! openmemory_sameMemoryArea(buffer->other.fw_payload, buffer->msg->packet)) ) {
+      openmemory_freeMemory(buffer->other.fw_payload);
+   }
+   buffer->other.fw_payload = NULL;
+}
+
+/**
+\brief Send the next fragment of a forwarded datagram, if it was received.
+
+\note  One fragment is sent at a time, the next one when it is done. It is
+       sent as soon as the data it carries has been received in order: it is
+       as large as the next hop allows, as the rest of the datagram, or else
+       as the data received so far in multiples of 8 bytes. The first one
+       must hold all the headers.
+
+\param buffer The fragmentation buffer of the forwarded datagram.
+*/
+void fragment_cutThrough(FragmentQueueEntry_t* buffer) {
+   uint16_t          received;
+   uint16_t          remaining;
+   uint8_t           size;
+   OpenQueueEntry_t* msg;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   if ( buffer->in_use != FRAGMENT_FW
+     || buffer->action != FRAGMENT_ACTION_FORWARD
+     || buffer->other.fw_busy ) {
+      ENABLE_INTERRUPTS();
+      return;
+   }
+   if ( buffer->other.txdata.actual_sent == buffer->other.txdata.datagram_size ) {
+      ENABLE_INTERRUPTS();
+      fragment_finishSend(buffer, E_SUCCESS);
+      return;
+   }
+
+   received  = fragment_receivedPrefix(buffer);
+   msg       = buffer->msg;
+   if ( ! buffer->other.txdata.fragn
+     && received == msg->length
+     && msg->length <= FRAGMENT_DATA_UTIL - fragment_askL2HeaderSize(msg) ) {
+      ENABLE_INTERRUPTS();
+      // fits in a frame: gather it whole
+      msg->payload = &(msg->packet[FRAGMENT_DATA_INIT - msg->length]);
+      fragment_gather(buffer, 0, msg->payload, msg->length);
+      openqueue_setCreator(msg,buffer->creator);
+      fragment_releaseChain(buffer);
+      fragment_freeBuffer(buffer);
+      if ( sixtop_send(msg) == E_FAIL ) {
+         forwarding_sendDone(msg, E_FAIL);
+      }
+      return;
+   }
+   remaining = received - buffer->other.txdata.actual_sent;
+   size      = buffer->other.txdata.fragn
+               ? buffer->other.txdata.max_fragment_size
+               : buffer->other.txdata.size;
+   if ( remaining < size ) {
+      if ( received == buffer->other.txdata.datagram_size ) {
+         size = remaining;          // last fragment
+      } else {
+         size = remaining & 0xF8;   // =/8*8
+      }
+   }
+   if ( size == 0
+     || (! buffer->other.txdata.fragn && size < buffer->other.fw_hsize) ) {
+      // wait for more
+      ENABLE_INTERRUPTS();
+      return;
+   }
+   buffer->other.txdata.size = size;
+   buffer->other.fw_busy     = TRUE;
+   ENABLE_INTERRUPTS();
+
+   fragment_tryToSend(buffer);
+}
+
+/**
+\brief Length of the forwarded datagram received in order, from its start.
+
+\note  It must be called in atomic context.
+
+\param buffer The fragmentation buffer of the forwarded datagram.
+
+\returns The number of bytes, in the datagram as it is sent.
+*/
+uint16_t fragment_receivedPrefix(FragmentQueueEntry_t* buffer) {
+   uint8_t  i;
+   bool     grown;
+   int16_t  start;
+   uint16_t received;
+
+   received = buffer->other.fw_length;
+   do {
+      grown = FALSE;
+      for ( i = 0; i < buffer->number; i++ ) {
+         if ( buffer->other.rxlist[i].fragment_offset == 0
+           || buffer->other.rxlist[i].state < FRAGMENT_PROCESSED ) {
+            continue;
+         }
+         start = (buffer->other.rxlist[i].fragment_offset<<3) - buffer->offset;
+         if ( start <= (int16_t)received
+           && start + buffer->other.rxlist[i].fragment_size > (int16_t)received ) {
+            received = start + buffer->other.rxlist[i].fragment_size;
+            grown    = TRUE;
+         }
+      }
+   } while ( grown );
+
+   return received;
+}
+
+/**
+\brief Free the received fragments of a forwarded datagram which have been
+       sent entirely.
+
+\param buffer The fragmentation buffer of the forwarded datagram.
+*/
+void fragment_releaseSent(FragmentQueueEntry_t* buffer) {
+   uint8_t  i;
+   int16_t  end;
+   uint16_t sent;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   sent = buffer->other.txdata.actual_sent;
+   for ( i = 0; i < buffer->number; i++ ) {
+      if ( buffer->other.rxlist[i].fragment_offset == 0
+        || buffer->other.rxlist[i].fragment == NULL ) {
+         continue;
+      }
+      end = (buffer->other.rxlist[i].fragment_offset<<3) - buffer->offset
+          + buffer->other.rxlist[i].fragment_size;
+      if ( end <= (int16_t)sent ) {
+         openmemory_freeMemory(buffer->other.rxlist[i].fragment);
+         buffer->other.rxlist[i].fragment = NULL;
+         buffer->other.rxlist[i].state    = FRAGMENT_FINISHED;
+      }
+   }
+   if ( buffer->other.fw_payload != NULL
+     && buffer->other.fw_length <= sent
+     && ! openmemory_sameMemoryArea(buffer->other.fw_payload, buffer->msg->packet) ) {
+      openmemory_freeMemory(buffer->other.fw_payload);
+      buffer->other.fw_payload = NULL;
+   }
+   ENABLE_INTERRUPTS();
+}
+
 /**
 \brief Request a new (free) fragment buffer.
 
@@ -798,9 +1083,12 @@ void fragment_resetBuffer(FragmentQueueEntry_t* buffer) {
    buffer->action        = FRAGMENT_ACTION_NONE;
    buffer->datagram_size = 0;
    buffer->number        = 0;
-   if ( buffer->in_use >= FRAGMENT_RX ) {
+   if ( buffer->other.rxlist != NULL ) {
       openmemory_freeMemory((uint8_t*)buffer->other.rxlist);
+      buffer->other.rxlist = NULL;
    }
+   buffer->other.fw_payload = NULL;
+   buffer->other.fw_busy    = FALSE;
 
    buffer->in_use = FRAGMENT_NONE;
 }
@@ -825,6 +1113,7 @@ OpenQueueEntry_t* fragment_restartBuffer(FragmentQueueEntry_t* buffer) {
       openmemory_freeMemory(buffer->payload);
       buffer->payload = NULL;
    }
+   buffer->other.fw_payload = NULL;
    buffer->in_use = FRAGMENT_RX;
    buffer->action = FRAGMENT_ACTION_NONE;
    pkt = buffer->msg;
@@ -859,6 +1148,7 @@ void fragment_timeout_timer_cb(opentimers_id_t id) {
    FragmentQueueEntry_t* buffer;
    OpenQueueEntry_t*     msg;
    bool                  openbridge;
+   bool                  busy;
    uint16_t              tag;
    uint16_t              size;
    open_addr_t           addr;
@@ -891,6 +1181,17 @@ void fragment_timeout_timer_cb(opentimers_id_t id) {
          opentimers_destroy(id);
 	 buffer->timerId = FRAGMENT_NOTIMER;
 
+	 // if forwarding, part of it may have been sent
+	 if ( buffer->in_use == FRAGMENT_FW ) {
+            buffer->action = FRAGMENT_ACTION_TIMEREXPIRED;
+            busy = buffer->other.fw_busy;
+            ENABLE_INTERRUPTS();
+            if ( ! busy ) {
+               fragment_finishSend(buffer, E_FAIL);
+            } // else once the fragment being sent is done
+            return;
+	 }
+
 	 msg = buffer->msg;
          openbridge = buffer->action == FRAGMENT_ACTION_OPENBRIDGE;
          if ( openbridge ) {
@@ -959,10 +1260,17 @@ void fragment_doCancel(FragmentQueueEntry_t* buffer) {
       return;
    }
 
+   if ( buffer->action == FRAGMENT_ACTION_TIMEREXPIRED ) {
+      // being freed, see fragment_sendDone
+      ENABLE_INTERRUPTS();
+      return;
+   }
    buffer->action = FRAGMENT_ACTION_CANCEL;
    received = buffer->number;
    ENABLE_INTERRUPTS();
-   for ( i = 0; i < received; i++ )
+   // fragments already sent are finished: the buffer may be freed before
+   // the last one is cancelled
+   for ( i = 0; i < received && buffer->in_use != FRAGMENT_NONE; i++ )
       fragment_cancel(buffer, i);
 }
 
@@ -989,9 +1297,11 @@ void fragment_cancel(FragmentQueueEntry_t* buffer, uint8_t frag) {
          ENABLE_INTERRUPTS();
          fragment_freeBuffer(buffer);
          openqueue_freePacketBuffer(msg);
-      } else { // Notify error to upper layer when forwarding
+      } else if ( ! buffer->other.fw_busy ) { // Notify error to upper layer when forwarding
          ENABLE_INTERRUPTS();
          fragment_finishSend(buffer, E_FAIL);
+      } else { // once the fragment being sent is done
+         ENABLE_INTERRUPTS();
       }
       return;
    }
@@ -1031,6 +1341,26 @@ void fragment_doAssemble(FragmentQueueEntry_t* buffer, FragmentAction action) {
                   - buffer->msg->length;
    received = buffer->datagram_size - buffer->offset;
 
+   if ( action == FRAGMENT_ACTION_FORWARD ) {
+      // no reassembly: frames are gathered from the fragments, as they come
+      buffer->other.fw_payload = buffer->msg->payload;
+      buffer->other.fw_length  = buffer->msg->length;
+      buffer->other.fw_hsize   = buffer->msg->length - buffer->msg->l4_length;
+      buffer->msg->length = received;
+      buffer->in_use = FRAGMENT_FW;
+      buffer->action = action;
+      // pending fragments, if any, are ready to be sent
+      for ( i = 0; i < buffer->number; i++ ) {
+         if ( buffer->other.rxlist[i].state == FRAGMENT_RECEIVED ) {
+            buffer->other.rxlist[i].state = FRAGMENT_PROCESSED;
+         }
+      }
+      ENABLE_INTERRUPTS();
+
+      fragment_startSend(buffer);
+      return;
+   }
+
    // reserve memory for assembled message
    auxPacket = openmemory_getMemory(received + FRAME_DATA_NODATA + IEEE802154_SECURITY_TAG_LEN);
    if ( auxPacket == NULL ) {
@@ -1052,12 +1382,7 @@ void fragment_doAssemble(FragmentQueueEntry_t* buffer, FragmentAction action) {
    // update data
    buffer->other.rxlist[frag1].state = FRAGMENT_FINISHED;
    buffer->msg->length = received;
-   if ( action == FRAGMENT_ACTION_FORWARD ) {
-      buffer->in_use = FRAGMENT_FW;
-      buffer->action = action;
-   } else {
-      buffer->action = FRAGMENT_ACTION_ASSEMBLE;
-   }
+   buffer->action = FRAGMENT_ACTION_ASSEMBLE;
    received = buffer->number;
    ENABLE_INTERRUPTS();
 
@@ -1077,6 +1402,16 @@ void fragment_assemble(FragmentQueueEntry_t* buffer, uint8_t frag) {
 
    // Assemble
    DISABLE_INTERRUPTS();
+   if ( buffer->in_use == FRAGMENT_FW ) {
+      // forwarding: keep it where it is until it is sent, see
+      // fragment_cutThrough
+      if ( buffer->other.rxlist[frag].state == FRAGMENT_RECEIVED ) {
+         buffer->other.rxlist[frag].state = FRAGMENT_PROCESSED;
+      }
+      ENABLE_INTERRUPTS();
+      fragment_cutThrough(buffer);
+      return;
+   }
    if ( buffer->other.rxlist[frag].state == FRAGMENT_RECEIVED ) {
       memcpy(buffer->payload - buffer->offset
                              +(buffer->other.rxlist[frag].fragment_offset<<3),
@@ -1088,20 +1423,13 @@ void fragment_assemble(FragmentQueueEntry_t* buffer, uint8_t frag) {
    }
 
    if ( fragment_completeRX(buffer, FRAGMENT_FINISHED) ) {
-      if ( buffer->in_use == FRAGMENT_FW ) {
-         openmemory_freeMemory((uint8_t*)buffer->other.rxlist);
-         buffer->in_use = FRAGMENT_TX;
-         ENABLE_INTERRUPTS();
-         fragment_startSend(buffer);
-      } else { // not forwarding
-         msg = buffer->msg;
-	 openmemory_freeMemory(msg->packet);
-	 msg->payload = buffer->payload;
-         msg->packet  = openmemory_firstSegmentAddr(msg->payload);
-         ENABLE_INTERRUPTS();
-         fragment_freeBuffer(buffer);
-         forwarding_toUpperLayer(msg);
-      }
+      msg = buffer->msg;
+      openmemory_freeMemory(msg->packet);
+      msg->payload = buffer->payload;
+      msg->packet  = openmemory_firstSegmentAddr(msg->payload);
+      ENABLE_INTERRUPTS();
+      fragment_freeBuffer(buffer);
+      forwarding_toUpperLayer(msg);
       return;
    }
    ENABLE_INTERRUPTS();
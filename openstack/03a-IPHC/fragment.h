@@ -90,15 +90,26 @@ typedef struct {
    uint8_t*          fragment; // msg->payload (not for FRAG1);
 } FragmentOffsetEntry_t;
 
-typedef union {
+typedef struct {
    // Data to track outgoing fragmented messages
    struct {
       uint8_t  max_fragment_size;
       uint16_t actual_sent;       // data sent
       uint8_t  size;              // next fragment size
       bool     fragn;             // True if not first fragment
+      uint16_t datagram_size;     // sent datagram, differs from the
+      uint16_t datagram_tag;      // received one when forwarding
    } txdata;
+   // Data to track incoming fragments, kept while forwarding
    FragmentOffsetEntry_t* rxlist;
+   // A forwarded datagram is not reassembled: it is cut through, each part
+   // of it is sent to the next hop, under a new tag, as soon as it has been
+   // received. Only the fragments not sent yet are kept, FRAG1 (as rewritten
+   // by IPHC) and the FRAGN fragments of rxlist.
+   uint8_t*  fw_payload;         // FRAG1 payload, NULL once sent
+   uint8_t   fw_length;          // FRAG1 payload length
+   uint8_t   fw_hsize;           // headers, all in the first fragment sent
+   bool      fw_busy;            // a fragment is being sent
 } FragmentOtherData_t;
 
 typedef struct FragmentQueueEntry {
@@ -19,6 +19,8 @@ static const uint8_t dagroot_mac64b[]   = {0x02,
    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01
 }; 
 
+iphc_vars_t iphc_vars;
+
 #ifdef DEADLINE_OPTION_ENABLED
     static monitor_expiration_vars_t  monitor_expiration_vars;
 #endif
@@ -45,6 +47,16 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t* temp_addr_16b,
    ipv6_header_iht*     ipv6_header,
    uint8_t              previousLen);
 
+//===== flow cache
+bool iphc_findFlow(
+   OpenQueueEntry_t*    msg,
+   uint8_t*             flowIndex
+);
+void iphc_cacheFlowIPv6Header(
+   OpenQueueEntry_t*    msg,
+   uint16_t             length
+);
+
 //===== IPv6 hop-by-hop header
 void iphc_prependIPv6HopByHopHeader(
    OpenQueueEntry_t*    msg,
@@ -66,6 +78,7 @@ uint8_t iphc_getAsnLen(
 //=========================== public ==========================================
 
 void      iphc_init() {
+   memset(&iphc_vars,0,sizeof(iphc_vars_t));
 }
 
 // send from upper layer: I need to add 6LoWPAN header
@@ -88,9 +101,14 @@ owerror_t iphc_sendFromForwarding(
     open_addr_t  temp_src_mac64b;
     open_addr_t  temp_dagroot_ip128b;
     uint8_t      sam;
+    uint16_t     length;
+    uint8_t      flowIndex;
+    bool         isCached;
 #ifndef DO_NOT_USE_FRAGMENTATION
     FragmentQueueEntry_t* buffer;
 #endif
+    INTERRUPT_DECLARATION();
+
     // take ownership over the packet
     msg->owner = COMPONENT_IPHC;
    
@@ -127,68 +145,108 @@ owerror_t iphc_sendFromForwarding(
         }
     }
    
-    packetfunctions_ip128bToMac64b(&(msg->l3_destinationAdd),&temp_dest_prefix,&temp_dest_mac64b);
-    //xv poipoi -- get the src prefix as well
-    packetfunctions_ip128bToMac64b(&(msg->l3_sourceAdd),&temp_src_prefix,&temp_src_mac64b);
-    //XV -poipoi we want to check if the source address prefix is the same as destination prefix
-    if (packetfunctions_sameAddress(&temp_dest_prefix,&temp_src_prefix)) {
-        sam = IPHC_SAM_64B;    // no ipinip 6loRH if in the same prefix
-    } else {
-        //not the same prefix. so the packet travels to another network
-        //check if this is a source routing pkt. in case it is then the DAM is elided as it is in the SrcRouting header.
-        if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd))==FALSE){
-            // ip in ip will be presented
-            sam = IPHC_SAM_128B;
-        } else {
-            // this is DIO, source address elided, multicast bit is set
-            sam = IPHC_SAM_ELIDED;
+    // a packet of a flow sent before reuses the IPinIP 6LoRH of the flow
+    isCached = FALSE;
+    if (fw_SendOrfw_Rcv==PCKTSEND) {
+        DISABLE_INTERRUPTS();
+        if (
+            iphc_findFlow(msg,&flowIndex) &&
+            iphc_vars.flowCache[flowIndex].ipinipLength!=IPHC_FLOW_UNKNOWN
+        ) {
+            if (iphc_vars.flowCache[flowIndex].ipinipLength>0) {
+                packetfunctions_reserveHeaderSize(msg,iphc_vars.flowCache[flowIndex].ipinipLength);
+                memcpy(
+                    msg->payload,
+                    iphc_vars.flowCache[flowIndex].ipinip,
+                    iphc_vars.flowCache[flowIndex].ipinipLength
+                );
+                // patch the hop limit
+                msg->payload[2] = ipv6_outer_header->hop_limit;
+            }
+            isCached = TRUE;
         }
+        ENABLE_INTERRUPTS();
     }
 
-    //IPinIP 6LoRH will be added at here if necessary.
-    if (packetfunctions_sameAddress(&temp_dest_prefix,&temp_src_prefix)){
-        // same network, IPinIP is elided
-    } else {
-        if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd))==FALSE){
-          memset(&(temp_dagroot_ip128b),0,sizeof(open_addr_t));
-          packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX),(open_addr_t*)dagroot_mac64b,&(temp_dagroot_ip128b));
-            if (
-                (
-                  ipv6_outer_header->src.type == ADDR_NONE &&
-                  packetfunctions_sameAddress(&(msg->l3_sourceAdd),&(temp_dagroot_ip128b))
-                ) || 
-                (
-                  ipv6_outer_header->src.type != ADDR_NONE &&
-                  packetfunctions_sameAddress(&(ipv6_outer_header->src),&(temp_dagroot_ip128b))
-                 )
-            ){
-                // hop limit
-                packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
-                *((uint8_t*)(msg->payload)) = ipv6_outer_header->hop_limit;
-                // type
-                packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
-                *((uint8_t*)(msg->payload)) = IPECAP_6LOTH_TYPE;
-                // length 
-                packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
-                *((uint8_t*)(msg->payload)) = ELECTIVE_6LoRH | 1;
+    if (isCached==FALSE) {
+        length = msg->length;
+        packetfunctions_ip128bToMac64b(&(msg->l3_destinationAdd),&temp_dest_prefix,&temp_dest_mac64b);
+        //xv poipoi -- get the src prefix as well
+        packetfunctions_ip128bToMac64b(&(msg->l3_sourceAdd),&temp_src_prefix,&temp_src_mac64b);
+        //XV -poipoi we want to check if the source address prefix is the same as destination prefix
+        if (packetfunctions_sameAddress(&temp_dest_prefix,&temp_src_prefix)) {
+            sam = IPHC_SAM_64B;    // no ipinip 6loRH if in the same prefix
+        } else {
+            //not the same prefix. so the packet travels to another network
+            //check if this is a source routing pkt. in case it is then the DAM is elided as it is in the SrcRouting header.
+            if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd))==FALSE){
+                // ip in ip will be presented
+                sam = IPHC_SAM_128B;
+            } else {
+                // this is DIO, source address elided, multicast bit is set
+                sam = IPHC_SAM_ELIDED;
             }
-            else {
-                if (sam == IPHC_SAM_128B){
-                    // encapsulate address
-                    packetfunctions_writeAddress(msg, &(msg->l3_sourceAdd),OW_BIG_ENDIAN);
-                    // hoplim
+        }
+
+        //IPinIP 6LoRH will be added at here if necessary.
+        if (packetfunctions_sameAddress(&temp_dest_prefix,&temp_src_prefix)){
+            // same network, IPinIP is elided
+        } else {
+            if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd))==FALSE){
+              memset(&(temp_dagroot_ip128b),0,sizeof(open_addr_t));
+              packetfunctions_mac64bToIp128b(idmanager_getMyID(ADDR_PREFIX),(open_addr_t*)dagroot_mac64b,&(temp_dagroot_ip128b));
+                if (
+                    (
+                      ipv6_outer_header->src.type == ADDR_NONE &&
+                      packetfunctions_sameAddress(&(msg->l3_sourceAdd),&(temp_dagroot_ip128b))
+                    ) || 
+                    (
+                      ipv6_outer_header->src.type != ADDR_NONE &&
+                      packetfunctions_sameAddress(&(ipv6_outer_header->src),&(temp_dagroot_ip128b))
+                     )
+                ){
+                    // hop limit
                     packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
                     *((uint8_t*)(msg->payload)) = ipv6_outer_header->hop_limit;
                     // type
                     packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
                     *((uint8_t*)(msg->payload)) = IPECAP_6LOTH_TYPE;
-                    // length
+                    // length 
                     packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
-                    *((uint8_t*)(msg->payload)) = ELECTIVE_6LoRH | 17;
+                    *((uint8_t*)(msg->payload)) = ELECTIVE_6LoRH | 1;
+                }
+                else {
+                    if (sam == IPHC_SAM_128B){
+                        // encapsulate address
+                        packetfunctions_writeAddress(msg, &(msg->l3_sourceAdd),OW_BIG_ENDIAN);
+                        // hoplim
+                        packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
+                        *((uint8_t*)(msg->payload)) = ipv6_outer_header->hop_limit;
+                        // type
+                        packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
+                        *((uint8_t*)(msg->payload)) = IPECAP_6LOTH_TYPE;
+                        // length
+                        packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
+                        *((uint8_t*)(msg->payload)) = ELECTIVE_6LoRH | 17;
+                    }
                 }
+            } else {
+                // this is DIO, no IPinIP either
             }
-        } else {
-            // this is DIO, no IPinIP either
+        }
+
+        // remember the IPinIP 6LoRH of the flow, the IPHC header was cached first
+        if (fw_SendOrfw_Rcv==PCKTSEND && msg->length-length<=IPHC_FLOW_MAXIPINIPLEN) {
+            DISABLE_INTERRUPTS();
+            if (iphc_findFlow(msg,&flowIndex)) {
+                iphc_vars.flowCache[flowIndex].ipinipLength = (uint8_t)(msg->length-length);
+                memcpy(
+                    iphc_vars.flowCache[flowIndex].ipinip,
+                    msg->payload,
+                    iphc_vars.flowCache[flowIndex].ipinipLength
+                );
+            }
+            ENABLE_INTERRUPTS();
         }
     }
     
@@ -382,7 +440,10 @@ owerror_t iphc_prependIPv6Header(
       uint8_t           fw_SendOrfw_Rcv
    ) {
    
-   uint8_t temp_8b;
+   uint8_t  temp_8b;
+   uint16_t length;
+   
+   length = msg->length;
    
    // destination address
    switch (dam) {
@@ -601,9 +662,48 @@ owerror_t iphc_prependIPv6Header(
    packetfunctions_reserveHeaderSize(msg,sizeof(uint8_t));
    *((uint8_t*)(msg->payload)) = temp_8b;
    
+   // the next packets of the flow copy this header, when nothing in it changes per packet
+   if (fw_SendOrfw_Rcv==PCKTSEND && tf==IPHC_TF_ELIDED && hlim!=IPHC_HLIM_INLINE) {
+      iphc_cacheFlowIPv6Header(msg,msg->length-length);
+   }
+   
    return E_SUCCESS;
 }
 
+/**
+\brief Prepend the IPv6 header cached for the flow of a message.
+
+The flow is that of a packet this mote sent before, with the same addresses
+and next header. The ports are not part of it, as openudp compresses them
+before the IPv6 header is prepended.
+
+\param[in,out] msg The message to send, with its addresses set.
+\param[out]    sam The source address mode of the cached header.
+
+\returns TRUE when the header was prepended, FALSE when the flow is not cached
+   and the header is to be built with iphc_prependIPv6Header().
+*/
+bool iphc_prependFlowIPv6Header(OpenQueueEntry_t* msg, uint8_t* sam) {
+   uint8_t flowIndex;
+   bool    isCached;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   isCached = iphc_findFlow(msg,&flowIndex);
+   if (isCached) {
+      packetfunctions_reserveHeaderSize(msg,iphc_vars.flowCache[flowIndex].iphcLength);
+      memcpy(
+         msg->payload,
+         iphc_vars.flowCache[flowIndex].iphc,
+         iphc_vars.flowCache[flowIndex].iphcLength
+      );
+      *sam = (iphc_vars.flowCache[flowIndex].iphc[1]>>IPHC_SAM) & 0x03;
+   }
+   ENABLE_INTERRUPTS();
+   
+   return isCached;
+}
+
 /**
 \brief Retrieve an IPv6 header from a message.
 */
@@ -1115,6 +1215,74 @@ uint8_t iphc_retrieveIphcHeader(open_addr_t* temp_addr_16b,
     return page;
 }
 
+//===== flow cache
+
+/**
+\brief Find the flow cache entry of a message.
+
+\note Call with interrupts disabled.
+
+\param[in]  msg       The message to send.
+\param[out] flowIndex The index of its entry in the flow cache.
+
+\returns TRUE when the flow of the message is cached.
+*/
+bool iphc_findFlow(OpenQueueEntry_t* msg, uint8_t* flowIndex) {
+   uint8_t      i;
+   iphc_flow_t* flow;
+   
+   for (i=0;i<IPHC_FLOWCACHE_SIZE;i++) {
+      flow = &(iphc_vars.flowCache[i]);
+      if (
+         flow->used                                              &&
+         flow->l4_protocol==msg->l4_protocol                     &&
+         flow->l4_protocol_compressed==msg->l4_protocol_compressed &&
+         memcmp(flow->dest,msg->l3_destinationAdd.addr_128b,16)==0 &&
+         memcmp(flow->src,msg->l3_sourceAdd.addr_128b,16)==0
+      ) {
+         *flowIndex = i;
+         return TRUE;
+      }
+   }
+   return FALSE;
+}
+
+/**
+\brief Cache the IPHC header just prepended to a message, for its flow.
+
+The IPinIP 6LoRH of the flow is cached by iphc_sendFromForwarding(), once the
+first packet of the flow goes through it. The oldest entry makes room for a
+new flow.
+
+\param[in] msg    The message, the IPHC header at its payload.
+\param[in] length The length of the IPHC header.
+*/
+void iphc_cacheFlowIPv6Header(OpenQueueEntry_t* msg, uint16_t length) {
+   uint8_t      flowIndex;
+   iphc_flow_t* flow;
+   INTERRUPT_DECLARATION();
+   
+   if (length>IPHC_FLOW_MAXIPHCLEN) {
+      return;
+   }
+   
+   DISABLE_INTERRUPTS();
+   if (iphc_findFlow(msg,&flowIndex)==FALSE) {
+      flowIndex                 = iphc_vars.flowCacheNext;
+      iphc_vars.flowCacheNext   = (iphc_vars.flowCacheNext+1)%IPHC_FLOWCACHE_SIZE;
+   }
+   flow = &(iphc_vars.flowCache[flowIndex]);
+   flow->used                   = TRUE;
+   memcpy(flow->dest,msg->l3_destinationAdd.addr_128b,16);
+   memcpy(flow->src,msg->l3_sourceAdd.addr_128b,16);
+   flow->l4_protocol            = msg->l4_protocol;
+   flow->l4_protocol_compressed = msg->l4_protocol_compressed;
+   flow->iphcLength             = (uint8_t)length;
+   memcpy(flow->iphc,msg->payload,length);
+   flow->ipinipLength           = IPHC_FLOW_UNKNOWN;
+   ENABLE_INTERRUPTS();
+}
+
 //===== IPv6 hop-by-hop header
 
 /**
@@ -16,6 +16,11 @@
 #define IPv6HOP_HDR_LEN           2  // tengfei: should be 2
 #define MAXNUM_RH3                3
 
+#define IPHC_FLOWCACHE_SIZE       4  // number of flows the compressed headers are cached for
+#define IPHC_FLOW_MAXIPHCLEN      35 // dispatch, two 128b addresses and next header
+#define IPHC_FLOW_MAXIPINIPLEN    19 // 6LoRH, type, hop limit and 128b source
+#define IPHC_FLOW_UNKNOWN         0xff
+
 enum IPHC_enums {
    IPHC_DISPATCH             = 5,
    IPHC_TF                   = 3,
@@ -246,6 +251,30 @@ typedef struct {
 	 uint16_t		time_elapsed;
 } monitor_expiration_vars_t;
 
+/**
+\brief Compressed headers of a flow this mote sends.
+
+The headers only depend on the addresses and on the next header, so the
+packets of a flow reuse the bytes computed for its first packet. A change of
+prefix or of EUI64 changes the source address, hence the flow.
+*/
+typedef struct {
+   bool       used;
+   uint8_t    dest[16];                           ///< 128b IPv6 destination.
+   uint8_t    src[16];                            ///< 128b IPv6 source.
+   uint8_t    l4_protocol;
+   bool       l4_protocol_compressed;
+   uint8_t    iphcLength;                         ///< length of the IPHC header.
+   uint8_t    iphc[IPHC_FLOW_MAXIPHCLEN];         ///< IPHC header, as prepended.
+   uint8_t    ipinipLength;                       ///< length of the IPinIP 6LoRH, IPHC_FLOW_UNKNOWN until sent once.
+   uint8_t    ipinip[IPHC_FLOW_MAXIPINIPLEN];     ///< IPinIP 6LoRH, as prepended, with the hop limit to patch.
+} iphc_flow_t;
+
+typedef struct {
+   iphc_flow_t flowCache[IPHC_FLOWCACHE_SIZE];
+   uint8_t     flowCacheNext;                     ///< next entry to evict, round robin.
+} iphc_vars_t;
+
 //=========================== variables =======================================
 
 //=========================== prototypes ======================================
@@ -286,6 +315,10 @@ owerror_t iphc_prependIPv6Header(
    open_addr_t*         value_src,
    uint8_t              fw_SendOrfw_Rcv
 );
+bool iphc_prependFlowIPv6Header(
+   OpenQueueEntry_t*    msg,
+   uint8_t*             sam
+);
 uint8_t iphc_retrieveIPv6HopByHopHeader(
    OpenQueueEntry_t*    msg,
    rpl_option_ht*       rpl_option
@@ -148,61 +148,65 @@ owerror_t forwarding_send(OpenQueueEntry_t* msg) {
     );
 #endif    
 
-    packetfunctions_ip128bToMac64b(&(msg->l3_destinationAdd),&temp_dest_prefix,&temp_dest_mac64b);
-    //xv poipoi -- get the src prefix as well
-    packetfunctions_ip128bToMac64b(&(msg->l3_sourceAdd),&temp_src_prefix,&temp_src_mac64b);
-    //XV -poipoi we want to check if the source address prefix is the same as destination prefix
-    if (packetfunctions_sameAddress(&temp_dest_prefix,&temp_src_prefix)) {
-         // same prefix use 64B address
-         sam = IPHC_SAM_64B;
-         dam = IPHC_DAM_64B;
-         p_dest = &temp_dest_mac64b;      
-         p_src  = &temp_src_mac64b; 
-    } else {
-        //not the same prefix. so the packet travels to another network
-        //check if this is a source routing pkt. in case it is then the DAM is elided as it is in the SrcRouting header.
-        if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd))==FALSE){
-            sam = IPHC_SAM_128B;
-            dam = IPHC_DAM_128B;
-            p_dest = &(msg->l3_destinationAdd);
-            p_src = &(msg->l3_sourceAdd);
-            
-            ipv6_outer_header.src.type = ADDR_128B;
-            memcpy(&ipv6_outer_header.src,p_src,sizeof(open_addr_t));
-            ipv6_outer_header.hop_limit = IPHC_DEFAULT_HOP_LIMIT;
+    // the packets of a flow sent before copy the IPHC header of the flow
+    if (iphc_prependFlowIPv6Header(msg,&sam)==FALSE) {
+        packetfunctions_ip128bToMac64b(&(msg->l3_destinationAdd),&temp_dest_prefix,&temp_dest_mac64b);
+        //xv poipoi -- get the src prefix as well
+        packetfunctions_ip128bToMac64b(&(msg->l3_sourceAdd),&temp_src_prefix,&temp_src_mac64b);
+        //XV -poipoi we want to check if the source address prefix is the same as destination prefix
+        if (packetfunctions_sameAddress(&temp_dest_prefix,&temp_src_prefix)) {
+             // same prefix use 64B address
+             sam = IPHC_SAM_64B;
+             dam = IPHC_DAM_64B;
+             p_dest = &temp_dest_mac64b;      
+             p_src  = &temp_src_mac64b; 
         } else {
-           // this is DIO, source address elided, multicast bit is set
-            sam = IPHC_SAM_ELIDED;
-            m   = IPHC_M_YES;
-            dam = IPHC_DAM_ELIDED;
-            p_dest = &(msg->l3_destinationAdd);
-            p_src = &(msg->l3_sourceAdd);
+            //not the same prefix. so the packet travels to another network
+            //check if this is a source routing pkt. in case it is then the DAM is elided as it is in the SrcRouting header.
+            if (packetfunctions_isBroadcastMulticast(&(msg->l3_destinationAdd))==FALSE){
+                sam = IPHC_SAM_128B;
+                dam = IPHC_DAM_128B;
+                p_dest = &(msg->l3_destinationAdd);
+                p_src = &(msg->l3_sourceAdd);
+            } else {
+               // this is DIO, source address elided, multicast bit is set
+                sam = IPHC_SAM_ELIDED;
+                m   = IPHC_M_YES;
+                dam = IPHC_DAM_ELIDED;
+                p_dest = &(msg->l3_destinationAdd);
+                p_src = &(msg->l3_sourceAdd);
+            }
         }
-    }
-    //IPHC inner header and NHC IPv6 header will be added at here
+        //IPHC inner header and NHC IPv6 header will be added at here
 
-    if (msg->l4_protocol_compressed){
-        next_header = IPHC_NH_COMPRESSED;
-    }else{
-        next_header = IPHC_NH_INLINE;
+        if (msg->l4_protocol_compressed){
+            next_header = IPHC_NH_COMPRESSED;
+        }else{
+            next_header = IPHC_NH_INLINE;
+        }
+        iphc_prependIPv6Header(msg,
+                    IPHC_TF_ELIDED,
+                    flow_label, // value_flowlabel
+                    next_header,
+                    msg->l4_protocol, // value nh. If compressed this is ignored as LOWPAN_NH is already there.
+                    IPHC_HLIM_64,
+                    ipv6_outer_header.hop_limit,
+                    IPHC_CID_NO,
+                    sac,
+                    sam,
+                    m,
+                    dac,
+                    dam,
+                    p_dest,
+                    p_src,            
+                    PCKTSEND  
+                    );
+    }
+    if (sam==IPHC_SAM_128B) {
+        // the packet travels to another network, in IPinIP
+        memcpy(&ipv6_outer_header.src,&(msg->l3_sourceAdd),sizeof(open_addr_t));
+        ipv6_outer_header.hop_limit = IPHC_DEFAULT_HOP_LIMIT;
     }
-    iphc_prependIPv6Header(msg,
-                IPHC_TF_ELIDED,
-                flow_label, // value_flowlabel
-                next_header,
-                msg->l4_protocol, // value nh. If compressed this is ignored as LOWPAN_NH is already there.
-                IPHC_HLIM_64,
-                ipv6_outer_header.hop_limit,
-                IPHC_CID_NO,
-                sac,
-                sam,
-                m,
-                dac,
-                dam,
-                p_dest,
-                p_src,            
-                PCKTSEND  
-                );
     // both of them are compressed
     ipv6_outer_header.next_header_compressed = TRUE;
 
@@ -282,6 +286,7 @@ void forwarding_receive(
     ) {
     uint8_t flags;
     uint16_t senderRank;
+    bool isLoop;
 #ifndef DO_NOT_USE_FRAGMENTATION
     FragmentQueueEntry_t* buffer;
 #endif
@@ -341,7 +346,7 @@ void forwarding_receive(
         // this packet is not for me: relay
       
         // change the creator of the packet
-        msg->creator = COMPONENT_FORWARDING;
+        openqueue_setCreator(msg,COMPONENT_FORWARDING);
         
 #ifdef DEADLINE_OPTION_ENABLED
         if (deadline_option != NULL) {       
@@ -392,7 +397,13 @@ void forwarding_receive(
         if (ipv6_outer_header->next_header!=IANA_IPv6ROUTE) {
             flags = rpl_option->flags;
             senderRank = rpl_option->senderRank;
+            // going up the DODAG, the sender is below me
+            isLoop = senderRank < icmpv6rpl_getMyDAGrank();
             if ((flags & O_FLAG)!=0){
+#ifdef RPL_STORING_MODE
+                // going down the DODAG, the sender is above me
+                isLoop = senderRank > icmpv6rpl_getMyDAGrank();
+#else
                 // wrong direction
                 // log error
                 openserial_printError(
@@ -401,8 +412,9 @@ void forwarding_receive(
                     (errorparameter_t)flags,
                     (errorparameter_t)senderRank
                 );
+#endif
             }
-            if (senderRank < icmpv6rpl_getMyDAGrank()){
+            if (isLoop){
                 // loop detected
                 // set flag
                 rpl_option->flags |= R_FLAG;
@@ -519,6 +531,10 @@ void forwarding_getNextHop(open_addr_t* destination128b, open_addr_t* addressToW
    } else if (neighbors_isStableNeighbor(destination128b)) {
       // IP destination is 1-hop neighbor, send directly
       packetfunctions_ip128bToMac64b(destination128b,&temp_prefix64btoWrite,addressToWrite64b);
+#ifdef RPL_STORING_MODE
+   } else if (icmpv6rpl_getDownwardNextHop(destination128b,addressToWrite64b)) {
+      // IP destination is in my sub-DODAG, send down to the child it was advertised by
+#endif
    } else {
       // destination is remote, send to preferred parent
       icmpv6rpl_getPreferredParentEui64(addressToWrite64b);
@@ -560,6 +576,27 @@ owerror_t forwarding_send_internal_RoutingTable(
       return E_FAIL;
    }
    
+#ifdef RPL_STORING_MODE
+   // flag the packets going down the DODAG, for the loop detection
+   if (
+         packetfunctions_isBroadcastMulticast(&(msg->l2_nextORpreviousHop))==FALSE &&
+         icmpv6rpl_isPreferredParent(&(msg->l2_nextORpreviousHop))==FALSE
+      ) {
+      rpl_option->flags |= O_FLAG;
+   } else if ((rpl_option->flags & O_FLAG)!=0 && fw_SendOrfw_Rcv==PCKTFORWARD) {
+      // no route down to the destination, sending it back up would loop
+      openserial_printError(
+         COMPONENT_FORWARDING,
+         ERR_NO_NEXTHOP,
+         (errorparameter_t)1,
+         (errorparameter_t)0
+      );
+      return E_FAIL;
+   } else {
+      rpl_option->flags &= ~O_FLAG;
+   }
+#endif
+   
    if (ipv6_outer_header->src.type != ADDR_NONE){
       packetfunctions_tossHeader(msg,ipv6_outer_header->header_length);
    }
@@ -10,6 +10,8 @@
 #include "idmanager.h"
 #include "opentimers.h"
 #include "IEEE802154E.h"
+#include "opentelemetry.h"
+#include "sixtop.h"
 
 //=========================== variables =======================================
 
@@ -20,11 +22,21 @@ icmpv6rpl_vars_t             icmpv6rpl_vars;
 // DIO-related
 void icmpv6rpl_timer_DIO_cb(opentimers_id_t id);
 void icmpv6rpl_timer_DIO_task(void);
+void icmpv6rpl_startDIOTrickle(void);
+void icmpv6rpl_indicateInconsistency(void);
 void sendDIO(void);
+void sendDIS(void);
 // DAO-related
 void icmpv6rpl_timer_DAO_cb(opentimers_id_t id);
 void icmpv6rpl_timer_DAO_task(void);
 void sendDAO(void);
+#ifdef RPL_STORING_MODE
+// downward routes
+void icmpv6rpl_indicateRxDAO(OpenQueueEntry_t* msg);
+void icmpv6rpl_updateRoutes(uint8_t* options, uint8_t* end, open_addr_t* nextHop, uint8_t pathLifetime);
+void icmpv6rpl_updateRoute(uint8_t* target, open_addr_t* nextHop, uint8_t lifetime);
+void icmpv6rpl_ageRoutes(void);
+#endif
 
 //=========================== public ==========================================
 
@@ -41,6 +53,9 @@ void icmpv6rpl_init() {
    //===== reset local variables
    memset(&icmpv6rpl_vars,0,sizeof(icmpv6rpl_vars_t));
    
+   // status reported over serial
+   opentelemetry_registerCounters(STATUS_DAGRANK,(uint8_t*)&icmpv6rpl_vars.myDAGrank,sizeof(dagrank_t),OPENTELEMETRY_PERIOD_ALWAYS);
+   
    //=== routing
    icmpv6rpl_vars.haveParent=FALSE;
    icmpv6rpl_vars.daoSent=FALSE;
@@ -80,7 +95,6 @@ void icmpv6rpl_init() {
    icmpv6rpl_vars.dioDestination.type = ADDR_128B;
    memcpy(&icmpv6rpl_vars.dioDestination.addr_128b[0],all_routers_multicast,sizeof(all_routers_multicast));
    
-   icmpv6rpl_vars.dioPeriod                 = TIMER_DIO_TIMEOUT;
    icmpv6rpl_vars.timerIdDIO                = opentimers_create();
 
    //initialize PIO -> move this to dagroot code
@@ -118,13 +132,7 @@ void icmpv6rpl_init() {
    icmpv6rpl_vars.conf.defLifetime = 0xff; //infinite - limit for DAO period  -> 0xff 
    icmpv6rpl_vars.conf.lifetimeUnit = 0xffff; // 0xffff
    
-   opentimers_scheduleIn(
-       icmpv6rpl_vars.timerIdDIO,
-       872 +(openrandom_get16b()&0xff),
-       TIME_MS,
-       TIMER_ONESHOT,
-       icmpv6rpl_timer_DIO_cb
-   );
+   icmpv6rpl_startDIOTrickle();
 
    //=== DAO
    
@@ -166,6 +174,10 @@ void icmpv6rpl_init() {
    icmpv6rpl_vars.dao_target.prefixLength = 0;
    
    icmpv6rpl_vars.daoPeriod                 = TIMER_DAO_TIMEOUT;
+#ifdef RPL_STORING_MODE
+   icmpv6rpl_vars.daoTargetIdx              = ICMPV6RPL_MAXROUTES+1; // no DAO pending
+   icmpv6rpl_vars.daoNoPath                 = FALSE;
+#endif
    icmpv6rpl_vars.timerIdDAO                = opentimers_create();
    opentimers_scheduleIn(
        icmpv6rpl_vars.timerIdDAO,
@@ -213,6 +225,7 @@ owerror_t icmpv6rpl_getRPLDODAGid(uint8_t* address_128b){
 \param[in] error Outcome of the sending.
 */
 void icmpv6rpl_sendDone(OpenQueueEntry_t* msg, owerror_t error) {
+   bool isDAO;
    
    // take ownership over that packet
    msg->owner = COMPONENT_ICMPv6RPL;
@@ -225,7 +238,8 @@ void icmpv6rpl_sendDone(OpenQueueEntry_t* msg, owerror_t error) {
    }
    
    // I'm not busy sending DIO/DAO anymore
-   if (packetfunctions_isBroadcastMulticast(&(msg->l2_nextORpreviousHop))){
+   isDAO = packetfunctions_isBroadcastMulticast(&(msg->l2_nextORpreviousHop))==FALSE;
+   if (isDAO==FALSE){
         icmpv6rpl_vars.busySendingDIO = FALSE;
    } else {
         icmpv6rpl_vars.busySendingDAO = FALSE;
@@ -233,6 +247,17 @@ void icmpv6rpl_sendDone(OpenQueueEntry_t* msg, owerror_t error) {
    
    // free packet
    openqueue_freePacketBuffer(msg);
+   
+#ifdef RPL_STORING_MODE
+   // advertise the targets which did not fit in that DAO, or those to the
+   // new parent after the No-Path DAOs to the previous one
+   if (
+      isDAO &&
+      (icmpv6rpl_vars.daoTargetIdx<=ICMPV6RPL_MAXROUTES || icmpv6rpl_vars.daoNoPath)
+   ) {
+      sendDAO();
+   }
+#endif
 }
 
 /**
@@ -255,7 +280,8 @@ void icmpv6rpl_receive(OpenQueueEntry_t* msg) {
    // handle message
    switch (icmpv6code) {
       case IANA_ICMPv6_RPL_DIS:
-         icmpv6rpl_timer_DIO_task();
+         // a neighbor is looking for a DODAG, advertise it again quickly
+         opentrickle_reset(&icmpv6rpl_vars.dioTrickle);
          break;
       case IANA_ICMPv6_RPL_DIO:
          if (idmanager_getIsDAGroot()==TRUE) {
@@ -268,10 +294,15 @@ void icmpv6rpl_receive(OpenQueueEntry_t* msg) {
          break;
       
       case IANA_ICMPv6_RPL_DAO:
+#ifdef RPL_STORING_MODE
+         // a child advertises the motes reachable through it
+         icmpv6rpl_indicateRxDAO(msg);
+#else
          // this should never happen
          openserial_printError(COMPONENT_ICMPv6RPL,ERR_UNEXPECTED_DAO,
                                (errorparameter_t)0,
                                (errorparameter_t)0);
+#endif
          break;
       default:
          // this should never happen
@@ -354,6 +385,9 @@ Meant for direct control from command on serial port or from test application,
 bypassing the routing protocol!
 */
 void icmpv6rpl_setMyDAGrank(dagrank_t rank){
+    if (rank/MINHOPRANKINCREASE!=icmpv6rpl_vars.myDAGrank/MINHOPRANKINCREASE) {
+        icmpv6rpl_indicateInconsistency();
+    }
     icmpv6rpl_vars.myDAGrank = rank;
 }
 
@@ -361,13 +395,15 @@ void icmpv6rpl_setMyDAGrank(dagrank_t rank){
 \brief Routing algorithm
 */
 void icmpv6rpl_updateMyDAGrankAndParentSelection() {
-    uint8_t   i;
+    dagrank_t entryDAGrank;
     uint16_t  previousDAGrank;
     uint16_t  prevRankIncrease;
     uint8_t   prevParentIndex;
     bool      prevHadParent;
     bool      foundBetterParent;
     // temporaries
+    uint8_t   candidateIndex;
+    dagrank_t candidateDAGrank;
     uint16_t  rankIncrease;
     dagrank_t neighborRank;
     uint32_t  tentativeDAGrank;
@@ -377,10 +413,12 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection() {
         // the dagrank is not set through setting command, set rank to MINHOPRANKINCREASE here 
         if (icmpv6rpl_vars.myDAGrank!=MINHOPRANKINCREASE) { // test for change so as not to report unchanged value when root
             icmpv6rpl_vars.myDAGrank=MINHOPRANKINCREASE;
+            icmpv6rpl_indicateInconsistency();
             return;
         }
     }
-    // prep for loop, remember state before neighbor table scanning
+    // remember state before looking for a better parent
+    entryDAGrank         = icmpv6rpl_vars.myDAGrank;
     prevParentIndex      = icmpv6rpl_vars.ParentIndex;
     prevHadParent        = icmpv6rpl_vars.haveParent;
     prevRankIncrease     = icmpv6rpl_vars.rankIncrease;
@@ -403,38 +441,17 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection() {
     foundBetterParent    = FALSE;
     icmpv6rpl_vars.haveParent = FALSE;
     
-    // loop through neighbor table, update myDAGrank
-    for (i=0;i<MAXNUMNEIGHBORS;i++) {
-        if (neighbors_isStableNeighborByIndex(i)) { // in use and link is stable
-            // neighbor marked as NORES can't be parent
-            if (neighbors_getNeighborNoResource(i)==TRUE) {
-                continue;
-            }
-            // get link cost to this neighbor
-            rankIncrease=neighbors_getLinkMetric(i);
-            // get this neighbor's advertized rank
-            neighborRank=neighbors_getNeighborRank(i);
-            // if this neighbor has unknown/infinite rank, pass on it
-            if (neighborRank==DEFAULTDAGRANK) continue;
-            // compute tentative cost of full path to root through this neighbor
-            tentativeDAGrank = (uint32_t)neighborRank+rankIncrease;
-            if (tentativeDAGrank > 65535) {tentativeDAGrank = 65535;}
-            // if not low enough to justify switch, pass (i.e. hysterisis)
-            if (
-                (previousDAGrank<tentativeDAGrank) ||
-                (previousDAGrank-tentativeDAGrank < 2*MINHOPRANKINCREASE)
-            ) {
-                  continue;
-            }
-            // remember that we have at least one valid candidate parent
-            foundBetterParent=TRUE;
-            // select best candidate so far
-            if (icmpv6rpl_vars.myDAGrank>tentativeDAGrank) {
-                icmpv6rpl_vars.myDAGrank    = (uint16_t)tentativeDAGrank;
-                icmpv6rpl_vars.ParentIndex  = i;
-                icmpv6rpl_vars.rankIncrease = rankIncrease;
-            }
-        }
+    // the neighbor table keeps track of the neighbor through which my DAGrank
+    // would be the lowest, switch to it if it is low enough (i.e. hysterisis)
+    if (
+        neighbors_getBestParentCandidate(&candidateIndex,&candidateDAGrank)==TRUE &&
+        previousDAGrank>=candidateDAGrank                                        &&
+        previousDAGrank-candidateDAGrank>=2*MINHOPRANKINCREASE
+    ) {
+        foundBetterParent           = TRUE;
+        icmpv6rpl_vars.myDAGrank    = candidateDAGrank;
+        icmpv6rpl_vars.ParentIndex  = candidateIndex;
+        icmpv6rpl_vars.rankIncrease = neighbors_getLinkMetric(candidateIndex);
     }
    
    if (foundBetterParent) {
@@ -466,6 +483,31 @@ void icmpv6rpl_updateMyDAGrankAndParentSelection() {
       icmpv6rpl_vars.rankIncrease= prevRankIncrease;
       // no change to report on
    }
+   
+   // a new parent or a new DAGRank() (RFC6550, section 3.5.1) is worth
+   // advertising quickly
+   if (
+      icmpv6rpl_vars.haveParent!=prevHadParent                                   ||
+      (icmpv6rpl_vars.haveParent && icmpv6rpl_vars.ParentIndex!=prevParentIndex) ||
+      icmpv6rpl_vars.myDAGrank/MINHOPRANKINCREASE!=entryDAGrank/MINHOPRANKINCREASE
+   ) {
+      icmpv6rpl_indicateInconsistency();
+   }
+   
+#ifdef RPL_STORING_MODE
+   // the downward routes up to the previous parent are stale: remove them
+   // with No-Path DAOs to it (RFC6550, section 9.8), then advertise the new
+   // path, rather than waiting for the end of the DAO period
+   if (
+      icmpv6rpl_vars.haveParent &&
+      (prevHadParent==FALSE || icmpv6rpl_vars.ParentIndex!=prevParentIndex)
+   ) {
+      icmpv6rpl_vars.daoNoPath = prevHadParent &&
+         neighbors_getNeighborEui64(&icmpv6rpl_vars.daoNoPathParent,ADDR_64B,prevParentIndex);
+      icmpv6rpl_vars.daoTargetIdx = 0;
+      sendDAO();
+   }
+#endif
 }
 
 /**
@@ -484,13 +526,17 @@ void icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg) {
    uint8_t          i;
    uint8_t          temp_8b;
    dagrank_t        neighborRank;
-   open_addr_t      NeighborAddress;
    open_addr_t      myPrefix;
    uint8_t*         current;
    uint8_t          optionsLen;
+   bool             newVersion;
+   bool             newTrickle;
    // take ownership over the packet
    msg->owner = COMPONENT_NEIGHBORS;
    
+   newVersion = ((icmpv6rpl_dio_ht*)(msg->payload))->verNumb!=icmpv6rpl_vars.dio.verNumb;
+   newTrickle = FALSE;
+   
    // update some fields of our DIO 
    memcpy(
       &(icmpv6rpl_vars.dio),
@@ -511,6 +557,13 @@ void icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg) {
      case RPL_OPTION_CONFIG:
        // configuration option
        icmpv6rpl_vars.incomingConf = (icmpv6rpl_config_ht*)(current);
+       if (
+          icmpv6rpl_vars.incomingConf->DIOIntDoubl!=icmpv6rpl_vars.conf.DIOIntDoubl ||
+          icmpv6rpl_vars.incomingConf->DIOIntMin!=icmpv6rpl_vars.conf.DIOIntMin     ||
+          icmpv6rpl_vars.incomingConf->DIORedun!=icmpv6rpl_vars.conf.DIORedun
+       ) {
+          newTrickle = TRUE;
+       }
        memcpy(&icmpv6rpl_vars.conf,icmpv6rpl_vars.incomingConf, sizeof(icmpv6rpl_config_ht));
        // do whatever needs to be done with the configuration option of RPL
        optionsLen = optionsLen - current[1] - 2;
@@ -547,33 +600,42 @@ void icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg) {
    
    //update rank in DIO as well (which will be overwritten with my rank when send).
    icmpv6rpl_vars.dio.rank = icmpv6rpl_vars.incomingDio->rank;
+   
+   // the DODAG dictates the parameters of the Trickle timer of the DIOs
+   if (newTrickle) {
+      icmpv6rpl_startDIOTrickle();
+   }
+   if (newVersion) {
+      // the DODAG was rebuilt
+      icmpv6rpl_indicateInconsistency();
+   } else if (icmpv6rpl_vars.incomingDio->rank!=DEFAULTDAGRANK) {
+      opentrickle_consistent(&icmpv6rpl_vars.dioTrickle);
+   }
 
    // update rank of that neighbor in table
-   for (i=0;i<MAXNUMNEIGHBORS;i++) {
-      if (neighbors_getNeighborEui64(&NeighborAddress, ADDR_64B, i)) { // this neighbor entry is in use
-         if (packetfunctions_sameAddress(&(msg->l2_nextORpreviousHop),&NeighborAddress)) { // matching address
-            neighborRank=neighbors_getNeighborRank(i);
-            if (
-              (icmpv6rpl_vars.incomingDio->rank > neighborRank) &&
-              (icmpv6rpl_vars.incomingDio->rank - neighborRank) > (DEFAULTLINKCOST*2*MINHOPRANKINCREASE)
-            ) {
-               // the new DAGrank looks suspiciously high, only increment a bit
-               neighbors_setNeighborRank(i,neighborRank + (DEFAULTLINKCOST*2*MINHOPRANKINCREASE));
-               openserial_printError(COMPONENT_NEIGHBORS,ERR_LARGE_DAGRANK,
-                               (errorparameter_t)icmpv6rpl_vars.incomingDio->rank,
-                               (errorparameter_t)neighborRank);
-            } else {
-               neighbors_setNeighborRank(i,icmpv6rpl_vars.incomingDio->rank);
-            }
-            // since changes were made to neighbors DAG rank, run the routing algorithm again
-            icmpv6rpl_updateMyDAGrankAndParentSelection(); 
-            break; // there should be only one matching entry, no need to loop further
-         }
+   if (neighbors_getNeighborIndex(&(msg->l2_nextORpreviousHop),&i)) {
+      neighborRank=neighbors_getNeighborRank(i);
+      if (
+        (icmpv6rpl_vars.incomingDio->rank > neighborRank) &&
+        (icmpv6rpl_vars.incomingDio->rank - neighborRank) > (DEFAULTLINKCOST*2*MINHOPRANKINCREASE)
+      ) {
+         // the new DAGrank looks suspiciously high, only increment a bit
+         neighbors_setNeighborRank(i,neighborRank + (DEFAULTLINKCOST*2*MINHOPRANKINCREASE));
+         openserial_printError(COMPONENT_NEIGHBORS,ERR_LARGE_DAGRANK,
+                         (errorparameter_t)icmpv6rpl_vars.incomingDio->rank,
+                         (errorparameter_t)neighborRank);
+      } else {
+         neighbors_setNeighborRank(i,icmpv6rpl_vars.incomingDio->rank);
       }
-   } 
+      // since changes were made to neighbors DAG rank, run the routing algorithm again
+      icmpv6rpl_updateMyDAGrankAndParentSelection(); 
+   }
 }
 
 void icmpv6rpl_killPreferredParent() {
+    if (icmpv6rpl_vars.haveParent==TRUE) {
+       icmpv6rpl_indicateInconsistency();
+    }
     icmpv6rpl_vars.haveParent=FALSE;
     if (idmanager_getIsDAGroot()==TRUE) {
        icmpv6rpl_vars.myDAGrank=MINHOPRANKINCREASE;
@@ -593,34 +655,62 @@ void icmpv6rpl_killPreferredParent() {
    task.
 */
 void icmpv6rpl_timer_DIO_cb(opentimers_id_t id) {
-    scheduler_push_task(icmpv6rpl_timer_DIO_task,TASKPRIO_RPL);
-    // update the period
-    opentimers_scheduleIn(
-        icmpv6rpl_vars.timerIdDIO,
-        872 +(openrandom_get16b()&0xff),
-        TIME_MS,
-        TIMER_ONESHOT,
-       icmpv6rpl_timer_DIO_cb
-    );
+    if (opentrickle_fired(&icmpv6rpl_vars.dioTrickle)) {
+        scheduler_push_task(icmpv6rpl_timer_DIO_task,TASKPRIO_RPL);
+    }
 }
 
 /**
 \brief Handler for DIO timer event.
 
+Called when the Trickle timer of the DIOs lets this mote transmit. Until it
+has a DAGrank, the mote solicits DIOs from its neighbors instead, holding the
+interval at Imin.
+
 \note This function is executed in task context, called by the scheduler.
 */
 void icmpv6rpl_timer_DIO_task() {
-    icmpv6rpl_vars.dioTimerCounter = (icmpv6rpl_vars.dioTimerCounter+1)%icmpv6rpl_vars.dioPeriod;
-    switch (icmpv6rpl_vars.dioTimerCounter) {
-    case 0:
-        // called every TIMER_DIO_TIMEOUT seconds
+    if (icmpv6rpl_getMyDAGrank()==DEFAULTDAGRANK) {
+        opentrickle_reset(&icmpv6rpl_vars.dioTrickle);
+        sendDIS();
+    } else {
         sendDIO();
-        break;
-    default:
-        break;
     }
 }
 
+/**
+\brief (Re)start the Trickle timer of the DIOs, with the parameters of the
+   configuration option.
+*/
+void icmpv6rpl_startDIOTrickle() {
+    uint32_t Imin;
+    
+    if (icmpv6rpl_vars.conf.DIOIntMin<32) {
+        Imin = (uint32_t)1<<icmpv6rpl_vars.conf.DIOIntMin;
+    } else {
+        Imin = OPENTRICKLE_MAX_INTERVAL_MS;
+    }
+    opentrickle_start(
+        &icmpv6rpl_vars.dioTrickle,
+        icmpv6rpl_vars.timerIdDIO,
+        icmpv6rpl_timer_DIO_cb,
+        Imin,
+        icmpv6rpl_vars.conf.DIOIntDoubl,
+        icmpv6rpl_vars.conf.DIORedun
+    );
+}
+
+/**
+\brief Indicate the routing state this mote advertises changed.
+
+Resets the Trickle timer of the DIOs, and tells sixtop, whose EBs carry the
+DAGrank.
+*/
+void icmpv6rpl_indicateInconsistency() {
+    opentrickle_reset(&icmpv6rpl_vars.dioTrickle);
+    sixtop_indicateRoutingChange();
+}
+
 /**
 \brief Prepare and a send a RPL DIO.
 */
@@ -739,6 +829,74 @@ void sendDIO() {
     }
 }
 
+/**
+\brief Prepare and a send a RPL DIS, to solicit DIOs from the neighbors.
+
+\note A DIS is multicast like a DIO, and shares its busy flag.
+*/
+void sendDIS() {
+   OpenQueueEntry_t*    msg;
+   
+   // stop if I'm not sync'ed
+   if (ieee154e_isSynch()==FALSE) {
+      
+      // remove packets genereted by this module (DIO and DAO) from openqueue
+      openqueue_removeAllCreatedBy(COMPONENT_ICMPv6RPL);
+      
+      // I'm not busy sending a DIO/DAO
+      icmpv6rpl_vars.busySendingDIO  = FALSE;
+      icmpv6rpl_vars.busySendingDAO  = FALSE;
+      
+      // stop here
+      return;
+   }
+   
+   // do not send DIS if I'm already busy sending
+   if (icmpv6rpl_vars.busySendingDIO==TRUE) {
+      return;
+   }
+   
+   // reserve a free packet buffer for DIS
+   msg = openqueue_getFreePacketBuffer(COMPONENT_ICMPv6RPL);
+   if (msg==NULL) {
+      openserial_printError(COMPONENT_ICMPv6RPL,ERR_NO_FREE_PACKET_BUFFER,
+                            (errorparameter_t)0,
+                            (errorparameter_t)0);
+      
+      return;
+   }
+   
+   // take ownership
+   msg->creator                             = COMPONENT_ICMPv6RPL;
+   msg->owner                               = COMPONENT_ICMPv6RPL;
+   
+   // set transport information
+   msg->l4_protocol                         = IANA_ICMPv6;
+   msg->l4_protocol_compressed              = FALSE;
+   msg->l4_sourcePortORicmpv6Type           = IANA_ICMPv6_RPL;
+   
+   // set DIS destination
+   memcpy(&(msg->l3_destinationAdd),&icmpv6rpl_vars.dioDestination,sizeof(open_addr_t));
+   
+   //===== DIS payload
+   packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dis_ht));
+   ((icmpv6rpl_dis_ht*)(msg->payload))->flags    = 0x00;
+   ((icmpv6rpl_dis_ht*)(msg->payload))->reserved = 0x00;
+   
+   //===== ICMPv6 header
+   packetfunctions_reserveHeaderSize(msg,sizeof(ICMPv6_ht));
+   ((ICMPv6_ht*)(msg->payload))->type       = msg->l4_sourcePortORicmpv6Type;
+   ((ICMPv6_ht*)(msg->payload))->code       = IANA_ICMPv6_RPL_DIS;
+   packetfunctions_calculateChecksum(msg,(uint8_t*)&(((ICMPv6_ht*)(msg->payload))->checksum));//call last
+   
+   //send
+   if (icmpv6_send(msg)==E_SUCCESS) {
+      icmpv6rpl_vars.busySendingDIO = TRUE;
+   } else {
+      openqueue_freePacketBuffer(msg);
+   }
+}
+
 //===== DAO-related
 
 /**
@@ -769,6 +927,11 @@ void icmpv6rpl_timer_DAO_task() {
     switch (icmpv6rpl_vars.daoTimerCounter) {
     case 0:
         // called every TIMER_DAO_TIMEOUT seconds
+#ifdef RPL_STORING_MODE
+        icmpv6rpl_ageRoutes();
+        // advertise myself and my routes, over as many DAOs as needed
+        icmpv6rpl_vars.daoTargetIdx = 0;
+#endif
         sendDAO();
         break;
     default:
@@ -781,8 +944,13 @@ void icmpv6rpl_timer_DAO_task() {
 */
 void sendDAO() {
    OpenQueueEntry_t*    msg;                // pointer to DAO messages
+#ifdef RPL_STORING_MODE
+   uint8_t*             target;             // EUI64 of the running target
+   uint8_t              numTargetParents;   // the number of targets indicated
+#else
    uint8_t              nbrIdx;             // running neighbor index
    uint8_t              numTransitParents,numTargetParents;  // the number of parents indicated in transit option
+#endif
    open_addr_t         address;
    open_addr_t*        prefix;
    
@@ -834,6 +1002,88 @@ void sendDAO() {
    msg->l4_protocol                         = IANA_ICMPv6;
    msg->l4_sourcePortORicmpv6Type           = IANA_ICMPv6_RPL;
    
+#ifdef RPL_STORING_MODE
+   // set DAO destination: my preferred parent, which stores the routes to the
+   // targets and advertises them in its own DAOs, or my previous parent, which
+   // is to remove them
+   if (icmpv6rpl_vars.daoNoPath) {
+      memcpy(&address,&icmpv6rpl_vars.daoNoPathParent,sizeof(open_addr_t));
+   } else if (icmpv6rpl_getPreferredParentEui64(&address)==FALSE) {
+      openqueue_freePacketBuffer(msg);
+      return;
+   }
+   msg->l3_destinationAdd.type=ADDR_128B;
+   memset(&msg->l3_destinationAdd.addr_128b[0],0,8);
+   msg->l3_destinationAdd.addr_128b[0] = 0xfe;   // link-local
+   msg->l3_destinationAdd.addr_128b[1] = 0x80;
+   memcpy(&msg->l3_destinationAdd.addr_128b[8],address.addr_64b,8);
+   
+   //===== fill in packet
+   
+   //=== transit option, without parent address in storing mode. A single one
+   // follows all the targets, it applies to all of them.
+   icmpv6rpl_vars.dao_transit.optionLength  = sizeof(icmpv6rpl_dao_transit_ht)-2;
+   icmpv6rpl_vars.dao_transit.PathControl   = 0;
+   icmpv6rpl_vars.dao_transit.PathLifetime  = icmpv6rpl_vars.daoNoPath ? 0 : 0xAA;
+   icmpv6rpl_vars.dao_transit.type          = OPTION_TRANSIT_INFORMATION_TYPE;
+   packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dao_transit_ht));
+   memcpy(
+          ((icmpv6rpl_dao_transit_ht*)(msg->payload)),
+          &(icmpv6rpl_vars.dao_transit),
+          sizeof(icmpv6rpl_dao_transit_ht)
+   );
+   
+   //=== target options: myself in the first DAO of the period, then the motes
+   // of my sub-DODAG, resuming where the previous DAO stopped
+   prefix                                   = idmanager_getMyID(ADDR_PREFIX);
+   numTargetParents                         = 0;
+   while (
+         numTargetParents<ICMPV6RPL_TARGETS_PER_DAO &&
+         icmpv6rpl_vars.daoTargetIdx<=ICMPV6RPL_MAXROUTES
+      ) {
+      if (icmpv6rpl_vars.daoTargetIdx==0) {
+         target = idmanager_getMyID(ADDR_64B)->addr_64b;
+      } else if (icmpv6rpl_vars.routes[icmpv6rpl_vars.daoTargetIdx-1].lifetime>0) {
+         target = icmpv6rpl_vars.routes[icmpv6rpl_vars.daoTargetIdx-1].target;
+      } else {
+         target = NULL;
+      }
+      icmpv6rpl_vars.daoTargetIdx++;
+      if (target==NULL) {
+         continue;
+      }
+      
+      packetfunctions_reserveHeaderSize(msg,8);
+      memcpy(msg->payload,target,8);
+      packetfunctions_reserveHeaderSize(msg,8);
+      memcpy(msg->payload,prefix->prefix,8);
+      
+      icmpv6rpl_vars.dao_target.optionLength  = LENGTH_ADDR128b +sizeof(icmpv6rpl_dao_target_ht) - 2;
+      icmpv6rpl_vars.dao_target.type  = OPTION_TARGET_INFORMATION_TYPE;
+      icmpv6rpl_vars.dao_target.flags  = 0;
+      icmpv6rpl_vars.dao_target.prefixLength = 128;
+      packetfunctions_reserveHeaderSize(msg,sizeof(icmpv6rpl_dao_target_ht));
+      memcpy(
+            ((icmpv6rpl_dao_target_ht*)(msg->payload)),
+            &(icmpv6rpl_vars.dao_target),
+            sizeof(icmpv6rpl_dao_target_ht)
+      );
+      
+      numTargetParents++;
+   }
+   
+   // stop here if all targets were advertised already
+   if (numTargetParents==0) {
+      openqueue_freePacketBuffer(msg);
+      if (icmpv6rpl_vars.daoNoPath) {
+         // done with the previous parent, on to the new one
+         icmpv6rpl_vars.daoNoPath    = FALSE;
+         icmpv6rpl_vars.daoTargetIdx = 0;
+         sendDAO();
+      }
+      return;
+   }
+#else
    // set DAO destination
    msg->l3_destinationAdd.type=ADDR_128B;
    memcpy(msg->l3_destinationAdd.addr_128b,icmpv6rpl_vars.dio.DODAGID,sizeof(icmpv6rpl_vars.dio.DODAGID));
@@ -913,6 +1163,7 @@ void sendDAO() {
       openqueue_freePacketBuffer(msg);
       return;
    }
+#endif
    
    icmpv6rpl_vars.dao_transit.PathSequence++; //increment path sequence.
    // if you get here, you will send a DAO
@@ -941,9 +1192,186 @@ void sendDAO() {
    }
 }
 
+#ifdef RPL_STORING_MODE
+//===== downward routes
+
+/**
+\brief Store the routes advertised in a DAO received from a child.
+
+Each Transit Information option applies to the Target options preceding it,
+up to the previous Transit Information option.
+
+\param[in] msg The DAO, starting at its DAO header.
+*/
+void icmpv6rpl_indicateRxDAO(OpenQueueEntry_t* msg) {
+   uint8_t*        options;
+   uint8_t*        targets;            // first Target option of the next Transit Information option
+   uint8_t*        end;
+   
+   // my parent advertising routes through itself would create a loop
+   if (icmpv6rpl_isPreferredParent(&(msg->l2_nextORpreviousHop))==TRUE) {
+      return;
+   }
+   
+   // skip the DAO header, its DODAGID is optional
+   options = msg->payload+sizeof(icmpv6rpl_dao_ht)-sizeof(((icmpv6rpl_dao_ht*)0)->DODAGID);
+   end     = msg->payload+msg->length;
+   if (options>end) {
+      return;
+   }
+   if ((((icmpv6rpl_dao_ht*)(msg->payload))->K_D_flags & D_DAO)!=0) {
+      options += sizeof(((icmpv6rpl_dao_ht*)0)->DODAGID);
+   }
+   
+   targets = options;
+   while (options<end) {
+      if (options[0]==OPTION_PAD1_TYPE) {
+         options++;
+         continue;
+      }
+      if (options+2>end || options+2+options[1]>end) {
+         // truncated option
+         break;
+      }
+      if (
+            options[0]==OPTION_TRANSIT_INFORMATION_TYPE &&
+            options[1]>=sizeof(icmpv6rpl_dao_transit_ht)-2
+         ) {
+         icmpv6rpl_updateRoutes(
+            targets,
+            options,
+            &(msg->l2_nextORpreviousHop),
+            ((icmpv6rpl_dao_transit_ht*)options)->PathLifetime
+         );
+         targets = options+2+options[1];
+      }
+      options += 2+options[1];
+   }
+}
+
+/**
+\brief Update the routes to the targets of a Transit Information option.
+
+\param[in] options      The first option which may be one of these targets.
+\param[in] end          The Transit Information option.
+\param[in] nextHop      The child which sent the DAO.
+\param[in] pathLifetime The path lifetime of the Transit Information option,
+   0 (No-Path) to remove the routes.
+*/
+void icmpv6rpl_updateRoutes(uint8_t* options, uint8_t* end, open_addr_t* nextHop, uint8_t pathLifetime) {
+   uint8_t* target;
+   
+   while (options<end) {
+      if (options[0]==OPTION_PAD1_TYPE) {
+         options++;
+         continue;
+      }
+      // only full addresses in my prefix, which are not mine
+      target = options+sizeof(icmpv6rpl_dao_target_ht);
+      if (
+            options[0]==OPTION_TARGET_INFORMATION_TYPE &&
+            options[1]>=LENGTH_ADDR128b+sizeof(icmpv6rpl_dao_target_ht)-2 &&
+            ((icmpv6rpl_dao_target_ht*)options)->prefixLength==128 &&
+            memcmp(target,idmanager_getMyID(ADDR_PREFIX)->prefix,8)==0 &&
+            memcmp(target+8,idmanager_getMyID(ADDR_64B)->addr_64b,8)!=0
+         ) {
+         icmpv6rpl_updateRoute(
+            target+8,
+            nextHop,
+            pathLifetime==0 ? 0 : ICMPV6RPL_ROUTE_LIFETIME
+         );
+      }
+      options += 2+options[1];
+   }
+}
+
+/**
+\brief Install, refresh or remove the route to a target.
+
+\param[in] target   The EUI64 of the target.
+\param[in] nextHop  The child the target is reached through.
+\param[in] lifetime The lifetime of the route, in DAO periods. 0 removes the
+   route, if it goes through that child.
+*/
+void icmpv6rpl_updateRoute(uint8_t* target, open_addr_t* nextHop, uint8_t lifetime) {
+   icmpv6rpl_route_t* route;
+   uint8_t            i;
+   
+   // look for the route to that target, or else a free entry
+   route = NULL;
+   for (i=0;i<ICMPV6RPL_MAXROUTES;i++) {
+      if (icmpv6rpl_vars.routes[i].lifetime==0) {
+         if (route==NULL) {
+            route = &icmpv6rpl_vars.routes[i];
+         }
+      } else if (memcmp(icmpv6rpl_vars.routes[i].target,target,8)==0) {
+         route = &icmpv6rpl_vars.routes[i];
+         break;
+      }
+   }
+   
+   if (lifetime==0) {
+      // a No-Path from another child than the next hop is stale
+      if (
+            i<ICMPV6RPL_MAXROUTES &&
+            memcmp(route->nextHop,nextHop->addr_64b,8)==0
+         ) {
+         route->lifetime = 0;
+      }
+      return;
+   }
+   
+   if (route==NULL) {
+      openserial_printError(COMPONENT_ICMPv6RPL,ERR_ROUTE_TABLE_FULL,
+                            (errorparameter_t)target[7],
+                            (errorparameter_t)ICMPV6RPL_MAXROUTES);
+      return;
+   }
+   memcpy(route->target,target,8);
+   memcpy(route->nextHop,nextHop->addr_64b,8);
+   route->lifetime = lifetime;
+}
+
+/**
+\brief Expire the routes no DAO refreshed for ICMPV6RPL_ROUTE_LIFETIME periods.
+*/
+void icmpv6rpl_ageRoutes() {
+   uint8_t i;
+   
+   for (i=0;i<ICMPV6RPL_MAXROUTES;i++) {
+      if (icmpv6rpl_vars.routes[i].lifetime>0) {
+         icmpv6rpl_vars.routes[i].lifetime--;
+      }
+   }
+}
+#endif
+
+/**
+\brief Set the longest interval between DIOs, in ms.
+
+The DIOs are sent on a Trickle timer, this sets the number of doublings of its
+Imin. The longest interval can only be Imin times a power of two, it is the
+longest one which does not exceed dioPeriod, or Imin if dioPeriod is shorter:
+with Imin 2^12 ms, 10000 ms gives 8192 ms. On the DAG root, the setting spreads
+to the DODAG through the configuration option.
+*/
 void icmpv6rpl_setDIOPeriod(uint16_t dioPeriod){
-    // convert to seconds
-    icmpv6rpl_vars.dioPeriod = dioPeriod/1000;
+    uint32_t interval;
+    uint8_t  doublings;
+    
+    if (icmpv6rpl_vars.conf.DIOIntMin>=16) {
+        // Imin already exceeds any period
+        doublings = 0;
+    } else {
+        interval  = (uint32_t)1<<icmpv6rpl_vars.conf.DIOIntMin;
+        doublings = 0;
+        while (interval*2<=dioPeriod) {
+            interval *= 2;
+            doublings++;
+        }
+    }
+    icmpv6rpl_vars.conf.DIOIntDoubl = doublings;
+    icmpv6rpl_startDIOTrickle();
 }
 
 void icmpv6rpl_setDAOPeriod(uint16_t daoPeriod){
@@ -958,3 +1386,37 @@ bool icmpv6rpl_daoSent(void) {
     return icmpv6rpl_vars.daoSent;
 }
 
+#ifdef RPL_STORING_MODE
+/**
+\brief Retrieve the next hop towards a mote of my sub-DODAG.
+
+\param[in]  destination128b   Final IPv6 destination address.
+\param[out] addressToWrite64b Location to write the EUI64 of next hop to.
+
+\returns TRUE if a DAO advertised a route to that destination, FALSE otherwise.
+*/
+bool icmpv6rpl_getDownwardNextHop(open_addr_t* destination128b, open_addr_t* addressToWrite64b) {
+   uint8_t i;
+   
+   // only the motes of the DODAG advertise routes
+   if (
+         destination128b->type!=ADDR_128B ||
+         memcmp(&destination128b->addr_128b[0],idmanager_getMyID(ADDR_PREFIX)->prefix,8)!=0
+      ) {
+      return FALSE;
+   }
+   
+   for (i=0;i<ICMPV6RPL_MAXROUTES;i++) {
+      if (
+            icmpv6rpl_vars.routes[i].lifetime>0 &&
+            memcmp(icmpv6rpl_vars.routes[i].target,&destination128b->addr_128b[8],8)==0
+         ) {
+         addressToWrite64b->type = ADDR_64B;
+         memcpy(addressToWrite64b->addr_64b,icmpv6rpl_vars.routes[i].nextHop,8);
+         return TRUE;
+      }
+   }
+   return FALSE;
+}
+#endif
+
@@ -9,16 +9,23 @@
 */
 
 #include "opentimers.h"
+#include "opentrickle.h"
 
 //=========================== define ==========================================
 
-#define TIMER_DIO_TIMEOUT         10  // seconds
 #define TIMER_DAO_TIMEOUT         60  // seconds
 
+#ifdef RPL_STORING_MODE
+// Storing Mode of Operation with no multicast support (2)
+#define MOP_DIO_A                 0<<5
+#define MOP_DIO_B                 1<<4
+#define MOP_DIO_C                 0<<3
+#else
 // Non-Storing Mode of Operation (1)
 #define MOP_DIO_A                 0<<5
 #define MOP_DIO_B                 0<<4
 #define MOP_DIO_C                 1<<3
+#endif
 // least preferred (0)
 #define PRF_DIO_A                 0<<2
 #define PRF_DIO_B                 0<<1
@@ -61,7 +68,19 @@
 //section 8.2.1 pag 67 RFC6550 -- using a subset
 #define MAX_TARGET_PARENTS        0x01
 
+#ifdef RPL_STORING_MODE
+// number of downward routes, to the motes of my sub-DODAG
+#ifndef ICMPV6RPL_MAXROUTES
+#define ICMPV6RPL_MAXROUTES       32
+#endif
+// number of DAO periods a route lives without being refreshed
+#define ICMPV6RPL_ROUTE_LIFETIME  3
+// number of targets per DAO, so it fits in a single frame
+#define ICMPV6RPL_TARGETS_PER_DAO 2
+#endif
+
 enum{
+  OPTION_PAD1_TYPE                = 0x00,
   OPTION_ROUTE_INFORMATION_TYPE   = 0x03,
   OPTION_DODAG_CONFIGURATION_TYPE = 0x04,
   OPTION_TARGET_INFORMATION_TYPE  = 0x05,
@@ -129,6 +148,18 @@ typedef struct {
 }icmpv6rpl_config_ht;
 END_PACK
 
+//===== DIS
+
+/**
+\brief Header format of a RPL DIS packet.
+*/
+BEGIN_PACK
+typedef struct {
+   uint8_t         flags;
+   uint8_t         reserved;
+} icmpv6rpl_dis_ht;
+END_PACK
+
 //===== DAO
 
 /**
@@ -170,6 +201,20 @@ typedef struct {
 } icmpv6rpl_dao_target_ht;
 END_PACK
 
+//===== downward routes
+
+/**
+\brief Route to a mote of my sub-DODAG, learnt from a DAO (storing mode).
+
+Only the EUI64s are stored: the targets share the prefix of the DODAG, and the
+next hop is a child.
+*/
+typedef struct {
+   uint8_t         target[8];          ///< EUI64 of the destination.
+   uint8_t         nextHop[8];         ///< EUI64 of the child the destination is reached through.
+   uint8_t         lifetime;           ///< DAO periods left before the route expires, 0 if unused.
+} icmpv6rpl_route_t;
+
 //=========================== module variables ================================
 
 
@@ -184,9 +229,8 @@ typedef struct {
    icmpv6rpl_pio_t           pio;                     ///< pre-populated PIO com
    icmpv6rpl_config_ht       conf;
    open_addr_t               dioDestination;          ///< IPv6 destination address for DIOs.
-   uint16_t                  dioTimerCounter;         ///< counter to determine when to send DIO.
    opentimers_id_t           timerIdDIO;              ///< ID of the timer used to send DIOs.
-   uint16_t                  dioPeriod;               ///< dio period in seconds.
+   opentrickle_t             dioTrickle;              ///< Trickle timer the DIOs are sent on.
    // DAO-related
    icmpv6rpl_dao_ht          dao;                     ///< pre-populated DAO packet.
    icmpv6rpl_dao_transit_ht  dao_transit;             ///< pre-populated DAO "Transit Info" option header.
@@ -194,6 +238,13 @@ typedef struct {
    opentimers_id_t           timerIdDAO;              ///< ID of the timer used to send DAOs.
    uint16_t                  daoTimerCounter;         ///< counter to determine when to send DAO.
    uint16_t                  daoPeriod;               ///< dao period in seconds.
+#ifdef RPL_STORING_MODE
+   // downward routes
+   icmpv6rpl_route_t         routes[ICMPV6RPL_MAXROUTES]; ///< routes to the motes of my sub-DODAG.
+   uint8_t                   daoTargetIdx;            ///< next target to advertise, 0 for myself, i for routes[i-1].
+   bool                      daoNoPath;               ///< the DAOs being sent are No-Path DAOs to my previous parent.
+   open_addr_t               daoNoPathParent;         ///< EUI64 of my previous parent.
+#endif
    // routing table
    dagrank_t                 myDAGrank;               ///< rank of this router within DAG.
    uint16_t                  rankIncrease;            ///< the cost of the link to the parent, in units of rank
@@ -227,6 +278,9 @@ void     icmpv6rpl_killPreferredParent(void);                            // new
 void     icmpv6rpl_updateMyDAGrankAndParentSelection(void);              // new DB
 void     icmpv6rpl_indicateRxDIO(OpenQueueEntry_t* msg);                 // new DB
 bool     icmpv6rpl_daoSent(void);
+#ifdef RPL_STORING_MODE
+bool     icmpv6rpl_getDownwardNextHop(open_addr_t* destination128b, open_addr_t* addressToWrite64b);
+#endif
 
 
 /**
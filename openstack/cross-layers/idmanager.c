@@ -6,6 +6,7 @@
 #include "neighbors.h"
 #include "schedule.h"
 #include "IEEE802154_security.h"
+#include "opentelemetry.h"
 
 //=========================== variables =======================================
 
@@ -13,6 +14,8 @@ idmanager_vars_t idmanager_vars;
 
 //=========================== prototypes ======================================
 
+void idmanager_getStatusRow(uint8_t row, uint8_t* buf);
+
 //=========================== public ==========================================
 
 void idmanager_init() {
@@ -67,6 +70,16 @@ void idmanager_init() {
    
    // my16bID
    packetfunctions_mac64bToMac16b(&idmanager_vars.my64bID,&idmanager_vars.my16bID);
+   
+   // status reported over serial
+   opentelemetry_registerTable(
+      STATUS_ID,
+      1,
+      sizeof(debugIDManagerEntry_t),
+      idmanager_getStatusRow,
+      OPENTELEMETRY_PERIOD_ALWAYS
+   );
+   opentelemetry_registerCounters(STATUS_JOINED,(uint8_t*)&idmanager_vars.joinAsn,sizeof(asn_t),OPENTELEMETRY_PERIOD_ALWAYS);
 }
 
 bool idmanager_getIsDAGroot() {
@@ -179,6 +192,15 @@ bool idmanager_isMyAddress(open_addr_t* addr) {
         memcpy(&temp_my128bID.addr_128b[8],&idmanager_vars.my64bID.addr_64b,8);
 
         res= packetfunctions_sameAddress(addr,&temp_my128bID);
+#ifdef RPL_STORING_MODE
+        if (res==FALSE) {
+           // my link-local address, DAOs are sent to it
+           memset(&temp_my128bID.addr_128b[0],0,8);
+           temp_my128bID.addr_128b[0] = 0xfe;
+           temp_my128bID.addr_128b[1] = 0x80;
+           res= packetfunctions_sameAddress(addr,&temp_my128bID);
+        }
+#endif
         ENABLE_INTERRUPTS();
         return res;
      case ADDR_PANID:
@@ -286,11 +308,7 @@ status information about several modules in the OpenWSN stack.
 bool debugPrint_id() {
    debugIDManagerEntry_t output;
    
-   output.isDAGroot = idmanager_vars.isDAGroot;
-   memcpy(output.myPANID,idmanager_vars.myPANID.panid,2);
-   memcpy(output.my16bID,idmanager_vars.my16bID.addr_16b,2);
-   memcpy(output.my64bID,idmanager_vars.my64bID.addr_64b,8);
-   memcpy(output.myPrefix,idmanager_vars.myPrefix.prefix,8);
+   idmanager_getStatusRow(0,(uint8_t*)&output);
    
    openserial_printStatus(STATUS_ID,(uint8_t*)&output,sizeof(debugIDManagerEntry_t));
    return TRUE;
@@ -306,3 +324,21 @@ bool debugPrint_joined() {
 }
 
 //=========================== private =========================================
+
+/**
+\brief Format the identity of this mote, as reported over serial.
+
+\param[in]  row Ignored, there is a single row.
+\param[out] buf Where to write the debugIDManagerEntry_t.
+*/
+void idmanager_getStatusRow(uint8_t row, uint8_t* buf) {
+   debugIDManagerEntry_t output;
+   
+   output.isDAGroot = idmanager_vars.isDAGroot;
+   memcpy(output.myPANID,idmanager_vars.myPANID.panid,2);
+   memcpy(output.my16bID,idmanager_vars.my16bID.addr_16b,2);
+   memcpy(output.my64bID,idmanager_vars.my64bID.addr_64b,8);
+   memcpy(output.myPrefix,idmanager_vars.myPrefix.prefix,8);
+   
+   memcpy(buf,&output,sizeof(debugIDManagerEntry_t));
+}
@@ -25,6 +25,17 @@
  * It does not include control mechanisms for overlapping, fragmentation
  * or other possible errors.
  *
+ * With OPENMEMORY_ALLOCATOR_BITMAP (the default), the map is only kept for
+ * the last block of each area. Three more structures make the common
+ * operations independent of the number of blocks:
+ *  - bitmap, one bit per block, set while the block is reserved. Areas of
+ *    several blocks are searched for a word at a time, from the bottom.
+ *  - last, the last block of the area each reserved block belongs to, so
+ *    the bounds of an area are found from any address inside it.
+ *  - stack, the blocks candidate to single-block reservations, which is
+ *    what every packet buffer needs. Freed blocks are pushed on it; blocks
+ *    since taken by a multi-block reservation are dropped when popped.
+ *
  * \author Antonio Cepero <cpro@uoc.edu>, March 2016.
  */
 
@@ -39,6 +50,13 @@ openmemory_vars_t openmemory_vars;
 //=========================== prototypes ======================================
 
 bool openmemory_segmentAddr(uint8_t* address, uint8_t** first, uint8_t** last);
+void openmemory_reserved(uint8_t nsegments);
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+bool openmemory_isReserved(uint8_t block);
+void openmemory_reserveBlocks(uint8_t first, uint8_t last, uint8_t end);
+void openmemory_releaseBlocks(uint8_t first, uint8_t last);
+uint8_t openmemory_findFreeBlocks(uint8_t nsegments);
+#endif
 
 //=========================== public ==========================================
 
@@ -54,7 +72,21 @@ void openmemory_init() {
       openmemory_vars.memory.map[i] = 0;
    }
 //   memset(&openmemory_vars.memory.buffer[0], 0, REAL_MEMORY_SIZE);
-   openmemory_vars.used = 0;
+   openmemory_vars.used      = 0;
+   openmemory_vars.highWater = 0;
+   openmemory_vars.numFailed = 0;
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   // bits past the last block read as reserved, so searches never use them
+   for ( i = 0; i < OPENMEMORY_BITMAP_WORDS; i++ ) {
+      openmemory_vars.memory.bitmap[i]  = 0xffffffff;
+      openmemory_vars.memory.stacked[i] = 0xffffffff;
+   }
+   for ( i = 0; i < FRAME_DATA_BLOCKS; i++ ) {
+      openmemory_vars.memory.bitmap[i/32]  &= ~((uint32_t)1 << (i%32));
+      openmemory_vars.memory.stack[i]       = i; // top block is popped first
+   }
+   openmemory_vars.stackTop = FRAME_DATA_BLOCKS;
+#endif
 }
 
 /**
@@ -85,9 +117,34 @@ uint8_t*  openmemory_getMemory(uint16_t size)
    // Normalize size and calculate the number of needed blocks
    nsegments = (size == 0 ? 0 : size - 1) / FRAME_DATA_TOTAL + 1;
    if ( openmemory_vars.used + nsegments > FRAME_DATA_BLOCKS ) {
+      openmemory_vars.numFailed++;
       return NULL; // do not search for non available segment
    }
 
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   // single block: pop the stack, dropping blocks reserved since pushed
+   if ( nsegments == 1 ) {
+      while ( openmemory_vars.stackTop > 0 ) {
+         i = openmemory_vars.memory.stack[--openmemory_vars.stackTop];
+         openmemory_vars.memory.stacked[i/32] &= ~((uint32_t)1 << (i%32));
+         if ( ! openmemory_isReserved(i) ) {
+            openmemory_reserveBlocks(i, i, i);
+            openmemory_vars.memory.map[i] = 1;
+            openmemory_reserved(1);
+            return &openmemory_vars.memory.buffer[i * FRAME_DATA_TOTAL];
+         }
+      }
+   }
+
+   i = openmemory_findFreeBlocks(nsegments);
+   if ( i < FRAME_DATA_BLOCKS ) {
+      j = i + nsegments - 1;
+      openmemory_reserveBlocks(i, j, j);
+      openmemory_vars.memory.map[j] = nsegments;
+      openmemory_reserved(nsegments);
+      return &openmemory_vars.memory.buffer[i * FRAME_DATA_TOTAL];
+   }
+#else
    // wraps around, so a negative value will be greater
    for ( i = FRAME_DATA_BLOCKS - 1; i < FRAME_DATA_BLOCKS; ) {
    // search for free space
@@ -100,7 +157,7 @@ uint8_t*  openmemory_getMemory(uint16_t size)
 	 }
 	 if ( j == nsegments ) {
             openmemory_vars.memory.map[i] = nsegments;
-            openmemory_vars.used += nsegments;
+            openmemory_reserved(nsegments);
             return &openmemory_vars.memory.buffer[(i-j+1) * FRAME_DATA_TOTAL];
          } else {
             i -= j; // advance to next occupied segment
@@ -109,8 +166,10 @@ uint8_t*  openmemory_getMemory(uint16_t size)
          i -= openmemory_vars.memory.map[i];
       }
    }
+#endif
 
    // There is no available segment
+   openmemory_vars.numFailed++;
    return NULL;
 }
 
@@ -135,6 +194,9 @@ owerror_t openmemory_freeMemory(uint8_t* address)
 
    end = (last - &openmemory_vars.memory.buffer[0]) / FRAME_DATA_TOTAL;
    openmemory_vars.used -= openmemory_vars.memory.map[end];
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   openmemory_releaseBlocks(end - openmemory_vars.memory.map[end] + 1, end);
+#endif
    openmemory_vars.memory.map[end] = 0;
 //   memset(first, 0, (size_t)(last-first)+1);
    return E_SUCCESS;
@@ -178,23 +240,35 @@ uint8_t* openmemory_increaseMemory(uint8_t* address, uint16_t size)
    }
 
    if ( openmemory_vars.used - old_segments + new_segments > FRAME_DATA_BLOCKS ) {
+      openmemory_vars.numFailed++;
       return NULL; // do not search for non available segment
    }
 
    // Try to allocate it in previous segments
    j = old_segments;
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   while ( new_segments > j && end - j >= 0
+        && ! openmemory_isReserved(end-j) ) {
+      j++;
+   }
+#else
    while ( new_segments > j && end - j >= 0
         && openmemory_vars.memory.map[end-j] == 0 ) {
       j++;
    }
+#endif
    if ( j == new_segments ) {
-      openmemory_vars.used += new_segments - old_segments;
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+      openmemory_reserveBlocks(end - new_segments + 1, end - old_segments, end);
+#endif
       openmemory_vars.memory.map[end] = new_segments;
+      openmemory_reserved(new_segments - old_segments);
       return address;
    }
 
    // There is no adjacent space to allocate it in contiguous form
    if ( openmemory_vars.used + new_segments > FRAME_DATA_BLOCKS ) {
+      openmemory_vars.numFailed++;
       return NULL; // do not search for non available segment
    }
 
@@ -209,6 +283,9 @@ uint8_t* openmemory_increaseMemory(uint8_t* address, uint16_t size)
       new = newlast - nsize;
       memcpy(new, address, nsize+1);
       openmemory_vars.used -= old_segments;
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+      openmemory_releaseBlocks(end - old_segments + 1, end);
+#endif
       openmemory_vars.memory.map[end] = 0; // freeing old area
 //      memset(first, 0, (size_t)(last-first)+1);
    }
@@ -345,6 +422,58 @@ uint8_t* openmemory_moveToEnd(uint8_t* address, uint16_t size, uint16_t tail)
    memmove(new, address, size);
    return new;
 }
+
+/**
+ * \brief Returns usage statistics of the memory
+ *
+ * \param stats OUTPUT The statistics. Free areas are counted at the time of
+ *                     the call.
+ */
+void openmemory_getStats(openmemory_stats_t* stats)
+{
+   uint8_t i;
+   uint8_t run;
+
+   stats->used            = openmemory_vars.used;
+   stats->highWater       = openmemory_vars.highWater;
+   stats->numFailed       = openmemory_vars.numFailed;
+   stats->freeAreas       = 0;
+   stats->largestFreeArea = 0;
+
+   run = 0;
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   for ( i = 0; i < FRAME_DATA_BLOCKS; i++ ) {
+      if ( openmemory_isReserved(i) ) {
+         run = 0;
+      } else {
+         if ( run == 0 ) {
+            stats->freeAreas++;
+         }
+         run++;
+         if ( run > stats->largestFreeArea ) {
+            stats->largestFreeArea = run;
+         }
+      }
+   }
+#else
+   // wraps around, so a negative value will be greater
+   for ( i = FRAME_DATA_BLOCKS - 1; i < FRAME_DATA_BLOCKS; ) {
+      if ( openmemory_vars.memory.map[i] == 0 ) {
+         if ( run == 0 ) {
+            stats->freeAreas++;
+         }
+         run++;
+         if ( run > stats->largestFreeArea ) {
+            stats->largestFreeArea = run;
+         }
+         i--;
+      } else {
+         run = 0;
+         i -= openmemory_vars.memory.map[i];
+      }
+   }
+#endif
+}
 //=========================== private =========================================
 
 /**
@@ -360,6 +489,23 @@ uint8_t* openmemory_moveToEnd(uint8_t* address, uint16_t size, uint16_t tail)
  */
 bool openmemory_segmentAddr(uint8_t* address, uint8_t** first, uint8_t** last)
 { 
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   uint8_t  block;
+   uint8_t  end;
+
+   if ( address <  &openmemory_vars.memory.buffer[0]
+     || address >= &openmemory_vars.memory.buffer[TOTAL_MEMORY_SIZE] ) {
+      return FALSE;
+   }
+   block = (address - &openmemory_vars.memory.buffer[0]) / FRAME_DATA_TOTAL;
+   if ( ! openmemory_isReserved(block) ) {
+      return FALSE;
+   }
+   end    = openmemory_vars.memory.last[block];
+   *first = &openmemory_vars.memory.buffer[(end - openmemory_vars.memory.map[end] + 1) * FRAME_DATA_TOTAL];
+   *last  = &openmemory_vars.memory.buffer[end * FRAME_DATA_TOTAL] + FRAME_DATA_TOTAL - 1;
+   return TRUE;
+#else
    uint8_t  i;
    uint8_t  j;
    uint8_t  start;
@@ -395,4 +541,97 @@ bool openmemory_segmentAddr(uint8_t* address, uint8_t** first, uint8_t** last)
    }
 
    return FALSE;
+#endif
+}
+
+/**
+ * \brief Accounts for newly reserved blocks
+ *
+ * \param nsegments The number of blocks just reserved.
+ */
+void openmemory_reserved(uint8_t nsegments)
+{
+   openmemory_vars.used += nsegments;
+   if ( openmemory_vars.used > openmemory_vars.highWater ) {
+      openmemory_vars.highWater = openmemory_vars.used;
+   }
+}
+
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+bool openmemory_isReserved(uint8_t block)
+{
+   return (openmemory_vars.memory.bitmap[block/32] >> (block%32)) & 1;
+}
+
+/**
+ * \brief Marks blocks as reserved
+ *
+ * \param first The first block to mark.
+ * \param last  The last block to mark.
+ * \param end   The last block of the area the blocks become part of.
+ */
+void openmemory_reserveBlocks(uint8_t first, uint8_t last, uint8_t end)
+{
+   uint8_t i;
+
+   for ( i = first; i <= last; i++ ) {
+      openmemory_vars.memory.bitmap[i/32] |= (uint32_t)1 << (i%32);
+      openmemory_vars.memory.last[i]       = end;
+   }
+}
+
+/**
+ * \brief Marks blocks as free, and pushes them on the single-block stack
+ */
+void openmemory_releaseBlocks(uint8_t first, uint8_t last)
+{
+   uint8_t  i;
+   uint32_t mask;
+
+   for ( i = first; i <= last; i++ ) {
+      mask = (uint32_t)1 << (i%32);
+      openmemory_vars.memory.bitmap[i/32] &= ~mask;
+      if ( (openmemory_vars.memory.stacked[i/32] & mask) == 0 ) {
+         openmemory_vars.memory.stacked[i/32] |= mask;
+         openmemory_vars.memory.stack[openmemory_vars.stackTop++] = i;
+      }
+   }
+}
+
+/**
+ * \brief Looks for the lowest run of free blocks, a bitmap word at a time
+ *
+ * \param nsegments The number of contiguous free blocks needed.
+ *
+ * \returns The first block of the run, FRAME_DATA_BLOCKS if there is none.
+ */
+uint8_t openmemory_findFreeBlocks(uint8_t nsegments)
+{
+   uint8_t  w;
+   uint8_t  b;
+   uint16_t run;
+   uint32_t word;
+
+   run = 0;
+   for ( w = 0; w < OPENMEMORY_BITMAP_WORDS; w++ ) {
+      word = openmemory_vars.memory.bitmap[w];
+      if ( word == 0xffffffff ) {
+         run = 0;
+      } else if ( word == 0 ) {
+         run += 32;
+         if ( run >= nsegments ) {
+            return w*32 + 32 - run;
+         }
+      } else {
+         for ( b = 0; b < 32; b++ ) {
+            if ( word & ((uint32_t)1 << b) ) {
+               run = 0;
+            } else if ( ++run == nsegments ) {
+               return w*32 + b + 1 - run;
+            }
+         }
+      }
+   }
+   return FRAME_DATA_BLOCKS;
 }
+#endif
@@ -23,20 +23,36 @@
 #define  TOTAL_DYNAMIC_MEMORY ARCH_TOTAL_OPENMEMORY
 #endif
 
+// allocators
+#define OPENMEMORY_ALLOCATOR_MAP     1 // walk the map, from the top
+#define OPENMEMORY_ALLOCATOR_BITMAP  2 // occupation bitmap, single-block free stack
+
+#ifndef OPENMEMORY_ALLOCATOR
+#define OPENMEMORY_ALLOCATOR OPENMEMORY_ALLOCATOR_BITMAP
+#endif
+
+// bookkeeping bytes per block, on top of the block itself
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+#define OPENMEMORY_BLOCK_OVERHEAD 4   // map, last, stack, 2 bits of bitmaps
+#else
+#define OPENMEMORY_BLOCK_OVERHEAD 1   // map
+#endif
+
 /*
   TOTAL_DYNAMIC_MEMORY is the max amount of memory to use and it is part of
   .DATA, not .HEAP. Then, if:
   TOTAL_BLOCKS = TOTAL_DYNAMIC_MEMORY/FRAME_DATA_TOTAL => Z = X/Y
   TOTAL_MEMORY = TOTAL_BLOCKS * FRAME_DATA_TOTAL
   I want that:
-  TOTAL_MEMORY_USED = TOTAL_MEMORY + TOTAL_BLOCKS + 1 <= TOTAL_DYNAMIC_MEMORY
-  i.e, memory for data vector plus memory for map vector plus the counter
-  must be less or equal than TOTAL_DYNAMIC_MEMORY:
+  TOTAL_MEMORY_USED = TOTAL_MEMORY + TOTAL_BLOCKS*O + 1 <= TOTAL_DYNAMIC_MEMORY
+  i.e, memory for data vector plus O bytes of bookkeeping per block
+  (OPENMEMORY_BLOCK_OVERHEAD) plus the counter must be less or equal than
+  TOTAL_DYNAMIC_MEMORY:
        
-  (X/Y)*Y + X/Y + 1 <= X
-  (X/Y)*(Y+1) + 1 <= X   <=>  Z*(Y+1) <= X-1   <=>  z = (X-1)/(Y+1)
+  (X/Y)*Y + (X/Y)*O + 1 <= X
+  (X/Y)*(Y+O) + 1 <= X   <=>  Z*(Y+O) <= X-1   <=>  z = (X-1)/(Y+O)
 */
-#define FRAME_DATA_BLOCKS ((TOTAL_DYNAMIC_MEMORY-1)/(FRAME_DATA_TOTAL+1))
+#define FRAME_DATA_BLOCKS ((TOTAL_DYNAMIC_MEMORY-1)/(FRAME_DATA_TOTAL+OPENMEMORY_BLOCK_OVERHEAD))
 #if FRAME_DATA_BLOCKS > 254
 #undef  FRAME_DATA_BLOCKS
 #define FRAME_DATA_BLOCKS 254
@@ -44,18 +60,39 @@
 
 #define TOTAL_MEMORY_SIZE (FRAME_DATA_BLOCKS*FRAME_DATA_TOTAL)
 
+#define OPENMEMORY_BITMAP_WORDS ((FRAME_DATA_BLOCKS+31)/32)
+
 //=========================== typedef =========================================
 
 typedef struct {
    uint8_t  buffer[TOTAL_MEMORY_SIZE];
    uint8_t  map[FRAME_DATA_BLOCKS];
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   uint32_t bitmap[OPENMEMORY_BITMAP_WORDS];  // bit set if the block is reserved
+   uint32_t stacked[OPENMEMORY_BITMAP_WORDS]; // bit set if the block is in stack
+   uint8_t  last[FRAME_DATA_BLOCKS];          // last block of the area a reserved block is in
+   uint8_t  stack[FRAME_DATA_BLOCKS];         // blocks candidate to single-block reservations
+#endif
 } OpenMemoryEntry_t;
 
+typedef struct {
+   uint8_t  used;                // blocks currently reserved
+   uint8_t  highWater;           // most blocks ever reserved at once
+   uint8_t  freeAreas;           // number of free areas, i.e. fragmentation
+   uint8_t  largestFreeArea;     // blocks in the largest free area
+   uint16_t numFailed;           // reservations which could not be satisfied
+} openmemory_stats_t;
+
 //=========================== module variables ================================
 
 typedef struct {
    OpenMemoryEntry_t memory;
    uint8_t           used;
+   uint8_t           highWater;
+   uint16_t          numFailed;
+#if OPENMEMORY_ALLOCATOR==OPENMEMORY_ALLOCATOR_BITMAP
+   uint8_t           stackTop;
+#endif
 } openmemory_vars_t;
 
 //=========================== prototypes ======================================
@@ -71,6 +108,7 @@ uint8_t*  openmemory_lastSegmentAddr(uint8_t* address);
 bool      openmemory_sameMemoryArea(uint8_t* addr1, uint8_t* addr2);
 uint16_t  openmemory_sizeof(uint8_t* address);
 uint8_t* openmemory_moveToEnd(uint8_t* address, uint16_t size, uint16_t tail);
+void      openmemory_getStats(openmemory_stats_t* stats);
 
 /**
 \}
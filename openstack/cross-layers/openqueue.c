@@ -8,6 +8,7 @@
 #include "packetfunctions.h"
 #include "IEEE802154E.h"
 #include "IEEE802154_security.h"
+#include "opentelemetry.h"
 
 //=========================== defination =====================================
 
@@ -18,7 +19,17 @@
 openqueue_vars_t openqueue_vars;
 
 //=========================== prototypes ======================================
-void openqueue_reset_entry(OpenQueueEntry_t* entry);
+void     openqueue_reset_entry(OpenQueueEntry_t* entry);
+uint8_t  openqueue_entry_index(OpenQueueEntry_t* entry);
+void     openqueue_release_entry(uint8_t i);
+void     openqueue_insert_entry(uint8_t listId, uint8_t i, bool atHead);
+void     openqueue_remove_entry(uint8_t i);
+void     openqueue_enqueue_tx(uint8_t i, bool atHead);
+uint8_t  openqueue_txneighbor_slot(open_addr_t* neighbor, bool allocate);
+uint8_t  openqueue_drr_next(void);
+void     openqueue_list_insert(openqueue_list_t* list, uint8_t i, bool atHead);
+void     openqueue_list_remove(openqueue_list_t* list, uint8_t i);
+void     openqueue_getStatusRow(uint8_t row, uint8_t* buf);
 
 //=========================== public ==========================================
 
@@ -29,12 +40,37 @@ void openqueue_reset_entry(OpenQueueEntry_t* entry);
 */
 void openqueue_init() {
    uint8_t i;
+   for (i=0;i<OPENQUEUE_NUMLISTS;i++) {
+      openqueue_vars.list[i].head   = OPENQUEUE_NONE;
+      openqueue_vars.list[i].tail   = OPENQUEUE_NONE;
+      openqueue_vars.list[i].length = 0;
+   }
+   for (i=0;i<OPENQUEUE_TXNEIGHBORS;i++) {
+      openqueue_vars.txNeighbor[i].type = ADDR_NONE;
+   }
+   openqueue_vars.numUpperLayer     = 0;
+   openqueue_vars.drrFlow           = 0;
+   for (i=0;i<OPENQUEUE_NUMFLOWS;i++) {
+      openqueue_vars.drrDeficit[i]  = 0;
+   }
    for (i=0;i<QUEUELENGTH;i++){
 #ifndef DO_NOT_USE_FRAGMENTATION
       openqueue_vars.queue[i].packet = NULL;
 #endif
       openqueue_reset_entry(&(openqueue_vars.queue[i]));
+      openqueue_vars.link[i].list         = OPENQUEUE_NONE;
+      openqueue_vars.link[i].isUpperLayer = FALSE;
+      openqueue_insert_entry(OPENQUEUE_LIST_FREE,i,FALSE);
    }
+   
+   // status reported over serial
+   opentelemetry_registerTable(
+      STATUS_QUEUE,
+      1,
+      QUEUELENGTH*sizeof(debugOpenQueueEntry_t),
+      openqueue_getStatusRow,
+      OPENTELEMETRY_PERIOD_ALWAYS
+   );
 }
 
 /**
@@ -47,11 +83,7 @@ status information about several modules in the OpenWSN stack.
 */
 bool debugPrint_queue() {
    debugOpenQueueEntry_t output[QUEUELENGTH];
-   uint8_t i;
-   for (i=0;i<QUEUELENGTH;i++) {
-      output[i].creator = openqueue_vars.queue[i].creator;
-      output[i].owner   = openqueue_vars.queue[i].owner;
-   }
+   openqueue_getStatusRow(0,(uint8_t*)&output);
    openserial_printStatus(STATUS_QUEUE,(uint8_t*)&output,QUEUELENGTH*sizeof(debugOpenQueueEntry_t));
    return TRUE;
 }
@@ -72,6 +104,9 @@ get a new packet buffer to start creating a new packet.
 */
 OpenQueueEntry_t* openqueue_getFreePacketBuffer(uint8_t creator) {
    uint8_t i;
+#ifndef DO_NOT_USE_FRAGMENTATION
+   uint8_t* packet;
+#endif
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    
@@ -89,27 +124,29 @@ OpenQueueEntry_t* openqueue_getFreePacketBuffer(uint8_t creator) {
       return NULL;
    }
    
-   // walk through queue and find free entry
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_NULL) {
+   // take the first free entry
+   i = openqueue_vars.list[OPENQUEUE_LIST_FREE].head;
+   if (i==OPENQUEUE_NONE) {
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
 #ifndef DO_NOT_USE_FRAGMENTATION
-         uint8_t* packet;
-
-         if ( (packet = openmemory_getMemory(0)) == NULL ) {
-            ENABLE_INTERRUPTS();
-	    return NULL;
-	 }
-         openqueue_vars.queue[i].packet=packet;
-         openqueue_vars.queue[i].payload=&packet[FRAME_DATA_PLOAD - IEEE802154_SECURITY_TAG_LEN];
+   if ( (packet = openmemory_getMemory(0)) == NULL ) {
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
+   openqueue_vars.queue[i].packet=packet;
+   openqueue_vars.queue[i].payload=&packet[FRAME_DATA_PLOAD - IEEE802154_SECURITY_TAG_LEN];
 #endif
-         openqueue_vars.queue[i].creator=creator;
-         openqueue_vars.queue[i].owner=COMPONENT_OPENQUEUE;
-         ENABLE_INTERRUPTS(); 
-         return &openqueue_vars.queue[i];
-      }
+   openqueue_remove_entry(i);
+   openqueue_vars.queue[i].creator=creator;
+   openqueue_vars.queue[i].owner=COMPONENT_OPENQUEUE;
+   if (creator>COMPONENT_SIXTOP_RES) {
+      openqueue_vars.link[i].isUpperLayer = TRUE;
+      openqueue_vars.numUpperLayer++;
    }
-   ENABLE_INTERRUPTS();
-   return NULL;
+   ENABLE_INTERRUPTS(); 
+   return &openqueue_vars.queue[i];
 }
 
 /**
@@ -124,59 +161,86 @@ owerror_t openqueue_freePacketBuffer(OpenQueueEntry_t* pkt) {
    uint8_t i;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (&openqueue_vars.queue[i]==pkt) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_NULL) {
-            // log the error
-            openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_UNUSED,
-                                  (errorparameter_t)0,
-                                  (errorparameter_t)0);
-         }
+   i = openqueue_entry_index(pkt);
+   if (i==OPENQUEUE_NONE) {
+      // log the error
+      openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_ERROR,
+                            (errorparameter_t)0,
+                            (errorparameter_t)0);
+      ENABLE_INTERRUPTS();
+      return E_FAIL;
+   }
+   if (pkt->owner==COMPONENT_NULL) {
+      // log the error
+      openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_UNUSED,
+                            (errorparameter_t)0,
+                            (errorparameter_t)0);
+   }
 #ifndef DO_NOT_USE_FRAGMENTATION
-         if (pkt->packet!=NULL) {
-            openmemory_freeMemory(pkt->packet);
-            pkt->packet = NULL;
-         }
-#endif
-         openqueue_reset_entry(&(openqueue_vars.queue[i]));
-         ENABLE_INTERRUPTS();
-         return E_SUCCESS;
-      }
+   if (pkt->packet!=NULL) {
+      openmemory_freeMemory(pkt->packet);
+      pkt->packet = NULL;
    }
-   // log the error
-   openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_ERROR,
-                         (errorparameter_t)0,
-                         (errorparameter_t)0);
+#endif
+   openqueue_release_entry(i);
    ENABLE_INTERRUPTS();
-   return E_FAIL;
+   return E_SUCCESS;
 }
 
 #ifndef DO_NOT_USE_FRAGMENTATION
 owerror_t openqueue_freePacketBuffer_atomic(OpenQueueEntry_t* pkt) {
    uint8_t i;
 
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (&openqueue_vars.queue[i]==pkt) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_NULL) {
-            // log the error
-            openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_UNUSED,
-                                  (errorparameter_t)0,
-                                  (errorparameter_t)0);
-         }
-
-         if (pkt->packet!=NULL) {
-            openmemory_freeMemory(pkt->packet);
-            pkt->packet = NULL;
-         }
-         openqueue_reset_entry(&(openqueue_vars.queue[i]));
-         return E_SUCCESS;
-      }
+   i = openqueue_entry_index(pkt);
+   if (i==OPENQUEUE_NONE) {
+      return E_FAIL;
+   }
+   if (pkt->owner==COMPONENT_NULL) {
+      // log the error
+      openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_UNUSED,
+                            (errorparameter_t)0,
+                            (errorparameter_t)0);
    }
 
-   return E_FAIL;
+   if (pkt->packet!=NULL) {
+      openmemory_freeMemory(pkt->packet);
+      pkt->packet = NULL;
+   }
+   openqueue_release_entry(i);
+   return E_SUCCESS;
 }
 #endif
 
+/**
+\brief Hand an allocated packet buffer over to a different creator.
+
+Use this rather than writing the creator field directly once the packet is
+allocated (e.g. when relaying a received packet), so the packet is accounted
+for correctly by openqueue_isHighPriorityEntryEnough().
+
+\param pkt     A pointer to the previsouly-allocated packet buffer.
+\param creator The identifier of the new creator, taken in COMPONENT_*.
+*/
+void openqueue_setCreator(OpenQueueEntry_t* pkt, uint8_t creator) {
+   uint8_t i;
+   bool    isUpperLayer;
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   i = openqueue_entry_index(pkt);
+   if (i!=OPENQUEUE_NONE) {
+      isUpperLayer = creator>COMPONENT_SIXTOP_RES;
+      if (isUpperLayer && openqueue_vars.link[i].isUpperLayer==FALSE) {
+         openqueue_vars.numUpperLayer++;
+      }
+      if (isUpperLayer==FALSE && openqueue_vars.link[i].isUpperLayer) {
+         openqueue_vars.numUpperLayer--;
+      }
+      openqueue_vars.link[i].isUpperLayer = isUpperLayer;
+   }
+   pkt->creator = creator;
+   ENABLE_INTERRUPTS();
+}
+
 /**
 \brief Free all the packet buffers created by a specific module.
 
@@ -193,7 +257,7 @@ void openqueue_removeAllCreatedBy(uint8_t creator) {
       } else
 #endif
       if (openqueue_vars.queue[i].creator==creator) {
-         openqueue_reset_entry(&(openqueue_vars.queue[i]));
+         openqueue_release_entry(i);
       }
    }
    ENABLE_INTERRUPTS();
@@ -213,7 +277,7 @@ void openqueue_removeAllOwnedBy(uint8_t owner) {
    DISABLE_INTERRUPTS();
    for (i=0;i<QUEUELENGTH;i++){
       if (openqueue_vars.queue[i].owner==owner) {
-         openqueue_reset_entry(&(openqueue_vars.queue[i]));
+         openqueue_release_entry(i);
       }
    }
    ENABLE_INTERRUPTS();
@@ -221,103 +285,180 @@ void openqueue_removeAllOwnedBy(uint8_t owner) {
 
 //======= called by RES
 
-OpenQueueEntry_t* openqueue_sixtopGetSentPacket() {
+/**
+\brief Hand a packet over to the virtual COMPONENT_SIXTOP_TO_IEEE802154E
+   component, for IEEE802154E to fetch it from the queue.
+
+Packets from the upper layers are refused once OPENQUEUE_MAXPERNEIGHBOR packets
+to their next hop are queued.
+
+\param pkt A pointer to the packet to transmit.
+
+\returns E_SUCCESS when the packet was queued, E_FAIL otherwise. The caller
+   still owns the packet when it was refused.
+*/
+owerror_t openqueue_sixtopPutPacket(OpenQueueEntry_t* pkt) {
    uint8_t i;
+   uint8_t slot;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_IEEE802154E_TO_SIXTOP &&
-          openqueue_vars.queue[i].creator!=COMPONENT_IEEE802154E) {
+   i = openqueue_entry_index(pkt);
+   if (i==OPENQUEUE_NONE) {
+      ENABLE_INTERRUPTS();
+      return E_FAIL;
+   }
+   if (openqueue_vars.link[i].isUpperLayer) {
+      slot = openqueue_txneighbor_slot(&(pkt->l2_nextORpreviousHop),FALSE);
+      if (
+            slot!=OPENQUEUE_NONE &&
+            openqueue_vars.list[OPENQUEUE_LIST_TX_NEIGHBOR+slot].length>=OPENQUEUE_MAXPERNEIGHBOR
+         ) {
+         openserial_printError(COMPONENT_OPENQUEUE,ERR_NEIGHBOR_QUEUE_FULL,
+                               (errorparameter_t)pkt->l2_nextORpreviousHop.addr_64b[7],
+                               (errorparameter_t)OPENQUEUE_MAXPERNEIGHBOR);
          ENABLE_INTERRUPTS();
-         return &openqueue_vars.queue[i];
+         return E_FAIL;
       }
    }
+   openqueue_enqueue_tx(i,FALSE);
+   ENABLE_INTERRUPTS();
+   return E_SUCCESS;
+}
+
+OpenQueueEntry_t* openqueue_sixtopGetSentPacket() {
+   uint8_t i;
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   i = openqueue_vars.list[OPENQUEUE_LIST_SENT].head;
+   if (i==OPENQUEUE_NONE) {
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
+   openqueue_remove_entry(i);
    ENABLE_INTERRUPTS();
-   return NULL;
+   return &openqueue_vars.queue[i];
 }
 
 OpenQueueEntry_t* openqueue_sixtopGetReceivedPacket() {
    uint8_t i;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_IEEE802154E_TO_SIXTOP &&
-          openqueue_vars.queue[i].creator==COMPONENT_IEEE802154E) {
-         ENABLE_INTERRUPTS();
-         return &openqueue_vars.queue[i];
+   i = openqueue_vars.list[OPENQUEUE_LIST_RECEIVED].head;
+   if (i==OPENQUEUE_NONE) {
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
+   openqueue_remove_entry(i);
+   ENABLE_INTERRUPTS();
+   return &openqueue_vars.queue[i];
+}
+
+//======= called by the scheduling functions
+
+/**
+\brief Number of packets queued for transmission to a neighbor.
+
+Lets a scheduling function size the cells to a neighbor after its backlog. The
+sixtop RES packets are not counted.
+
+\param neighbor The 64-bit address of the neighbor.
+
+\returns The number of packets to that neighbor waiting for a cell.
+*/
+uint8_t openqueue_getNeighborDepth(open_addr_t* neighbor) {
+   uint8_t depth;
+   uint8_t slot;
+   uint8_t i;
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   depth = 0;
+   slot  = openqueue_txneighbor_slot(neighbor,FALSE);
+   if (slot!=OPENQUEUE_NONE) {
+      depth = openqueue_vars.list[OPENQUEUE_LIST_TX_NEIGHBOR+slot].length;
+   }
+   // packets queued while all TX neighbor slots were taken
+   for (
+      i=openqueue_vars.list[OPENQUEUE_LIST_TX_OTHER].head;
+      i!=OPENQUEUE_NONE;
+      i=openqueue_vars.link[i].hook.next
+   ) {
+      if (packetfunctions_sameAddress(neighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)) {
+         depth++;
       }
    }
    ENABLE_INTERRUPTS();
-   return NULL;
+   return depth;
 }
 
 //======= called by IEEE80215E
 
+/**
+\brief Take the next packet to transmit to a neighbor out of the queue.
+
+Sixtop RES packets go first. For a unicast neighbor, the oldest packet to that
+neighbor is taken from its TX list. For anycast, the TX lists are served in
+turn, see openqueue_drr_next(), so a neighbor which does not acknowledge only
+holds back its own packets.
+
+\param toNeighbor The neighbor of the cell, or an anycast address.
+
+\returns The packet to transmit, or NULL if there is none.
+*/
 OpenQueueEntry_t* openqueue_macGetDataPacket(open_addr_t* toNeighbor) {
    uint8_t i;
+   uint8_t slot;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
 
-    // first to look the sixtop RES packet
-    for (i=0;i<QUEUELENGTH;i++) {
-       if (
-           openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-           openqueue_vars.queue[i].creator==COMPONENT_SIXTOP_RES &&
-           (
-               (
-                   toNeighbor->type==ADDR_64B &&
-                   packetfunctions_sameAddress(toNeighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)
-               ) || toNeighbor->type==ADDR_ANYCAST
-           )
-       ){
-          ENABLE_INTERRUPTS();
-          return &openqueue_vars.queue[i];
-       }
-    }
-  
+   i = OPENQUEUE_NONE;
    if (toNeighbor->type==ADDR_64B) {
-      // a neighbor is specified, look for a packet unicast to that neigbhbor
-      for (i=0;i<QUEUELENGTH;i++) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-            packetfunctions_sameAddress(toNeighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)
-          ) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+      // first to look the sixtop RES packet to that neighbor
+      for (
+         i=openqueue_vars.list[OPENQUEUE_LIST_TX_RES].head;
+         i!=OPENQUEUE_NONE;
+         i=openqueue_vars.link[i].hook.next
+      ) {
+         if (packetfunctions_sameAddress(toNeighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)) {
+            break;
          }
       }
-   } else if (toNeighbor->type==ADDR_ANYCAST) {
-      // anycast case: look for a packet which is either not created by RES
-      // or an KA (created by RES, but not broadcast)
-      for (i=0;i<QUEUELENGTH;i++) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-             ( openqueue_vars.queue[i].creator!=COMPONENT_SIXTOP ||
-                (
-                   openqueue_vars.queue[i].creator==COMPONENT_SIXTOP &&
-                   packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))==FALSE
-                )
-             )
-            ) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+      // then for a packet unicast to that neighbor
+      if (i==OPENQUEUE_NONE) {
+         slot = openqueue_txneighbor_slot(toNeighbor,FALSE);
+         if (slot!=OPENQUEUE_NONE) {
+            i = openqueue_vars.list[OPENQUEUE_LIST_TX_NEIGHBOR+slot].head;
          }
       }
+      // packets queued while all TX neighbor slots were taken
+      if (i==OPENQUEUE_NONE) {
+         for (
+            i=openqueue_vars.list[OPENQUEUE_LIST_TX_OTHER].head;
+            i!=OPENQUEUE_NONE;
+            i=openqueue_vars.link[i].hook.next
+         ) {
+            if (packetfunctions_sameAddress(toNeighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)) {
+               break;
+            }
+         }
+      }
+   } else if (toNeighbor->type==ADDR_ANYCAST) {
+      // anycast case: sixtop RES packets first, then anything but an EB
+      i = openqueue_vars.list[OPENQUEUE_LIST_TX_RES].head;
+      if (i==OPENQUEUE_NONE) {
+         i = openqueue_drr_next();
+      }
    }
+   if (i==OPENQUEUE_NONE) {
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
+   openqueue_remove_entry(i);
    ENABLE_INTERRUPTS();
-   return NULL;
+   return &openqueue_vars.queue[i];
 }
 
 bool openqueue_isHighPriorityEntryEnough(){
-    uint8_t i;
-    uint8_t numberOfEntry;
-    
-    numberOfEntry = 0;
-    for (i=0;i<QUEUELENGTH;i++) {
-        if(openqueue_vars.queue[i].creator>COMPONENT_SIXTOP_RES){
-            numberOfEntry++;
-        }
-    }
-    
-    if (numberOfEntry>QUEUELENGTH-HIGH_PRIORITY_QUEUE_ENTRY){
+    if (openqueue_vars.numUpperLayer>QUEUELENGTH-HIGH_PRIORITY_QUEUE_ENTRY){
         return FALSE;
     } else {
         return TRUE;
@@ -328,20 +469,77 @@ OpenQueueEntry_t* openqueue_macGetEBPacket() {
    uint8_t i;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-          openqueue_vars.queue[i].creator==COMPONENT_SIXTOP              &&
-          packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))) {
-         ENABLE_INTERRUPTS();
-         return &openqueue_vars.queue[i];
+   i = openqueue_vars.list[OPENQUEUE_LIST_TX_EB].head;
+   if (i==OPENQUEUE_NONE) {
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
+   openqueue_remove_entry(i);
+   ENABLE_INTERRUPTS();
+   return &openqueue_vars.queue[i];
+}
+
+/**
+\brief Return a packet to the virtual COMPONENT_SIXTOP_TO_IEEE802154E
+   component after a failed transmission attempt.
+
+The packet goes back to the head of its TX list, so it is retried before any
+packet queued after it.
+
+\param pkt A pointer to the packet to retransmit.
+*/
+void openqueue_macPutBackPacket(OpenQueueEntry_t* pkt) {
+   uint8_t i;
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   i = openqueue_entry_index(pkt);
+   if (i!=OPENQUEUE_NONE) {
+      openqueue_enqueue_tx(i,TRUE);
+   }
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Hand a sent or received packet over to the virtual
+   COMPONENT_IEEE802154E_TO_SIXTOP component, for sixtop to fetch it.
+
+\param pkt A pointer to the packet sent or received.
+*/
+void openqueue_macPutPacket(OpenQueueEntry_t* pkt) {
+   uint8_t i;
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   i = openqueue_entry_index(pkt);
+   if (i!=OPENQUEUE_NONE) {
+      openqueue_remove_entry(i);
+      pkt->owner = COMPONENT_IEEE802154E_TO_SIXTOP;
+      if (pkt->creator==COMPONENT_IEEE802154E) {
+         openqueue_insert_entry(OPENQUEUE_LIST_RECEIVED,i,FALSE);
+      } else {
+         openqueue_insert_entry(OPENQUEUE_LIST_SENT,i,FALSE);
       }
    }
    ENABLE_INTERRUPTS();
-   return NULL;
 }
 
 //=========================== private =========================================
 
+/**
+\brief Format the creator and owner of each entry, as reported over serial.
+
+\param[in]  row Ignored, the whole queue is a single row.
+\param[out] buf Where to write QUEUELENGTH debugOpenQueueEntry_t.
+*/
+void openqueue_getStatusRow(uint8_t row, uint8_t* buf) {
+   debugOpenQueueEntry_t output[QUEUELENGTH];
+   uint8_t i;
+   for (i=0;i<QUEUELENGTH;i++) {
+      output[i].creator = openqueue_vars.queue[i].creator;
+      output[i].owner   = openqueue_vars.queue[i].owner;
+   }
+   memcpy(buf,output,sizeof(output));
+}
+
 void openqueue_reset_entry(OpenQueueEntry_t* entry) {
    //admin
    entry->creator                      = COMPONENT_NULL;
@@ -371,3 +569,205 @@ void openqueue_reset_entry(OpenQueueEntry_t* entry) {
    //l2-security
    entry->l2_securityLevel             = 0;
 }
+
+/**
+\brief Index of a queue entry, OPENQUEUE_NONE if it is not one.
+*/
+uint8_t openqueue_entry_index(OpenQueueEntry_t* entry) {
+   uint8_t i;
+   if (entry<&openqueue_vars.queue[0] || entry>=&openqueue_vars.queue[QUEUELENGTH]) {
+      return OPENQUEUE_NONE;
+   }
+   i = (uint8_t)(entry-&openqueue_vars.queue[0]);
+   if (&openqueue_vars.queue[i]!=entry) {
+      return OPENQUEUE_NONE;
+   }
+   return i;
+}
+
+/**
+\brief Reset an entry and put it back on the free list.
+*/
+void openqueue_release_entry(uint8_t i) {
+   if (openqueue_vars.link[i].list!=OPENQUEUE_LIST_FREE) {
+      openqueue_remove_entry(i);
+      if (openqueue_vars.link[i].isUpperLayer) {
+         openqueue_vars.link[i].isUpperLayer = FALSE;
+         openqueue_vars.numUpperLayer--;
+      }
+      openqueue_insert_entry(OPENQUEUE_LIST_FREE,i,FALSE);
+   }
+   openqueue_reset_entry(&(openqueue_vars.queue[i]));
+}
+
+/**
+\brief Put an entry on a list.
+*/
+void openqueue_insert_entry(uint8_t listId, uint8_t i, bool atHead) {
+   openqueue_vars.link[i].list = listId;
+   openqueue_list_insert(&openqueue_vars.list[listId],i,atHead);
+}
+
+/**
+\brief Take an entry off the list it is on, if any.
+
+A per-neighbor TX list which becomes empty releases its neighbor slot, and a TX
+list which becomes empty loses its deficit.
+*/
+void openqueue_remove_entry(uint8_t i) {
+   uint8_t listId;
+   
+   listId = openqueue_vars.link[i].list;
+   if (listId==OPENQUEUE_NONE) {
+      return;
+   }
+   openqueue_list_remove(&openqueue_vars.list[listId],i);
+   if (listId>=OPENQUEUE_LIST_TX_OTHER && openqueue_vars.list[listId].length==0) {
+      openqueue_vars.drrDeficit[listId-OPENQUEUE_LIST_TX_OTHER] = 0;
+      if (listId>=OPENQUEUE_LIST_TX_NEIGHBOR) {
+         openqueue_vars.txNeighbor[listId-OPENQUEUE_LIST_TX_NEIGHBOR].type = ADDR_NONE;
+      }
+   }
+   openqueue_vars.link[i].list = OPENQUEUE_NONE;
+}
+
+/**
+\brief Give an entry to COMPONENT_SIXTOP_TO_IEEE802154E, on the TX list the
+   MAC looks it up in.
+*/
+void openqueue_enqueue_tx(uint8_t i, bool atHead) {
+   OpenQueueEntry_t* pkt;
+   uint8_t           listId;
+   uint8_t           slot;
+   
+   pkt = &openqueue_vars.queue[i];
+   openqueue_remove_entry(i);
+   pkt->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+   if (pkt->creator==COMPONENT_SIXTOP_RES) {
+      listId = OPENQUEUE_LIST_TX_RES;
+   } else if (packetfunctions_isBroadcastMulticast(&(pkt->l2_nextORpreviousHop))) {
+      if (pkt->creator==COMPONENT_SIXTOP) {
+         listId = OPENQUEUE_LIST_TX_EB;
+      } else {
+         listId = OPENQUEUE_LIST_TX_OTHER;
+      }
+   } else {
+      slot = openqueue_txneighbor_slot(&(pkt->l2_nextORpreviousHop),TRUE);
+      if (slot==OPENQUEUE_NONE) {
+         listId = OPENQUEUE_LIST_TX_OTHER;
+      } else {
+         listId = OPENQUEUE_LIST_TX_NEIGHBOR+slot;
+      }
+   }
+   openqueue_insert_entry(listId,i,atHead);
+}
+
+/**
+\brief Find the TX neighbor slot of a next hop.
+
+\param neighbor The 64-bit address of the next hop.
+\param allocate Whether to take a free slot when the next hop has none.
+
+\returns The slot, or OPENQUEUE_NONE if there is none.
+*/
+uint8_t openqueue_txneighbor_slot(open_addr_t* neighbor, bool allocate) {
+   uint8_t i;
+   uint8_t freeSlot;
+   
+   if (neighbor->type!=ADDR_64B) {
+      return OPENQUEUE_NONE;
+   }
+   freeSlot = OPENQUEUE_NONE;
+   for (i=0;i<OPENQUEUE_TXNEIGHBORS;i++) {
+      if (openqueue_vars.txNeighbor[i].type==ADDR_NONE) {
+         if (freeSlot==OPENQUEUE_NONE) {
+            freeSlot = i;
+         }
+      } else if (packetfunctions_sameAddress(neighbor,&openqueue_vars.txNeighbor[i])) {
+         return i;
+      }
+   }
+   if (allocate==FALSE || freeSlot==OPENQUEUE_NONE) {
+      return OPENQUEUE_NONE;
+   }
+   memcpy(&openqueue_vars.txNeighbor[freeSlot],neighbor,sizeof(open_addr_t));
+   return freeSlot;
+}
+
+/**
+\brief Pick the next entry a shared cell transmits, by deficit round robin.
+
+The TX lists other than the EB and RES ones are served in turn. Each time its
+turn comes, a backlogged list earns OPENQUEUE_DRR_QUANTUM bytes, and transmits
+from its head as long as they cover the length of the packet.
+
+\returns The entry to transmit, OPENQUEUE_NONE if none of these lists holds one.
+*/
+uint8_t openqueue_drr_next() {
+   uint8_t flow;
+   uint8_t n;
+   uint8_t i;
+   
+   // a round gives every backlogged list enough to send a packet
+   for (n=0;n<=OPENQUEUE_NUMFLOWS;n++) {
+      flow = openqueue_vars.drrFlow;
+      i    = openqueue_vars.list[OPENQUEUE_LIST_TX_OTHER+flow].head;
+      if (i!=OPENQUEUE_NONE && openqueue_vars.drrDeficit[flow]>=openqueue_vars.queue[i].length) {
+         openqueue_vars.drrDeficit[flow] -= openqueue_vars.queue[i].length;
+         return i;
+      }
+      
+      // turn of the next list
+      flow = (flow+1)%OPENQUEUE_NUMFLOWS;
+      openqueue_vars.drrFlow = flow;
+      if (openqueue_vars.list[OPENQUEUE_LIST_TX_OTHER+flow].head!=OPENQUEUE_NONE) {
+         openqueue_vars.drrDeficit[flow] += OPENQUEUE_DRR_QUANTUM;
+      }
+   }
+   return OPENQUEUE_NONE;
+}
+
+void openqueue_list_insert(openqueue_list_t* list, uint8_t i, bool atHead) {
+   openqueue_hook_t* hook;
+   
+   hook = &openqueue_vars.link[i].hook;
+   if (atHead) {
+      hook->prev = OPENQUEUE_NONE;
+      hook->next = list->head;
+      if (list->head!=OPENQUEUE_NONE) {
+         openqueue_vars.link[list->head].hook.prev = i;
+      } else {
+         list->tail = i;
+      }
+      list->head = i;
+   } else {
+      hook->prev = list->tail;
+      hook->next = OPENQUEUE_NONE;
+      if (list->tail!=OPENQUEUE_NONE) {
+         openqueue_vars.link[list->tail].hook.next = i;
+      } else {
+         list->head = i;
+      }
+      list->tail = i;
+   }
+   list->length++;
+}
+
+void openqueue_list_remove(openqueue_list_t* list, uint8_t i) {
+   openqueue_hook_t* hook;
+   
+   hook = &openqueue_vars.link[i].hook;
+   if (hook->prev!=OPENQUEUE_NONE) {
+      openqueue_vars.link[hook->prev].hook.next = hook->next;
+   } else {
+      list->head = hook->next;
+   }
+   if (hook->next!=OPENQUEUE_NONE) {
+      openqueue_vars.link[hook->next].hook.prev = hook->prev;
+   } else {
+      list->tail = hook->prev;
+   }
+   hook->prev = OPENQUEUE_NONE;
+   hook->next = OPENQUEUE_NONE;
+   list->length--;
+}
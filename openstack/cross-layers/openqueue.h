@@ -13,7 +13,49 @@
 
 //=========================== define ==========================================
 
+#ifndef QUEUELENGTH
 #define QUEUELENGTH  10
+#endif
+
+// number of next hops the TX index keeps a list for at the same time
+#ifndef OPENQUEUE_TXNEIGHBORS
+#define OPENQUEUE_TXNEIGHBORS  MAXNUMNEIGHBORS
+#endif
+
+// packets to a single next hop the queue holds at most, so a neighbor which
+// does not acknowledge leaves room for the others in the entries the upper
+// layers may take
+#ifndef OPENQUEUE_MAXPERNEIGHBOR
+#define OPENQUEUE_MAXPERNEIGHBOR  (QUEUELENGTH/2-1)
+#endif
+
+// bytes a TX list earns per round of the shared cells, at least the largest
+// frame so every round serves every backlogged list
+#ifndef OPENQUEUE_DRR_QUANTUM
+#define OPENQUEUE_DRR_QUANTUM  127
+#endif
+
+// end of list, or entry not on any list
+#define OPENQUEUE_NONE         0xff
+
+#if QUEUELENGTH>=OPENQUEUE_NONE
+#error "QUEUELENGTH too large for the openqueue entry indices"
+#endif
+
+enum {
+   OPENQUEUE_LIST_FREE         = 0, // owned by COMPONENT_NULL
+   OPENQUEUE_LIST_SENT,             // owned by COMPONENT_IEEE802154E_TO_SIXTOP, sent by me
+   OPENQUEUE_LIST_RECEIVED,         // owned by COMPONENT_IEEE802154E_TO_SIXTOP, received
+   OPENQUEUE_LIST_TX_EB,            // owned by COMPONENT_SIXTOP_TO_IEEE802154E, EBs
+   OPENQUEUE_LIST_TX_RES,           // owned by COMPONENT_SIXTOP_TO_IEEE802154E, 6P packets
+   OPENQUEUE_LIST_TX_OTHER,         // owned by COMPONENT_SIXTOP_TO_IEEE802154E, no TX neighbor slot
+   OPENQUEUE_LIST_TX_NEIGHBOR,      // first of the OPENQUEUE_TXNEIGHBORS per-neighbor lists
+};
+
+#define OPENQUEUE_NUMLISTS     (OPENQUEUE_LIST_TX_NEIGHBOR+OPENQUEUE_TXNEIGHBORS)
+
+// TX lists the shared cells serve in turn: the other one, then the per-neighbor ones
+#define OPENQUEUE_NUMFLOWS     (OPENQUEUE_NUMLISTS-OPENQUEUE_LIST_TX_OTHER)
 
 //=========================== typedef =========================================
 
@@ -22,10 +64,33 @@ typedef struct {
    uint8_t  owner;
 } debugOpenQueueEntry_t;
 
+typedef struct {
+   uint8_t  head;
+   uint8_t  tail;
+   uint8_t  length;
+} openqueue_list_t;
+
+typedef struct {
+   uint8_t  prev;
+   uint8_t  next;
+} openqueue_hook_t;
+
+typedef struct {
+   openqueue_hook_t hook;
+   uint8_t          list;           // OPENQUEUE_LIST_*, OPENQUEUE_NONE if on no list
+   bool             isUpperLayer;   // created above COMPONENT_SIXTOP_RES
+} openqueue_link_t;
+
 //=========================== module variables ================================
 
 typedef struct {
    OpenQueueEntry_t queue[QUEUELENGTH];
+   openqueue_link_t link[QUEUELENGTH];
+   openqueue_list_t list[OPENQUEUE_NUMLISTS];
+   open_addr_t      txNeighbor[OPENQUEUE_TXNEIGHBORS]; // next hop of each per-neighbor list
+   uint8_t          numUpperLayer;  // entries created above COMPONENT_SIXTOP_RES
+   uint8_t          drrFlow;        // TX list the shared cells serve, from OPENQUEUE_LIST_TX_OTHER
+   uint16_t         drrDeficit[OPENQUEUE_NUMFLOWS]; // bytes each TX list may still send this round
 } openqueue_vars_t;
 
 //=========================== prototypes ======================================
@@ -36,15 +101,21 @@ bool               debugPrint_queue(void);
 // called by any component
 OpenQueueEntry_t*  openqueue_getFreePacketBuffer(uint8_t creator);
 owerror_t          openqueue_freePacketBuffer(OpenQueueEntry_t* pkt);
+void               openqueue_setCreator(OpenQueueEntry_t* pkt, uint8_t creator);
 void               openqueue_removeAllCreatedBy(uint8_t creator);
 void               openqueue_removeAllOwnedBy(uint8_t owner);
 bool               openqueue_isHighPriorityEntryEnough(void);
 // called by res
+owerror_t          openqueue_sixtopPutPacket(OpenQueueEntry_t* pkt);
 OpenQueueEntry_t*  openqueue_sixtopGetSentPacket(void);
 OpenQueueEntry_t*  openqueue_sixtopGetReceivedPacket(void);
+// called by the scheduling functions
+uint8_t            openqueue_getNeighborDepth(open_addr_t* neighbor);
 // called by IEEE80215E
 OpenQueueEntry_t*  openqueue_macGetDataPacket(open_addr_t* toNeighbor);
 OpenQueueEntry_t*  openqueue_macGetEBPacket(void);
+void               openqueue_macPutBackPacket(OpenQueueEntry_t* pkt);
+void               openqueue_macPutPacket(OpenQueueEntry_t* pkt);
 
 /**
 \}
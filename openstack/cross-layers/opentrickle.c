@@ -0,0 +1,152 @@
+#include "opendefs.h"
+#include "opentrickle.h"
+#include "openrandom.h"
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+void opentrickle_startInterval(opentrickle_t* trickle);
+
+//=========================== public ==========================================
+
+/**
+\brief Start a Trickle timer, with an interval of Imin.
+
+Calling it on a running Trickle timer restarts it with the new parameters.
+
+\param[out] trickle   The Trickle timer to start.
+\param[in]  timerId   The timer the intervals run on.
+\param[in]  cb        The callback of that timer, which calls opentrickle_fired().
+\param[in]  Imin      The minimum interval size, in ms.
+\param[in]  doublings The number of times Imin doubles into the maximum
+   interval size.
+\param[in]  k         The redundancy constant, 0 to never suppress
+   transmissions.
+*/
+void opentrickle_start(
+      opentrickle_t*  trickle,
+      opentimers_id_t timerId,
+      opentimers_cbt  cb,
+      uint32_t        Imin,
+      uint8_t         doublings,
+      uint8_t         k
+   ) {
+   INTERRUPT_DECLARATION();
+
+   if (Imin<OPENTRICKLE_MIN_INTERVAL_MS) {
+      Imin = OPENTRICKLE_MIN_INTERVAL_MS;
+   }
+   if (Imin>OPENTRICKLE_MAX_INTERVAL_MS) {
+      Imin = OPENTRICKLE_MAX_INTERVAL_MS;
+   }
+
+   DISABLE_INTERRUPTS();
+   trickle->timerId = timerId;
+   trickle->cb      = cb;
+   trickle->Imin    = Imin;
+   trickle->k       = k;
+   // double one at a time, so Imax does not overflow
+   trickle->Imax    = Imin;
+   while (doublings>0 && trickle->Imax<=OPENTRICKLE_MAX_INTERVAL_MS/2) {
+      trickle->Imax *= 2;
+      doublings--;
+   }
+   trickle->I       = Imin;
+   opentrickle_startInterval(trickle);
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Indicate an inconsistency was heard.
+
+Starts over with an interval of Imin, unless already there.
+
+\param[in,out] trickle The Trickle timer.
+*/
+void opentrickle_reset(opentrickle_t* trickle) {
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   if (trickle->I!=trickle->Imin) {
+      trickle->I = trickle->Imin;
+      opentrickle_startInterval(trickle);
+   }
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Indicate a consistent transmission was heard.
+
+\param[in,out] trickle The Trickle timer.
+*/
+void opentrickle_consistent(opentrickle_t* trickle) {
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   if (trickle->c<0xff) {
+      trickle->c++;
+   }
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Handle the expiration of the timer of a Trickle timer.
+
+\note This function is called from the callback of the timer, in interrupt
+   context.
+
+\param[in,out] trickle The Trickle timer.
+
+\returns TRUE when the owner is to transmit, i.e. when t is reached and fewer
+   than k consistent transmissions were heard in this interval.
+*/
+bool opentrickle_fired(opentrickle_t* trickle) {
+
+   if (trickle->isBeforeT) {
+      // t is reached, wait for the end of the interval
+      trickle->isBeforeT = FALSE;
+      opentimers_scheduleIn(
+         trickle->timerId,
+         trickle->I-trickle->t,
+         TIME_MS,
+         TIMER_ONESHOT,
+         trickle->cb
+      );
+      return trickle->k==0 || trickle->c<trickle->k;
+   }
+
+   // the interval is over, start the next one twice as long
+   if (trickle->I<=trickle->Imax/2) {
+      trickle->I *= 2;
+   } else {
+      trickle->I  = trickle->Imax;
+   }
+   opentrickle_startInterval(trickle);
+   return FALSE;
+}
+
+//=========================== private =========================================
+
+/**
+\brief Start an interval of size I, picking t in [I/2, I).
+
+\param[in,out] trickle The Trickle timer.
+*/
+void opentrickle_startInterval(opentrickle_t* trickle) {
+   uint32_t half;
+   uint32_t random;
+
+   half               = trickle->I/2;
+   random             = ((uint32_t)openrandom_get16b()<<16) | openrandom_get16b();
+   trickle->t         = half+random%(trickle->I-half);
+   trickle->c         = 0;
+   trickle->isBeforeT = TRUE;
+   opentimers_scheduleIn(
+      trickle->timerId,
+      trickle->t,
+      TIME_MS,
+      TIMER_ONESHOT,
+      trickle->cb
+   );
+}
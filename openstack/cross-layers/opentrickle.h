@@ -0,0 +1,63 @@
+#ifndef __OPENTRICKLE_H
+#define __OPENTRICKLE_H
+
+/**
+\addtogroup cross-layers
+\{
+\addtogroup OpenTrickle
+\{
+*/
+
+#include "opendefs.h"
+#include "opentimers.h"
+
+//=========================== define ==========================================
+
+// the timers count in ticks on 32 bits, longer intervals are capped to this
+#define OPENTRICKLE_MAX_INTERVAL_MS  0x00ffffff // ~4.6h
+// below this, the interval can not be split in two halves
+#define OPENTRICKLE_MIN_INTERVAL_MS  2
+
+//=========================== typedef =========================================
+
+/**
+\brief State of a Trickle timer (RFC6206).
+
+The owner of the timer creates it with opentimers_create(), and hands it over
+with a callback which calls opentrickle_fired(), then transmits if it returns
+TRUE.
+*/
+typedef struct {
+   uint32_t        Imin;          ///< minimum interval size, in ms.
+   uint32_t        Imax;          ///< maximum interval size, in ms.
+   uint8_t         k;             ///< redundancy constant, 0 to never suppress.
+   uint32_t        I;             ///< current interval size, in ms.
+   uint32_t        t;             ///< time to transmit at within the current interval, in ms.
+   uint8_t         c;             ///< consistent transmissions heard in the current interval.
+   bool            isBeforeT;     ///< the timer runs until t, rather than until the end of the interval.
+   opentimers_id_t timerId;       ///< ID of the timer the interval runs on.
+   opentimers_cbt  cb;            ///< callback of that timer.
+} opentrickle_t;
+
+//=========================== module variables ================================
+
+//=========================== prototypes ======================================
+
+void     opentrickle_start(
+   opentrickle_t*  trickle,
+   opentimers_id_t timerId,
+   opentimers_cbt  cb,
+   uint32_t        Imin,
+   uint8_t         doublings,
+   uint8_t         k
+);
+void     opentrickle_reset(opentrickle_t* trickle);
+void     opentrickle_consistent(opentrickle_t* trickle);
+bool     opentrickle_fired(opentrickle_t* trickle);
+
+/**
+\}
+\}
+*/
+
+#endif
@@ -1,6 +1,7 @@
 #include "packetfunctions.h"
 #include "openserial.h"
 #include "idmanager.h"
+#include "opencrc.h"
 #ifndef DO_NOT_USE_FRAGMENTATION
 #include "IEEE802154_security.h"
 #endif
@@ -394,19 +395,10 @@ void packetfunctions_duplicatePacket(OpenQueueEntry_t* dst, OpenQueueEntry_t* sr
 
 void packetfunctions_calculateCRC(OpenQueueEntry_t* msg) {
    uint16_t crc;
-   uint8_t  i;
-   uint16_t count;
    crc = 0;
-   for (count=1;count<msg->length-2;count++) {
-      crc = crc ^ (uint8_t)*(msg->payload+count);
-      //crc = crc ^ (uint16_t)*ptr++ << 8;
-      for (i=0;i<8;i++) {
-         if (crc & 0x1) {
-            crc = crc >> 1 ^ 0x8408;
-         } else {
-            crc = crc >> 1;
-         }
-      }
+   if (msg->length>3) {
+      // the first byte is not covered by the CRC
+      crc = opencrc_update(crc,msg->payload+1,msg->length-3);
    }
    *(msg->payload+(msg->length-2)) = crc%256;
    *(msg->payload+(msg->length-1)) = crc/256;
@@ -414,19 +406,9 @@ void packetfunctions_calculateCRC(OpenQueueEntry_t* msg) {
 
 bool packetfunctions_checkCRC(OpenQueueEntry_t* msg) {
    uint16_t crc;
-   uint8_t  i;
-   uint16_t count;
    crc = 0;
-   for (count=0;count<msg->length-2;count++) {
-      crc = crc ^ (uint8_t)*(msg->payload+count);
-      //crc = crc ^ (uint16_t)*ptr++ << 8;
-      for (i=0;i<8;i++) {
-         if (crc & 0x1) {
-            crc = crc >> 1 ^ 0x8408;
-         } else {
-            crc = crc >> 1;
-         }
-      }
+   if (msg->length>2) {
+      crc = opencrc_update(crc,msg->payload,msg->length-2);
    }
    if (*(msg->payload+(msg->length-2))==crc%256 &&
        *(msg->payload+(msg->length-1))==crc/256) {
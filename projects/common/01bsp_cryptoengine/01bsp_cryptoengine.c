@@ -24,6 +24,7 @@ tests passed. If there was an error, we use the Error LED to signal.
 #define TEST_AES_CCMS_DEC              1
 #define TEST_AES_CCMS_AUTH_FORWARD     1
 #define TEST_AES_CCMS_AUTH_INVERSE     1
+#define TEST_AES_CCMS_DEC_FORGED       1
 #define TEST_BENCHMARK_CCMS            1
 
 typedef struct {
@@ -38,11 +39,11 @@ typedef struct
     uint8_t len_tag;
     uint8_t nonce[13];
     uint8_t a[15];
-    uint8_t m[20 + 4];
+    uint8_t m[32 + 8];
     uint8_t len_a;
     uint8_t len_m;
     uint8_t l;
-    uint8_t expected_ciphertext[24];
+    uint8_t expected_ciphertext[40];
 } aes_ccms_enc_suite_t;
 
 typedef struct
@@ -51,11 +52,11 @@ typedef struct
     uint8_t len_tag;
     uint8_t nonce[13];
     uint8_t a[15];
-    uint8_t c[20 + 4];
+    uint8_t c[32 + 8];
     uint8_t len_a;
     uint8_t len_c;
     uint8_t l;
-    uint8_t expected_plaintext[20];
+    uint8_t expected_plaintext[32];
 } aes_ccms_dec_suite_t;
 
 typedef struct
@@ -197,6 +198,28 @@ static owerror_t run_aes_ccms_auth_inverse_suite(aes_ccms_auth_forward_suite_t*
 }
 #endif /* TEST_AES_CCMS_AUTH_INVERSE */
 
+#if TEST_AES_CCMS_DEC_FORGED
+static owerror_t run_aes_ccms_dec_forged_suite(aes_ccms_dec_suite_t* suite, uint8_t test_suite_len) {
+   uint8_t i = 0;
+   uint8_t success = 0;
+
+   // the tag of each of these was tampered with, decryption must fail
+   for(i = 0; i < test_suite_len; i++) {
+      if(cryptoengine_aes_ccms_dec(suite[i].a,
+                       suite[i].len_a,
+                       suite[i].c,
+                       &suite[i].len_c,
+                       suite[i].nonce,
+                       suite[i].l,
+                       suite[i].key,
+                       suite[i].len_tag) == E_FAIL) {
+         success++;
+      }
+   }
+   return success == test_suite_len ? E_SUCCESS : E_FAIL;
+}
+#endif /* TEST_AES_CCMS_DEC_FORGED */
+
 /**
 \brief The program starts executing here.
 */
@@ -230,6 +253,11 @@ int mote_main(void) {
          { 0x6c, 0x5f, 0x51, 0x74, 0x53, 0x53, 0x77, 0x5a, 0x5a, 0x5f, 0x57, 0x58, 0x55, 0x53, 0x06, 0x0f },
          { 0x83, 0x78, 0x10, 0x60, 0x0e, 0x13, 0x93, 0x9b, 0x27, 0xe0, 0xd7, 0xe4, 0x58, 0xf0, 0xa9, 0xd1 },
       },
+      { /* FIPS-197, appendix C.1 */
+         { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+         { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+         { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a },
+      },
    };
 #endif /* TEST_AES_ECB */
 
@@ -263,6 +291,46 @@ int mote_main(void) {
          { 0x92, 0xe8, 0xad, 0xca, 0x53, 0x81, 0xbf, 0xd0, 0x5b, 0xdd, 0xf3, 0x61, 0x09, 0x09, 0x82, 0xe6, 0x2c,
             0x61, 0x01, 0x4e, 0x7b, 0x34, 0x4f, 0x09 } /* expected ciphertext */
       },
+      { /* RFC 3610, packet vector #1 */
+         { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+            8, /* tag_len */
+         { 0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+         { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+         { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E }, /* m vector + 8 octets for authentication tag */
+         8, /* len_a */
+         23, /* len_m */
+         2, /* CCM L */
+         { 0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+            0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84, 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0 } /* expected ciphertext */
+      },
+      { /* RFC 3610, packet vector #2 */
+         { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+            8, /* tag_len */
+         { 0x00, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+         { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+         { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F }, /* m vector + 8 octets for authentication tag */
+         8, /* len_a */
+         24, /* len_m */
+         2, /* CCM L */
+         { 0x72, 0xC9, 0x1A, 0x36, 0xE1, 0x35, 0xF8, 0xCF, 0x29, 0x1C, 0xA8, 0x94, 0x08, 0x5C, 0x87, 0xE3,
+            0xCC, 0x15, 0xC4, 0x39, 0xC9, 0xE4, 0x3A, 0x3B, 0xA0, 0x91, 0xD5, 0x6E, 0x10, 0x40, 0x09, 0x16 } /* expected ciphertext */
+      },
+      { /* RFC 3610, packet vector #3 */
+         { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+            8, /* tag_len */
+         { 0x00, 0x00, 0x00, 0x05, 0x04, 0x03, 0x02, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+         { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+         { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20 }, /* m vector + 8 octets for authentication tag */
+         8, /* len_a */
+         25, /* len_m */
+         2, /* CCM L */
+         { 0x51, 0xB1, 0xE5, 0xF4, 0x4A, 0x19, 0x7D, 0x1D, 0xA4, 0x6B, 0x0F, 0x8E, 0x2D, 0x28, 0x2A, 0xE8,
+            0x71, 0xE8, 0x38, 0xBB, 0x64, 0xDA, 0x85, 0x96, 0x57, 0x4A, 0xDA, 0xA7, 0x6F, 0xBD, 0x9F, 0xB0,
+            0xC5 } /* expected ciphertext */
+      },
    };
 #endif /* TEST_AES_CCMS_ENC */
 
@@ -295,9 +363,66 @@ int mote_main(void) {
         { 0x14, 0xaa, 0xbb, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
             0x0c, 0x0d, 0x0e, 0x0f } /* expected plaintext */
       },
+      { /* RFC 3610, packet vector #1 */
+        { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+        8, /* tag len */
+        { 0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+        { 0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+            0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84, 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0 }, /* c vector (m + tag) */
+        8, /* len_a */
+        31, /* len_c */
+        2, /* CCM L */
+        { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E } /* expected plaintext */
+      },
+      { /* RFC 3610, packet vector #2 */
+        { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+        8, /* tag len */
+        { 0x00, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+        { 0x72, 0xC9, 0x1A, 0x36, 0xE1, 0x35, 0xF8, 0xCF, 0x29, 0x1C, 0xA8, 0x94, 0x08, 0x5C, 0x87, 0xE3,
+            0xCC, 0x15, 0xC4, 0x39, 0xC9, 0xE4, 0x3A, 0x3B, 0xA0, 0x91, 0xD5, 0x6E, 0x10, 0x40, 0x09, 0x16 }, /* c vector (m + tag) */
+        8, /* len_a */
+        32, /* len_c */
+        2, /* CCM L */
+        { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F } /* expected plaintext */
+      },
+      { /* RFC 3610, packet vector #3 */
+        { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+        8, /* tag len */
+        { 0x00, 0x00, 0x00, 0x05, 0x04, 0x03, 0x02, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+        { 0x51, 0xB1, 0xE5, 0xF4, 0x4A, 0x19, 0x7D, 0x1D, 0xA4, 0x6B, 0x0F, 0x8E, 0x2D, 0x28, 0x2A, 0xE8,
+            0x71, 0xE8, 0x38, 0xBB, 0x64, 0xDA, 0x85, 0x96, 0x57, 0x4A, 0xDA, 0xA7, 0x6F, 0xBD, 0x9F, 0xB0,
+            0xC5 }, /* c vector (m + tag) */
+        8, /* len_a */
+        33, /* len_c */
+        2, /* CCM L */
+        { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20 } /* expected plaintext */
+      },
    };
 #endif /* TEST_AES_CCMS_DEC */
 
+#if TEST_AES_CCMS_DEC_FORGED
+   aes_ccms_dec_suite_t aes_ccms_dec_forged_suite[] = {
+      { /* RFC 3610, packet vector #1, last bit of the tag flipped */
+        { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }, /* key */
+        8, /* tag len */
+        { 0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 }, /* nonce */
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, /* a vector */
+        { 0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+            0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84, 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE1 }, /* c vector (m + tag) */
+        8, /* len_a */
+        31, /* len_c */
+        2, /* CCM L */
+        { 0x00 } /* not used */
+      },
+   };
+#endif /* TEST_AES_CCMS_DEC_FORGED */
+
 #if TEST_AES_CCMS_AUTH_FORWARD
    aes_ccms_auth_forward_suite_t aes_ccms_auth_forward_suite[] = {
 
@@ -367,6 +492,13 @@ int mote_main(void) {
    }
 #endif /* TEST_AES_CCMS_AUTH_INVERSE */
 
+#if TEST_AES_CCMS_DEC_FORGED
+   if (run_aes_ccms_dec_forged_suite(aes_ccms_dec_forged_suite,
+            sizeof(aes_ccms_dec_forged_suite)/sizeof(aes_ccms_dec_forged_suite[0])) == E_FAIL) {
+      fail++;
+   }
+#endif /* TEST_AES_CCMS_DEC_FORGED */
+
 #if TEST_BENCHMARK_CCMS
 
 #define A_LEN 30
@@ -0,0 +1,182 @@
+/**
+\brief This is a program which verifies the "opencrc" driver module.
+
+It checks each CRC strategy compiled into this build against known-answer test
+vectors (HDLC FCS and IEEE802.15.4 FCS), then cross-checks all strategies
+against the bitwise reference on pseudo-random buffers of every length up to a
+full frame, at every alignment.
+
+Load this program on your board. Radio LED will stay on indefinitely if all
+tests passed. If there was an error, we use the Error LED to signal.
+*/
+
+#include "stdint.h"
+#include "stdio.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+// driver modules required
+#include "opencrc.h"
+#include "openhdlc.h"
+
+//=========================== defines =========================================
+
+#define TEST_KNOWN_ANSWERS      1
+#define TEST_CROSS_CHECK        1
+
+#define CROSS_CHECK_MAXLEN      (FRAME_DATA_DATA+FRAME_DATA_CRC)
+
+typedef uint16_t (*opencrc_strategy_t)(uint16_t crc, uint8_t* buf, uint16_t len);
+
+typedef struct {
+   uint8_t  data[11];
+   uint8_t  len;
+   uint16_t init;
+   uint16_t expected_crc;
+} opencrc_suite_t;
+
+//=========================== variables =======================================
+
+static const opencrc_strategy_t strategies[] = {
+   opencrc_updateBitwise,
+   opencrc_updateNibble,
+#ifdef OPENCRC_TABLE_ENABLED
+   opencrc_updateTable,
+#endif
+#ifdef OPENCRC_SLICE4_ENABLED
+   opencrc_updateSlice4,
+#endif
+   opencrc_update,
+};
+
+#define NUM_STRATEGIES (sizeof(strategies)/sizeof(strategies[0]))
+
+uint8_t buffer[CROSS_CHECK_MAXLEN+4];
+
+//=========================== prototypes ======================================
+
+//=========================== main ============================================
+
+static int hang(uint8_t error_code) {
+
+   error_code ? leds_error_on() : leds_radio_on();
+
+   while (1);
+
+   return 0;
+}
+
+#if TEST_KNOWN_ANSWERS
+static owerror_t run_opencrc_suite(opencrc_suite_t* suite, uint8_t test_suite_len) {
+   uint8_t  i;
+   uint8_t  j;
+   uint8_t  success = 0;
+   bool     passed;
+   uint16_t crc;
+
+   for (i = 0; i < test_suite_len; i++) {
+      passed = TRUE;
+      for (j = 0; j < NUM_STRATEGIES; j++) {
+         if (strategies[j](suite[i].init, suite[i].data, suite[i].len) != suite[i].expected_crc) {
+            passed = FALSE;
+         }
+      }
+      // the byte-wise entry point, as used by HDLC, must agree as well
+      crc = suite[i].init;
+      for (j = 0; j < suite[i].len; j++) {
+         crc = opencrc_updateByte(crc, suite[i].data[j]);
+      }
+      if (crc != suite[i].expected_crc) {
+         passed = FALSE;
+      }
+      if (passed) {
+         success++;
+      }
+   }
+
+   return success == test_suite_len ? E_SUCCESS : E_FAIL;
+}
+#endif /* TEST_KNOWN_ANSWERS */
+
+#if TEST_CROSS_CHECK
+static owerror_t run_opencrc_cross_check(void) {
+   uint16_t lfsr = 0xace1;
+   uint16_t len;
+   uint16_t i;
+   uint16_t reference;
+   uint8_t  offset;
+   uint8_t  s;
+
+   for (i = 0; i < sizeof(buffer); i++) {
+      // 16-bit Galois LFSR, taps 16,14,13,11
+      lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xb400u);
+      buffer[i] = (uint8_t)lfsr;
+   }
+
+   for (offset = 0; offset < 4; offset++) {
+      for (len = 0; len <= CROSS_CHECK_MAXLEN; len++) {
+         reference = opencrc_updateBitwise(HDLC_CRCINIT, &buffer[offset], len);
+         for (s = 0; s < NUM_STRATEGIES; s++) {
+            if (strategies[s](HDLC_CRCINIT, &buffer[offset], len) != reference) {
+               return E_FAIL;
+            }
+         }
+      }
+   }
+
+   return E_SUCCESS;
+}
+#endif /* TEST_CROSS_CHECK */
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main(void) {
+   uint8_t fail = 0;
+
+#if TEST_KNOWN_ANSWERS
+   opencrc_suite_t opencrc_suite[] = {
+      { /* CRC-16/KERMIT check value, i.e. the IEEE802.15.4 FCS */
+         { '1', '2', '3', '4', '5', '6', '7', '8', '9' },
+         9,
+         0x0000,
+         0x2189,
+      },
+      { /* CRC-16/X-25 check value, i.e. the HDLC FCS, before complement */
+         { '1', '2', '3', '4', '5', '6', '7', '8', '9' },
+         9,
+         HDLC_CRCINIT,
+         0x906e ^ 0xffff,
+      },
+      { /* HDLC frame followed by its FCS leaves the good residue */
+         { '1', '2', '3', '4', '5', '6', '7', '8', '9', 0x6e, 0x90 },
+         11,
+         HDLC_CRCINIT,
+         HDLC_CRCGOOD,
+      },
+      { /* empty buffer leaves the CRC untouched */
+         { 0x00 },
+         0,
+         HDLC_CRCINIT,
+         HDLC_CRCINIT,
+      },
+   };
+#endif /* TEST_KNOWN_ANSWERS */
+
+   board_init();
+
+#if TEST_KNOWN_ANSWERS
+   if (run_opencrc_suite(opencrc_suite, sizeof(opencrc_suite)/sizeof(opencrc_suite[0])) == E_FAIL) {
+      fail++;
+   }
+#endif /* TEST_KNOWN_ANSWERS */
+
+#if TEST_CROSS_CHECK
+   if (run_opencrc_cross_check() == E_FAIL) {
+      fail++;
+   }
+#endif /* TEST_CROSS_CHECK */
+
+   return hang(fail);
+}
@@ -13,7 +13,7 @@
 #define RF_BUF_LEN           125+LENGTH_CRC // maximum length is 127 bytes
 #define MAC_LEN              8
 
-#define TASK_PRIO_SERIAL     TASKPRIO_MAX
+#define TASK_PRIO_SERIAL     TASKPRIO_OPENSERIAL
 #define TASK_PRIO_WIRELESS   TASKPRIO_SIXTOP_TIMEOUT
 
 #define TYPE_REQ_ST          1
@@ -0,0 +1,250 @@
+/**
+\brief This is a program which benchmarks the "openoscoap" module.
+
+It sets up a client and a server security context derived from the same master
+secret, then repeatedly protects a request at the client and unprotects it at
+the server. Each round trip is checked, and the time spent in
+openoscoap_protect_message() and openoscoap_unprotect_message() is accumulated
+in sctimer ticks. Once all round trips are done, the averages are printed over
+the serial port, formatted as follows:
+- [4B] average ticks per openoscoap_protect_message(), big endian
+- [4B] average ticks per openoscoap_unprotect_message(), big endian
+- [1B] number of round trips which failed
+- [3B] closing flags, each of value 0xff
+
+Load this program on your board. Radio LED will stay on indefinitely if all
+round trips succeeded. If there was an error, we use the Error LED to signal.
+*/
+
+#include "stdint.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "sctimer.h"
+#include "uart.h"
+// stack modules required
+#include "opendefs.h"
+#include "opencoap.h"
+#include "openoscoap.h"
+#include "packetfunctions.h"
+
+//=========================== defines =========================================
+
+#define BENCH_ITERATIONS        32
+#define BENCH_PAYLOAD_LEN       40
+#define LENGTH_SERIAL_FRAME     12   ///< length of the serial frame
+
+//=========================== variables =======================================
+
+typedef struct {
+   PORT_TIMER_WIDTH protectTicks;      // average ticks per openoscoap_protect_message()
+   PORT_TIMER_WIDTH unprotectTicks;    // average ticks per openoscoap_unprotect_message()
+   uint8_t          numFailures;
+   // uart
+   uint8_t          uart_txFrame[LENGTH_SERIAL_FRAME];
+   uint8_t          uart_lastTxByte;
+   volatile uint8_t uart_done;
+} oscoap_bench_vars_t;
+
+oscoap_bench_vars_t        oscoap_bench_vars;
+
+static const uint8_t       masterSecret[] = {
+   0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+   0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10
+};
+
+oscoap_security_context_t  clientContext;
+oscoap_security_context_t  serverContext;
+OpenQueueEntry_t           pkt;
+#ifndef DO_NOT_USE_FRAGMENTATION
+uint8_t                    pktBuffer[1+1+125+2+1];
+#endif
+
+//=========================== prototypes ======================================
+
+void cb_uartTxDone(void);
+void cb_uartRxCb(void);
+
+//=========================== main ============================================
+
+static int hang(uint8_t error_code) {
+
+   error_code ? leds_error_on() : leds_radio_on();
+
+   while (1);
+
+   return 0;
+}
+
+static owerror_t run_oscoap_round_trip(uint16_t sequenceNumber,
+                                       PORT_TIMER_WIDTH* protectTicks,
+                                       PORT_TIMER_WIDTH* unprotectTicks) {
+   coap_option_iht   options[MAX_COAP_OPTIONS];
+   uint8_t           optionsLen;
+   uint8_t*          kid;
+   uint8_t           kidLen;
+   uint16_t          receivedSequenceNumber;
+   uint8_t           index;
+   uint8_t           i;
+   PORT_TIMER_WIDTH  time1;
+   owerror_t         ret;
+
+   memset(&pkt, 0, sizeof(OpenQueueEntry_t));
+#ifndef DO_NOT_USE_FRAGMENTATION
+   pkt.packet  = pktBuffer;
+#endif
+   pkt.payload = &pkt.packet[127];
+   pkt.length  = 0;
+
+   packetfunctions_reserveHeaderSize(&pkt, BENCH_PAYLOAD_LEN);
+   for (i = 0; i < BENCH_PAYLOAD_LEN; i++) {
+      pkt.payload[i] = i;
+   }
+
+   options[0].type   = COAP_OPTION_NUM_URIPATH;
+   options[0].length = 1;
+   options[0].pValue = (uint8_t*)"s";
+   options[1].type   = COAP_OPTION_NUM_OBJECTSECURITY;
+   options[1].length = 0;
+   options[1].pValue = NULL;
+
+   // client side
+   time1 = sctimer_readCounter();
+   ret = openoscoap_protect_message(&clientContext,
+                                    COAP_VERSION,
+                                    COAP_CODE_REQ_GET,
+                                    options,
+                                    2,
+                                    &pkt,
+                                    sequenceNumber);
+   *protectTicks += sctimer_readCounter() - time1;
+   if (ret != E_SUCCESS) {
+      return E_FAIL;
+   }
+
+   // server side, the Object-Security option carries the compressed COSE object
+   index = openoscoap_parse_compressed_COSE(pkt.payload,
+                                            pkt.length,
+                                            &receivedSequenceNumber,
+                                            &kid,
+                                            &kidLen);
+   if (index == 0 || receivedSequenceNumber != sequenceNumber) {
+      return E_FAIL;
+   }
+   packetfunctions_tossHeader(&pkt, index);
+
+   options[0].type   = COAP_OPTION_NUM_OBJECTSECURITY;
+   options[0].length = 0;
+   options[0].pValue = NULL;
+   optionsLen        = 1;
+
+   time1 = sctimer_readCounter();
+   ret = openoscoap_unprotect_message(&serverContext,
+                                      COAP_VERSION,
+                                      COAP_CODE_REQ_GET,
+                                      options,
+                                      &optionsLen,
+                                      &pkt,
+                                      receivedSequenceNumber);
+   *unprotectTicks += sctimer_readCounter() - time1;
+   if (ret != E_SUCCESS) {
+      return E_FAIL;
+   }
+
+   // the decrypted message ends with the original payload
+   if (pkt.length < BENCH_PAYLOAD_LEN) {
+      return E_FAIL;
+   }
+   for (i = 0; i < BENCH_PAYLOAD_LEN; i++) {
+      if (pkt.payload[pkt.length - BENCH_PAYLOAD_LEN + i] != i) {
+         return E_FAIL;
+      }
+   }
+
+   return E_SUCCESS;
+}
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main(void) {
+   PORT_TIMER_WIDTH protectTicks   = 0;
+   PORT_TIMER_WIDTH unprotectTicks = 0;
+   uint16_t         i;
+
+   board_init();
+
+   // setup UART
+   uart_setCallbacks(cb_uartTxDone,cb_uartRxCb);
+
+   memset(&oscoap_bench_vars, 0, sizeof(oscoap_bench_vars_t));
+
+   openoscoap_init_security_context(&clientContext,
+                                    (uint8_t*)"client", 6,
+                                    (uint8_t*)"server", 6,
+                                    (uint8_t*)masterSecret, sizeof(masterSecret),
+                                    NULL, 0);
+   openoscoap_init_security_context(&serverContext,
+                                    (uint8_t*)"server", 6,
+                                    (uint8_t*)"client", 6,
+                                    (uint8_t*)masterSecret, sizeof(masterSecret),
+                                    NULL, 0);
+
+   for (i = 0; i < BENCH_ITERATIONS; i++) {
+      if (run_oscoap_round_trip(i + 1, &protectTicks, &unprotectTicks) == E_FAIL) {
+         oscoap_bench_vars.numFailures++;
+      }
+   }
+
+   oscoap_bench_vars.protectTicks   = protectTicks/BENCH_ITERATIONS;
+   oscoap_bench_vars.unprotectTicks = unprotectTicks/BENCH_ITERATIONS;
+
+   // format frame to send over serial port
+   oscoap_bench_vars.uart_txFrame[0]  = (uint8_t)((uint32_t)oscoap_bench_vars.protectTicks>>24);
+   oscoap_bench_vars.uart_txFrame[1]  = (uint8_t)((uint32_t)oscoap_bench_vars.protectTicks>>16);
+   oscoap_bench_vars.uart_txFrame[2]  = (uint8_t)((uint32_t)oscoap_bench_vars.protectTicks>>8);
+   oscoap_bench_vars.uart_txFrame[3]  = (uint8_t)((uint32_t)oscoap_bench_vars.protectTicks>>0);
+   oscoap_bench_vars.uart_txFrame[4]  = (uint8_t)((uint32_t)oscoap_bench_vars.unprotectTicks>>24);
+   oscoap_bench_vars.uart_txFrame[5]  = (uint8_t)((uint32_t)oscoap_bench_vars.unprotectTicks>>16);
+   oscoap_bench_vars.uart_txFrame[6]  = (uint8_t)((uint32_t)oscoap_bench_vars.unprotectTicks>>8);
+   oscoap_bench_vars.uart_txFrame[7]  = (uint8_t)((uint32_t)oscoap_bench_vars.unprotectTicks>>0);
+   oscoap_bench_vars.uart_txFrame[8]  = oscoap_bench_vars.numFailures;
+   oscoap_bench_vars.uart_txFrame[9]  = 0xff;                  // closing flag
+   oscoap_bench_vars.uart_txFrame[10] = 0xff;                  // closing flag
+   oscoap_bench_vars.uart_txFrame[11] = 0xff;                  // closing flag
+
+   oscoap_bench_vars.uart_done        = 0;
+   oscoap_bench_vars.uart_lastTxByte  = 0;
+
+   // send oscoap_bench_vars.uart_txFrame over UART
+   uart_clearTxInterrupts();
+   uart_clearRxInterrupts();
+   uart_enableInterrupts();
+   uart_writeByte(oscoap_bench_vars.uart_txFrame[oscoap_bench_vars.uart_lastTxByte]);
+   while (oscoap_bench_vars.uart_done==0); // busy wait to finish
+   uart_disableInterrupts();
+
+   return hang(oscoap_bench_vars.numFailures);
+}
+
+//=========================== callbacks =======================================
+
+void cb_uartTxDone(void) {
+
+   uart_clearTxInterrupts();
+
+   // prepare to send the next byte
+   oscoap_bench_vars.uart_lastTxByte++;
+
+   if (oscoap_bench_vars.uart_lastTxByte<sizeof(oscoap_bench_vars.uart_txFrame)) {
+      uart_writeByte(oscoap_bench_vars.uart_txFrame[oscoap_bench_vars.uart_lastTxByte]);
+   } else {
+      oscoap_bench_vars.uart_done=1;
+   }
+}
+
+void cb_uartRxCb(void) {
+
+   uart_clearRxInterrupts();
+}